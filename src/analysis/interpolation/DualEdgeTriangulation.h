@@ -120,8 +120,8 @@ class ANALYSIS_EXPORT DualEdgeTriangulation: public Triangulation
     QVector<QgsPoint *> mPointVector;
     //! Default value for the number of storable HalfEdges at the beginning
     static const unsigned int DEFAULT_STORAGE_FOR_HALF_EDGES = 300006;
-    //! Stores pointers to the HalfEdges
-    QVector<HalfEdge *> mHalfEdge;
+    //! Stores the HalfEdges. They refer to each other by their index, so they are kept by value without allocations per HalfEdge
+    QVector<HalfEdge> mHalfEdge;
     //! Association to an interpolator object
     TriangleInterpolator *mTriangleInterpolator = nullptr;
     //! Member to store the behavior in case of crossing forced segments
@@ -213,14 +213,14 @@ inline QgsPoint *DualEdgeTriangulation::getPoint( unsigned int i ) const
 inline bool DualEdgeTriangulation::halfEdgeBBoxTest( int edge, double xlowleft, double ylowleft, double xupright, double yupright ) const
 {
   return (
-           ( getPoint( mHalfEdge[edge]->getPoint() )->x() >= xlowleft &&
-             getPoint( mHalfEdge[edge]->getPoint() )->x() <= xupright &&
-             getPoint( mHalfEdge[edge]->getPoint() )->y() >= ylowleft &&
-             getPoint( mHalfEdge[edge]->getPoint() )->y() <= yupright ) ||
-           ( getPoint( mHalfEdge[mHalfEdge[edge]->getDual()]->getPoint() )->x() >= xlowleft &&
-             getPoint( mHalfEdge[mHalfEdge[edge]->getDual()]->getPoint() )->x() <= xupright &&
-             getPoint( mHalfEdge[mHalfEdge[edge]->getDual()]->getPoint() )->y() >= ylowleft &&
-             getPoint( mHalfEdge[mHalfEdge[edge]->getDual()]->getPoint() )->y() <= yupright )
+           ( getPoint( mHalfEdge[edge].getPoint() )->x() >= xlowleft &&
+             getPoint( mHalfEdge[edge].getPoint() )->x() <= xupright &&
+             getPoint( mHalfEdge[edge].getPoint() )->y() >= ylowleft &&
+             getPoint( mHalfEdge[edge].getPoint() )->y() <= yupright ) ||
+           ( getPoint( mHalfEdge[mHalfEdge[edge].getDual()].getPoint() )->x() >= xlowleft &&
+             getPoint( mHalfEdge[mHalfEdge[edge].getDual()].getPoint() )->x() <= xupright &&
+             getPoint( mHalfEdge[mHalfEdge[edge].getDual()].getPoint() )->y() >= ylowleft &&
+             getPoint( mHalfEdge[mHalfEdge[edge].getDual()].getPoint() )->y() <= yupright )
          );
 }
 
@@ -18,6 +18,7 @@
 #define HALFEDGE_H
 
 #include "qgis_analysis.h"
+#include <QtGlobal>
 
 #define SIP_NO_FILE
 
@@ -129,6 +130,8 @@ inline void HalfEdge::setForced( bool f )
   mForced = f;
 }
 
+Q_DECLARE_TYPEINFO( HalfEdge, Q_MOVABLE_TYPE );
+
 #endif
 
 #endif
@@ -19,8 +19,51 @@
 #include "qgsinterpolator.h"
 #include "qgsvectorlayer.h"
 #include "qgsfeedback.h"
+#include <algorithm>
 #include <QFile>
 #include <QFileInfo>
+#include <QThreadPool>
+#include <QtConcurrentMap>
+
+///@cond PRIVATE
+
+//! Interpolated values of a single grid row
+struct QgsGridFileWriterRow
+{
+  double y = 0;
+  QVector< double > values;
+  QVector< bool > valid;
+};
+
+//! Interpolates a grid row, for use with QtConcurrent
+struct QgsGridFileWriterRowWrapper
+{
+  QgsInterpolator *interpolator = nullptr;
+  double xMin;
+  double cellSizeX;
+  int columns;
+
+  QgsGridFileWriterRowWrapper( QgsInterpolator *interpolator, double xMin, double cellSizeX, int columns )
+    : interpolator( interpolator )
+    , xMin( xMin )
+    , cellSizeX( cellSizeX )
+    , columns( columns )
+  {}
+
+  void operator()( QgsGridFileWriterRow &row )
+  {
+    row.values.resize( columns );
+    row.valid.resize( columns );
+    double currentXValue = xMin;
+    for ( int j = 0; j < columns; ++j )
+    {
+      row.valid[ j ] = interpolator->interpolatePoint( currentXValue, row.y, row.values[ j ] ) == 0;
+      currentXValue += cellSizeX;
+    }
+  }
+};
+
+///@endcond
 
 QgsGridFileWriter::QgsGridFileWriter( QgsInterpolator *i, const QString &outputPath, const QgsRectangle &extent, int nCols, int nRows, double cellSizeX, double cellSizeY )
   : mInterpolator( i )
@@ -52,35 +95,56 @@ int QgsGridFileWriter::writeFile( QgsFeedback *feedback )
   writeHeader( outStream );
 
   double currentYValue = mInterpolationExtent.yMaximum() - mCellSizeY / 2.0; //calculate value in the center of the cell
-  double currentXValue;
-  double interpolatedValue;
+  QgsGridFileWriterRowWrapper interpolateRow( mInterpolator, mInterpolationExtent.xMinimum() + mCellSizeX / 2.0, mCellSizeX, mNumColumns ); //calculate value in the center of the cell
+
+  // rows are interpolated in blocks, in parallel if the interpolator supports it, and written out in order
+  const bool parallel = mInterpolator->supportsConcurrentInterpolation() && QThreadPool::globalInstance()->maxThreadCount() > 1;
+  const int rowsPerBlock = parallel ? 4 * QThreadPool::globalInstance()->maxThreadCount() : 1;
+  QVector< QgsGridFileWriterRow > rows;
 
-  for ( int i = 0; i < mNumRows; ++i )
+  for ( int blockStart = 0; blockStart < mNumRows; blockStart += rowsPerBlock )
   {
-    currentXValue = mInterpolationExtent.xMinimum() + mCellSizeX / 2.0; //calculate value in the center of the cell
-    for ( int j = 0; j < mNumColumns; ++j )
+    rows.resize( std::min( rowsPerBlock, mNumRows - blockStart ) );
+    for ( QgsGridFileWriterRow &row : rows )
+    {
+      row.y = currentYValue;
+      currentYValue -= mCellSizeY;
+    }
+
+    if ( parallel )
+      QtConcurrent::blockingMap( rows, interpolateRow );
+    else
     {
-      if ( mInterpolator->interpolatePoint( currentXValue, currentYValue, interpolatedValue ) == 0 )
+      for ( QgsGridFileWriterRow &row : rows )
+        interpolateRow( row );
+    }
+
+    for ( int i = 0; i < rows.size(); ++i )
+    {
+      const QgsGridFileWriterRow &row = rows.at( i );
+      for ( int j = 0; j < mNumColumns; ++j )
       {
-        outStream << interpolatedValue << ' ';
+        if ( row.valid.at( j ) )
+        {
+          outStream << row.values.at( j ) << ' ';
+        }
+        else
+        {
+          outStream << "-9999 ";
+        }
       }
-      else
+      outStream << endl;
+
+      if ( feedback )
       {
-        outStream << "-9999 ";
+        feedback->setProgress( 100.0 * ( blockStart + i ) / static_cast< double >( mNumRows ) );
       }
-      currentXValue += mCellSizeX;
     }
-    outStream << endl;
-    currentYValue -= mCellSizeY;
 
-    if ( feedback )
+    if ( feedback && feedback->isCanceled() )
     {
-      if ( feedback->isCanceled() )
-      {
-        outputFile.remove();
-        return 3;
-      }
-      feedback->setProgress( 100.0 * i / static_cast< double >( mNumRows ) );
+      outputFile.remove();
+      return 3;
     }
   }
 
@@ -16,8 +16,101 @@
  ***************************************************************************/
 
 #include "qgsidwinterpolator.h"
+#include "qgis.h"
+#include <QMutexLocker>
+#include <algorithm>
 #include <cmath>
 #include <limits>
+#include <vector>
+
+///@cond PRIVATE
+
+/**
+ * Static 2D kd-tree over the cached sample points, used to find the
+ * neighbors of interpolated points. The tree is stored implicitly in
+ * a reordered copy of the points, so queries are read only and may run
+ * concurrently.
+ */
+class QgsIDWPointIndex
+{
+  public:
+
+    explicit QgsIDWPointIndex( const QVector<vertexData> &points )
+      : mPoints( points.constBegin(), points.constEnd() )
+    {
+      build( 0, mPoints.size(), 0 );
+    }
+
+    /**
+     * Collects the \a maxCount (or all if \a maxCount is 0) points nearest to \a x, \a y
+     * whose squared distance does not exceed \a maxDistanceSquared.
+     */
+    void neighbors( double x, double y, int maxCount, double maxDistanceSquared, std::vector< std::pair< double, const vertexData * > > &result ) const
+    {
+      result.clear();
+      search( 0, mPoints.size(), 0, x, y, static_cast< std::size_t >( maxCount ), maxDistanceSquared, result );
+    }
+
+  private:
+
+    typedef std::pair< double, const vertexData * > Neighbor;
+
+    static bool compareNeighbor( const Neighbor &a, const Neighbor &b ) { return a.first < b.first; }
+
+    void build( std::size_t begin, std::size_t end, int depth )
+    {
+      if ( end - begin <= 1 )
+        return;
+
+      const std::size_t mid = begin + ( end - begin ) / 2;
+      if ( depth % 2 == 0 )
+        std::nth_element( mPoints.begin() + begin, mPoints.begin() + mid, mPoints.begin() + end, []( const vertexData & a, const vertexData & b ) { return a.x < b.x; } );
+      else
+        std::nth_element( mPoints.begin() + begin, mPoints.begin() + mid, mPoints.begin() + end, []( const vertexData & a, const vertexData & b ) { return a.y < b.y; } );
+
+      build( begin, mid, depth + 1 );
+      build( mid + 1, end, depth + 1 );
+    }
+
+    void search( std::size_t begin, std::size_t end, int depth, double x, double y, std::size_t maxCount, double maxDistanceSquared, std::vector< Neighbor > &result ) const
+    {
+      if ( begin >= end )
+        return;
+
+      const std::size_t mid = begin + ( end - begin ) / 2;
+      const vertexData &p = mPoints[ mid ];
+      const double dx = p.x - x;
+      const double dy = p.y - y;
+      const double distanceSquared = dx * dx + dy * dy;
+
+      // result is a max heap of the nearest points found so far
+      if ( distanceSquared <= maxDistanceSquared && ( maxCount == 0 || result.size() < maxCount || distanceSquared < result.front().first ) )
+      {
+        if ( maxCount > 0 && result.size() == maxCount )
+        {
+          std::pop_heap( result.begin(), result.end(), compareNeighbor );
+          result.pop_back();
+        }
+        result.push_back( Neighbor( distanceSquared, &p ) );
+        std::push_heap( result.begin(), result.end(), compareNeighbor );
+      }
+
+      const double diff = depth % 2 == 0 ? x - p.x : y - p.y;
+      const bool lowerFirst = diff < 0;
+      search( lowerFirst ? begin : mid + 1, lowerFirst ? mid : end, depth + 1, x, y, maxCount, maxDistanceSquared, result );
+
+      // only visit the other side if it may contain closer points
+      double bound = maxDistanceSquared;
+      if ( maxCount > 0 && result.size() == maxCount )
+        bound = std::min( bound, result.front().first );
+      if ( diff * diff <= bound )
+        search( lowerFirst ? mid + 1 : begin, lowerFirst ? end : mid, depth + 1, x, y, maxCount, maxDistanceSquared, result );
+    }
+
+    std::vector< vertexData > mPoints;
+};
+
+///@endcond
 
 QgsIDWInterpolator::QgsIDWInterpolator( const QList<LayerData> &layerData )
   : QgsInterpolator( layerData )
@@ -31,12 +124,32 @@ QgsIDWInterpolator::QgsIDWInterpolator()
 
 }
 
-int QgsIDWInterpolator::interpolatePoint( double x, double y, double &result )
+QgsIDWInterpolator::~QgsIDWInterpolator() = default;
+
+void QgsIDWInterpolator::prepare()
 {
+  if ( mPrepared.loadAcquire() )
+    return;
+
+  QMutexLocker locker( &mPrepareMutex );
+  if ( mPrepared.loadAcquire() )
+    return;
+
   if ( !mDataIsCached )
   {
     cacheBaseData();
   }
+  // without limits all points are used, so a spatial index does not help
+  if ( !mIndex && ( mMaximumNeighbors > 0 || mSearchRadius > 0 ) )
+  {
+    mIndex.reset( new QgsIDWPointIndex( mCachedBaseData ) );
+  }
+  mPrepared.storeRelease( 1 );
+}
+
+int QgsIDWInterpolator::interpolatePoint( double x, double y, double &result )
+{
+  prepare();
 
   double currentWeight;
   double distance;
@@ -44,17 +157,39 @@ int QgsIDWInterpolator::interpolatePoint( double x, double y, double &result )
   double sumCounter = 0;
   double sumDenominator = 0;
 
-  Q_FOREACH ( const vertexData &vertex_it, mCachedBaseData )
+  if ( mMaximumNeighbors <= 0 && mSearchRadius <= 0 )
   {
-    distance = std::sqrt( ( vertex_it.x - x ) * ( vertex_it.x - x ) + ( vertex_it.y - y ) * ( vertex_it.y - y ) );
-    if ( ( distance - 0 ) < std::numeric_limits<double>::min() )
+    for ( const vertexData &vertex_it : qgsAsConst( mCachedBaseData ) )
+    {
+      distance = std::sqrt( ( vertex_it.x - x ) * ( vertex_it.x - x ) + ( vertex_it.y - y ) * ( vertex_it.y - y ) );
+      if ( ( distance - 0 ) < std::numeric_limits<double>::min() )
+      {
+        result = vertex_it.z;
+        return 0;
+      }
+      currentWeight = 1 / ( std::pow( distance, mDistanceCoefficient ) );
+      sumCounter += ( currentWeight * vertex_it.z );
+      sumDenominator += currentWeight;
+    }
+  }
+  else
+  {
+    const double maxDistanceSquared = mSearchRadius > 0 ? mSearchRadius * mSearchRadius : std::numeric_limits<double>::infinity();
+    std::vector< std::pair< double, const vertexData * > > neighbors;
+    mIndex->neighbors( x, y, mMaximumNeighbors, maxDistanceSquared, neighbors );
+
+    for ( const std::pair< double, const vertexData * > &neighbor : neighbors )
     {
-      result = vertex_it.z;
-      return 0;
+      distance = std::sqrt( neighbor.first );
+      if ( ( distance - 0 ) < std::numeric_limits<double>::min() )
+      {
+        result = neighbor.second->z;
+        return 0;
+      }
+      currentWeight = 1 / ( std::pow( distance, mDistanceCoefficient ) );
+      sumCounter += ( currentWeight * neighbor.second->z );
+      sumDenominator += currentWeight;
     }
-    currentWeight = 1 / ( std::pow( distance, mDistanceCoefficient ) );
-    sumCounter += ( currentWeight * vertex_it.z );
-    sumDenominator += currentWeight;
   }
 
   if ( sumDenominator == 0.0 )
@@ -21,6 +21,12 @@
 #include "qgsinterpolator.h"
 #include "qgis_analysis.h"
 
+#include <QMutex>
+#include <QAtomicInt>
+#include <memory>
+
+class QgsIDWPointIndex;
+
 /** \ingroup analysis
  * \class QgsIDWInterpolator
  */
@@ -29,6 +35,13 @@ class ANALYSIS_EXPORT QgsIDWInterpolator: public QgsInterpolator
   public:
     QgsIDWInterpolator( const QList<QgsInterpolator::LayerData> &layerData );
 
+    ~QgsIDWInterpolator();
+
+    //! QgsIDWInterpolator cannot be copied.
+    QgsIDWInterpolator( const QgsIDWInterpolator &rh ) = delete;
+    //! QgsIDWInterpolator cannot be copied.
+    QgsIDWInterpolator &operator=( const QgsIDWInterpolator &rh ) = delete;
+
     /** Calculates interpolation value for map coordinates x, y
        \param x x-coordinate (in map units)
        \param y y-coordinate (in map units)
@@ -38,14 +51,69 @@ class ANALYSIS_EXPORT QgsIDWInterpolator: public QgsInterpolator
 
     void setDistanceCoefficient( double p ) {mDistanceCoefficient = p;}
 
+    /**
+     * Sets the maximum number of nearest sample points used to interpolate each point.
+     * A value of 0 (the default) means that all sample points are used.
+     *
+     * Limiting the number of neighbors considerably speeds up interpolation of
+     * large data sets, as the nearest points are found using a spatial index.
+     * \see maximumNeighbors()
+     * \see setSearchRadius()
+     * \since QGIS 3.0
+     */
+    void setMaximumNeighbors( int neighbors ) { mMaximumNeighbors = neighbors; mPrepared.storeRelease( 0 ); }
+
+    /**
+     * Returns the maximum number of nearest sample points used to interpolate each point,
+     * or 0 if all sample points are used.
+     * \see setMaximumNeighbors()
+     * \since QGIS 3.0
+     */
+    int maximumNeighbors() const { return mMaximumNeighbors; }
+
+    /**
+     * Sets the search \a radius (in map units) around each interpolated point. Only
+     * sample points within this radius are used, and points without any sample within
+     * the radius cannot be interpolated. A value of 0 (the default) means that the
+     * search radius is unlimited.
+     * \see searchRadius()
+     * \see setMaximumNeighbors()
+     * \since QGIS 3.0
+     */
+    void setSearchRadius( double radius ) { mSearchRadius = radius; mPrepared.storeRelease( 0 ); }
+
+    /**
+     * Returns the search radius (in map units) around each interpolated point, or 0
+     * if the search radius is unlimited.
+     * \see setSearchRadius()
+     * \since QGIS 3.0
+     */
+    double searchRadius() const { return mSearchRadius; }
+
+    bool supportsConcurrentInterpolation() const override { return true; }
+
   private:
 
     QgsIDWInterpolator(); //forbidden
 
+#ifdef SIP_RUN
+    QgsIDWInterpolator( const QgsIDWInterpolator &rh );
+#endif
+
+    //! Caches the base data and builds the spatial index if neighbors are limited, if not done yet
+    void prepare();
+
     /** The parameter that sets how the values are weighted with distance.
        Smaller values mean sharper peaks at the data points. The default is a
        value of 2*/
     double mDistanceCoefficient = 2.0;
+
+    int mMaximumNeighbors = 0;
+    double mSearchRadius = 0.0;
+
+    std::unique_ptr< QgsIDWPointIndex > mIndex;
+    QMutex mPrepareMutex;
+    QAtomicInt mPrepared;
 };
 
 #endif
@@ -67,6 +67,14 @@ class ANALYSIS_EXPORT QgsInterpolator
        \returns 0 in case of success*/
     virtual int interpolatePoint( double x, double y, double &result ) = 0;
 
+    /**
+     * Returns true if interpolatePoint() can safely be called from multiple threads
+     * at the same time. Interpolators which return true allow QgsGridFileWriter to
+     * interpolate rows in parallel.
+     * \since QGIS 3.0
+     */
+    virtual bool supportsConcurrentInterpolation() const { return false; }
+
     //! \note not available in Python bindings
     QList<LayerData> layerData() const { return mLayerData; } SIP_SKIP
 
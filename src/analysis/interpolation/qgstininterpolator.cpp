@@ -28,6 +28,47 @@
 #include "qgsvectorlayer.h"
 #include "qgswkbptr.h"
 #include "qgsfeedback.h"
+#include "MathUtils.h"
+
+#include <algorithm>
+#include <random>
+
+///@cond PRIVATE
+
+//! Number of cells of the grid the Hilbert curve is calculated on, in each direction
+static const quint32 HILBERT_GRID_SIZE = 1 << 16;
+
+//! Size of the first round of points inserted into the triangulation
+static const int MIN_INSERTION_ROUND_SIZE = 64;
+
+//! Minimum number of collected points to sort them, fewer points are inserted in their original order
+static const int MIN_SORTED_INSERTION_POINTS = 1000;
+
+//! Returns the position of the grid cell \a x, \a y along a Hilbert curve
+static quint64 hilbertIndex( quint32 x, quint32 y )
+{
+  quint64 index = 0;
+  for ( quint32 s = HILBERT_GRID_SIZE / 2; s > 0; s /= 2 )
+  {
+    const quint32 rx = ( x & s ) > 0;
+    const quint32 ry = ( y & s ) > 0;
+    index += static_cast< quint64 >( s ) * s * ( ( 3 * rx ) ^ ry );
+
+    // rotate the quadrant, so that the curve continues within it
+    if ( ry == 0 )
+    {
+      if ( rx == 1 )
+      {
+        x = HILBERT_GRID_SIZE - 1 - x;
+        y = HILBERT_GRID_SIZE - 1 - y;
+      }
+      std::swap( x, y );
+    }
+  }
+  return index;
+}
+
+///@endcond
 
 QgsTINInterpolator::QgsTINInterpolator( const QList<LayerData> &inputData, TINInterpolation interpolation, QgsFeedback *feedback )
   : QgsInterpolator( inputData )
@@ -41,6 +82,7 @@ QgsTINInterpolator::~QgsTINInterpolator()
 {
   delete mTriangulation;
   delete mTriangleInterpolator;
+  qDeleteAll( mCollectedPoints );
 }
 
 int QgsTINInterpolator::interpolatePoint( double x, double y, double &result )
@@ -131,6 +173,7 @@ void QgsTINInterpolator::initialize()
       }
     }
   }
+  addCollectedPoints();
 
   if ( mInterpolation == CloughTocher )
   {
@@ -215,11 +258,7 @@ int QgsTINInterpolator::insertData( QgsFeature *f, bool zCoord, int attr, InputT
       {
         z = attributeValue;
       }
-      QgsPoint *point = new QgsPoint( x, y, z );
-      if ( mTriangulation->addPoint( point ) == -100 )
-      {
-        return -1;
-      }
+      mCollectedPoints << new QgsPoint( x, y, z );
       break;
     }
     case QgsWkbTypes::MultiPoint25D:
@@ -269,8 +308,7 @@ int QgsTINInterpolator::insertData( QgsFeature *f, bool zCoord, int attr, InputT
 
         if ( type == POINTS )
         {
-          //todo: handle error code -100
-          mTriangulation->addPoint( new QgsPoint( x, y, z ) );
+          mCollectedPoints << new QgsPoint( x, y, z );
         }
         else
         {
@@ -280,6 +318,7 @@ int QgsTINInterpolator::insertData( QgsFeature *f, bool zCoord, int attr, InputT
 
       if ( type != POINTS )
       {
+        addCollectedPoints();
         mTriangulation->addLine( line, type == BREAK_LINES );
       }
       break;
@@ -313,8 +352,7 @@ int QgsTINInterpolator::insertData( QgsFeature *f, bool zCoord, int attr, InputT
 
           if ( type == POINTS )
           {
-            //todo: handle error code -100
-            mTriangulation->addPoint( new QgsPoint( x, y, z ) );
+            mCollectedPoints << new QgsPoint( x, y, z );
           }
           else
           {
@@ -323,6 +361,7 @@ int QgsTINInterpolator::insertData( QgsFeature *f, bool zCoord, int attr, InputT
         }
         if ( type != POINTS )
         {
+          addCollectedPoints();
           mTriangulation->addLine( line, type == BREAK_LINES );
         }
       }
@@ -357,8 +396,7 @@ int QgsTINInterpolator::insertData( QgsFeature *f, bool zCoord, int attr, InputT
           }
           if ( type == POINTS )
           {
-            //todo: handle error code -100
-            mTriangulation->addPoint( new QgsPoint( x, y, z ) );
+            mCollectedPoints << new QgsPoint( x, y, z );
           }
           else
           {
@@ -368,6 +406,7 @@ int QgsTINInterpolator::insertData( QgsFeature *f, bool zCoord, int attr, InputT
 
         if ( type != POINTS )
         {
+          addCollectedPoints();
           mTriangulation->addLine( line, type == BREAK_LINES );
         }
       }
@@ -407,8 +446,7 @@ int QgsTINInterpolator::insertData( QgsFeature *f, bool zCoord, int attr, InputT
             }
             if ( type == POINTS )
             {
-              //todo: handle error code -100
-              mTriangulation->addPoint( new QgsPoint( x, y, z ) );
+              mCollectedPoints << new QgsPoint( x, y, z );
             }
             else
             {
@@ -417,6 +455,7 @@ int QgsTINInterpolator::insertData( QgsFeature *f, bool zCoord, int attr, InputT
           }
           if ( type != POINTS )
           {
+            addCollectedPoints();
             mTriangulation->addLine( line, type == BREAK_LINES );
           }
         }
@@ -431,3 +470,108 @@ int QgsTINInterpolator::insertData( QgsFeature *f, bool zCoord, int attr, InputT
   return 0;
 }
 
+
+void QgsTINInterpolator::addCollectedPoints()
+{
+  if ( mFeedback && mFeedback->isCanceled() )
+  {
+    qDeleteAll( mCollectedPoints );
+    mCollectedPoints.clear();
+    return;
+  }
+
+  if ( mCollectedPoints.size() < MIN_SORTED_INSERTION_POINTS )
+  {
+    for ( QgsPoint *point : qgsAsConst( mCollectedPoints ) )
+    {
+      mTriangulation->addPoint( point );
+    }
+    mCollectedPoints.clear();
+    return;
+  }
+
+  double xMin = mCollectedPoints.at( 0 )->x();
+  double xMax = xMin;
+  double yMin = mCollectedPoints.at( 0 )->y();
+  double yMax = yMin;
+  for ( const QgsPoint *point : qgsAsConst( mCollectedPoints ) )
+  {
+    xMin = std::min( xMin, point->x() );
+    xMax = std::max( xMax, point->x() );
+    yMin = std::min( yMin, point->y() );
+    yMax = std::max( yMax, point->y() );
+  }
+  const double scaleX = xMax > xMin ? ( HILBERT_GRID_SIZE - 1 ) / ( xMax - xMin ) : 0;
+  const double scaleY = yMax > yMin ? ( HILBERT_GRID_SIZE - 1 ) / ( yMax - yMin ) : 0;
+
+  QVector< QPair< quint64, QgsPoint * > > points;
+  points.reserve( mCollectedPoints.size() );
+  for ( QgsPoint *point : qgsAsConst( mCollectedPoints ) )
+  {
+    const quint32 x = static_cast< quint32 >( ( point->x() - xMin ) * scaleX );
+    const quint32 y = static_cast< quint32 >( ( point->y() - yMin ) * scaleY );
+    points << qMakePair( hilbertIndex( x, y ), point );
+  }
+  mCollectedPoints.clear();
+
+  // biased randomized insertion order: the shuffled points are split into rounds, each about twice
+  // as large as the previous one. The fixed seed keeps the triangulation reproducible.
+  std::mt19937 generator( 1 );
+  std::shuffle( points.begin(), points.end(), generator );
+  QVector< int > roundEnds;
+  int roundEnd = points.size();
+  while ( roundEnd > 0 )
+  {
+    const int roundBegin = roundEnd / 2 >= MIN_INSERTION_ROUND_SIZE ? roundEnd / 2 : 0;
+    std::sort( points.begin() + roundBegin, points.begin() + roundEnd, []( const QPair< quint64, QgsPoint * > &a, const QPair< quint64, QgsPoint * > &b )
+    {
+      return a.first < b.first;
+    } );
+    roundEnds.prepend( roundEnd );
+    roundEnd = roundBegin;
+  }
+
+  // the first three points of the triangulation must not be on a line
+  if ( mTriangulation->getNumberOfPoints() == 0 )
+  {
+    for ( int i = 1; i < points.size(); ++i )
+    {
+      if ( points.at( i ).second->x() != points.at( 0 ).second->x() || points.at( i ).second->y() != points.at( 0 ).second->y() )
+      {
+        std::rotate( points.begin() + 1, points.begin() + i, points.begin() + i + 1 );
+        break;
+      }
+    }
+    for ( int i = 2; i < points.size(); ++i )
+    {
+      if ( std::fabs( MathUtils::leftOf( points.at( i ).second, points.at( 0 ).second, points.at( 1 ).second ) ) > 0.00000001 )
+      {
+        std::rotate( points.begin() + 2, points.begin() + i, points.begin() + i + 1 );
+        break;
+      }
+    }
+  }
+
+  int nInserted = 0;
+  for ( int end : qgsAsConst( roundEnds ) )
+  {
+    for ( ; nInserted < end; ++nInserted )
+    {
+      mTriangulation->addPoint( points.at( nInserted ).second );
+    }
+
+    if ( mFeedback )
+    {
+      if ( mFeedback->isCanceled() )
+      {
+        // the triangulation only owns the points which have been inserted
+        for ( int i = nInserted; i < points.size(); ++i )
+        {
+          delete points.at( i ).second;
+        }
+        return;
+      }
+      mFeedback->setProgress( 100.0 * static_cast< double >( nInserted ) / points.size() );
+    }
+  }
+}
@@ -20,6 +20,7 @@
 
 #include "qgsinterpolator.h"
 #include <QString>
+#include <QVector>
 #include "qgis_analysis.h"
 
 class QgsFeatureSink;
@@ -28,6 +29,7 @@ class TriangleInterpolator;
 class QgsFeature;
 class QgsFeedback;
 class QgsFields;
+class QgsPoint;
 
 /** \ingroup analysis
  *  Interpolation in a triangular irregular network*/
@@ -86,6 +88,8 @@ class ANALYSIS_EXPORT QgsTINInterpolator: public QgsInterpolator
     QgsFeatureSink *mTriangulationSink = nullptr;
     //! Type of interpolation
     TINInterpolation mInterpolation;
+    //! Points collected by insertData(), which are added to the triangulation by addCollectedPoints()
+    QVector< QgsPoint * > mCollectedPoints;
 
     //! Create dual edge triangulation
     void initialize();
@@ -95,8 +99,15 @@ class ANALYSIS_EXPORT QgsTINInterpolator: public QgsInterpolator
       \param zCoord true if the z coordinate is the interpolation attribute
       \param attr interpolation attribute index (if zCoord is false)
       \param type point/structure line, break line
-      \returns 0 in case of success, -1 if the feature could not be inserted because of numerical problems*/
+      \returns 0 in case of success*/
     int insertData( QgsFeature *f, bool zCoord, int attr, InputType type );
+
+    /**
+     * Adds the collected points to the triangulation. Larger sets of points are inserted in rounds of
+     * growing size, each sorted along a Hilbert curve, so that the triangulation can find the triangle
+     * of a point by walking from the triangle of the previous one.
+     */
+    void addCollectedPoints();
 };
 
 #endif
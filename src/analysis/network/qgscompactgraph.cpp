@@ -0,0 +1,278 @@
+/***************************************************************************
+  qgscompactgraph.cpp
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS contributors
+****************************************************************************
+*                                                                          *
+*   This program is free software; you can redistribute it and/or modify   *
+*   it under the terms of the GNU General Public License as published by   *
+*   the Free Software Foundation; either version 2 of the License, or      *
+*   (at your option) any later version.                                    *
+*                                                                          *
+***************************************************************************/
+
+#include <algorithm>
+#include <limits>
+
+#include "qgscompactgraph.h"
+#include "qgsgraph.h"
+
+///@cond PRIVATE
+
+QgsGraphVertexHeap::QgsGraphVertexHeap( int vertexCount )
+  : mPositions( std::max( vertexCount, 0 ), -1 )
+{
+}
+
+void QgsGraphVertexHeap::push( int vertex, double cost )
+{
+  int pos = mPositions[ vertex ];
+  if ( pos < 0 )
+  {
+    mHeap.push_back( Entry{ cost, vertex } );
+    mPositions[ vertex ] = mHeap.size() - 1;
+    siftUp( mHeap.size() - 1 );
+  }
+  else if ( cost < mHeap[ pos ].cost )
+  {
+    mHeap[ pos ].cost = cost;
+    siftUp( pos );
+  }
+}
+
+int QgsGraphVertexHeap::pop( double &cost )
+{
+  Entry top = mHeap.front();
+  cost = top.cost;
+  mPositions[ top.vertex ] = -1;
+
+  Entry last = mHeap.back();
+  mHeap.pop_back();
+  if ( !mHeap.empty() )
+  {
+    mHeap[ 0 ] = last;
+    mPositions[ last.vertex ] = 0;
+    siftDown( 0 );
+  }
+  return top.vertex;
+}
+
+void QgsGraphVertexHeap::clear()
+{
+  for ( const Entry &e : mHeap )
+    mPositions[ e.vertex ] = -1;
+  mHeap.clear();
+}
+
+void QgsGraphVertexHeap::siftUp( std::size_t idx )
+{
+  Entry e = mHeap[ idx ];
+  while ( idx > 0 )
+  {
+    std::size_t parent = ( idx - 1 ) / 2;
+    if ( mHeap[ parent ].cost <= e.cost )
+      break;
+    mHeap[ idx ] = mHeap[ parent ];
+    mPositions[ mHeap[ idx ].vertex ] = idx;
+    idx = parent;
+  }
+  mHeap[ idx ] = e;
+  mPositions[ e.vertex ] = idx;
+}
+
+void QgsGraphVertexHeap::siftDown( std::size_t idx )
+{
+  Entry e = mHeap[ idx ];
+  const std::size_t size = mHeap.size();
+  while ( true )
+  {
+    std::size_t child = 2 * idx + 1;
+    if ( child >= size )
+      break;
+    if ( child + 1 < size && mHeap[ child + 1 ].cost < mHeap[ child ].cost )
+      ++child;
+    if ( e.cost <= mHeap[ child ].cost )
+      break;
+    mHeap[ idx ] = mHeap[ child ];
+    mPositions[ mHeap[ idx ].vertex ] = idx;
+    idx = child;
+  }
+  mHeap[ idx ] = e;
+  mPositions[ e.vertex ] = idx;
+}
+
+///@endcond
+
+QgsCompactGraph::QgsCompactGraph( const QgsGraph &graph, int criterionNum )
+{
+  const int vertexCount = graph.vertexCount();
+  const int edgeCount = graph.edgeCount();
+
+  mOutOffsets.fill( 0, vertexCount + 1 );
+  mInOffsets.fill( 0, vertexCount + 1 );
+
+  QVector< double > costs( edgeCount );
+  for ( int i = 0; i < edgeCount; ++i )
+  {
+    const QgsGraphEdge &edge = graph.edge( i );
+    costs[ i ] = edge.cost( criterionNum ).toDouble();
+    mOutOffsets[ edge.outVertex() + 1 ]++;
+    mInOffsets[ edge.inVertex() + 1 ]++;
+  }
+  for ( int v = 0; v < vertexCount; ++v )
+  {
+    mOutOffsets[ v + 1 ] += mOutOffsets[ v ];
+    mInOffsets[ v + 1 ] += mInOffsets[ v ];
+  }
+
+  mOutTargets.resize( edgeCount );
+  mOutCosts.resize( edgeCount );
+  mOutEdgeIds.resize( edgeCount );
+  mInSources.resize( edgeCount );
+  mInCosts.resize( edgeCount );
+  mInEdgeIds.resize( edgeCount );
+
+  QVector< int > outFill = mOutOffsets;
+  QVector< int > inFill = mInOffsets;
+  for ( int i = 0; i < edgeCount; ++i )
+  {
+    const QgsGraphEdge &edge = graph.edge( i );
+    int pos = outFill[ edge.outVertex() ]++;
+    mOutTargets[ pos ] = edge.inVertex();
+    mOutCosts[ pos ] = costs.at( i );
+    mOutEdgeIds[ pos ] = i;
+
+    pos = inFill[ edge.inVertex() ]++;
+    mInSources[ pos ] = edge.outVertex();
+    mInCosts[ pos ] = costs.at( i );
+    mInEdgeIds[ pos ] = i;
+  }
+}
+
+void QgsCompactGraph::dijkstra( int startVertexIdx, QVector<int> *resultTree, QVector<double> *resultCost ) const
+{
+  const int count = vertexCount();
+  QVector< double > localCost;
+  QVector< double > &cost = resultCost ? *resultCost : localCost;
+  cost.fill( std::numeric_limits<double>::infinity(), count );
+  if ( resultTree )
+    resultTree->fill( -1, count );
+
+  if ( startVertexIdx < 0 || startVertexIdx >= count )
+    return;
+
+  // use raw pointers, avoiding repeated detach checks on the hot path
+  double *costData = cost.data();
+  int *treeData = resultTree ? resultTree->data() : nullptr;
+  const int *offsets = mOutOffsets.constData();
+  const int *targets = mOutTargets.constData();
+  const double *edgeCosts = mOutCosts.constData();
+  const int *edgeIds = mOutEdgeIds.constData();
+
+  QgsGraphVertexHeap heap( count );
+  costData[ startVertexIdx ] = 0.0;
+  heap.push( startVertexIdx, 0.0 );
+
+  while ( !heap.isEmpty() )
+  {
+    double curCost = 0;
+    int curVertex = heap.pop( curCost );
+
+    for ( int e = offsets[ curVertex ]; e < offsets[ curVertex + 1 ]; ++e )
+    {
+      const int target = targets[ e ];
+      const double newCost = curCost + edgeCosts[ e ];
+      if ( newCost < costData[ target ] )
+      {
+        costData[ target ] = newCost;
+        if ( treeData )
+          treeData[ target ] = edgeIds[ e ];
+        heap.push( target, newCost );
+      }
+    }
+  }
+}
+
+double QgsCompactGraph::shortestPath( int startVertexIdx, int endVertexIdx, QVector<int> *route ) const
+{
+  const double inf = std::numeric_limits<double>::infinity();
+  const int count = vertexCount();
+  if ( route )
+    route->clear();
+
+  if ( startVertexIdx < 0 || startVertexIdx >= count || endVertexIdx < 0 || endVertexIdx >= count )
+    return inf;
+  if ( startVertexIdx == endVertexIdx )
+    return 0.0;
+
+  // forward search from the start over outgoing edges, backward search from the end over incoming edges
+  QVector< double > costForward( count, inf );
+  QVector< double > costBackward( count, inf );
+  QVector< int > edgeForward( count, -1 );
+  QVector< int > edgeBackward( count, -1 );
+  QVector< int > prevForward( count, -1 );
+  QVector< int > prevBackward( count, -1 );
+  QgsGraphVertexHeap heapForward( count );
+  QgsGraphVertexHeap heapBackward( count );
+
+  costForward[ startVertexIdx ] = 0.0;
+  costBackward[ endVertexIdx ] = 0.0;
+  heapForward.push( startVertexIdx, 0.0 );
+  heapBackward.push( endVertexIdx, 0.0 );
+
+  double best = inf;
+  int meetingVertex = -1;
+
+  while ( !heapForward.isEmpty() || !heapBackward.isEmpty() )
+  {
+    const double minForward = heapForward.isEmpty() ? inf : heapForward.minCost();
+    const double minBackward = heapBackward.isEmpty() ? inf : heapBackward.minCost();
+    // no shorter path can be found once the two search radii together exceed the best path
+    if ( minForward + minBackward >= best )
+      break;
+
+    const bool forward = minForward <= minBackward;
+    QgsGraphVertexHeap &heap = forward ? heapForward : heapBackward;
+    QVector< double > &cost = forward ? costForward : costBackward;
+    const QVector< double > &otherCost = forward ? costBackward : costForward;
+    QVector< int > &edge = forward ? edgeForward : edgeBackward;
+    QVector< int > &prev = forward ? prevForward : prevBackward;
+    const QVector< int > &offsets = forward ? mOutOffsets : mInOffsets;
+    const QVector< int > &neighbors = forward ? mOutTargets : mInSources;
+    const QVector< double > &edgeCosts = forward ? mOutCosts : mInCosts;
+    const QVector< int > &edgeIds = forward ? mOutEdgeIds : mInEdgeIds;
+
+    double curCost = 0;
+    const int curVertex = heap.pop( curCost );
+
+    for ( int e = offsets.at( curVertex ); e < offsets.at( curVertex + 1 ); ++e )
+    {
+      const int next = neighbors.at( e );
+      const double newCost = curCost + edgeCosts.at( e );
+      if ( newCost < cost.at( next ) )
+      {
+        cost[ next ] = newCost;
+        edge[ next ] = edgeIds.at( e );
+        prev[ next ] = curVertex;
+        heap.push( next, newCost );
+      }
+      if ( newCost + otherCost.at( next ) < best )
+      {
+        best = newCost + otherCost.at( next );
+        meetingVertex = next;
+      }
+    }
+  }
+
+  if ( route && meetingVertex >= 0 )
+  {
+    for ( int v = meetingVertex; v != startVertexIdx; v = prevForward.at( v ) )
+      route->append( edgeForward.at( v ) );
+    std::reverse( route->begin(), route->end() );
+    for ( int v = meetingVertex; v != endVertexIdx; v = prevBackward.at( v ) )
+      route->append( edgeBackward.at( v ) );
+  }
+
+  return best;
+}
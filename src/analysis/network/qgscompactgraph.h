@@ -0,0 +1,153 @@
+/***************************************************************************
+  qgscompactgraph.h
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS contributors
+****************************************************************************
+*                                                                          *
+*   This program is free software; you can redistribute it and/or modify   *
+*   it under the terms of the GNU General Public License as published by   *
+*   the Free Software Foundation; either version 2 of the License, or      *
+*   (at your option) any later version.                                    *
+*                                                                          *
+***************************************************************************/
+
+#ifndef QGSCOMPACTGRAPH_H
+#define QGSCOMPACTGRAPH_H
+
+#define SIP_NO_FILE
+
+#include <QVector>
+#include <vector>
+
+#include "qgis_analysis.h"
+
+class QgsGraph;
+
+///@cond PRIVATE
+
+/**
+ * \ingroup analysis
+ * Binary min-heap of graph vertices keyed by cost, supporting decrease-key.
+ *
+ * The heap keeps the position of every vertex, so clear() only resets vertices
+ * which have been touched since the last clear. This makes it cheap to reuse
+ * a single heap for many searches on a large graph.
+ * \note not available in Python bindings
+ * \since QGIS 3.0
+ */
+class ANALYSIS_EXPORT QgsGraphVertexHeap
+{
+  public:
+
+    //! Constructor for a heap able to hold vertices 0 to \a vertexCount - 1
+    explicit QgsGraphVertexHeap( int vertexCount );
+
+    //! Returns true if the heap is empty
+    bool isEmpty() const { return mHeap.empty(); }
+
+    //! Returns the smallest cost in the heap. The heap must not be empty.
+    double minCost() const { return mHeap.front().cost; }
+
+    /**
+     * Inserts \a vertex with \a cost, or lowers the cost of \a vertex if it
+     * is already in the heap with a higher cost.
+     */
+    void push( int vertex, double cost );
+
+    //! Removes the vertex with the smallest cost from the heap, returning it and its \a cost
+    int pop( double &cost );
+
+    //! Removes all vertices from the heap
+    void clear();
+
+  private:
+
+    struct Entry
+    {
+      double cost;
+      int vertex;
+    };
+
+    void siftUp( std::size_t idx );
+    void siftDown( std::size_t idx );
+
+    std::vector< Entry > mHeap;
+    //! Position of each vertex in mHeap, -1 if not contained
+    std::vector< int > mPositions;
+};
+
+///@endcond
+
+/**
+ * \ingroup analysis
+ * \class QgsCompactGraph
+ * \brief Compact, read-only representation of a QgsGraph for fast shortest path searches.
+ *
+ * The edges of a single cost strategy are stored in compressed sparse row arrays
+ * (edge targets and costs as contiguous vectors, indexed by per-vertex offsets),
+ * for both outgoing and incoming edges. This avoids the QVariant conversions and
+ * scattered memory accesses of searching a QgsGraph directly.
+ *
+ * Vertex and edge indices are the same as in the source QgsGraph. Edge costs must not be negative.
+ *
+ * \see QgsGraphAnalyzer
+ * \see QgsGraphContractionHierarchy
+ * \note not available in Python bindings
+ * \since QGIS 3.0
+ */
+class ANALYSIS_EXPORT QgsCompactGraph
+{
+  public:
+
+    /**
+     * Constructor for QgsCompactGraph, using the edge costs of the strategy
+     * with index \a criterionNum of the \a graph.
+     */
+    QgsCompactGraph( const QgsGraph &graph, int criterionNum );
+
+    //! Returns number of graph vertices
+    int vertexCount() const { return mOutOffsets.size() - 1; }
+
+    //! Returns number of graph edges
+    int edgeCount() const { return mOutTargets.size(); }
+
+    /**
+     * Solves the one-to-all shortest path problem from the vertex \a startVertexIdx.
+     *
+     * \param startVertexIdx index of the start vertex
+     * \param resultTree array that represents shortest path tree. resultTree[ vertexIndex ] == inboundingArcIndex if vertex reachable, otherwise resultTree[ vertexIndex ] == -1
+     * \param resultCost array of the paths costs, infinity for unreachable vertices
+     * \see QgsGraphAnalyzer::dijkstra()
+     */
+    void dijkstra( int startVertexIdx, QVector<int> *resultTree = nullptr, QVector<double> *resultCost = nullptr ) const;
+
+    /**
+     * Finds the shortest path between the vertices \a startVertexIdx and \a endVertexIdx,
+     * using a bidirectional search which only explores the vertices around both ends.
+     *
+     * \param startVertexIdx index of the start vertex
+     * \param endVertexIdx index of the end vertex
+     * \param route if specified, will be set to the indices of the edges along the path, in order
+     * \returns cost of the shortest path, or infinity if the end vertex is not reachable
+     */
+    double shortestPath( int startVertexIdx, int endVertexIdx, QVector<int> *route = nullptr ) const;
+
+  private:
+
+    //! Index of the first outgoing edge of each vertex in the out arrays (plus end marker)
+    QVector< int > mOutOffsets;
+    QVector< int > mOutTargets;
+    QVector< double > mOutCosts;
+    QVector< int > mOutEdgeIds;
+
+    //! Index of the first incoming edge of each vertex in the in arrays (plus end marker)
+    QVector< int > mInOffsets;
+    QVector< int > mInSources;
+    QVector< double > mInCosts;
+    QVector< int > mInEdgeIds;
+
+    friend class QgsGraphContractionHierarchy;
+};
+
+#endif // QGSCOMPACTGRAPH_H
@@ -13,9 +13,11 @@
 *                                                                          *
 ***************************************************************************/
 
+#include <functional>
 #include <limits>
+#include <queue>
+#include <vector>
 
-#include <QMap>
 #include <QVector>
 #include <QPair>
 
@@ -44,19 +46,21 @@ void QgsGraphAnalyzer::dijkstra( const QgsGraph *source, int startPointIdx, int
     resultTree->insert( resultTree->begin(), source->vertexCount(), -1 );
   }
 
-  // QMultiMap< cost, vertexIdx > not_begin
-  // I use it and don't create any struct or class
-  QMultiMap< double, int > not_begin;
-  QMultiMap< double, int >::iterator it;
+  // binary heap of ( cost, vertexIdx ). Vertices are pushed again when their cost
+  // decreases, and stale entries are skipped when popped
+  typedef QPair< double, int > QueueEntry;
+  std::priority_queue< QueueEntry, std::vector< QueueEntry >, std::greater< QueueEntry > > not_begin;
 
-  not_begin.insert( 0.0, startPointIdx );
+  not_begin.push( QueueEntry( 0.0, startPointIdx ) );
 
   while ( !not_begin.empty() )
   {
-    it = not_begin.begin();
-    double curCost = it.key();
-    int curVertex = it.value();
-    not_begin.erase( it );
+    const QueueEntry top = not_begin.top();
+    not_begin.pop();
+    double curCost = top.first;
+    int curVertex = top.second;
+    if ( curCost > ( *result )[ curVertex ] )
+      continue;
 
     // edge index list
     QgsGraphEdgeIds l = source->vertex( curVertex ).outEdges();
@@ -73,7 +77,7 @@ void QgsGraphAnalyzer::dijkstra( const QgsGraph *source, int startPointIdx, int
         {
           ( *resultTree )[ arc.inVertex()] = *arcIt;
         }
-        not_begin.insert( cost, arc.inVertex() );
+        not_begin.push( QueueEntry( cost, arc.inVertex() ) );
       }
     }
   }
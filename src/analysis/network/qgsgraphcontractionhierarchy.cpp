@@ -0,0 +1,395 @@
+/***************************************************************************
+  qgsgraphcontractionhierarchy.cpp
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS contributors
+****************************************************************************
+*                                                                          *
+*   This program is free software; you can redistribute it and/or modify   *
+*   it under the terms of the GNU General Public License as published by   *
+*   the Free Software Foundation; either version 2 of the License, or      *
+*   (at your option) any later version.                                    *
+*                                                                          *
+***************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+#include <vector>
+
+#include <QPair>
+
+#include "qgis.h"
+#include "qgsgraphcontractionhierarchy.h"
+#include "qgscompactgraph.h"
+
+///@cond PRIVATE
+
+// Maximum number of vertices settled by a single witness search. Stopping early
+// only results in superfluous shortcuts, never in wrong costs.
+static const int WITNESS_SETTLE_LIMIT = 100;
+
+namespace
+{
+  struct Arc
+  {
+    int vertex;
+    double cost;
+  };
+
+  /**
+   * Mutable adjacency lists of the not yet contracted part of the graph,
+   * used while building the hierarchy.
+   */
+  class ContractionGraph
+  {
+    public:
+
+      ContractionGraph( int vertexCount, const QVector< int > &outOffsets, const QVector< int > &outTargets, const QVector< double > &outCosts )
+        : mOut( vertexCount )
+        , mIn( vertexCount )
+        , mContractedNeighbors( vertexCount, 0 )
+        , mLevel( vertexCount, 0 )
+        , mWitnessCost( vertexCount, std::numeric_limits<double>::infinity() )
+        , mWitnessTarget( vertexCount, -1 )
+        , mHeap( vertexCount )
+      {
+        for ( int v = 0; v < vertexCount; ++v )
+        {
+          for ( int e = outOffsets.at( v ); e < outOffsets.at( v + 1 ); ++e )
+          {
+            if ( outTargets.at( e ) != v )
+              addArc( v, outTargets.at( e ), outCosts.at( e ) );
+          }
+        }
+      }
+
+      //! Adds an arc, or lowers the cost of an existing parallel arc
+      void addArc( int from, int to, double cost )
+      {
+        if ( updateArc( mOut[ from ], to, cost ) )
+          updateArc( mIn[ to ], from, cost );
+        else
+        {
+          mOut[ from ].push_back( Arc{ to, cost } );
+          mIn[ to ].push_back( Arc{ from, cost } );
+        }
+      }
+
+      /**
+       * Collects the shortcuts needed when contracting \a vertex. For each shortcut,
+       * \a shortcutFrom and \a shortcutTo contain its end vertices and its cost.
+       */
+      void shortcuts( int vertex, std::vector< Arc > &shortcutFrom, std::vector< Arc > &shortcutTo )
+      {
+        shortcutFrom.clear();
+        shortcutTo.clear();
+
+        const std::vector< Arc > &inArcs = mIn.at( vertex );
+        const std::vector< Arc > &outArcs = mOut.at( vertex );
+        if ( inArcs.empty() || outArcs.empty() )
+          return;
+
+        double maxOut = 0;
+        for ( const Arc &out : outArcs )
+        {
+          maxOut = std::max( maxOut, out.cost );
+          mWitnessTarget[ out.vertex ] = vertex;
+        }
+
+        for ( const Arc &in : inArcs )
+        {
+          witnessSearch( in.vertex, vertex, in.cost + maxOut, static_cast< int >( outArcs.size() ) );
+          for ( const Arc &out : outArcs )
+          {
+            if ( out.vertex == in.vertex )
+              continue;
+            const double viaCost = in.cost + out.cost;
+            if ( mWitnessCost.at( out.vertex ) > viaCost )
+            {
+              shortcutFrom.push_back( Arc{ in.vertex, viaCost } );
+              shortcutTo.push_back( Arc{ out.vertex, viaCost } );
+            }
+          }
+        }
+      }
+
+      /**
+       * Returns the contraction priority of \a vertex, lower values are contracted first.
+       * The shortcuts needed for contracting the vertex are stored in \a shortcutFrom and \a shortcutTo.
+       */
+      int priority( int vertex, std::vector< Arc > &shortcutFrom, std::vector< Arc > &shortcutTo )
+      {
+        shortcuts( vertex, shortcutFrom, shortcutTo );
+        const int edgeDifference = static_cast< int >( shortcutFrom.size() ) - static_cast< int >( mIn.at( vertex ).size() + mOut.at( vertex ).size() );
+        // prefer vertices which add few shortcuts, and spread the contraction evenly over the graph
+        return 2 * edgeDifference + mContractedNeighbors.at( vertex ) + mLevel.at( vertex );
+      }
+
+      //! Removes \a vertex from the graph, returning its remaining incoming and outgoing arcs
+      void contract( int vertex, std::vector< Arc > &inArcs, std::vector< Arc > &outArcs )
+      {
+        inArcs = mIn[ vertex ];
+        outArcs = mOut[ vertex ];
+        for ( const Arc &in : inArcs )
+        {
+          removeArc( mOut[ in.vertex ], vertex );
+          mContractedNeighbors[ in.vertex ]++;
+          mLevel[ in.vertex ] = std::max( mLevel.at( in.vertex ), mLevel.at( vertex ) + 1 );
+        }
+        for ( const Arc &out : outArcs )
+        {
+          removeArc( mIn[ out.vertex ], vertex );
+          mContractedNeighbors[ out.vertex ]++;
+          mLevel[ out.vertex ] = std::max( mLevel.at( out.vertex ), mLevel.at( vertex ) + 1 );
+        }
+        mIn[ vertex ].clear();
+        mOut[ vertex ].clear();
+      }
+
+    private:
+
+      std::vector< std::vector< Arc > > mOut;
+      std::vector< std::vector< Arc > > mIn;
+      std::vector< int > mContractedNeighbors;
+      //! Depth of each vertex in the hierarchy of contracted vertices below it
+      std::vector< int > mLevel;
+
+      std::vector< double > mWitnessCost;
+      //! Vertex being contracted for which each vertex is a witness search target
+      std::vector< int > mWitnessTarget;
+      std::vector< int > mWitnessTouched;
+      QgsGraphVertexHeap mHeap;
+
+      static bool updateArc( std::vector< Arc > &arcs, int vertex, double cost )
+      {
+        for ( Arc &arc : arcs )
+        {
+          if ( arc.vertex == vertex )
+          {
+            arc.cost = std::min( arc.cost, cost );
+            return true;
+          }
+        }
+        return false;
+      }
+
+      static void removeArc( std::vector< Arc > &arcs, int vertex )
+      {
+        arcs.erase( std::remove_if( arcs.begin(), arcs.end(), [vertex]( const Arc & arc ) { return arc.vertex == vertex; } ), arcs.end() );
+      }
+
+      /**
+       * Bounded Dijkstra search from \a start which avoids \a skipVertex, storing costs in mWitnessCost.
+       * The search stops as soon as all \a targetCount out neighbors of \a skipVertex are settled.
+       */
+      void witnessSearch( int start, int skipVertex, double maxCost, int targetCount )
+      {
+        for ( int v : mWitnessTouched )
+          mWitnessCost[ v ] = std::numeric_limits<double>::infinity();
+        mWitnessTouched.clear();
+        mHeap.clear();
+
+        mWitnessCost[ start ] = 0;
+        mWitnessTouched.push_back( start );
+        mHeap.push( start, 0 );
+
+        int settled = 0;
+        while ( !mHeap.isEmpty() && settled < WITNESS_SETTLE_LIMIT )
+        {
+          double curCost = 0;
+          const int cur = mHeap.pop( curCost );
+          if ( curCost > maxCost )
+            break;
+          ++settled;
+          if ( mWitnessTarget.at( cur ) == skipVertex && --targetCount == 0 )
+            break;
+
+          for ( const Arc &arc : mOut.at( cur ) )
+          {
+            if ( arc.vertex == skipVertex )
+              continue;
+            const double newCost = curCost + arc.cost;
+            if ( newCost < mWitnessCost.at( arc.vertex ) )
+            {
+              if ( std::isinf( mWitnessCost.at( arc.vertex ) ) )
+                mWitnessTouched.push_back( arc.vertex );
+              mWitnessCost[ arc.vertex ] = newCost;
+              mHeap.push( arc.vertex, newCost );
+            }
+          }
+        }
+      }
+  };
+
+  //! Converts per-vertex arc lists to compressed sparse row arrays
+  void toCsr( const std::vector< std::vector< Arc > > &arcs, QVector< int > &offsets, QVector< int > &vertices, QVector< double > &costs )
+  {
+    offsets.resize( static_cast< int >( arcs.size() ) + 1 );
+    offsets[ 0 ] = 0;
+    for ( std::size_t v = 0; v < arcs.size(); ++v )
+      offsets[ v + 1 ] = offsets.at( v ) + static_cast< int >( arcs[ v ].size() );
+
+    vertices.resize( offsets.last() );
+    costs.resize( offsets.last() );
+    int pos = 0;
+    for ( const std::vector< Arc > &vertexArcs : arcs )
+    {
+      for ( const Arc &arc : vertexArcs )
+      {
+        vertices[ pos ] = arc.vertex;
+        costs[ pos ] = arc.cost;
+        ++pos;
+      }
+    }
+  }
+}
+
+///@endcond
+
+QgsGraphContractionHierarchy::QgsGraphContractionHierarchy( const QgsCompactGraph &graph )
+{
+  const int count = graph.vertexCount();
+  ContractionGraph contraction( count, graph.mOutOffsets, graph.mOutTargets, graph.mOutCosts );
+
+  // lazily updated priority queue of ( priority, vertex )
+  typedef std::pair< int, int > Entry;
+  std::priority_queue< Entry, std::vector< Entry >, std::greater< Entry > > queue;
+  std::vector< Arc > shortcutFrom;
+  std::vector< Arc > shortcutTo;
+  for ( int v = 0; v < count; ++v )
+    queue.push( Entry( contraction.priority( v, shortcutFrom, shortcutTo ), v ) );
+
+  std::vector< std::vector< Arc > > up( count );
+  std::vector< std::vector< Arc > > down( count );
+  mRank.fill( -1, count );
+
+  std::vector< Arc > inArcs;
+  std::vector< Arc > outArcs;
+  int rank = 0;
+  while ( !queue.empty() )
+  {
+    const Entry top = queue.top();
+    queue.pop();
+    const int vertex = top.second;
+    if ( mRank.at( vertex ) >= 0 )
+      continue;
+
+    // priorities change as neighbors get contracted, so recompute before committing to this vertex
+    const int priority = contraction.priority( vertex, shortcutFrom, shortcutTo );
+    if ( !queue.empty() && priority > queue.top().first )
+    {
+      queue.push( Entry( priority, vertex ) );
+      continue;
+    }
+
+    contraction.contract( vertex, inArcs, outArcs );
+    mRank[ vertex ] = rank++;
+
+    // all remaining neighbors will be contracted later, so these arcs lead upwards
+    up[ vertex ] = outArcs;
+    down[ vertex ] = inArcs;
+
+    for ( std::size_t i = 0; i < shortcutFrom.size(); ++i )
+      contraction.addArc( shortcutFrom[ i ].vertex, shortcutTo[ i ].vertex, shortcutFrom[ i ].cost );
+    mShortcutCount += static_cast< int >( shortcutFrom.size() );
+  }
+
+  toCsr( up, mUpOffsets, mUpTargets, mUpCosts );
+  toCsr( down, mDownOffsets, mDownSources, mDownCosts );
+}
+
+void QgsGraphContractionHierarchy::upwardSearch( int vertex, bool forward, QgsGraphVertexHeap &heap, QVector< double > &cost, QVector< int > &settled ) const
+{
+  const QVector< int > &offsets = forward ? mUpOffsets : mDownOffsets;
+  const QVector< int > &neighbors = forward ? mUpTargets : mDownSources;
+  const QVector< double > &edgeCosts = forward ? mUpCosts : mDownCosts;
+
+  cost[ vertex ] = 0;
+  heap.push( vertex, 0 );
+  while ( !heap.isEmpty() )
+  {
+    double curCost = 0;
+    const int cur = heap.pop( curCost );
+    settled.append( cur );
+    for ( int e = offsets.at( cur ); e < offsets.at( cur + 1 ); ++e )
+    {
+      const int next = neighbors.at( e );
+      const double newCost = curCost + edgeCosts.at( e );
+      if ( newCost < cost.at( next ) )
+      {
+        cost[ next ] = newCost;
+        heap.push( next, newCost );
+      }
+    }
+  }
+}
+
+double QgsGraphContractionHierarchy::cost( int startVertexIdx, int endVertexIdx ) const
+{
+  const double inf = std::numeric_limits<double>::infinity();
+  const int count = vertexCount();
+  if ( startVertexIdx < 0 || startVertexIdx >= count || endVertexIdx < 0 || endVertexIdx >= count )
+    return inf;
+
+  QVector< double > costForward( count, inf );
+  QVector< double > costBackward( count, inf );
+  QVector< int > settledForward;
+  QVector< int > settledBackward;
+  QgsGraphVertexHeap heap( count );
+  upwardSearch( startVertexIdx, true, heap, costForward, settledForward );
+  upwardSearch( endVertexIdx, false, heap, costBackward, settledBackward );
+
+  // the shortest path passes through its highest ranked vertex, which both searches reach
+  double best = inf;
+  for ( int v : qgsAsConst( settledForward ) )
+    best = std::min( best, costForward.at( v ) + costBackward.at( v ) );
+  return best;
+}
+
+QVector< double > QgsGraphContractionHierarchy::costMatrix( const QVector< int > &sources, const QVector< int > &targets ) const
+{
+  const double inf = std::numeric_limits<double>::infinity();
+  const int count = vertexCount();
+  QVector< double > result( sources.size() * targets.size(), inf );
+
+  // buckets of ( target index, cost ) for every vertex reached by the backward searches
+  QVector< QVector< QPair< int, double > > > buckets( count );
+  QVector< double > cost( count, inf );
+  QVector< int > settled;
+  QgsGraphVertexHeap heap( count );
+
+  for ( int j = 0; j < targets.size(); ++j )
+  {
+    const int target = targets.at( j );
+    if ( target < 0 || target >= count )
+      continue;
+    upwardSearch( target, false, heap, cost, settled );
+    for ( int v : qgsAsConst( settled ) )
+    {
+      buckets[ v ].append( qMakePair( j, cost.at( v ) ) );
+      cost[ v ] = inf;
+    }
+    settled.clear();
+  }
+
+  for ( int i = 0; i < sources.size(); ++i )
+  {
+    const int source = sources.at( i );
+    if ( source < 0 || source >= count )
+      continue;
+    double *row = result.data() + i * targets.size();
+    upwardSearch( source, true, heap, cost, settled );
+    for ( int v : qgsAsConst( settled ) )
+    {
+      const double sourceCost = cost.at( v );
+      for ( const QPair< int, double > &entry : buckets.at( v ) )
+        row[ entry.first ] = std::min( row[ entry.first ], sourceCost + entry.second );
+      cost[ v ] = inf;
+    }
+    settled.clear();
+  }
+
+  return result;
+}
@@ -0,0 +1,100 @@
+/***************************************************************************
+  qgsgraphcontractionhierarchy.h
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS contributors
+****************************************************************************
+*                                                                          *
+*   This program is free software; you can redistribute it and/or modify   *
+*   it under the terms of the GNU General Public License as published by   *
+*   the Free Software Foundation; either version 2 of the License, or      *
+*   (at your option) any later version.                                    *
+*                                                                          *
+***************************************************************************/
+
+#ifndef QGSGRAPHCONTRACTIONHIERARCHY_H
+#define QGSGRAPHCONTRACTIONHIERARCHY_H
+
+#define SIP_NO_FILE
+
+#include <QVector>
+
+#include "qgis_analysis.h"
+
+class QgsCompactGraph;
+class QgsGraphVertexHeap;
+
+/**
+ * \ingroup analysis
+ * \class QgsGraphContractionHierarchy
+ * \brief Contraction hierarchy built from a QgsCompactGraph, for answering many shortest path cost queries.
+ *
+ * Building the hierarchy contracts the graph vertices one by one, ordered by
+ * their importance, and adds shortcut edges which preserve the shortest path
+ * costs between the remaining vertices. Queries then only need to follow edges
+ * towards more important vertices, which visits a tiny fraction of the graph
+ * compared to a Dijkstra search.
+ *
+ * Building is considerably more expensive than a single Dijkstra search, so the
+ * hierarchy only pays off when many queries are run on the same graph, e.g. for
+ * origin-destination cost matrices. The hierarchy answers path costs only and
+ * must be rebuilt whenever the graph or edge costs change.
+ *
+ * \see QgsCompactGraph
+ * \note not available in Python bindings
+ * \since QGIS 3.0
+ */
+class ANALYSIS_EXPORT QgsGraphContractionHierarchy
+{
+  public:
+
+    /**
+     * Constructor for QgsGraphContractionHierarchy, which contracts all vertices of \a graph.
+     */
+    explicit QgsGraphContractionHierarchy( const QgsCompactGraph &graph );
+
+    //! Returns number of graph vertices
+    int vertexCount() const { return mRank.size(); }
+
+    //! Returns the number of shortcut edges which were added while building the hierarchy
+    int shortcutCount() const { return mShortcutCount; }
+
+    /**
+     * Returns the cost of the shortest path from \a startVertexIdx to \a endVertexIdx,
+     * or infinity if the end vertex is not reachable.
+     */
+    double cost( int startVertexIdx, int endVertexIdx ) const;
+
+    /**
+     * Returns the shortest path costs from all \a sources to all \a targets vertices.
+     *
+     * The result is stored in row major order, i.e. the cost from sources[i] to
+     * targets[j] is at index i * targets.size() + j. Unreachable targets have
+     * infinite cost.
+     *
+     * This is much faster than calling cost() for every pair of vertices, as only
+     * one search is run per source and per target.
+     */
+    QVector< double > costMatrix( const QVector< int > &sources, const QVector< int > &targets ) const;
+
+  private:
+
+    //! Contraction order of each vertex, higher rank means contracted later
+    QVector< int > mRank;
+
+    //! Edges to higher ranked vertices, indexed by source vertex
+    QVector< int > mUpOffsets;
+    QVector< int > mUpTargets;
+    QVector< double > mUpCosts;
+
+    //! Reversed edges coming from higher ranked vertices, indexed by target vertex
+    QVector< int > mDownOffsets;
+    QVector< int > mDownSources;
+    QVector< double > mDownCosts;
+
+    int mShortcutCount = 0;
+
+    void upwardSearch( int vertex, bool forward, QgsGraphVertexHeap &heap, QVector< double > &cost, QVector< int > &settled ) const;
+};
+
+#endif // QGSGRAPHCONTRACTIONHIERARCHY_H
@@ -17,6 +17,7 @@
 
 #include "qgsaspectfilter.h"
 #include <cmath>
+#include <typeinfo>
 
 QgsAspectFilter::QgsAspectFilter( const QString &inputFile, const QString &outputFile, const QString &outputFormat )
   : QgsDerivativeFilter( inputFile, outputFile, outputFormat )
@@ -44,3 +45,25 @@ float QgsAspectFilter::processNineCellWindow(
   }
 }
 
+bool QgsAspectFilter::supportsConcurrentProcessing() const
+{
+  // subclasses reimplementing processNineCellWindow(), e.g. in Python, are not known to be thread safe
+  return typeid( *this ) == typeid( QgsAspectFilter );
+}
+
+void QgsAspectFilter::processNineCellRow( float *rowAbove, float *row, float *rowBelow, float *result, int width )
+{
+  if ( typeid( *this ) != typeid( QgsAspectFilter ) )
+  {
+    // honor the reimplementations of processNineCellWindow() in subclasses
+    QgsNineCellFilter::processNineCellRow( rowAbove, row, rowBelow, result, width );
+    return;
+  }
+
+  // non virtual calls, which can be inlined
+  for ( int j = 0; j < width; ++j )
+  {
+    result[j] = QgsAspectFilter::processNineCellWindow( &rowAbove[j - 1], &rowAbove[j], &rowAbove[j + 1], &row[j - 1], &row[j],
+                &row[j + 1], &rowBelow[j - 1], &rowBelow[j], &rowBelow[j + 1] );
+  }
+}
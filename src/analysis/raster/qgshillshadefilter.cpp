@@ -17,6 +17,7 @@
 
 #include "qgshillshadefilter.h"
 #include <cmath>
+#include <typeinfo>
 
 QgsHillshadeFilter::QgsHillshadeFilter( const QString &inputFile, const QString &outputFile, const QString &outputFormat, double lightAzimuth,
                                         double lightAngle )
@@ -52,3 +53,26 @@ float QgsHillshadeFilter::processNineCellWindow( float *x11, float *x21, float *
   }
   return std::max( 0.0, 255.0 * ( ( std::cos( zenith_rad ) * std::cos( slope_rad ) ) + ( std::sin( zenith_rad ) * std::sin( slope_rad ) * std::cos( azimuth_rad - aspect_rad ) ) ) );
 }
+
+bool QgsHillshadeFilter::supportsConcurrentProcessing() const
+{
+  // subclasses reimplementing processNineCellWindow(), e.g. in Python, are not known to be thread safe
+  return typeid( *this ) == typeid( QgsHillshadeFilter );
+}
+
+void QgsHillshadeFilter::processNineCellRow( float *rowAbove, float *row, float *rowBelow, float *result, int width )
+{
+  if ( typeid( *this ) != typeid( QgsHillshadeFilter ) )
+  {
+    // honor the reimplementations of processNineCellWindow() in subclasses
+    QgsNineCellFilter::processNineCellRow( rowAbove, row, rowBelow, result, width );
+    return;
+  }
+
+  // non virtual calls, which can be inlined
+  for ( int j = 0; j < width; ++j )
+  {
+    result[j] = QgsHillshadeFilter::processNineCellWindow( &rowAbove[j - 1], &rowAbove[j], &rowAbove[j + 1], &row[j - 1], &row[j],
+                &row[j + 1], &rowBelow[j - 1], &rowBelow[j], &rowBelow[j + 1] );
+  }
+}
@@ -18,8 +18,151 @@
 #include "qgsfeatureiterator.h"
 #include "qgsgeometry.h"
 
+#include <QHash>
+#include <QMutex>
+#include <QSet>
+#include <QThreadPool>
+#include <QVector>
+#include <QtConcurrentMap>
+
+#include <vector>
+
 #define NO_DATA -9999
 
+///@cond PRIVATE
+
+//! Size (in pixels) of the tiles the surface is split into
+static const int TILE_SIZE = 256;
+
+//! Maximum memory (in bytes) used for the surface, the remaining tiles are temporarily written to the output file
+static const qint64 MAX_SURFACE_MEMORY = 512 * 1024 * 1024LL;
+
+//! Number of points read by run() before they are added to the surface by multiple threads
+static const int POINT_BATCH_SIZE = 10000;
+
+/**
+ * The KDE surface, split into tiles which are only allocated once a kernel touches them.
+ * If the tiles exceed the maximum memory, the least recently used ones are written to the
+ * raster band and read again when needed.
+ */
+class QgsKernelDensityEstimation::Surface
+{
+  public:
+
+    Surface( int columns, int rows, GDALRasterBandH band, qint64 maximumMemory )
+      : mColumns( columns )
+      , mRows( rows )
+      , mTilesX( ( columns + TILE_SIZE - 1 ) / TILE_SIZE )
+      , mTilesY( ( rows + TILE_SIZE - 1 ) / TILE_SIZE )
+      , mBand( band )
+      , mMaximumTiles( std::max( maximumMemory / ( TILE_SIZE * TILE_SIZE * static_cast< qint64 >( sizeof( float ) ) ), static_cast< qint64 >( 1 ) ) )
+    {}
+
+    int columns() const { return mColumns; }
+    int rows() const { return mRows; }
+    int tileRows() const { return mTilesY; }
+
+    //! Returns true if all tiles fit into memory, so no tile is ever written before flush()
+    bool fitsInMemory() const { return static_cast< qint64 >( mTilesX ) * mTilesY <= mMaximumTiles; }
+
+    /**
+     * Returns the cells of a tile, TILE_SIZE cells per line, or nullptr if the tile could not be read.
+     * May be called from multiple threads, as long as the surface fits into memory.
+     */
+    float *tile( int tileX, int tileY );
+
+    //! Writes all tiles held in memory to the band
+    bool flush();
+
+  private:
+
+    struct Tile
+    {
+      std::vector< float > cells;
+      qint64 lastAccess;
+    };
+
+    //! Reads or writes the cells of the tile with \a key from or to the band
+    bool rasterIO( GDALRWFlag flag, int key, float *cells ) const;
+
+    int mColumns;
+    int mRows;
+    int mTilesX;
+    int mTilesY;
+    GDALRasterBandH mBand;
+    qint64 mMaximumTiles;
+    qint64 mAccessCounter = 0;
+
+    QHash< int, Tile > mTiles;
+    //! Tiles which were removed from memory and have to be read from the band again
+    QSet< int > mWrittenTiles;
+
+    QMutex mMutex;
+};
+
+float *QgsKernelDensityEstimation::Surface::tile( int tileX, int tileY )
+{
+  QMutexLocker locker( &mMutex );
+  const int key = tileY * mTilesX + tileX;
+  auto it = mTiles.find( key );
+  if ( it != mTiles.end() )
+  {
+    it->lastAccess = ++mAccessCounter;
+    return it->cells.data();
+  }
+
+  if ( mTiles.size() >= mMaximumTiles )
+  {
+    auto oldest = mTiles.begin();
+    for ( auto candidate = mTiles.begin(); candidate != mTiles.end(); ++candidate )
+    {
+      if ( candidate->lastAccess < oldest->lastAccess )
+        oldest = candidate;
+    }
+    if ( !rasterIO( GF_Write, oldest.key(), oldest->cells.data() ) )
+      return nullptr;
+
+    mWrittenTiles.insert( oldest.key() );
+    mTiles.erase( oldest );
+  }
+
+  Tile &newTile = mTiles[ key ];
+  newTile.lastAccess = ++mAccessCounter;
+  newTile.cells.assign( TILE_SIZE * TILE_SIZE, NO_DATA );
+  if ( mWrittenTiles.contains( key ) && !rasterIO( GF_Read, key, newTile.cells.data() ) )
+  {
+    mTiles.remove( key );
+    return nullptr;
+  }
+  return newTile.cells.data();
+}
+
+bool QgsKernelDensityEstimation::Surface::flush()
+{
+  bool result = true;
+  for ( auto it = mTiles.begin(); it != mTiles.end(); ++it )
+  {
+    if ( !rasterIO( GF_Write, it.key(), it->cells.data() ) )
+      result = false;
+  }
+  return result;
+}
+
+bool QgsKernelDensityEstimation::Surface::rasterIO( GDALRWFlag flag, int key, float *cells ) const
+{
+  if ( !mBand )
+    return false;
+
+  const int left = ( key % mTilesX ) * TILE_SIZE;
+  const int top = ( key / mTilesX ) * TILE_SIZE;
+  const int width = std::min( TILE_SIZE, mColumns - left );
+  const int height = std::min( TILE_SIZE, mRows - top );
+  return GDALRasterIO( mBand, flag, left, top, width, height, cells, width, height, GDT_Float32,
+                       0, TILE_SIZE * sizeof( float ) ) == CE_None;
+}
+
+///@endcond
+
 QgsKernelDensityEstimation::QgsKernelDensityEstimation( const QgsKernelDensityEstimation::Parameters &parameters, const QString &outputFile, const QString &outputFormat )
   : mSource( parameters.source )
   , mOutputFile( outputFile )
@@ -32,6 +175,7 @@ QgsKernelDensityEstimation::QgsKernelDensityEstimation( const QgsKernelDensityEs
   , mDecay( parameters.decayRatio )
   , mOutputValues( parameters.outputValues )
   , mBufferSize( -1 )
+  , mMaximumSurfaceMemory( MAX_SURFACE_MEMORY )
   , mDatasetH( nullptr )
   , mRasterBandH( nullptr )
 {
@@ -41,6 +185,8 @@ QgsKernelDensityEstimation::QgsKernelDensityEstimation( const QgsKernelDensityEs
     mWeightField = mSource->fields().lookupField( parameters.weightField );
 }
 
+QgsKernelDensityEstimation::~QgsKernelDensityEstimation() = default;
+
 QgsKernelDensityEstimation::Result QgsKernelDensityEstimation::run()
 {
   Result result = prepare();
@@ -58,9 +204,55 @@ QgsKernelDensityEstimation::Result QgsKernelDensityEstimation::run()
   QgsFeatureIterator fit = mSource->getFeatures( QgsFeatureRequest().setSubsetOfAttributes( requiredAttributes ) );
 
   QgsFeature f;
-  while ( fit.nextFeature( f ) )
+  const int threadCount = QThreadPool::globalInstance()->maxThreadCount();
+  if ( threadCount <= 1 || mSurface->tileRows() < 2 || !mSurface->fitsInMemory() )
+  {
+    while ( fit.nextFeature( f ) )
+    {
+      addFeature( f );
+    }
+    return finalise();
+  }
+
+  // The surface is split into bands of tile rows. The kernels of all points are added to a band by
+  // a single thread, in the order of the points. Every cell is therefore summed in the same order as
+  // by addFeature(), and the output does not depend on the number of threads. There are more bands
+  // than threads, as the points are usually not evenly distributed over the surface.
+  struct Band
+  {
+    int firstTileRow;
+    int lastTileRow;
+  };
+  const int bandCount = std::min( 4 * threadCount, mSurface->tileRows() );
+  QVector< Band > bands( bandCount );
+  for ( int i = 0; i < bandCount; ++i )
+  {
+    bands[i].firstTileRow = i * mSurface->tileRows() / bandCount;
+    bands[i].lastTileRow = ( i + 1 ) * mSurface->tileRows() / bandCount - 1;
+  }
+
+  std::vector< KernelPoint > points;
+  points.reserve( POINT_BATCH_SIZE );
+  auto addPoints = [this, &points]( const Band & band )
   {
-    addFeature( f );
+    std::vector< double > squaredDistancesX;
+    std::vector< double > squaredDistancesY;
+    for ( const KernelPoint &point : points )
+    {
+      addKernel( point, band.firstTileRow, band.lastTileRow, squaredDistancesX, squaredDistancesY );
+    }
+  };
+
+  bool hasMoreFeatures = true;
+  while ( hasMoreFeatures )
+  {
+    points.clear();
+    while ( points.size() < static_cast< std::size_t >( POINT_BATCH_SIZE ) && ( hasMoreFeatures = fit.nextFeature( f ) ) )
+    {
+      appendKernelPoints( f, points );
+    }
+    if ( !points.empty() )
+      QtConcurrent::blockingMap( bands, addPoints );
   }
 
   return finalise();
@@ -97,6 +289,8 @@ QgsKernelDensityEstimation::Result QgsKernelDensityEstimation::prepare()
   if ( !mRasterBandH )
     return FileCreationError;
 
+  mSurface.reset( new Surface( cols, rows, mRasterBandH, mMaximumSurfaceMemory ) );
+
   mBufferSize = -1;
   if ( mRadiusField < 0 )
     mBufferSize = radiusSizeInPixels( mRadius );
@@ -105,23 +299,38 @@ QgsKernelDensityEstimation::Result QgsKernelDensityEstimation::prepare()
 }
 
 QgsKernelDensityEstimation::Result QgsKernelDensityEstimation::addFeature( const QgsFeature &feature )
+{
+  if ( !mSurface )
+    return InvalidParameters;
+
+  std::vector< KernelPoint > points;
+  appendKernelPoints( feature, points );
+
+  Result result = Success;
+  // squared distances of the pixel columns and rows of the block to the point
+  std::vector< double > squaredDistancesX;
+  std::vector< double > squaredDistancesY;
+  for ( const KernelPoint &point : points )
+  {
+    if ( addKernel( point, 0, mSurface->tileRows() - 1, squaredDistancesX, squaredDistancesY ) != Success )
+      result = RasterIoError;
+  }
+  return result;
+}
+
+void QgsKernelDensityEstimation::appendKernelPoints( const QgsFeature &feature, std::vector< KernelPoint > &points ) const
 {
   QgsGeometry featureGeometry = feature.geometry();
   if ( featureGeometry.isNull() )
   {
-    return Success;
+    return;
   }
 
   // convert the geometry to multipoint
   QgsMultiPoint multiPoints;
   if ( !featureGeometry.isMultipart() )
   {
-    QgsPointXY p = featureGeometry.asPoint();
-    // avoiding any empty points or out of extent points
-    if ( !mBounds.contains( p ) )
-      return Success;
-
-    multiPoints << p;
+    multiPoints << featureGeometry.asPoint();
   }
   else
   {
@@ -136,7 +345,6 @@ QgsKernelDensityEstimation::Result QgsKernelDensityEstimation::addFeature( const
     radius = feature.attribute( mRadiusField ).toDouble();
     buffer = radiusSizeInPixels( radius );
   }
-  int blockSize = 2 * buffer + 1; //Block SIDE would be more appropriate
 
   // calculate weight
   double weight = 1.0;
@@ -145,8 +353,6 @@ QgsKernelDensityEstimation::Result QgsKernelDensityEstimation::addFeature( const
     weight = feature.attribute( mWeightField ).toDouble();
   }
 
-  Result result = Success;
-
   //loop through all points in multipoint
   for ( QgsMultiPoint::const_iterator pointIt = multiPoints.constBegin(); pointIt != multiPoints.constEnd(); ++pointIt )
   {
@@ -156,50 +362,91 @@ QgsKernelDensityEstimation::Result QgsKernelDensityEstimation::addFeature( const
       continue;
     }
 
-    // calculate the pixel position
-    unsigned int xPosition = ( ( ( *pointIt ).x() - mBounds.xMinimum() ) / mPixelSize ) - buffer;
-    unsigned int yPosition = ( ( ( *pointIt ).y() - mBounds.yMinimum() ) / mPixelSize ) - buffer;
-    unsigned int yPositionIO = ( ( mBounds.yMaximum() - ( *pointIt ).y() ) / mPixelSize ) - buffer;
+    KernelPoint point;
+    point.x = pointIt->x();
+    point.y = pointIt->y();
+    point.radius = radius;
+    point.buffer = buffer;
+    point.weight = weight;
+    points.push_back( point );
+  }
+}
+
+QgsKernelDensityEstimation::Result QgsKernelDensityEstimation::addKernel( const KernelPoint &point, int firstTileRow, int lastTileRow,
+    std::vector< double > &squaredDistancesX, std::vector< double > &squaredDistancesY )
+{
+  const int buffer = point.buffer;
+  const int blockSize = 2 * buffer + 1; //Block SIDE would be more appropriate
 
+  // calculate the pixel position
+  int xPosition = ( ( point.x - mBounds.xMinimum() ) / mPixelSize ) - buffer;
+  int yPosition = ( ( point.y - mBounds.yMinimum() ) / mPixelSize ) - buffer;
+  int yPositionIO = ( ( mBounds.yMaximum() - point.y ) / mPixelSize ) - buffer;
 
-    // get the data
-    float *dataBuffer = ( float * ) CPLMalloc( sizeof( float ) * blockSize * blockSize );
-    if ( GDALRasterIO( mRasterBandH, GF_Read, xPosition, yPositionIO, blockSize, blockSize,
-                       dataBuffer, blockSize, blockSize, GDT_Float32, 0, 0 ) != CE_None )
-    {
-      result = RasterIoError;
-    }
+  // blocks reaching beyond the raster can't be written
+  if ( xPosition < 0 || yPositionIO < 0 || xPosition + blockSize > mSurface->columns() || yPositionIO + blockSize > mSurface->rows() )
+  {
+    return RasterIoError;
+  }
 
-    for ( int xp = 0; xp < blockSize; xp++ )
-    {
-      for ( int yp = 0; yp < blockSize; yp++ )
-      {
-        double pixelCentroidX = ( xPosition + xp + 0.5 ) * mPixelSize + mBounds.xMinimum();
-        double pixelCentroidY = ( yPosition + yp + 0.5 ) * mPixelSize + mBounds.yMinimum();
+  firstTileRow = std::max( firstTileRow, yPositionIO / TILE_SIZE );
+  lastTileRow = std::min( lastTileRow, ( yPositionIO + blockSize - 1 ) / TILE_SIZE );
+  if ( firstTileRow > lastTileRow )
+    return Success; // nothing to add in these rows
 
-        double distance = std::sqrt( std::pow( pixelCentroidX - ( *pointIt ).x(), 2.0 ) + std::pow( pixelCentroidY - ( *pointIt ).y(), 2.0 ) );
+  squaredDistancesX.resize( blockSize );
+  squaredDistancesY.resize( blockSize );
+  for ( int xp = 0; xp < blockSize; xp++ )
+  {
+    double pixelCentroidX = ( xPosition + xp + 0.5 ) * mPixelSize + mBounds.xMinimum();
+    squaredDistancesX[ xp ] = std::pow( pixelCentroidX - point.x, 2.0 );
+  }
+  for ( int yp = 0; yp < blockSize; yp++ )
+  {
+    double pixelCentroidY = ( yPosition + yp + 0.5 ) * mPixelSize + mBounds.yMinimum();
+    squaredDistancesY[ yp ] = std::pow( pixelCentroidY - point.y, 2.0 );
+  }
 
-        // is pixel outside search bandwidth of feature?
-        if ( distance > radius )
-        {
-          continue;
-        }
+  Result result = Success;
+  for ( int tileY = firstTileRow; tileY <= lastTileRow; ++tileY )
+  {
+    for ( int tileX = xPosition / TILE_SIZE; tileX <= ( xPosition + blockSize - 1 ) / TILE_SIZE; ++tileX )
+    {
+      float *cells = mSurface->tile( tileX, tileY );
+      if ( !cells )
+      {
+        result = RasterIoError;
+        continue;
+      }
 
-        double pixelValue = weight * calculateKernelValue( distance, radius, mShape, mOutputValues );
-        int pos = xp + blockSize * yp;
-        if ( dataBuffer[ pos ] == NO_DATA )
+      const int firstColumn = std::max( xPosition, tileX * TILE_SIZE );
+      const int endColumn = std::min( xPosition + blockSize, ( tileX + 1 ) * TILE_SIZE );
+      const int firstRow = std::max( yPositionIO, tileY * TILE_SIZE );
+      const int endRow = std::min( yPositionIO + blockSize, ( tileY + 1 ) * TILE_SIZE );
+      for ( int row = firstRow; row < endRow; ++row )
+      {
+        const double squaredDistanceY = squaredDistancesY[ row - yPositionIO ];
+        float *line = cells + ( row - tileY * TILE_SIZE ) * TILE_SIZE;
+        for ( int column = firstColumn; column < endColumn; ++column )
         {
-          dataBuffer[ pos ] = 0;
+          double distance = std::sqrt( squaredDistancesX[ column - xPosition ] + squaredDistanceY );
+
+          // is pixel outside search bandwidth of feature?
+          if ( distance > point.radius )
+          {
+            continue;
+          }
+
+          double pixelValue = point.weight * calculateKernelValue( distance, point.radius, mShape, mOutputValues );
+          float &value = line[ column - tileX * TILE_SIZE ];
+          if ( value == NO_DATA )
+          {
+            value = 0;
+          }
+          value += pixelValue;
         }
-        dataBuffer[ pos ] += pixelValue;
       }
     }
-    if ( GDALRasterIO( mRasterBandH, GF_Write, xPosition, yPositionIO, blockSize, blockSize,
-                       dataBuffer, blockSize, blockSize, GDT_Float32, 0, 0 ) != CE_None )
-    {
-      result = RasterIoError;
-    }
-    CPLFree( dataBuffer );
   }
 
   return result;
@@ -207,10 +454,15 @@ QgsKernelDensityEstimation::Result QgsKernelDensityEstimation::addFeature( const
 
 QgsKernelDensityEstimation::Result QgsKernelDensityEstimation::finalise()
 {
+  Result result = Success;
+  if ( mSurface && !mSurface->flush() )
+    result = RasterIoError;
+  mSurface.reset();
+
   GDALClose( ( GDALDatasetH ) mDatasetH );
   mDatasetH = nullptr;
   mRasterBandH = nullptr;
-  return Success;
+  return result;
 }
 
 int QgsKernelDensityEstimation::radiusSizeInPixels( double radius ) const
@@ -18,6 +18,8 @@
 
 #include "qgsrectangle.h"
 #include <QString>
+#include <memory>
+#include <vector>
 
 // GDAL includes
 #include <gdal.h>
@@ -99,10 +101,18 @@ class ANALYSIS_EXPORT QgsKernelDensityEstimation
      * to generate the surface. The output path and file format are also required.
      */
     QgsKernelDensityEstimation( const Parameters &parameters, const QString &outputFile, const QString &outputFormat );
+    ~QgsKernelDensityEstimation();
+
+    //! QgsKernelDensityEstimation cannot be copied
+    QgsKernelDensityEstimation( const QgsKernelDensityEstimation &other ) = delete;
+    //! QgsKernelDensityEstimation cannot be copied
+    QgsKernelDensityEstimation &operator=( const QgsKernelDensityEstimation &other ) = delete;
 
     /**
      * Runs the KDE calculation across the whole layer at once. Either call this method, or manually
      * call run(), addFeature() and finalise() separately.
+     * If the surface fits into memory, the rows of the surface are calculated by multiple threads.
+     * The output is the same as when adding the features one by one.
      */
     Result run();
 
@@ -123,12 +133,38 @@ class ANALYSIS_EXPORT QgsKernelDensityEstimation
 
     /**
      * Finalises the output file. Must be called after adding all features via addFeature().
+     * The surface is accumulated in memory and only written to the output file here.
      * \see prepare()
      * \see addFeature()
      */
     Result finalise();
 
   private:
+#ifdef SIP_RUN
+    QgsKernelDensityEstimation( const QgsKernelDensityEstimation &other );
+#endif
+
+    class Surface;
+
+    //! A point of a feature, with the kernel radius and weight of the feature
+    struct KernelPoint
+    {
+      double x;
+      double y;
+      double radius;
+      int buffer;
+      double weight;
+    };
+
+    //! Appends the points of \a feature which are within the bounds to \a points
+    void appendKernelPoints( const QgsFeature &feature, std::vector< KernelPoint > &points ) const;
+
+    /**
+     * Adds the kernel of \a point to the surface, restricted to the rows of tiles from \a firstTileRow
+     * to \a lastTileRow. \a squaredDistancesX and \a squaredDistancesY are used as buffers.
+     */
+    Result addKernel( const KernelPoint &point, int firstTileRow, int lastTileRow,
+                      std::vector< double > &squaredDistancesX, std::vector< double > &squaredDistancesY );
 
     //! Calculate the value given to a point width a given distance for a specified kernel shape
     double calculateKernelValue( const double distance, const double bandwidth, const KernelShape shape, const OutputValues outputType ) const;
@@ -162,12 +198,20 @@ class ANALYSIS_EXPORT QgsKernelDensityEstimation
 
     int mBufferSize;
 
+    //! Maximum memory (in bytes) used for the surface
+    qint64 mMaximumSurfaceMemory;
+
     GDALDatasetH mDatasetH;
     GDALRasterBandH mRasterBandH;
 
+    //! Surface accumulating the kernel values until it is written by finalise()
+    std::unique_ptr< Surface > mSurface;
+
     //! Creates a new raster layer and initializes it to the no data value
     bool createEmptyLayer( GDALDriverH driver, const QgsRectangle &bounds, int rows, int columns ) const;
     int radiusSizeInPixels( double radius ) const;
+
+    friend class TestQgsKernelDensityEstimation;
 };
 
 
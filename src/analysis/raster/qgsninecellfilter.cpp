@@ -19,7 +19,41 @@
 #include "qgslogger.h"
 #include "cpl_string.h"
 #include "qgsfeedback.h"
+#include <algorithm>
 #include <QFile>
+#include <QThreadPool>
+#include <QVector>
+#include <QtConcurrentMap>
+
+///@cond PRIVATE
+
+//! Input and output rows for QgsNineCellFilter::processNineCellRow()
+struct QgsNineCellFilterRow
+{
+  float *rowAbove = nullptr;
+  float *row = nullptr;
+  float *rowBelow = nullptr;
+  float *result = nullptr;
+};
+
+//! Processes a raster row, for use with QtConcurrent
+struct QgsNineCellFilterRowWrapper
+{
+  QgsNineCellFilter *filter = nullptr;
+  int width;
+
+  QgsNineCellFilterRowWrapper( QgsNineCellFilter *filter, int width )
+    : filter( filter )
+    , width( width )
+  {}
+
+  void operator()( QgsNineCellFilterRow &row )
+  {
+    filter->processNineCellRow( row.rowAbove, row.row, row.rowBelow, row.result, width );
+  }
+};
+
+///@endcond
 
 QgsNineCellFilter::QgsNineCellFilter( const QString &inputFile, const QString &outputFile, const QString &outputFormat )
   : mInputFile( inputFile )
@@ -82,15 +116,18 @@ int QgsNineCellFilter::processRaster( QgsFeedback *feedback )
     return 6;
   }
 
-  //keep only three scanlines in memory at a time
-  float *scanLine1 = ( float * ) CPLMalloc( sizeof( float ) * xSize );
-  float *scanLine2 = ( float * ) CPLMalloc( sizeof( float ) * xSize );
-  float *scanLine3 = ( float * ) CPLMalloc( sizeof( float ) * xSize );
-
-  float *resultLine = ( float * ) CPLMalloc( sizeof( float ) * xSize );
-
-  //values outside the layer extent (if the 3x3 window is on the border) are sent to the processing method as (input) nodata values
-  for ( int i = 0; i < ySize; ++i )
+  // rows are processed in strips, in parallel if the filter supports it, and each strip is written out in one go.
+  // The input strip has a halo of one row above and below and one column left and right, filled with
+  // (input) nodata values outside the layer extent
+  const bool parallel = supportsConcurrentProcessing() && QThreadPool::globalInstance()->maxThreadCount() > 1;
+  const int rowsPerStrip = parallel ? 16 * QThreadPool::globalInstance()->maxThreadCount() : 64;
+  const int stride = xSize + 2;
+  QVector< float > inputStrip;
+  QVector< float > resultStrip;
+  QVector< QgsNineCellFilterRow > rows;
+  QgsNineCellFilterRowWrapper processRow( this, xSize );
+
+  for ( int stripStart = 0; stripStart < ySize; stripStart += rowsPerStrip )
   {
     if ( feedback && feedback->isCanceled() )
     {
@@ -99,75 +136,47 @@ int QgsNineCellFilter::processRaster( QgsFeedback *feedback )
 
     if ( feedback )
     {
-      feedback->setProgress( 100.0 * static_cast< double >( i ) / ySize );
+      feedback->setProgress( 100.0 * static_cast< double >( stripStart ) / ySize );
     }
 
-    if ( i == 0 )
-    {
-      //fill scanline 1 with (input) nodata for the values above the first row and feed scanline2 with the first row
-      for ( int a = 0; a < xSize; ++a )
-      {
-        scanLine1[a] = mInputNodataValue;
-      }
-      if ( GDALRasterIO( rasterBand, GF_Read, 0, 0, xSize, 1, scanLine2, xSize, 1, GDT_Float32, 0, 0 ) != CE_None )
-      {
-        QgsDebugMsg( "Raster IO Error" );
-      }
-    }
-    else
-    {
-      //normally fetch only scanLine3 and release scanline 1 if we move forward one row
-      CPLFree( scanLine1 );
-      scanLine1 = scanLine2;
-      scanLine2 = scanLine3;
-      scanLine3 = ( float * ) CPLMalloc( sizeof( float ) * xSize );
-    }
+    const int stripRows = std::min( rowsPerStrip, ySize - stripStart );
+    inputStrip.fill( mInputNodataValue, stride * ( stripRows + 2 ) );
+    resultStrip.resize( xSize * stripRows );
 
-    if ( i == ySize - 1 ) //fill the row below the bottom with nodata values
+    // input rows from stripStart - 1 to stripStart + stripRows, clamped to the raster
+    const int firstRow = std::max( stripStart - 1, 0 );
+    const int lastRow = std::min( stripStart + stripRows, ySize - 1 );
+    float *firstRowData = inputStrip.data() + ( firstRow - stripStart + 1 ) * stride + 1;
+    if ( GDALRasterIO( rasterBand, GF_Read, 0, firstRow, xSize, lastRow - firstRow + 1, firstRowData, xSize, lastRow - firstRow + 1,
+                       GDT_Float32, 0, stride * static_cast< int >( sizeof( float ) ) ) != CE_None )
     {
-      for ( int a = 0; a < xSize; ++a )
-      {
-        scanLine3[a] = mInputNodataValue;
-      }
+      QgsDebugMsg( "Raster IO Error" );
     }
-    else
+
+    rows.resize( stripRows );
+    for ( int i = 0; i < stripRows; ++i )
     {
-      if ( GDALRasterIO( rasterBand, GF_Read, 0, i + 1, xSize, 1, scanLine3, xSize, 1, GDT_Float32, 0, 0 ) != CE_None )
-      {
-        QgsDebugMsg( "Raster IO Error" );
-      }
+      QgsNineCellFilterRow &row = rows[i];
+      row.rowAbove = inputStrip.data() + i * stride + 1;
+      row.row = row.rowAbove + stride;
+      row.rowBelow = row.row + stride;
+      row.result = resultStrip.data() + i * xSize;
     }
 
-    for ( int j = 0; j < xSize; ++j )
+    if ( parallel )
+      QtConcurrent::blockingMap( rows, processRow );
+    else
     {
-      if ( j == 0 )
-      {
-        resultLine[j] = processNineCellWindow( &mInputNodataValue, &scanLine1[j], &scanLine1[j + 1], &mInputNodataValue, &scanLine2[j],
-                                               &scanLine2[j + 1], &mInputNodataValue, &scanLine3[j], &scanLine3[j + 1] );
-      }
-      else if ( j == xSize - 1 )
-      {
-        resultLine[j] = processNineCellWindow( &scanLine1[j - 1], &scanLine1[j], &mInputNodataValue, &scanLine2[j - 1], &scanLine2[j],
-                                               &mInputNodataValue, &scanLine3[j - 1], &scanLine3[j], &mInputNodataValue );
-      }
-      else
-      {
-        resultLine[j] = processNineCellWindow( &scanLine1[j - 1], &scanLine1[j], &scanLine1[j + 1], &scanLine2[j - 1], &scanLine2[j],
-                                               &scanLine2[j + 1], &scanLine3[j - 1], &scanLine3[j], &scanLine3[j + 1] );
-      }
+      for ( QgsNineCellFilterRow &row : rows )
+        processRow( row );
     }
 
-    if ( GDALRasterIO( outputRasterBand, GF_Write, 0, i, xSize, 1, resultLine, xSize, 1, GDT_Float32, 0, 0 ) != CE_None )
+    if ( GDALRasterIO( outputRasterBand, GF_Write, 0, stripStart, xSize, stripRows, resultStrip.data(), xSize, stripRows, GDT_Float32, 0, 0 ) != CE_None )
     {
       QgsDebugMsg( "Raster IO Error" );
     }
   }
 
-  CPLFree( resultLine );
-  CPLFree( scanLine1 );
-  CPLFree( scanLine2 );
-  CPLFree( scanLine3 );
-
   GDALClose( inputDataset );
 
   if ( feedback && feedback->isCanceled() )
@@ -181,6 +190,15 @@ int QgsNineCellFilter::processRaster( QgsFeedback *feedback )
   return 0;
 }
 
+void QgsNineCellFilter::processNineCellRow( float *rowAbove, float *row, float *rowBelow, float *result, int width )
+{
+  for ( int j = 0; j < width; ++j )
+  {
+    result[j] = processNineCellWindow( &rowAbove[j - 1], &rowAbove[j], &rowAbove[j + 1], &row[j - 1], &row[j],
+                                       &row[j + 1], &rowBelow[j - 1], &rowBelow[j], &rowBelow[j + 1] );
+  }
+}
+
 GDALDatasetH QgsNineCellFilter::openInputFile( int &nCellsX, int &nCellsY )
 {
   GDALDatasetH inputDataset = GDALOpen( mInputFile.toUtf8().constData(), GA_ReadOnly );
@@ -21,6 +21,7 @@
 #include <QString>
 #include "gdal.h"
 #include "qgis_analysis.h"
+#include "qgis_sip.h"
 
 class QgsFeedback;
 
@@ -60,6 +61,29 @@ class ANALYSIS_EXPORT QgsNineCellFilter
                                          float *x12, float *x22, float *x32,
                                          float *x13, float *x23, float *x33 ) = 0;
 
+    /**
+     * Returns true if processNineCellWindow() and processNineCellRow() may be called
+     * concurrently from several threads. In this case processRaster() processes the
+     * rows in parallel.
+     * The default implementation returns false.
+     * \since QGIS 3.0
+     */
+    virtual bool supportsConcurrentProcessing() const { return false; }
+
+    /**
+     * Calculates the output values of a raster row.
+     *
+     * \a rowAbove, \a row and \a rowBelow point to the first cell of the
+     * input rows, \a result to the first of \a width output values. The input
+     * rows are padded with an input nodata value at index -1 and \a width, and
+     * rows outside the raster are filled with input nodata values.
+     *
+     * The default implementation calls processNineCellWindow() for each cell.
+     * Subclasses may reimplement it to avoid a virtual call per cell.
+     * \since QGIS 3.0
+     */
+    virtual void processNineCellRow( float *rowAbove, float *row, float *rowBelow, float *result, int width ) SIP_SKIP;
+
   private:
     //default constructor forbidden. We need input file, output file and format obligatory
     QgsNineCellFilter() = delete;
@@ -70,24 +70,22 @@ bool QgsRasterCalcNode::calculate( QMap<QString, QgsRasterBlock * > &rasterData,
       return false;
     }
 
-    int nRows = ( row >= 0 ? 1 : ( *it )->height() );
+    QgsRasterBlock *block = *it;
+    int nRows = ( row >= 0 ? 1 : block->height() );
     int startRow = ( row >= 0 ? row : 0 );
-    int endRow = startRow + nRows;
-    int nCols = ( *it )->width();
+    int nCols = block->width();
     int nEntries = nCols * nRows;
     double *data = new double[nEntries];
 
     //convert input raster values to double, also convert input no data to result no data
-
-    int outRow = 0;
-    for ( int dataRow = startRow; dataRow < endRow ; ++dataRow, ++outRow )
+    //the requested rows are contiguous in the block, so walk through them by index
+    const double nodataValue = result.nodataValue();
+    qgssize index = static_cast< qgssize >( startRow ) * nCols;
+    for ( int i = 0; i < nEntries; ++i, ++index )
     {
-      for ( int dataCol = 0; dataCol < nCols; ++dataCol )
-      {
-        data[ dataCol + nCols * outRow] = ( *it )->isNoData( dataRow, dataCol ) ? result.nodataValue() : ( *it )->value( dataRow, dataCol );
-      }
+      data[i] = block->isNoData( index ) ? nodataValue : block->value( index );
     }
-    result.setData( nCols, nRows, data, result.nodataValue() );
+    result.setData( nCols, nRows, data, nodataValue );
     return true;
   }
   else if ( mType == tOperator )
@@ -25,10 +25,35 @@
 #include "qgsfeedback.h"
 
 #include <QFile>
+#include <QMutex>
+#include <QThreadPool>
+#include <QtConcurrentMap>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
 
 #include <cpl_string.h>
 #include <gdalwarper.h>
 
+///@cond PRIVATE
+
+//! Number of cells the calculator aims to read and calculate in one strip of rows
+static const int TARGET_STRIP_CELLS = 1024 * 1024;
+
+//! A strip of consecutive output rows, read, calculated and written in one go
+struct QgsRasterCalculatorStrip
+{
+  int startRow = 0;
+  int rows = 0;
+  //! The calculated values, empty if the calculation failed
+  QVector< float > data;
+  //! True if an input could not be read
+  bool inputError = false;
+};
+
+///@endcond
+
 QgsRasterCalculator::QgsRasterCalculator( const QString &formulaString, const QString &outputFile, const QString &outputFormat,
     const QgsRectangle &outputExtent, int nOutputColumns, int nOutputRows, const QVector<QgsRasterCalculatorEntry> &rasterEntries )
   : mFormulaString( formulaString )
@@ -38,6 +63,7 @@ QgsRasterCalculator::QgsRasterCalculator( const QString &formulaString, const QS
   , mNumOutputColumns( nOutputColumns )
   , mNumOutputRows( nOutputRows )
   , mRasterEntries( rasterEntries )
+  , mStripCells( TARGET_STRIP_CELLS )
 {
   //default to first layer's crs
   mOutputCrs = mRasterEntries.at( 0 ).raster->crs();
@@ -53,6 +79,7 @@ QgsRasterCalculator::QgsRasterCalculator( const QString &formulaString, const QS
   , mNumOutputColumns( nOutputColumns )
   , mNumOutputRows( nOutputRows )
   , mRasterEntries( rasterEntries )
+  , mStripCells( TARGET_STRIP_CELLS )
 {
 }
 
@@ -60,47 +87,23 @@ int QgsRasterCalculator::processCalculation( QgsFeedback *feedback )
 {
   //prepare search string / tree
   QString errorString;
-  QgsRasterCalcNode *calcNode = QgsRasterCalcNode::parseRasterCalcString( mFormulaString, errorString );
+  std::unique_ptr< QgsRasterCalcNode > calcNode( QgsRasterCalcNode::parseRasterCalcString( mFormulaString, errorString ) );
   if ( !calcNode )
   {
     //error
     return static_cast<int>( ParserError );
   }
 
-  QMap< QString, QgsRasterBlock * > inputBlocks;
-  QVector<QgsRasterCalculatorEntry>::const_iterator it = mRasterEntries.constBegin();
-  for ( ; it != mRasterEntries.constEnd(); ++it )
+  QVector< QgsRasterDataProvider * > layerProviders;
+  QVector< bool > needsProjection;
+  for ( const QgsRasterCalculatorEntry &entry : qgsAsConst( mRasterEntries ) )
   {
-    if ( !it->raster ) // no raster layer in entry
+    if ( !entry.raster ) // no raster layer in entry
     {
-      delete calcNode;
-      qDeleteAll( inputBlocks );
       return static_cast< int >( InputLayerError );
     }
-
-    QgsRasterBlock *block = nullptr;
-    // if crs transform needed
-    if ( it->raster->crs() != mOutputCrs )
-    {
-      QgsRasterProjector proj;
-      proj.setCrs( it->raster->crs(), mOutputCrs );
-      proj.setInput( it->raster->dataProvider() );
-      proj.setPrecision( QgsRasterProjector::Exact );
-
-      block = proj.block( it->bandNumber, mOutputRectangle, mNumOutputColumns, mNumOutputRows );
-    }
-    else
-    {
-      block = it->raster->dataProvider()->block( it->bandNumber, mOutputRectangle, mNumOutputColumns, mNumOutputRows );
-    }
-    if ( block->isEmpty() )
-    {
-      delete block;
-      delete calcNode;
-      qDeleteAll( inputBlocks );
-      return static_cast<int>( MemoryError );
-    }
-    inputBlocks.insert( it->ref, block );
+    layerProviders << entry.raster->dataProvider();
+    needsProjection << ( entry.raster->crs() != mOutputCrs );
   }
 
   //open output dataset for writing
@@ -111,21 +114,145 @@ int QgsRasterCalculator::processCalculation( QgsFeedback *feedback )
   }
 
   GDALDatasetH outputDataset = openOutputFile( outputDriver );
+  if ( !outputDataset )
+  {
+    return static_cast< int >( CreateOutputError );
+  }
   GDALSetProjection( outputDataset, mOutputCrs.toWkt().toLocal8Bit().data() );
   GDALRasterBandH outputRasterBand = GDALGetRasterBand( outputDataset, 1 );
 
   float outputNodataValue = -FLT_MAX;
   GDALSetRasterNoDataValue( outputRasterBand, outputNodataValue );
 
-  QgsRasterMatrix resultMatrix;
-  resultMatrix.setNodataValue( outputNodataValue );
+  //calculate strips of rows, with a height which is a multiple of the output block height
+  int blockXSize = 0;
+  int blockYSize = 0;
+  GDALGetBlockSize( outputRasterBand, &blockXSize, &blockYSize );
+  blockYSize = std::max( 1, blockYSize );
+  int stripRows = std::max( 1, mStripCells / std::max( 1, mNumOutputColumns ) );
+  stripRows = std::max( blockYSize, stripRows / blockYSize * blockYSize );
+  const double cellSizeY = mOutputRectangle.height() / mNumOutputRows;
+
+  // a provider can't be used from several threads at once, so every thread reads with clones of its own
+  QMutex providerMutex;
+  std::vector< std::unique_ptr< QgsRasterDataProvider > > providerClones;
+  QList< QVector< QgsRasterDataProvider * > > idleProviders;
+  auto acquireProviders = [&]() -> QVector< QgsRasterDataProvider * >
+  {
+    QMutexLocker locker( &providerMutex );
+    if ( !idleProviders.isEmpty() )
+      return idleProviders.takeLast();
+
+    QVector< QgsRasterDataProvider * > providers;
+    for ( QgsRasterDataProvider *provider : qgsAsConst( layerProviders ) )
+    {
+      QgsRasterDataProvider *clone = dynamic_cast< QgsRasterDataProvider * >( provider->clone() );
+      if ( !clone )
+        return QVector< QgsRasterDataProvider * >();
+      providerClones.emplace_back( clone );
+      providers << clone;
+    }
+    return providers;
+  };
+  auto releaseProviders = [&]( const QVector< QgsRasterDataProvider * > &providers )
+  {
+    QMutexLocker locker( &providerMutex );
+    idleProviders << providers;
+  };
+
+  bool parallel = QThreadPool::globalInstance()->maxThreadCount() > 1 && mNumOutputRows > stripRows;
+  if ( parallel )
+  {
+    QVector< QgsRasterDataProvider * > providers = acquireProviders();
+    if ( providers.size() == layerProviders.size() )
+      releaseProviders( providers );
+    else
+      parallel = false;
+  }
+
+  auto calculateStrip = [&]( QgsRasterCalculatorStrip & strip )
+  {
+    if ( feedback && feedback->isCanceled() )
+      return;
+
+    const QVector< QgsRasterDataProvider * > providers = parallel ? acquireProviders() : layerProviders;
+    if ( providers.size() != layerProviders.size() )
+    {
+      strip.inputError = true;
+      return;
+    }
+
+    const double yMaximum = mOutputRectangle.yMaximum() - strip.startRow * cellSizeY;
+    const double yMinimum = strip.startRow + strip.rows == mNumOutputRows ? mOutputRectangle.yMinimum() : yMaximum - strip.rows * cellSizeY;
+    const QgsRectangle stripExtent( mOutputRectangle.xMinimum(), yMinimum, mOutputRectangle.xMaximum(), yMaximum );
+
+    QMap< QString, QgsRasterBlock * > inputBlocks;
+    for ( int i = 0; i < mRasterEntries.size(); ++i )
+    {
+      const QgsRasterCalculatorEntry &entry = mRasterEntries.at( i );
+      QgsRasterBlock *block = nullptr;
+      // if crs transform needed
+      if ( needsProjection.at( i ) )
+      {
+        QgsRasterProjector proj;
+        proj.setCrs( entry.raster->crs(), mOutputCrs );
+        proj.setInput( providers.at( i ) );
+        proj.setPrecision( QgsRasterProjector::Exact );
+
+        block = proj.block( entry.bandNumber, stripExtent, mNumOutputColumns, strip.rows );
+      }
+      else
+      {
+        block = providers.at( i )->block( entry.bandNumber, stripExtent, mNumOutputColumns, strip.rows );
+      }
+      if ( block->isEmpty() )
+      {
+        delete block;
+        strip.inputError = true;
+        break;
+      }
+      inputBlocks.insert( entry.ref, block );
+    }
+
+    if ( !strip.inputError )
+    {
+      QgsRasterMatrix resultMatrix;
+      resultMatrix.setNodataValue( outputNodataValue );
+      if ( calcNode->calculate( inputBlocks, resultMatrix ) )
+      {
+        const int nEntries = mNumOutputColumns * strip.rows;
+        strip.data.resize( nEntries );
+        if ( resultMatrix.isNumber() )
+        {
+          strip.data.fill( static_cast< float >( resultMatrix.number() ) );
+        }
+        else
+        {
+          const double *resultData = resultMatrix.data();
+          float *stripData = strip.data.data();
+          for ( int j = 0; j < nEntries; ++j )
+          {
+            stripData[j] = static_cast< float >( resultData[j] );
+          }
+        }
+      }
+    }
 
-  //read / write line by line
-  for ( int i = 0; i < mNumOutputRows; ++i )
+    qDeleteAll( inputBlocks );
+    if ( parallel )
+      releaseProviders( providers );
+  };
+
+  //read, calculate and write batches of strips, calculating the strips of a batch in parallel
+  const int stripsPerBatch = parallel ? QThreadPool::globalInstance()->maxThreadCount() : 1;
+  QVector< QgsRasterCalculatorStrip > batch;
+  Result result = Success;
+  int startRow = 0;
+  while ( startRow < mNumOutputRows )
   {
     if ( feedback )
     {
-      feedback->setProgress( 100.0 * static_cast< double >( i ) / mNumOutputRows );
+      feedback->setProgress( 100.0 * static_cast< double >( startRow ) / mNumOutputRows );
     }
 
     if ( feedback && feedback->isCanceled() )
@@ -133,25 +260,43 @@ int QgsRasterCalculator::processCalculation( QgsFeedback *feedback )
       break;
     }
 
-    if ( calcNode->calculate( inputBlocks, resultMatrix, i ) )
+    batch.clear();
+    for ( ; batch.size() < stripsPerBatch && startRow < mNumOutputRows; startRow += stripRows )
     {
-      bool resultIsNumber = resultMatrix.isNumber();
-      float *calcData = new float[mNumOutputColumns];
+      QgsRasterCalculatorStrip strip;
+      strip.startRow = startRow;
+      strip.rows = std::min( stripRows, mNumOutputRows - startRow );
+      batch << strip;
+    }
+
+    if ( parallel )
+      QtConcurrent::blockingMap( batch, calculateStrip );
+    else
+      std::for_each( batch.begin(), batch.end(), calculateStrip );
 
-      for ( int j = 0; j < mNumOutputColumns; ++j )
+    //write the strips to the dataset, GDAL datasets may only be written from a single thread
+    for ( QgsRasterCalculatorStrip &strip : batch )
+    {
+      if ( strip.inputError )
       {
-        calcData[j] = ( float )( resultIsNumber ? resultMatrix.number() : resultMatrix.data()[j] );
+        result = MemoryError;
+        break;
+      }
+      if ( strip.data.isEmpty() )
+      {
+        continue;
       }
 
-      //write scanline to the dataset
-      if ( GDALRasterIO( outputRasterBand, GF_Write, 0, i, mNumOutputColumns, 1, calcData, mNumOutputColumns, 1, GDT_Float32, 0, 0 ) != CE_None )
+      if ( GDALRasterIO( outputRasterBand, GF_Write, 0, strip.startRow, mNumOutputColumns, strip.rows, strip.data.data(), mNumOutputColumns, strip.rows, GDT_Float32, 0, 0 ) != CE_None )
       {
         QgsDebugMsg( "RasterIO error!" );
       }
-
-      delete[] calcData;
     }
 
+    if ( result != Success )
+    {
+      break;
+    }
   }
 
   if ( feedback )
@@ -159,16 +304,16 @@ int QgsRasterCalculator::processCalculation( QgsFeedback *feedback )
     feedback->setProgress( 100.0 );
   }
 
-  //close datasets and release memory
-  delete calcNode;
-  qDeleteAll( inputBlocks );
-  inputBlocks.clear();
-
   if ( feedback && feedback->isCanceled() )
+  {
+    result = Canceled;
+  }
+
+  if ( result != Success )
   {
     //delete the dataset without closing (because it is faster)
     GDALDeleteDataset( outputDriver, mOutputFile.toUtf8().constData() );
-    return static_cast< int >( Canceled );
+    return static_cast< int >( result );
   }
   GDALClose( outputDataset );
 
@@ -200,7 +345,12 @@ GDALDatasetH QgsRasterCalculator::openOutputFile( GDALDriverH outputDriver )
 {
   //open output file
   char **papszOptions = nullptr;
+  for ( const QString &option : qgsAsConst( mCreateOptions ) )
+  {
+    papszOptions = CSLAddString( papszOptions, option.toLocal8Bit().constData() );
+  }
   GDALDatasetH outputDataset = GDALCreate( outputDriver, mOutputFile.toUtf8().constData(), mNumOutputColumns, mNumOutputRows, 1, GDT_Float32, papszOptions );
+  CSLDestroy( papszOptions );
   if ( !outputDataset )
   {
     return outputDataset;
@@ -21,6 +21,7 @@
 #include "qgsrectangle.h"
 #include "qgscoordinatereferencesystem.h"
 #include <QString>
+#include <QStringList>
 #include <QVector>
 #include "gdal.h"
 #include "qgis_analysis.h"
@@ -86,6 +87,9 @@ class ANALYSIS_EXPORT QgsRasterCalculator
                          const QgsRectangle &outputExtent, const QgsCoordinateReferenceSystem &outputCrs, int nOutputColumns, int nOutputRows, const QVector<QgsRasterCalculatorEntry> &rasterEntries );
 
     /** Starts the calculation and writes a new raster.
+     *
+     * The output is calculated in strips of rows, which are read and calculated in parallel
+     * and are aligned to the blocks of the output file.
      *
      * The optional \a feedback argument can be used for progress reporting and cancelation support.
      * \returns 0 in case of success
@@ -93,6 +97,21 @@ class ANALYSIS_EXPORT QgsRasterCalculator
     //TODO QGIS 3.0 - return QgsRasterCalculator::Result
     int processCalculation( QgsFeedback *feedback = nullptr );
 
+    /**
+     * Sets the GDAL creation \a options for the output file, e.g. "TILED=YES" and "COMPRESS=DEFLATE"
+     * for a tiled and compressed GeoTIFF.
+     * \see createOptions()
+     * \since QGIS 3.0
+     */
+    void setCreateOptions( const QStringList &options ) { mCreateOptions = options; }
+
+    /**
+     * Returns the GDAL creation options for the output file.
+     * \see setCreateOptions()
+     * \since QGIS 3.0
+     */
+    QStringList createOptions() const { return mCreateOptions; }
+
   private:
     //default constructor forbidden. We need formula, output file, output format and output raster resolution obligatory
     QgsRasterCalculator() = delete;
@@ -112,6 +131,7 @@ class ANALYSIS_EXPORT QgsRasterCalculator
     QString mFormulaString;
     QString mOutputFile;
     QString mOutputFormat;
+    QStringList mCreateOptions;
 
     //! Output raster extent
     QgsRectangle mOutputRectangle;
@@ -124,6 +144,11 @@ class ANALYSIS_EXPORT QgsRasterCalculator
 
     /***/
     QVector<QgsRasterCalculatorEntry> mRasterEntries;
+
+    //! Number of cells to read and calculate in one strip of rows
+    int mStripCells;
+
+    friend class TestQgsRasterCalculator;
 };
 
 #endif // QGSRASTERCALCULATOR_H
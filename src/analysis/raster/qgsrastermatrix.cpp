@@ -182,224 +182,188 @@ bool QgsRasterMatrix::log10()
   return oneArgumentOperation( opLOG10 );
 }
 
-bool QgsRasterMatrix::oneArgumentOperation( OneArgOperator op )
-{
-  if ( !mData )
-  {
-    return false;
-  }
+///@cond PRIVATE
 
-  int nEntries = mColumns * mRows;
-  double value;
+/**
+ * Applies \a function to all values of \a data which are not \a nodataValue.
+ * Keeping the operator outside of the loop lets the compiler vectorize the loop body.
+ */
+template <typename Function>
+static void applyOneArgumentFunction( double *data, int nEntries, double nodataValue, Function function )
+{
   for ( int i = 0; i < nEntries; ++i )
   {
-    value = mData[i];
-    if ( value != mNodataValue )
+    const double value = data[i];
+    if ( value != nodataValue )
     {
-      switch ( op )
-      {
-        case opSQRT:
-          if ( value < 0 ) //no complex numbers
-          {
-            mData[i] = mNodataValue;
-          }
-          else
-          {
-            mData[i] = std::sqrt( value );
-          }
-          break;
-        case opSIN:
-          mData[i] = std::sin( value );
-          break;
-        case opCOS:
-          mData[i] = std::cos( value );
-          break;
-        case opTAN:
-          mData[i] = std::tan( value );
-          break;
-        case opASIN:
-          mData[i] = std::asin( value );
-          break;
-        case opACOS:
-          mData[i] = std::acos( value );
-          break;
-        case opATAN:
-          mData[i] = std::atan( value );
-          break;
-        case opSIGN:
-          mData[i] = -value;
-          break;
-        case opLOG:
-          if ( value <= 0 )
-          {
-            mData[i] = mNodataValue;
-          }
-          else
-          {
-            mData[i] = ::log( value );
-          }
-          break;
-        case opLOG10:
-          if ( value <= 0 )
-          {
-            mData[i] = mNodataValue;
-          }
-          else
-          {
-            mData[i] = ::log10( value );
-          }
-          break;
-      }
+      data[i] = function( value );
     }
   }
-  return true;
 }
 
-double QgsRasterMatrix::calculateTwoArgumentOp( TwoArgOperator op, double arg1, double arg2 ) const
+/**
+ * Combines the \a nEntries values of \a left and \a right with \a function into \a result.
+ * A stride of 0 repeats the first value of an argument, a stride of 1 steps through it. Only one
+ * of the arguments may have a stride of 0.
+ * Values of either argument which are nodata result in \a resultNodataValue.
+ */
+template <typename Function>
+static void applyTwoArgumentFunction( const double *left, int leftStride, double leftNodataValue,
+                                      const double *right, int rightStride, double rightNodataValue,
+                                      double *result, int nEntries, double resultNodataValue, Function function )
 {
-  switch ( op )
+  if ( leftStride == 1 && rightStride == 1 )
   {
-    case opPLUS:
-      return arg1 + arg2;
-    case opMINUS:
-      return arg1 - arg2;
-    case opMUL:
-      return arg1 * arg2;
-    case opDIV:
-      if ( arg2 == 0 )
-      {
-        return mNodataValue;
-      }
-      else
-      {
-        return arg1 / arg2;
-      }
-    case opPOW:
-      if ( !testPowerValidity( arg1, arg2 ) )
-      {
-        return mNodataValue;
-      }
-      else
-      {
-        return std::pow( arg1, arg2 );
-      }
-    case opEQ:
-      return ( arg1 == arg2 ? 1.0 : 0.0 );
-    case opNE:
-      return ( arg1 == arg2 ? 0.0 : 1.0 );
-    case opGT:
-      return ( arg1 > arg2 ? 1.0 : 0.0 );
-    case opLT:
-      return ( arg1 < arg2 ? 1.0 : 0.0 );
-    case opGE:
-      return ( arg1 >= arg2 ? 1.0 : 0.0 );
-    case opLE:
-      return ( arg1 <= arg2 ? 1.0 : 0.0 );
-    case opAND:
-      return ( arg1 && arg2 ? 1.0 : 0.0 );
-    case opOR:
-      return ( arg1 || arg2 ? 1.0 : 0.0 );
+    for ( int i = 0; i < nEntries; ++i )
+    {
+      const double value1 = left[i];
+      const double value2 = right[i];
+      result[i] = value1 == leftNodataValue || value2 == rightNodataValue ? resultNodataValue : function( value1, value2 );
+    }
   }
-  return mNodataValue;
-}
-
-bool QgsRasterMatrix::twoArgumentOperation( TwoArgOperator op, const QgsRasterMatrix &other )
-{
-  if ( isNumber() && other.isNumber() ) //operation on two 1x1 matrices
+  else if ( leftStride == 0 )
   {
-    //operations with nodata values always generate nodata
-    if ( mData[0] == mNodataValue || other.number() == other.nodataValue() )
+    const double value1 = left[0];
+    for ( int i = 0; i < nEntries; ++i )
     {
-      mData[0] = mNodataValue;
+      const double value2 = right[i];
+      result[i] = value1 == leftNodataValue || value2 == rightNodataValue ? resultNodataValue : function( value1, value2 );
     }
-    else
+  }
+  else
+  {
+    const double value2 = right[0];
+    for ( int i = 0; i < nEntries; ++i )
     {
-      mData[0] = calculateTwoArgumentOp( op, mData[0], other.number() );
+      const double value1 = left[i];
+      result[i] = value1 == leftNodataValue || value2 == rightNodataValue ? resultNodataValue : function( value1, value2 );
     }
-    return true;
   }
+}
+
+///@endcond
 
-  //two matrices
-  if ( !isNumber() && !other.isNumber() )
+bool QgsRasterMatrix::oneArgumentOperation( OneArgOperator op )
+{
+  if ( !mData )
   {
-    double *matrix = other.mData;
-    int nEntries = mColumns * mRows;
-    double value1, value2;
+    return false;
+  }
 
-    for ( int i = 0; i < nEntries; ++i )
-    {
-      value1 = mData[i];
-      value2 = matrix[i];
-      if ( value1 == mNodataValue || value2 == other.mNodataValue )
-      {
-        mData[i] = mNodataValue;
-      }
-      else
-      {
-        mData[i] = calculateTwoArgumentOp( op, value1, value2 );
-      }
-    }
-    return true;
+  const int nEntries = mColumns * mRows;
+  const double nodata = mNodataValue;
+  switch ( op )
+  {
+    case opSQRT:
+      //no complex numbers
+      applyOneArgumentFunction( mData, nEntries, nodata, [nodata]( double value ) { return value < 0 ? nodata : std::sqrt( value ); } );
+      break;
+    case opSIN:
+      applyOneArgumentFunction( mData, nEntries, nodata, []( double value ) { return std::sin( value ); } );
+      break;
+    case opCOS:
+      applyOneArgumentFunction( mData, nEntries, nodata, []( double value ) { return std::cos( value ); } );
+      break;
+    case opTAN:
+      applyOneArgumentFunction( mData, nEntries, nodata, []( double value ) { return std::tan( value ); } );
+      break;
+    case opASIN:
+      applyOneArgumentFunction( mData, nEntries, nodata, []( double value ) { return std::asin( value ); } );
+      break;
+    case opACOS:
+      applyOneArgumentFunction( mData, nEntries, nodata, []( double value ) { return std::acos( value ); } );
+      break;
+    case opATAN:
+      applyOneArgumentFunction( mData, nEntries, nodata, []( double value ) { return std::atan( value ); } );
+      break;
+    case opSIGN:
+      applyOneArgumentFunction( mData, nEntries, nodata, []( double value ) { return -value; } );
+      break;
+    case opLOG:
+      applyOneArgumentFunction( mData, nEntries, nodata, [nodata]( double value ) { return value <= 0 ? nodata : ::log( value ); } );
+      break;
+    case opLOG10:
+      applyOneArgumentFunction( mData, nEntries, nodata, [nodata]( double value ) { return value <= 0 ? nodata : ::log10( value ); } );
+      break;
   }
+  return true;
+}
 
-  //this matrix is a single number and the other one a real matrix
-  if ( isNumber() )
+bool QgsRasterMatrix::twoArgumentOperation( TwoArgOperator op, const QgsRasterMatrix &other )
+{
+  const double *left = mData;
+  int leftStride = 1;
+  const double *right = other.mData;
+  int rightStride = 1;
+  int nEntries = mColumns * mRows;
+  double *result = mData;
+  double *numberData = nullptr;
+
+  if ( isNumber() && !other.isNumber() )
   {
-    double *matrix = other.mData;
-    int nEntries = other.nColumns() * other.nRows();
-    double value = mData[0];
-    delete[] mData;
+    //this matrix is a single number and the other one a real matrix, the result takes the size and nodata value of the other matrix
+    numberData = mData;
+    leftStride = 0;
+    nEntries = other.nColumns() * other.nRows();
     mData = new double[nEntries];
     mColumns = other.nColumns();
     mRows = other.nRows();
     mNodataValue = other.nodataValue();
-
-    if ( value == mNodataValue )
-    {
-      for ( int i = 0; i < nEntries; ++i )
-      {
-        mData[i] = mNodataValue;
-      }
-      return true;
-    }
-
-    for ( int i = 0; i < nEntries; ++i )
-    {
-      if ( matrix[i] == other.mNodataValue )
-      {
-        mData[i] = mNodataValue;
-        continue;
-      }
-
-      mData[i] = calculateTwoArgumentOp( op, value, matrix[i] );
-    }
-    return true;
+    result = mData;
   }
-  else //this matrix is a real matrix and the other a number
+  else if ( !isNumber() && other.isNumber() )
   {
-    double value = other.number();
-    int nEntries = mColumns * mRows;
-
-    if ( other.number() == other.mNodataValue )
-    {
-      for ( int i = 0; i < nEntries; ++i )
-      {
-        mData[i] = mNodataValue;
-      }
-      return true;
-    }
-
-    for ( int i = 0; i < nEntries; ++i )
-    {
-      if ( mData[i] == mNodataValue )
-      {
-        continue;
-      }
+    rightStride = 0;
+  }
 
-      mData[i] = calculateTwoArgumentOp( op, mData[i], value );
-    }
-    return true;
+  //operations with nodata values always generate nodata
+  const double nodata = mNodataValue;
+  const double otherNodata = other.mNodataValue;
+  switch ( op )
+  {
+    case opPLUS:
+      applyTwoArgumentFunction( left, leftStride, nodata, right, rightStride, otherNodata, result, nEntries, nodata, []( double a, double b ) { return a + b; } );
+      break;
+    case opMINUS:
+      applyTwoArgumentFunction( left, leftStride, nodata, right, rightStride, otherNodata, result, nEntries, nodata, []( double a, double b ) { return a - b; } );
+      break;
+    case opMUL:
+      applyTwoArgumentFunction( left, leftStride, nodata, right, rightStride, otherNodata, result, nEntries, nodata, []( double a, double b ) { return a * b; } );
+      break;
+    case opDIV:
+      applyTwoArgumentFunction( left, leftStride, nodata, right, rightStride, otherNodata, result, nEntries, nodata, [nodata]( double a, double b ) { return b == 0 ? nodata : a / b; } );
+      break;
+    case opPOW:
+      applyTwoArgumentFunction( left, leftStride, nodata, right, rightStride, otherNodata, result, nEntries, nodata, [this, nodata]( double a, double b ) { return testPowerValidity( a, b ) ? std::pow( a, b ) : nodata; } );
+      break;
+    case opEQ:
+      applyTwoArgumentFunction( left, leftStride, nodata, right, rightStride, otherNodata, result, nEntries, nodata, []( double a, double b ) { return a == b ? 1.0 : 0.0; } );
+      break;
+    case opNE:
+      applyTwoArgumentFunction( left, leftStride, nodata, right, rightStride, otherNodata, result, nEntries, nodata, []( double a, double b ) { return a == b ? 0.0 : 1.0; } );
+      break;
+    case opGT:
+      applyTwoArgumentFunction( left, leftStride, nodata, right, rightStride, otherNodata, result, nEntries, nodata, []( double a, double b ) { return a > b ? 1.0 : 0.0; } );
+      break;
+    case opLT:
+      applyTwoArgumentFunction( left, leftStride, nodata, right, rightStride, otherNodata, result, nEntries, nodata, []( double a, double b ) { return a < b ? 1.0 : 0.0; } );
+      break;
+    case opGE:
+      applyTwoArgumentFunction( left, leftStride, nodata, right, rightStride, otherNodata, result, nEntries, nodata, []( double a, double b ) { return a >= b ? 1.0 : 0.0; } );
+      break;
+    case opLE:
+      applyTwoArgumentFunction( left, leftStride, nodata, right, rightStride, otherNodata, result, nEntries, nodata, []( double a, double b ) { return a <= b ? 1.0 : 0.0; } );
+      break;
+    case opAND:
+      applyTwoArgumentFunction( left, leftStride, nodata, right, rightStride, otherNodata, result, nEntries, nodata, []( double a, double b ) { return a && b ? 1.0 : 0.0; } );
+      break;
+    case opOR:
+      applyTwoArgumentFunction( left, leftStride, nodata, right, rightStride, otherNodata, result, nEntries, nodata, []( double a, double b ) { return a || b ? 1.0 : 0.0; } );
+      break;
   }
+
+  delete[] numberData;
+  return true;
 }
 
 bool QgsRasterMatrix::testPowerValidity( double base, double power ) const
@@ -17,6 +17,7 @@
 
 #include "qgsruggednessfilter.h"
 #include <cmath>
+#include <typeinfo>
 
 QgsRuggednessFilter::QgsRuggednessFilter( const QString &inputFile, const QString &outputFile, const QString &outputFormat )
   : QgsNineCellFilter( inputFile, outputFile, outputFormat )
@@ -89,3 +90,25 @@ float QgsRuggednessFilter::processNineCellWindow( float *x11, float *x21, float
   return std::sqrt( sum );
 }
 
+bool QgsRuggednessFilter::supportsConcurrentProcessing() const
+{
+  // subclasses reimplementing processNineCellWindow(), e.g. in Python, are not known to be thread safe
+  return typeid( *this ) == typeid( QgsRuggednessFilter );
+}
+
+void QgsRuggednessFilter::processNineCellRow( float *rowAbove, float *row, float *rowBelow, float *result, int width )
+{
+  if ( typeid( *this ) != typeid( QgsRuggednessFilter ) )
+  {
+    // honor the reimplementations of processNineCellWindow() in subclasses
+    QgsNineCellFilter::processNineCellRow( rowAbove, row, rowBelow, result, width );
+    return;
+  }
+
+  // non virtual calls, which can be inlined
+  for ( int j = 0; j < width; ++j )
+  {
+    result[j] = QgsRuggednessFilter::processNineCellWindow( &rowAbove[j - 1], &rowAbove[j], &rowAbove[j + 1], &row[j - 1], &row[j],
+                &row[j + 1], &rowBelow[j - 1], &rowBelow[j], &rowBelow[j + 1] );
+  }
+}
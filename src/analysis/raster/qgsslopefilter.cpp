@@ -17,6 +17,7 @@
 
 #include "qgsslopefilter.h"
 #include <cmath>
+#include <typeinfo>
 
 QgsSlopeFilter::QgsSlopeFilter( const QString &inputFile, const QString &outputFile, const QString &outputFormat )
   : QgsDerivativeFilter( inputFile, outputFile, outputFormat )
@@ -38,3 +39,25 @@ float QgsSlopeFilter::processNineCellWindow( float *x11, float *x21, float *x31,
   return std::atan( std::sqrt( derX * derX + derY * derY ) ) * 180.0 / M_PI;
 }
 
+bool QgsSlopeFilter::supportsConcurrentProcessing() const
+{
+  // subclasses reimplementing processNineCellWindow(), e.g. in Python, are not known to be thread safe
+  return typeid( *this ) == typeid( QgsSlopeFilter );
+}
+
+void QgsSlopeFilter::processNineCellRow( float *rowAbove, float *row, float *rowBelow, float *result, int width )
+{
+  if ( typeid( *this ) != typeid( QgsSlopeFilter ) )
+  {
+    // honor the reimplementations of processNineCellWindow() in subclasses
+    QgsNineCellFilter::processNineCellRow( rowAbove, row, rowBelow, result, width );
+    return;
+  }
+
+  // non virtual calls, which can be inlined
+  for ( int j = 0; j < width; ++j )
+  {
+    result[j] = QgsSlopeFilter::processNineCellWindow( &rowAbove[j - 1], &rowAbove[j], &rowAbove[j + 1], &row[j - 1], &row[j],
+                &row[j + 1], &rowBelow[j - 1], &rowBelow[j], &rowBelow[j + 1] );
+  }
+}
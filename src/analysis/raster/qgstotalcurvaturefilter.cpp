@@ -17,6 +17,8 @@
 
 #include "qgstotalcurvaturefilter.h"
 
+#include <typeinfo>
+
 QgsTotalCurvatureFilter::QgsTotalCurvatureFilter( const QString &inputFile, const QString &outputFile, const QString &outputFormat )
   : QgsNineCellFilter( inputFile, outputFile, outputFormat )
 {
@@ -41,3 +43,26 @@ float QgsTotalCurvatureFilter::processNineCellWindow( float *x11, float *x21, fl
 
   return dxx * dxx + 2 * dxy * dxy + dyy * dyy;
 }
+
+bool QgsTotalCurvatureFilter::supportsConcurrentProcessing() const
+{
+  // subclasses reimplementing processNineCellWindow(), e.g. in Python, are not known to be thread safe
+  return typeid( *this ) == typeid( QgsTotalCurvatureFilter );
+}
+
+void QgsTotalCurvatureFilter::processNineCellRow( float *rowAbove, float *row, float *rowBelow, float *result, int width )
+{
+  if ( typeid( *this ) != typeid( QgsTotalCurvatureFilter ) )
+  {
+    // honor the reimplementations of processNineCellWindow() in subclasses
+    QgsNineCellFilter::processNineCellRow( rowAbove, row, rowBelow, result, width );
+    return;
+  }
+
+  // non virtual calls, which can be inlined
+  for ( int j = 0; j < width; ++j )
+  {
+    result[j] = QgsTotalCurvatureFilter::processNineCellWindow( &rowAbove[j - 1], &rowAbove[j], &rowAbove[j + 1], &row[j - 1], &row[j],
+                &row[j + 1], &rowBelow[j - 1], &rowBelow[j], &rowBelow[j + 1] );
+  }
+}
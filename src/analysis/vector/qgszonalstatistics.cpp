@@ -19,6 +19,8 @@
 #include "qgsfeatureiterator.h"
 #include "qgsfeedback.h"
 #include "qgsgeometry.h"
+#include "qgsgeometryengine.h"
+#include "qgspoint.h"
 #include "qgsvectordataprovider.h"
 #include "qgsvectorlayer.h"
 #include "qgsrasterdataprovider.h"
@@ -26,7 +28,359 @@
 #include "qgsrasterblock.h"
 #include "qgslogger.h"
 
+#include <QCache>
 #include <QFile>
+#include <QMutex>
+#include <QThreadPool>
+#include <QVector>
+#include <QtConcurrentMap>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+///@cond PRIVATE
+
+//! Size (in cells) of the raster tiles, which are read once and shared by neighbouring polygons
+static const int TILE_SIZE = 256;
+
+//! Maximum size (in bytes) of the cached raster tiles
+static const int MAX_TILE_CACHE_SIZE = 256 * 1024 * 1024;
+
+//! Number of polygons per thread processed between progress reports
+static const int POLYGONS_PER_THREAD_AND_BATCH = 64;
+
+/**
+ * Calculates the coverage of raster cells by a polygon with a scanline algorithm, row by row.
+ * The coverage is either binary (cell center within the polygon) or the fraction of the cell
+ * area covered by the polygon.
+ */
+class QgsZonalStatisticsRasterizer
+{
+  public:
+
+    /**
+     * Constructor for a window of \a columns x \a rows cells, with the top left corner of the
+     * window at \a left, \a top.
+     */
+    QgsZonalStatisticsRasterizer( const QgsGeometry &polygon, double left, double top, double cellSizeX, double cellSizeY, int columns, int rows );
+
+    /**
+     * Sets \a coverage to 1 for the cells of \a row with their center (at \a centerY and \a centersX)
+     * strictly within the polygon, and to 0 otherwise.
+     * Returns false if the centers of the row touch the polygon boundary in a vertex or on an edge.
+     * The cells of the row have to be tested one by one then.
+     */
+    bool centerCoverage( int row, double centerY, const QVector< double > &centersX, QVector< double > &coverage ) const;
+
+    //! Sets \a coverage to the fraction of the area of each cell of \a row covered by the polygon
+    void areaCoverage( int row, QVector< double > &coverage ) const;
+
+  private:
+
+    struct Edge
+    {
+      double x0;
+      double y0;
+      double x1;
+      double y1;
+      //! Orientation factor, so that exterior rings add their area and interior rings subtract it
+      double orientation;
+    };
+
+    //! Sets \a x to the sorted x coordinates where the edges of \a row cross the horizontal line at \a y
+    void crossings( int row, double y, QVector< double > &x ) const;
+
+    //! Adds the area between the segment and the bottom of the row to the columns spanned by the segment
+    void addSegmentArea( const Edge &edge, double xStart, double yStart, double xEnd, double yEnd, double bottom, QVector< double > &area ) const;
+
+    double mLeft;
+    double mTop;
+    double mCellSizeX;
+    double mCellSizeY;
+    int mColumns;
+
+    QVector< Edge > mEdges;
+    //! Indexes of the edges overlapping each row
+    QVector< QVector< int > > mRowEdges;
+};
+
+QgsZonalStatisticsRasterizer::QgsZonalStatisticsRasterizer( const QgsGeometry &polygon, double left, double top, double cellSizeX, double cellSizeY, int columns, int rows )
+  : mLeft( left )
+  , mTop( top )
+  , mCellSizeX( cellSizeX )
+  , mCellSizeY( cellSizeY )
+  , mColumns( columns )
+  , mRowEdges( rows )
+{
+  QgsGeometry geometry = polygon;
+  if ( QgsWkbTypes::isCurvedType( geometry.wkbType() ) )
+    geometry = QgsGeometry( geometry.geometry()->segmentize() );
+
+  QgsMultiPolygon parts;
+  if ( geometry.isMultipart() )
+    parts = geometry.asMultiPolygon();
+  else
+    parts << geometry.asPolygon();
+
+  for ( const QgsPolygon &part : qgsAsConst( parts ) )
+  {
+    for ( int ringIndex = 0; ringIndex < part.size(); ++ringIndex )
+    {
+      const QgsPolyline &ring = part.at( ringIndex );
+      if ( ring.size() < 3 )
+        continue;
+
+      // twice the signed area, positive for counter-clockwise rings
+      double signedArea = 0;
+      for ( int i = 0; i < ring.size() - 1; ++i )
+        signedArea += ring.at( i ).x() * ring.at( i + 1 ).y() - ring.at( i + 1 ).x() * ring.at( i ).y();
+      if ( qgsDoubleNear( signedArea, 0.0 ) )
+        continue;
+
+      const double orientation = ( signedArea > 0 ? 1.0 : -1.0 ) * ( ringIndex == 0 ? 1.0 : -1.0 );
+      for ( int i = 0; i < ring.size() - 1; ++i )
+      {
+        const Edge edge = { ring.at( i ).x(), ring.at( i ).y(), ring.at( i + 1 ).x(), ring.at( i + 1 ).y(), orientation };
+        if ( edge.x0 == edge.x1 && edge.y0 == edge.y1 )
+          continue;
+
+        // one row more on each side, so that rounding errors can't drop an edge
+        const int firstRow = std::max( static_cast< int >( std::floor( ( top - std::max( edge.y0, edge.y1 ) ) / cellSizeY ) ) - 1, 0 );
+        const int lastRow = std::min( static_cast< int >( std::floor( ( top - std::min( edge.y0, edge.y1 ) ) / cellSizeY ) ) + 1, rows - 1 );
+        if ( firstRow > lastRow )
+          continue;
+
+        mEdges << edge;
+        for ( int row = firstRow; row <= lastRow; ++row )
+          mRowEdges[ row ] << mEdges.size() - 1;
+      }
+    }
+  }
+}
+
+void QgsZonalStatisticsRasterizer::crossings( int row, double y, QVector< double > &x ) const
+{
+  x.clear();
+  for ( int index : mRowEdges.at( row ) )
+  {
+    const Edge &edge = mEdges.at( index );
+    if ( ( edge.y0 > y ) != ( edge.y1 > y ) )
+      x << edge.x0 + ( y - edge.y0 ) * ( edge.x1 - edge.x0 ) / ( edge.y1 - edge.y0 );
+  }
+  std::sort( x.begin(), x.end() );
+}
+
+bool QgsZonalStatisticsRasterizer::centerCoverage( int row, double centerY, const QVector< double > &centersX, QVector< double > &coverage ) const
+{
+  coverage.fill( 0, mColumns );
+
+  for ( int index : mRowEdges.at( row ) )
+  {
+    const Edge &edge = mEdges.at( index );
+    if ( edge.y0 == centerY || edge.y1 == centerY )
+      return false;
+  }
+
+  QVector< double > x;
+  crossings( row, centerY, x );
+  int column = 0;
+  for ( int i = 0; i + 1 < x.size(); i += 2 )
+  {
+    const double start = x.at( i );
+    const double end = x.at( i + 1 );
+    while ( column < mColumns && centersX.at( column ) < start )
+      column++;
+    if ( column < mColumns && centersX.at( column ) == start )
+      return false;
+    while ( column < mColumns && centersX.at( column ) < end )
+      coverage[ column++ ] = 1;
+    if ( column < mColumns && centersX.at( column ) == end )
+      return false;
+  }
+  return true;
+}
+
+void QgsZonalStatisticsRasterizer::areaCoverage( int row, QVector< double > &coverage ) const
+{
+  coverage.fill( 0, mColumns );
+  const double top = mTop - row * mCellSizeY;
+  const double bottom = top - mCellSizeY;
+
+  // By Green's theorem the area of the polygon within a cell is the integral of (y - bottom) along
+  // the boundary of the clipped polygon. The cell sides are vertical or at the bottom of the row,
+  // so they do not contribute. What remains are the polygon edges within the row and the parts of
+  // the top of the row inside the polygon.
+  for ( int index : mRowEdges.at( row ) )
+  {
+    const Edge &edge = mEdges.at( index );
+    double x0 = edge.x0;
+    double y0 = edge.y0;
+    double x1 = edge.x1;
+    double y1 = edge.y1;
+    if ( y0 == y1 )
+    {
+      if ( y0 < bottom || y0 > top )
+        continue;
+    }
+    else
+    {
+      // clip the edge to the row
+      const double tBottom = ( bottom - edge.y0 ) / ( edge.y1 - edge.y0 );
+      const double tTop = ( top - edge.y0 ) / ( edge.y1 - edge.y0 );
+      const double tStart = std::max( 0.0, std::min( tBottom, tTop ) );
+      const double tEnd = std::min( 1.0, std::max( tBottom, tTop ) );
+      if ( tStart >= tEnd )
+        continue;
+
+      x0 = edge.x0 + tStart * ( edge.x1 - edge.x0 );
+      y0 = qBound( bottom, edge.y0 + tStart * ( edge.y1 - edge.y0 ), top );
+      x1 = edge.x0 + tEnd * ( edge.x1 - edge.x0 );
+      y1 = qBound( bottom, edge.y0 + tEnd * ( edge.y1 - edge.y0 ), top );
+    }
+    addSegmentArea( edge, x0, y0, x1, y1, bottom, coverage );
+  }
+
+  QVector< double > x;
+  crossings( row, top, x );
+  for ( int i = 0; i + 1 < x.size(); i += 2 )
+  {
+    const int firstColumn = std::max( static_cast< int >( std::floor( ( x.at( i ) - mLeft ) / mCellSizeX ) ), 0 );
+    const int lastColumn = std::min( static_cast< int >( std::floor( ( x.at( i + 1 ) - mLeft ) / mCellSizeX ) ), mColumns - 1 );
+    for ( int column = firstColumn; column <= lastColumn; ++column )
+    {
+      const double cellLeft = mLeft + column * mCellSizeX;
+      const double overlap = std::min( x.at( i + 1 ), cellLeft + mCellSizeX ) - std::max( x.at( i ), cellLeft );
+      if ( overlap > 0 )
+        coverage[ column ] += overlap * mCellSizeY;
+    }
+  }
+
+  const double cellArea = mCellSizeX * mCellSizeY;
+  for ( int column = 0; column < mColumns; ++column )
+    coverage[ column ] = qBound( 0.0, coverage.at( column ) / cellArea, 1.0 );
+}
+
+void QgsZonalStatisticsRasterizer::addSegmentArea( const Edge &edge, double xStart, double yStart, double xEnd, double yEnd, double bottom, QVector< double > &area ) const
+{
+  if ( xStart == xEnd )
+    return;
+
+  const double minX = std::min( xStart, xEnd );
+  const double maxX = std::max( xStart, xEnd );
+  const int firstColumn = std::max( static_cast< int >( std::floor( ( minX - mLeft ) / mCellSizeX ) ), 0 );
+  const int lastColumn = std::min( static_cast< int >( std::floor( ( maxX - mLeft ) / mCellSizeX ) ), mColumns - 1 );
+  const double slope = ( yEnd - yStart ) / ( xEnd - xStart );
+  for ( int column = firstColumn; column <= lastColumn; ++column )
+  {
+    const double cellLeft = mLeft + column * mCellSizeX;
+    const double pieceStart = std::max( minX, cellLeft );
+    const double pieceEnd = std::min( maxX, cellLeft + mCellSizeX );
+    if ( pieceEnd <= pieceStart )
+      continue;
+
+    const double meanHeight = yStart + slope * ( 0.5 * ( pieceStart + pieceEnd ) - xStart ) - bottom;
+    // counter-clockwise rings run from right to left above their interior
+    const double dx = xEnd > xStart ? pieceEnd - pieceStart : pieceStart - pieceEnd;
+    area[ column ] -= edge.orientation * dx * meanHeight;
+  }
+}
+
+/**
+ * Raster tiles aligned to the raster grid. Tiles are cached, so that neighbouring polygons do not
+ * read the same cells again. Tiles are read with the provider passed by the caller, as a provider
+ * can't be used by several threads at the same time.
+ */
+class QgsZonalStatistics::RasterTiles
+{
+  public:
+
+    RasterTiles( int band, const QgsRectangle &extent, double cellSizeX, double cellSizeY, int columns, int rows )
+      : mBand( band )
+      , mExtent( extent )
+      , mCellSizeX( cellSizeX )
+      , mCellSizeY( cellSizeY )
+      , mColumns( columns )
+      , mRows( rows )
+      , mTiles( MAX_TILE_CACHE_SIZE )
+    {}
+
+    //! Sets \a values to the values of the cells of a window, row by row. Cells which can't be read are NaN.
+    void readWindow( QgsRasterDataProvider *provider, int offsetX, int offsetY, int nCellsX, int nCellsY, QVector< float > &values )
+    {
+      values.fill( std::numeric_limits< float >::quiet_NaN(), nCellsX * nCellsY );
+
+      for ( int tileY = offsetY / TILE_SIZE; tileY <= ( offsetY + nCellsY - 1 ) / TILE_SIZE; ++tileY )
+      {
+        for ( int tileX = offsetX / TILE_SIZE; tileX <= ( offsetX + nCellsX - 1 ) / TILE_SIZE; ++tileX )
+        {
+          std::shared_ptr< QgsRasterBlock > block = tile( provider, tileX, tileY );
+          if ( !block )
+            continue;
+
+          const int tileLeft = tileX * TILE_SIZE;
+          const int tileTop = tileY * TILE_SIZE;
+          const int firstColumn = std::max( offsetX, tileLeft );
+          const int lastColumn = std::min( offsetX + nCellsX, tileLeft + block->width() );
+          const int firstRow = std::max( offsetY, tileTop );
+          const int lastRow = std::min( offsetY + nCellsY, tileTop + block->height() );
+          for ( int row = firstRow; row < lastRow; ++row )
+          {
+            float *out = values.data() + ( row - offsetY ) * nCellsX;
+            for ( int column = firstColumn; column < lastColumn; ++column )
+              out[ column - offsetX ] = static_cast< float >( block->value( row - tileTop, column - tileLeft ) );
+          }
+        }
+      }
+    }
+
+  private:
+
+    std::shared_ptr< QgsRasterBlock > tile( QgsRasterDataProvider *provider, int tileX, int tileY )
+    {
+      const QPair< int, int > key( tileX, tileY );
+      {
+        QMutexLocker locker( &mMutex );
+        if ( std::shared_ptr< QgsRasterBlock > *cached = mTiles.object( key ) )
+          return *cached;
+      }
+
+      // read outside of the lock, other threads may continue with their tiles meanwhile
+      const int width = std::min( TILE_SIZE, mColumns - tileX * TILE_SIZE );
+      const int height = std::min( TILE_SIZE, mRows - tileY * TILE_SIZE );
+      const QgsRectangle extent( mExtent.xMinimum() + tileX * TILE_SIZE * mCellSizeX,
+                                 mExtent.yMaximum() - ( tileY * TILE_SIZE + height ) * mCellSizeY,
+                                 mExtent.xMinimum() + ( tileX * TILE_SIZE + width ) * mCellSizeX,
+                                 mExtent.yMaximum() - tileY * TILE_SIZE * mCellSizeY );
+      std::shared_ptr< QgsRasterBlock > block( provider->block( mBand, extent, width, height ) );
+      if ( !block || !block->isValid() )
+        return nullptr;
+
+      QMutexLocker locker( &mMutex );
+      mTiles.insert( key, new std::shared_ptr< QgsRasterBlock >( block ), std::max( 1, width * height * block->dataTypeSize() ) );
+      return block;
+    }
+
+    int mBand;
+    QgsRectangle mExtent;
+    double mCellSizeX;
+    double mCellSizeY;
+    int mColumns;
+    int mRows;
+
+    QMutex mMutex;
+    QCache< QPair< int, int >, std::shared_ptr< QgsRasterBlock > > mTiles;
+};
+
+//! A polygon and its calculated statistics
+struct QgsZonalStatisticsPolygon
+{
+  QgsFeatureId id;
+  QgsGeometry geometry;
+  QgsAttributeMap attributes;
+};
+
+///@endcond
 
 QgsZonalStatistics::QgsZonalStatistics( QgsVectorLayer *polygonLayer, QgsRasterLayer *rasterLayer, const QString &attributePrefix, int rasterBand, QgsZonalStatistics::Statistics stats )
   : mRasterLayer( rasterLayer )
@@ -63,160 +417,144 @@ int QgsZonalStatistics::calculateStatistics( QgsFeedback *feedback )
   mInputNodataValue = mRasterProvider->sourceNoDataValue( mRasterBand );
 
   //get geometry info about raster layer
-  int nCellsXProvider = mRasterProvider->xSize();
-  int nCellsYProvider = mRasterProvider->ySize();
-  double cellsizeX = mRasterLayer->rasterUnitsPerPixelX();
-  if ( cellsizeX < 0 )
-  {
-    cellsizeX = -cellsizeX;
-  }
-  double cellsizeY = mRasterLayer->rasterUnitsPerPixelY();
-  if ( cellsizeY < 0 )
-  {
-    cellsizeY = -cellsizeY;
-  }
-  QgsRectangle rasterBBox = mRasterProvider->extent();
+  mRasterColumns = mRasterProvider->xSize();
+  mRasterRows = mRasterProvider->ySize();
+  mCellSizeX = std::fabs( mRasterLayer->rasterUnitsPerPixelX() );
+  mCellSizeY = std::fabs( mRasterLayer->rasterUnitsPerPixelY() );
+  mRasterExtent = mRasterProvider->extent();
 
   //add the new fields to the provider
   QList<QgsField> newFieldList;
-  QString countFieldName;
-  if ( mStatistics & QgsZonalStatistics::Count )
-  {
-    countFieldName = getUniqueFieldName( mAttributePrefix + "count", newFieldList );
-    QgsField countField( countFieldName, QVariant::Double, QStringLiteral( "double precision" ) );
-    newFieldList.push_back( countField );
-  }
-  QString sumFieldName;
-  if ( mStatistics & QgsZonalStatistics::Sum )
+  QList< QPair< Statistic, QString > > statisticFieldNames;
+  auto addField = [&]( Statistic statistic, const QString & name, QVariant::Type type, const QString & typeName )
   {
-    sumFieldName = getUniqueFieldName( mAttributePrefix + "sum", newFieldList );
-    QgsField sumField( sumFieldName, QVariant::Double, QStringLiteral( "double precision" ) );
-    newFieldList.push_back( sumField );
-  }
-  QString meanFieldName;
-  if ( mStatistics & QgsZonalStatistics::Mean )
-  {
-    meanFieldName = getUniqueFieldName( mAttributePrefix + "mean", newFieldList );
-    QgsField meanField( meanFieldName, QVariant::Double, QStringLiteral( "double precision" ) );
-    newFieldList.push_back( meanField );
-  }
-  QString medianFieldName;
-  if ( mStatistics & QgsZonalStatistics::Median )
-  {
-    medianFieldName = getUniqueFieldName( mAttributePrefix + "median", newFieldList );
-    QgsField medianField( medianFieldName, QVariant::Double, QStringLiteral( "double precision" ) );
-    newFieldList.push_back( medianField );
-  }
-  QString stdevFieldName;
-  if ( mStatistics & QgsZonalStatistics::StDev )
-  {
-    stdevFieldName = getUniqueFieldName( mAttributePrefix + "stdev", newFieldList );
-    QgsField stdField( stdevFieldName, QVariant::Double, QStringLiteral( "double precision" ) );
-    newFieldList.push_back( stdField );
-  }
-  QString minFieldName;
-  if ( mStatistics & QgsZonalStatistics::Min )
+    if ( !( mStatistics & statistic ) )
+      return;
+
+    const QString fieldName = getUniqueFieldName( mAttributePrefix + name, newFieldList );
+    newFieldList.push_back( QgsField( fieldName, type, typeName ) );
+    statisticFieldNames << qMakePair( statistic, fieldName );
+  };
+  addField( QgsZonalStatistics::Count, QStringLiteral( "count" ), QVariant::Double, QStringLiteral( "double precision" ) );
+  addField( QgsZonalStatistics::Sum, QStringLiteral( "sum" ), QVariant::Double, QStringLiteral( "double precision" ) );
+  addField( QgsZonalStatistics::Mean, QStringLiteral( "mean" ), QVariant::Double, QStringLiteral( "double precision" ) );
+  addField( QgsZonalStatistics::Median, QStringLiteral( "median" ), QVariant::Double, QStringLiteral( "double precision" ) );
+  addField( QgsZonalStatistics::StDev, QStringLiteral( "stdev" ), QVariant::Double, QStringLiteral( "double precision" ) );
+  addField( QgsZonalStatistics::Min, QStringLiteral( "min" ), QVariant::Double, QStringLiteral( "double precision" ) );
+  addField( QgsZonalStatistics::Max, QStringLiteral( "max" ), QVariant::Double, QStringLiteral( "double precision" ) );
+  addField( QgsZonalStatistics::Range, QStringLiteral( "range" ), QVariant::Double, QStringLiteral( "double precision" ) );
+  addField( QgsZonalStatistics::Minority, QStringLiteral( "minority" ), QVariant::Double, QStringLiteral( "double precision" ) );
+  addField( QgsZonalStatistics::Majority, QStringLiteral( "majority" ), QVariant::Double, QStringLiteral( "double precision" ) );
+  addField( QgsZonalStatistics::Variety, QStringLiteral( "variety" ), QVariant::Int, QStringLiteral( "int" ) );
+  addField( QgsZonalStatistics::Variance, QStringLiteral( "variance" ), QVariant::Double, QStringLiteral( "double precision" ) );
+
+  QStringList percentileFieldNames;
+  if ( mStatistics & QgsZonalStatistics::Percentiles )
   {
-    minFieldName = getUniqueFieldName( mAttributePrefix + "min", newFieldList );
-    QgsField minField( minFieldName, QVariant::Double, QStringLiteral( "double precision" ) );
-    newFieldList.push_back( minField );
+    for ( double percentile : qgsAsConst( mPercentiles ) )
+    {
+      const QString fieldName = getUniqueFieldName( mAttributePrefix + 'p' + QString::number( percentile ).replace( '.', '_' ), newFieldList );
+      newFieldList.push_back( QgsField( fieldName, QVariant::Double, QStringLiteral( "double precision" ) ) );
+      percentileFieldNames << fieldName;
+    }
   }
-  QString maxFieldName;
-  if ( mStatistics & QgsZonalStatistics::Max )
+  vectorProvider->addAttributes( newFieldList );
+
+  //index of the new fields
+  mFieldIndexes.clear();
+  for ( const QPair< Statistic, QString > &field : qgsAsConst( statisticFieldNames ) )
   {
-    maxFieldName = getUniqueFieldName( mAttributePrefix + "max", newFieldList );
-    QgsField maxField( maxFieldName, QVariant::Double, QStringLiteral( "double precision" ) );
-    newFieldList.push_back( maxField );
+    const int index = vectorProvider->fieldNameIndex( field.second );
+    if ( index == -1 )
+    {
+      //failed to create a required field
+      return 8;
+    }
+    mFieldIndexes.insert( field.first, index );
   }
-  QString rangeFieldName;
-  if ( mStatistics & QgsZonalStatistics::Range )
+  mPercentileFieldIndexes.clear();
+  for ( const QString &fieldName : qgsAsConst( percentileFieldNames ) )
   {
-    rangeFieldName = getUniqueFieldName( mAttributePrefix + "range", newFieldList );
-    QgsField rangeField( rangeFieldName, QVariant::Double, QStringLiteral( "double precision" ) );
-    newFieldList.push_back( rangeField );
+    const int index = vectorProvider->fieldNameIndex( fieldName );
+    if ( index == -1 )
+    {
+      return 8;
+    }
+    mPercentileFieldIndexes << index;
   }
-  QString minorityFieldName;
-  if ( mStatistics & QgsZonalStatistics::Minority )
+
+  //progress dialog
+  long featureCount = vectorProvider->featureCount();
+
+  bool statsStoreValueCount = ( mStatistics & QgsZonalStatistics::Median ) ||
+                              ( mStatistics & QgsZonalStatistics::Minority ) ||
+                              ( mStatistics & QgsZonalStatistics::Majority ) ||
+                              ( mStatistics & QgsZonalStatistics::Variety ) ||
+                              ( mStatistics & QgsZonalStatistics::Percentiles );
+
+  RasterTiles tiles( mRasterBand, mRasterExtent, mCellSizeX, mCellSizeY, mRasterColumns, mRasterRows );
+
+  // a provider can't be used from several threads at once, so every thread reads with a clone of its own
+  QMutex providerMutex;
+  std::vector< std::unique_ptr< QgsRasterDataProvider > > providerClones;
+  QList< QgsRasterDataProvider * > idleProviders;
+  auto acquireProvider = [&]() -> QgsRasterDataProvider *
   {
-    minorityFieldName = getUniqueFieldName( mAttributePrefix + "minority", newFieldList );
-    QgsField minorityField( minorityFieldName, QVariant::Double, QStringLiteral( "double precision" ) );
-    newFieldList.push_back( minorityField );
-  }
-  QString majorityFieldName;
-  if ( mStatistics & QgsZonalStatistics::Majority )
+    QMutexLocker locker( &providerMutex );
+    if ( !idleProviders.isEmpty() )
+      return idleProviders.takeLast();
+
+    QgsRasterDataProvider *clone = dynamic_cast< QgsRasterDataProvider * >( mRasterProvider->clone() );
+    if ( clone )
+      providerClones.emplace_back( clone );
+    return clone;
+  };
+  auto releaseProvider = [&]( QgsRasterDataProvider * provider )
   {
-    majorityFieldName = getUniqueFieldName( mAttributePrefix + "majority", newFieldList );
-    QgsField majField( majorityFieldName, QVariant::Double, QStringLiteral( "double precision" ) );
-    newFieldList.push_back( majField );
-  }
-  QString varietyFieldName;
-  if ( mStatistics & QgsZonalStatistics::Variety )
+    QMutexLocker locker( &providerMutex );
+    idleProviders << provider;
+  };
+
+  bool parallel = QThreadPool::globalInstance()->maxThreadCount() > 1;
+  if ( parallel )
   {
-    varietyFieldName = getUniqueFieldName( mAttributePrefix + "variety", newFieldList );
-    QgsField varietyField( varietyFieldName, QVariant::Int, QStringLiteral( "int" ) );
-    newFieldList.push_back( varietyField );
+    QgsRasterDataProvider *provider = acquireProvider();
+    if ( provider )
+      releaseProvider( provider );
+    else
+      parallel = false;
   }
-  QString varianceFieldName;
-  if ( mStatistics & QgsZonalStatistics::Variance )
+
+  auto processPolygon = [&]( QgsZonalStatisticsPolygon & polygon )
   {
-    varianceFieldName = getUniqueFieldName( mAttributePrefix + "variance", newFieldList );
-    QgsField varianceField( varianceFieldName, QVariant::Double, QStringLiteral( "double precision" ) );
-    newFieldList.push_back( varianceField );
-  }
-  vectorProvider->addAttributes( newFieldList );
+    if ( feedback && feedback->isCanceled() )
+      return;
 
-  //index of the new fields
-  int countIndex = mStatistics & QgsZonalStatistics::Count ? vectorProvider->fieldNameIndex( countFieldName ) : -1;
-  int sumIndex = mStatistics & QgsZonalStatistics::Sum ? vectorProvider->fieldNameIndex( sumFieldName ) : -1;
-  int meanIndex = mStatistics & QgsZonalStatistics::Mean ? vectorProvider->fieldNameIndex( meanFieldName ) : -1;
-  int medianIndex = mStatistics & QgsZonalStatistics::Median ? vectorProvider->fieldNameIndex( medianFieldName ) : -1;
-  int stdevIndex = mStatistics & QgsZonalStatistics::StDev ? vectorProvider->fieldNameIndex( stdevFieldName ) : -1;
-  int minIndex = mStatistics & QgsZonalStatistics::Min ? vectorProvider->fieldNameIndex( minFieldName ) : -1;
-  int maxIndex = mStatistics & QgsZonalStatistics::Max ? vectorProvider->fieldNameIndex( maxFieldName ) : -1;
-  int rangeIndex = mStatistics & QgsZonalStatistics::Range ? vectorProvider->fieldNameIndex( rangeFieldName ) : -1;
-  int minorityIndex = mStatistics & QgsZonalStatistics::Minority ? vectorProvider->fieldNameIndex( minorityFieldName ) : -1;
-  int majorityIndex = mStatistics & QgsZonalStatistics::Majority ? vectorProvider->fieldNameIndex( majorityFieldName ) : -1;
-  int varietyIndex = mStatistics & QgsZonalStatistics::Variety ? vectorProvider->fieldNameIndex( varietyFieldName ) : -1;
-  int varianceIndex = mStatistics & QgsZonalStatistics::Variance ? vectorProvider->fieldNameIndex( varianceFieldName ) : -1;
-
-  if ( ( mStatistics & QgsZonalStatistics::Count && countIndex == -1 )
-       || ( mStatistics & QgsZonalStatistics::Sum && sumIndex == -1 )
-       || ( mStatistics & QgsZonalStatistics::Mean && meanIndex == -1 )
-       || ( mStatistics & QgsZonalStatistics::Median && medianIndex == -1 )
-       || ( mStatistics & QgsZonalStatistics::StDev && stdevIndex == -1 )
-       || ( mStatistics & QgsZonalStatistics::Min && minIndex == -1 )
-       || ( mStatistics & QgsZonalStatistics::Max && maxIndex == -1 )
-       || ( mStatistics & QgsZonalStatistics::Range && rangeIndex == -1 )
-       || ( mStatistics & QgsZonalStatistics::Minority && minorityIndex == -1 )
-       || ( mStatistics & QgsZonalStatistics::Majority && majorityIndex == -1 )
-       || ( mStatistics & QgsZonalStatistics::Variety && varietyIndex == -1 )
-       || ( mStatistics & QgsZonalStatistics::Variance && varianceIndex == -1 )
-     )
-  {
-    //failed to create a required field
-    return 8;
-  }
+    QgsRasterDataProvider *provider = parallel ? acquireProvider() : mRasterProvider;
+    if ( !provider )
+      return;
 
-  //progress dialog
-  long featureCount = vectorProvider->featureCount();
+    FeatureStats featureStats( statsStoreValueCount );
+    statisticsForPolygon( polygon.geometry, tiles, provider, featureStats );
+    polygon.attributes = attributesForStatistics( featureStats );
+
+    if ( parallel )
+      releaseProvider( provider );
+  };
 
-  //iterate over each polygon
+  //iterate over each polygon, processing batches of polygons in parallel
   QgsFeatureRequest request;
   request.setSubsetOfAttributes( QgsAttributeList() );
   QgsFeatureIterator fi = vectorProvider->getFeatures( request );
   QgsFeature f;
 
-  bool statsStoreValues = ( mStatistics & QgsZonalStatistics::Median ) ||
-                          ( mStatistics & QgsZonalStatistics::StDev ) ||
-                          ( mStatistics & QgsZonalStatistics::Variance );
-  bool statsStoreValueCount = ( mStatistics & QgsZonalStatistics::Minority ) ||
-                              ( mStatistics & QgsZonalStatistics::Majority );
-
-  FeatureStats featureStats( statsStoreValues, statsStoreValueCount );
+  const int batchSize = POLYGONS_PER_THREAD_AND_BATCH * QThreadPool::globalInstance()->maxThreadCount();
+  QVector< QgsZonalStatisticsPolygon > batch;
   int featureCounter = 0;
+  bool finished = false;
 
   QgsChangedAttributesMap changeMap;
-  while ( fi.nextFeature( f ) )
+  while ( !finished )
   {
     if ( feedback && feedback->isCanceled() )
     {
@@ -228,118 +566,38 @@ int QgsZonalStatistics::calculateStatistics( QgsFeedback *feedback )
       feedback->setProgress( 100.0 * static_cast< double >( featureCounter ) / featureCount );
     }
 
-    if ( !f.hasGeometry() )
-    {
-      ++featureCounter;
-      continue;
-    }
-    QgsGeometry featureGeometry = f.geometry();
-
-    QgsRectangle featureRect = featureGeometry.boundingBox().intersect( &rasterBBox );
-    if ( featureRect.isEmpty() )
+    batch.clear();
+    while ( batch.size() < batchSize )
     {
-      ++featureCounter;
-      continue;
-    }
+      if ( !fi.nextFeature( f ) )
+      {
+        finished = true;
+        break;
+      }
 
-    int offsetX, offsetY, nCellsX, nCellsY;
-    if ( cellInfoForBBox( rasterBBox, featureRect, cellsizeX, cellsizeY, offsetX, offsetY, nCellsX, nCellsY ) != 0 )
-    {
       ++featureCounter;
-      continue;
-    }
+      if ( !f.hasGeometry() || f.geometry().boundingBox().intersect( &mRasterExtent ).isEmpty() )
+      {
+        continue;
+      }
 
-    //avoid access to cells outside of the raster (may occur because of rounding)
-    if ( ( offsetX + nCellsX ) > nCellsXProvider )
-    {
-      nCellsX = nCellsXProvider - offsetX;
-    }
-    if ( ( offsetY + nCellsY ) > nCellsYProvider )
-    {
-      nCellsY = nCellsYProvider - offsetY;
+      QgsZonalStatisticsPolygon polygon;
+      polygon.id = f.id();
+      polygon.geometry = f.geometry();
+      batch << polygon;
     }
 
-    statisticsFromMiddlePointTest( featureGeometry, offsetX, offsetY, nCellsX, nCellsY, cellsizeX, cellsizeY,
-                                   rasterBBox, featureStats );
-
-    if ( featureStats.count <= 1 )
-    {
-      //the cell resolution is probably larger than the polygon area. We switch to precise pixel - polygon intersection in this case
-      statisticsFromPreciseIntersection( featureGeometry, offsetX, offsetY, nCellsX, nCellsY, cellsizeX, cellsizeY,
-                                         rasterBBox, featureStats );
-    }
+    if ( parallel )
+      QtConcurrent::blockingMap( batch, processPolygon );
+    else
+      std::for_each( batch.begin(), batch.end(), processPolygon );
 
     //write the statistics value to the vector data provider
-    QgsAttributeMap changeAttributeMap;
-    if ( mStatistics & QgsZonalStatistics::Count )
-      changeAttributeMap.insert( countIndex, QVariant( featureStats.count ) );
-    if ( mStatistics & QgsZonalStatistics::Sum )
-      changeAttributeMap.insert( sumIndex, QVariant( featureStats.sum ) );
-    if ( featureStats.count > 0 )
+    for ( const QgsZonalStatisticsPolygon &polygon : qgsAsConst( batch ) )
     {
-      double mean = featureStats.sum / featureStats.count;
-      if ( mStatistics & QgsZonalStatistics::Mean )
-        changeAttributeMap.insert( meanIndex, QVariant( mean ) );
-      if ( mStatistics & QgsZonalStatistics::Median )
-      {
-        std::sort( featureStats.values.begin(), featureStats.values.end() );
-        int size = featureStats.values.count();
-        bool even = ( size % 2 ) < 1;
-        double medianValue;
-        if ( even )
-        {
-          medianValue = ( featureStats.values.at( size / 2 - 1 ) + featureStats.values.at( size / 2 ) ) / 2;
-        }
-        else //odd
-        {
-          medianValue = featureStats.values.at( ( size + 1 ) / 2 - 1 );
-        }
-        changeAttributeMap.insert( medianIndex, QVariant( medianValue ) );
-      }
-      if ( mStatistics & QgsZonalStatistics::StDev || mStatistics & QgsZonalStatistics::Variance )
-      {
-        double sumSquared = 0;
-        for ( int i = 0; i < featureStats.values.count(); ++i )
-        {
-          double diff = featureStats.values.at( i ) - mean;
-          sumSquared += diff * diff;
-        }
-        double variance = sumSquared / featureStats.values.count();
-        if ( mStatistics & QgsZonalStatistics::StDev )
-        {
-          double stdev = std::pow( variance, 0.5 );
-          changeAttributeMap.insert( stdevIndex, QVariant( stdev ) );
-        }
-        if ( mStatistics & QgsZonalStatistics::Variance )
-          changeAttributeMap.insert( varianceIndex, QVariant( variance ) );
-      }
-      if ( mStatistics & QgsZonalStatistics::Min )
-        changeAttributeMap.insert( minIndex, QVariant( featureStats.min ) );
-      if ( mStatistics & QgsZonalStatistics::Max )
-        changeAttributeMap.insert( maxIndex, QVariant( featureStats.max ) );
-      if ( mStatistics & QgsZonalStatistics::Range )
-        changeAttributeMap.insert( rangeIndex, QVariant( featureStats.max - featureStats.min ) );
-      if ( mStatistics & QgsZonalStatistics::Minority || mStatistics & QgsZonalStatistics::Majority )
-      {
-        QList<int> vals = featureStats.valueCount.values();
-        std::sort( vals.begin(), vals.end() );
-        if ( mStatistics & QgsZonalStatistics::Minority )
-        {
-          float minorityKey = featureStats.valueCount.key( vals.first() );
-          changeAttributeMap.insert( minorityIndex, QVariant( minorityKey ) );
-        }
-        if ( mStatistics & QgsZonalStatistics::Majority )
-        {
-          float majKey = featureStats.valueCount.key( vals.last() );
-          changeAttributeMap.insert( majorityIndex, QVariant( majKey ) );
-        }
-      }
-      if ( mStatistics & QgsZonalStatistics::Variety )
-        changeAttributeMap.insert( varietyIndex, QVariant( featureStats.valueCount.count() ) );
+      if ( !polygon.attributes.isEmpty() )
+        changeMap.insert( polygon.id, polygon.attributes );
     }
-
-    changeMap.insert( f.id(), changeAttributeMap );
-    ++featureCounter;
   }
 
   vectorProvider->changeAttributeValues( changeMap );
@@ -386,111 +644,196 @@ int QgsZonalStatistics::cellInfoForBBox( const QgsRectangle &rasterBBox, const Q
   return 0;
 }
 
-void QgsZonalStatistics::statisticsFromMiddlePointTest( const QgsGeometry &poly, int pixelOffsetX,
-    int pixelOffsetY, int nCellsX, int nCellsY, double cellSizeX, double cellSizeY, const QgsRectangle &rasterBBox, FeatureStats &stats )
-{
-  double cellCenterX, cellCenterY;
 
-  cellCenterY = rasterBBox.yMaximum() - pixelOffsetY * cellSizeY - cellSizeY / 2;
+void QgsZonalStatistics::statisticsForPolygon( const QgsGeometry &poly, RasterTiles &tiles, QgsRasterDataProvider *provider, FeatureStats &stats ) const
+{
   stats.reset();
 
-  GEOSGeometry *polyGeos = poly.exportToGeos();
-  if ( !polyGeos )
-  {
+  QgsRectangle featureRect = poly.boundingBox().intersect( &mRasterExtent );
+  if ( featureRect.isEmpty() )
     return;
-  }
 
-  GEOSContextHandle_t geosctxt = QgsGeometry::getGEOSHandler();
-  const GEOSPreparedGeometry *polyGeosPrepared = GEOSPrepare_r( geosctxt, polyGeos );
-  if ( !polyGeosPrepared )
-  {
-    GEOSGeom_destroy_r( geosctxt, polyGeos );
+  int offsetX, offsetY, nCellsX, nCellsY;
+  if ( cellInfoForBBox( mRasterExtent, featureRect, mCellSizeX, mCellSizeY, offsetX, offsetY, nCellsX, nCellsY ) != 0 )
+    return;
+
+  //avoid access to cells outside of the raster (may occur because of rounding)
+  nCellsX = std::min( nCellsX, mRasterColumns - offsetX );
+  nCellsY = std::min( nCellsY, mRasterRows - offsetY );
+  if ( nCellsX <= 0 || nCellsY <= 0 )
     return;
-  }
 
-  GEOSCoordSequence *cellCenterCoords = nullptr;
-  GEOSGeometry *currentCellCenter = nullptr;
+  QVector< float > values;
+  tiles.readWindow( provider, offsetX, offsetY, nCellsX, nCellsY, values );
+
+  const double left = mRasterExtent.xMinimum() + offsetX * mCellSizeX;
+  const double top = mRasterExtent.yMaximum() - offsetY * mCellSizeY;
+  QgsZonalStatisticsRasterizer rasterizer( poly, left, top, mCellSizeX, mCellSizeY, nCellsX, nCellsY );
+
+  QVector< double > centersX( nCellsX );
+  double cellCenterX = left + mCellSizeX / 2;
+  for ( int j = 0; j < nCellsX; ++j )
+  {
+    centersX[ j ] = cellCenterX;
+    cellCenterX += mCellSizeX;
+  }
 
-  QgsRectangle featureBBox = poly.boundingBox().intersect( &rasterBBox );
-  QgsRectangle intersectBBox = rasterBBox.intersect( &featureBBox );
+  // only needed for rows with cell centers on the polygon boundary
+  std::unique_ptr< QgsGeometryEngine > engine;
 
-  QgsRasterBlock *block = mRasterProvider->block( mRasterBand, intersectBBox, nCellsX, nCellsY );
+  QVector< double > coverage;
+  double cellCenterY = top - mCellSizeY / 2;
   for ( int i = 0; i < nCellsY; ++i )
   {
-    cellCenterX = rasterBBox.xMinimum() + pixelOffsetX * cellSizeX + cellSizeX / 2;
-    for ( int j = 0; j < nCellsX; ++j )
+    const float *rowValues = values.constData() + i * nCellsX;
+    if ( rasterizer.centerCoverage( i, cellCenterY, centersX, coverage ) )
     {
-      if ( validPixel( block->value( i, j ) ) )
+      for ( int j = 0; j < nCellsX; ++j )
       {
-        GEOSGeom_destroy_r( geosctxt, currentCellCenter );
-        cellCenterCoords = GEOSCoordSeq_create_r( geosctxt, 1, 2 );
-        GEOSCoordSeq_setX_r( geosctxt, cellCenterCoords, 0, cellCenterX );
-        GEOSCoordSeq_setY_r( geosctxt, cellCenterCoords, 0, cellCenterY );
-        currentCellCenter = GEOSGeom_createPoint_r( geosctxt, cellCenterCoords );
-        if ( GEOSPreparedContains_r( geosctxt, polyGeosPrepared, currentCellCenter ) )
-        {
-          stats.addValue( block->value( i, j ) );
-        }
+        if ( coverage.at( j ) > 0 && validPixel( rowValues[ j ] ) )
+          stats.addValue( rowValues[ j ] );
       }
-      cellCenterX += cellSizeX;
     }
-    cellCenterY -= cellSizeY;
+    else
+    {
+      if ( !engine )
+      {
+        engine.reset( QgsGeometry::createGeometryEngine( poly.geometry() ) );
+        engine->prepareGeometry();
+      }
+      for ( int j = 0; j < nCellsX; ++j )
+      {
+        if ( !validPixel( rowValues[ j ] ) )
+          continue;
+
+        const QgsPoint center( centersX.at( j ), cellCenterY );
+        if ( engine->contains( &center ) )
+          stats.addValue( rowValues[ j ] );
+      }
+    }
+    cellCenterY -= mCellSizeY;
   }
 
-  GEOSGeom_destroy_r( geosctxt, currentCellCenter );
-  GEOSPreparedGeom_destroy_r( geosctxt, polyGeosPrepared );
-  GEOSGeom_destroy_r( geosctxt, polyGeos );
-  delete block;
+  if ( stats.count <= 1 )
+  {
+    //the cell resolution is probably larger than the polygon area. We switch to precise pixel - polygon intersection in this case
+    stats.reset();
+    for ( int i = 0; i < nCellsY; ++i )
+    {
+      const float *rowValues = values.constData() + i * nCellsX;
+      rasterizer.areaCoverage( i, coverage );
+      for ( int j = 0; j < nCellsX; ++j )
+      {
+        if ( coverage.at( j ) > 0 && validPixel( rowValues[ j ] ) )
+          stats.addValue( rowValues[ j ], coverage.at( j ) );
+      }
+    }
+  }
 }
 
-void QgsZonalStatistics::statisticsFromPreciseIntersection( const QgsGeometry &poly, int pixelOffsetX,
-    int pixelOffsetY, int nCellsX, int nCellsY, double cellSizeX, double cellSizeY, const QgsRectangle &rasterBBox, FeatureStats &stats )
+QgsAttributeMap QgsZonalStatistics::attributesForStatistics( FeatureStats &stats ) const
 {
-  stats.reset();
-
-  double currentY = rasterBBox.yMaximum() - pixelOffsetY * cellSizeY - cellSizeY / 2;
-  QgsGeometry pixelRectGeometry;
-
-  double hCellSizeX = cellSizeX / 2.0;
-  double hCellSizeY = cellSizeY / 2.0;
-  double pixelArea = cellSizeX * cellSizeY;
-  double weight = 0;
-
-  QgsRectangle featureBBox = poly.boundingBox().intersect( &rasterBBox );
-  QgsRectangle intersectBBox = rasterBBox.intersect( &featureBBox );
+  QgsAttributeMap attributes;
+  if ( mStatistics & QgsZonalStatistics::Count )
+    attributes.insert( mFieldIndexes.value( QgsZonalStatistics::Count ), QVariant( stats.count ) );
+  if ( mStatistics & QgsZonalStatistics::Sum )
+    attributes.insert( mFieldIndexes.value( QgsZonalStatistics::Sum ), QVariant( stats.sum ) );
+  if ( stats.count <= 0 )
+    return attributes;
 
-  QgsRasterBlock *block = mRasterProvider->block( mRasterBand, intersectBBox, nCellsX, nCellsY );
-  for ( int i = 0; i < nCellsY; ++i )
+  double mean = stats.sum / stats.count;
+  if ( mStatistics & QgsZonalStatistics::Mean )
+    attributes.insert( mFieldIndexes.value( QgsZonalStatistics::Mean ), QVariant( mean ) );
+  if ( mStatistics & QgsZonalStatistics::Median )
+    attributes.insert( mFieldIndexes.value( QgsZonalStatistics::Median ), QVariant( stats.percentile( 50 ) ) );
+  if ( mStatistics & QgsZonalStatistics::StDev || mStatistics & QgsZonalStatistics::Variance )
+  {
+    double variance = stats.variance( mean );
+    if ( mStatistics & QgsZonalStatistics::StDev )
+      attributes.insert( mFieldIndexes.value( QgsZonalStatistics::StDev ), QVariant( std::sqrt( variance ) ) );
+    if ( mStatistics & QgsZonalStatistics::Variance )
+      attributes.insert( mFieldIndexes.value( QgsZonalStatistics::Variance ), QVariant( variance ) );
+  }
+  if ( mStatistics & QgsZonalStatistics::Min )
+    attributes.insert( mFieldIndexes.value( QgsZonalStatistics::Min ), QVariant( stats.min ) );
+  if ( mStatistics & QgsZonalStatistics::Max )
+    attributes.insert( mFieldIndexes.value( QgsZonalStatistics::Max ), QVariant( stats.max ) );
+  if ( mStatistics & QgsZonalStatistics::Range )
+    attributes.insert( mFieldIndexes.value( QgsZonalStatistics::Range ), QVariant( stats.max - stats.min ) );
+  if ( ( mStatistics & QgsZonalStatistics::Minority || mStatistics & QgsZonalStatistics::Majority ) && !stats.valueCount.isEmpty() )
   {
-    double currentX = rasterBBox.xMinimum() + cellSizeX / 2.0 + pixelOffsetX * cellSizeX;
-    for ( int j = 0; j < nCellsX; ++j )
+    // ties are resolved to the smallest value, independent of the hash order
+    float minorityKey = 0;
+    float majorityKey = 0;
+    int minorityCount = std::numeric_limits< int >::max();
+    int majorityCount = 0;
+    for ( auto it = stats.valueCount.constBegin(); it != stats.valueCount.constEnd(); ++it )
     {
-      if ( !validPixel( block->value( i, j ) ) )
+      if ( it.value() < minorityCount || ( it.value() == minorityCount && it.key() < minorityKey ) )
       {
-        continue;
+        minorityKey = it.key();
+        minorityCount = it.value();
       }
-
-      pixelRectGeometry = QgsGeometry::fromRect( QgsRectangle( currentX - hCellSizeX, currentY - hCellSizeY, currentX + hCellSizeX, currentY + hCellSizeY ) );
-      if ( !pixelRectGeometry.isNull() )
+      if ( it.value() > majorityCount || ( it.value() == majorityCount && it.key() < majorityKey ) )
       {
-        //intersection
-        QgsGeometry intersectGeometry = pixelRectGeometry.intersection( poly );
-        if ( !intersectGeometry.isNull() )
-        {
-          double intersectionArea = intersectGeometry.area();
-          if ( intersectionArea >= 0.0 )
-          {
-            weight = intersectionArea / pixelArea;
-            stats.addValue( block->value( i, j ), weight );
-          }
-        }
-        pixelRectGeometry = QgsGeometry();
+        majorityKey = it.key();
+        majorityCount = it.value();
       }
-      currentX += cellSizeX;
     }
-    currentY -= cellSizeY;
+    if ( mStatistics & QgsZonalStatistics::Minority )
+      attributes.insert( mFieldIndexes.value( QgsZonalStatistics::Minority ), QVariant( minorityKey ) );
+    if ( mStatistics & QgsZonalStatistics::Majority )
+      attributes.insert( mFieldIndexes.value( QgsZonalStatistics::Majority ), QVariant( majorityKey ) );
+  }
+  if ( mStatistics & QgsZonalStatistics::Variety )
+    attributes.insert( mFieldIndexes.value( QgsZonalStatistics::Variety ), QVariant( stats.valueCount.count() ) );
+  for ( int i = 0; i < mPercentileFieldIndexes.size(); ++i )
+    attributes.insert( mPercentileFieldIndexes.at( i ), QVariant( stats.percentile( mPercentiles.at( i ) ) ) );
+
+  return attributes;
+}
+
+double QgsZonalStatistics::FeatureStats::percentile( double percentile ) const
+{
+  if ( valueCount.isEmpty() )
+    return std::numeric_limits< double >::quiet_NaN();
+
+  QList< float > sortedValues = valueCount.keys();
+  std::sort( sortedValues.begin(), sortedValues.end() );
+
+  int total = 0;
+  for ( float value : qgsAsConst( sortedValues ) )
+    total += valueCount.value( value );
+
+  // position within the sorted list of all values, as the median of an even number of values is the mean of the middle values
+  const double position = qBound( 0.0, percentile, 100.0 ) / 100.0 * ( total - 1 );
+  const int lowerIndex = static_cast< int >( std::floor( position ) );
+  const double fraction = position - lowerIndex;
+
+  int valuesBefore = 0;
+  for ( int i = 0; i < sortedValues.size(); ++i )
+  {
+    valuesBefore += valueCount.value( sortedValues.at( i ) );
+    if ( lowerIndex < valuesBefore )
+    {
+      const double lower = sortedValues.at( i );
+      // the next value is the same one, unless the lower value is the last of its kind
+      if ( fraction == 0 || lowerIndex + 1 < valuesBefore || i + 1 == sortedValues.size() )
+        return lower;
+      return lower + fraction * ( sortedValues.at( i + 1 ) - lower );
+    }
   }
-  delete block;
+  return sortedValues.last();
+}
+
+double QgsZonalStatistics::FeatureStats::variance( double mean ) const
+{
+  if ( nValues == 0 )
+    return 0;
+
+  // the variance around the mean of the values, shifted to the requested (possibly weighted) mean
+  const double shift = valuesMean - mean;
+  return ( valuesM2 + nValues * shift * shift ) / nValues;
 }
 
 bool QgsZonalStatistics::validPixel( float value ) const
@@ -19,19 +19,21 @@
 #define QGSZONALSTATISTICS_H
 
 #include <QString>
-#include <QMap>
+#include <QHash>
+#include <QList>
 
 #include <limits>
 #include <cfloat>
 
 #include "qgis_analysis.h"
 #include "qgsfeedback.h"
+#include "qgsfeature.h"
+#include "qgsrectangle.h"
 
 class QgsGeometry;
 class QgsVectorLayer;
 class QgsRasterLayer;
 class QgsRasterDataProvider;
-class QgsRectangle;
 class QgsField;
 
 /** \ingroup analysis
@@ -55,6 +57,7 @@ class ANALYSIS_EXPORT QgsZonalStatistics
       Majority = 512, //!< Majority of pixel values
       Variety = 1024, //!< Variety (count of distinct) pixel values
       Variance = 2048, //!< Variance of pixel values
+      Percentiles = 4096, //!< Percentiles of pixel values, see setPercentiles() (since QGIS 3.0)
       All = Count | Sum | Mean | Median | StDev | Max | Min | Range | Minority | Majority | Variety | Variance
     };
     Q_DECLARE_FLAGS( Statistics, Statistic )
@@ -68,6 +71,22 @@ class ANALYSIS_EXPORT QgsZonalStatistics
                         int rasterBand = 1,
                         QgsZonalStatistics::Statistics stats = QgsZonalStatistics::Statistics( QgsZonalStatistics::Count | QgsZonalStatistics::Sum | QgsZonalStatistics::Mean ) );
 
+    /**
+     * Sets the \a percentiles (between 0 and 100) calculated for the Percentiles statistic.
+     * A field named "p" followed by the percentile is added for each of them, e.g. "p90".
+     * The default percentiles are 25 and 75.
+     * \see percentiles()
+     * \since QGIS 3.0
+     */
+    void setPercentiles( const QList< double > &percentiles ) { mPercentiles = percentiles; }
+
+    /**
+     * Returns the percentiles calculated for the Percentiles statistic.
+     * \see setPercentiles()
+     * \since QGIS 3.0
+     */
+    QList< double > percentiles() const { return mPercentiles; }
+
     /** Starts the calculation
       \returns 0 in case of success*/
     int calculateStatistics( QgsFeedback *feedback );
@@ -78,13 +97,12 @@ class ANALYSIS_EXPORT QgsZonalStatistics
     class FeatureStats
     {
       public:
-        FeatureStats( bool storeValues = false, bool storeValueCounts = false )
-          : mStoreValues( storeValues )
-          , mStoreValueCounts( storeValueCounts )
+        FeatureStats( bool storeValueCounts = false )
+          : mStoreValueCounts( storeValueCounts )
         {
           reset();
         }
-        void reset() { sum = 0; count = 0; max = -FLT_MAX; min = FLT_MAX; valueCount.clear(); values.clear(); }
+        void reset() { sum = 0; count = 0; max = -FLT_MAX; min = FLT_MAX; valueCount.clear(); nValues = 0; valuesMean = 0; valuesM2 = 0; }
         void addValue( float value, double weight = 1.0 )
         {
           if ( weight < 1.0 )
@@ -100,34 +118,55 @@ class ANALYSIS_EXPORT QgsZonalStatistics
           min = std::min( min, value );
           max = std::max( max, value );
           if ( mStoreValueCounts )
-            valueCount.insert( value, valueCount.value( value, 0 ) + 1 );
-          if ( mStoreValues )
-            values.append( value );
+            valueCount[ value ]++;
+
+          // running mean and sum of squared differences of the (unweighted) values
+          nValues++;
+          const double delta = value - valuesMean;
+          valuesMean += delta / nValues;
+          valuesM2 += delta * ( value - valuesMean );
         }
+
+        /**
+         * Returns the value at \a percentile (0 - 100) of the added values, interpolating
+         * between the closest values. Requires the value counts to be stored.
+         */
+        double percentile( double percentile ) const;
+
+        //! Returns the variance of the added values around \a mean
+        double variance( double mean ) const;
+
         double sum;
         double count;
         float max;
         float min;
-        QMap< float, int > valueCount;
-        QList< float > values;
+        //! Histogram of the added values
+        QHash< float, int > valueCount;
+        //! Number of added values, ignoring their weights
+        int nValues;
+        double valuesMean;
+        double valuesM2;
 
       private:
-        bool mStoreValues;
         bool mStoreValueCounts;
     };
 
+    class RasterTiles;
+
     /** Analysis what cells need to be considered to cover the bounding box of a feature
       \returns 0 in case of success*/
     int cellInfoForBBox( const QgsRectangle &rasterBBox, const QgsRectangle &featureBBox, double cellSizeX, double cellSizeY,
                          int &offsetX, int &offsetY, int &nCellsX, int &nCellsY ) const;
 
-    //! Returns statistics by considering the pixels where the center point is within the polygon (fast)
-    void statisticsFromMiddlePointTest( const QgsGeometry &poly, int pixelOffsetX, int pixelOffsetY, int nCellsX, int nCellsY,
-                                        double cellSizeX, double cellSizeY, const QgsRectangle &rasterBBox, FeatureStats &stats );
+    /**
+     * Calculates the statistics for the cells covered by \a poly, reading the cell values from \a tiles with \a provider.
+     * Cells are considered if their center point is within the polygon. If the cell resolution is too coarse for this,
+     * cells are weighted with the fraction of their area covered by the polygon.
+     */
+    void statisticsForPolygon( const QgsGeometry &poly, RasterTiles &tiles, QgsRasterDataProvider *provider, FeatureStats &stats ) const;
 
-    //! Returns statistics with precise pixel - polygon intersection test (slow)
-    void statisticsFromPreciseIntersection( const QgsGeometry &poly, int pixelOffsetX, int pixelOffsetY, int nCellsX, int nCellsY,
-                                            double cellSizeX, double cellSizeY, const QgsRectangle &rasterBBox, FeatureStats &stats );
+    //! Returns the attribute values for the calculated \a stats
+    QgsAttributeMap attributesForStatistics( FeatureStats &stats ) const;
 
     //! Tests whether a pixel's value should be included in the result
     bool validPixel( float value ) const;
@@ -143,6 +182,18 @@ class ANALYSIS_EXPORT QgsZonalStatistics
     //! The nodata value of the input layer
     float mInputNodataValue = -1;
     Statistics mStatistics = QgsZonalStatistics::All;
+    QList< double > mPercentiles = QList< double >() << 25 << 75;
+
+    //! Extent, cell sizes and dimensions of the raster
+    QgsRectangle mRasterExtent;
+    double mCellSizeX = 0;
+    double mCellSizeY = 0;
+    int mRasterColumns = 0;
+    int mRasterRows = 0;
+
+    //! Field indexes of the calculated statistics
+    QHash< int, int > mFieldIndexes;
+    QList< int > mPercentileFieldIndexes;
 };
 
 Q_DECLARE_OPERATORS_FOR_FLAGS( QgsZonalStatistics::Statistics )
@@ -1237,6 +1237,8 @@ QList<QgsPointLocator::Match> QgsNodeTool::layerVerticesSnappedToPoint( QgsVecto
 {
   MatchCollectingFilter myfilter( this );
   QgsPointLocator *loc = canvas()->snappingUtils()->locatorForLayer( layer );
+  // all the coincident vertices are needed, do not use an index which is not ready yet
+  loc->waitForIndexingFinished();
   loc->nearestVertex( mapPoint, 0, &myfilter );
   return myfilter.matches;
 }
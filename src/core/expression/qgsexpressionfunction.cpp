@@ -547,6 +547,28 @@ static QVariant fcnAggregate( const QVariantList &values, const QgsExpressionCon
   return result;
 }
 
+/**
+ * Returns true if the relation aggregate can be calculated for all parent features at once, grouping the child
+ * features by the referencing fields. This requires the referencing and referenced fields to be of the same type,
+ * as the child features are grouped by the string representation of their values. The referenced field values
+ * of the parent feature \a f are stored in \a groupValues.
+ */
+static bool _canGroupRelationAggregate( const QgsRelation &relation, QVariantList &groupValues, const QgsFeature &f )
+{
+  const QgsFields childFields = relation.referencingLayer()->fields();
+  const QgsFields parentFields = relation.referencedLayer()->fields();
+  Q_FOREACH ( const QgsRelation::FieldPair &fieldPair, relation.fieldPairs() )
+  {
+    int childIdx = childFields.lookupField( fieldPair.referencingField() );
+    int parentIdx = parentFields.lookupField( fieldPair.referencedField() );
+    if ( childIdx < 0 || parentIdx < 0 || childFields.at( childIdx ).type() != parentFields.at( parentIdx ).type() )
+      return false;
+
+    groupValues << f.attribute( fieldPair.referencedField() );
+  }
+  return !groupValues.isEmpty();
+}
+
 static QVariant fcnAggregateRelation( const QVariantList &values, const QgsExpressionContext *context, QgsExpression *parent, const QgsExpressionNodeFunction * )
 {
   if ( !context )
@@ -629,6 +651,45 @@ static QVariant fcnAggregateRelation( const QVariantList &values, const QgsExpre
   if ( context && context->hasCachedValue( cacheKey ) )
     return context->cachedValue( cacheKey );
 
+  // when the aggregate is evaluated for more than one parent feature with the same context (e.g. in the
+  // field calculator or for labeling), the values for all parents are calculated in a single pass over
+  // the child layer
+  QString groupedCacheKey = QStringLiteral( "relagg_grouped:%1:%2:%3:%4:%5" ).arg( vl->id(),
+                            relation.id(),
+                            QString::number( static_cast< int >( aggregate ) ),
+                            subExpression,
+                            parameters.delimiter );
+  QVariantList groupValues;
+  if ( _canGroupRelationAggregate( relation, groupValues, f ) )
+  {
+    if ( !context->hasCachedValue( groupedCacheKey ) && context->hasCachedValue( groupedCacheKey + QStringLiteral( ":used" ) ) )
+    {
+      QStringList groupByFields;
+      Q_FOREACH ( const QgsRelation::FieldPair &fieldPair, relation.fieldPairs() )
+        groupByFields << fieldPair.referencingField();
+
+      QgsAggregateCalculator calculator( childLayer );
+      calculator.setDelimiter( parameters.delimiter );
+      QgsExpressionContext subContext( *context );
+      QVariantMap grouped = calculator.calculateGrouped( aggregate, subExpression, groupByFields, &subContext, &ok );
+      if ( !ok )
+      {
+        parent->setEvalErrorString( QObject::tr( "Could not calculate aggregate for: %1" ).arg( subExpression ) );
+        return QVariant();
+      }
+      context->setCachedValue( groupedCacheKey, grouped );
+    }
+
+    if ( context->hasCachedValue( groupedCacheKey ) )
+    {
+      const QVariantMap grouped = context->cachedValue( groupedCacheKey ).toMap();
+      return grouped.value( QgsAggregateCalculator::groupKey( groupValues ), grouped.value( QString() ) );
+    }
+
+    // first use in this context, a single parent is cheaper to calculate with a filter
+    context->setCachedValue( groupedCacheKey + QStringLiteral( ":used" ), true );
+  }
+
   QVariant result;
   ok = false;
 
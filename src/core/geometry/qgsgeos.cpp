@@ -99,7 +99,10 @@ class GEOSInit
     GEOSInit &operator=( const GEOSInit &rh ) = delete;
 };
 
-static GEOSInit geosinit;
+// every thread gets a context of its own, as the contexts keep the last error
+// message and are not safe to be used from several threads at the same time.
+// GEOS geometries are not bound to the context which created them.
+static thread_local GEOSInit geosinit;
 
 ///@endcond
 
@@ -257,6 +257,11 @@ class CORE_EXPORT QgsGeos: public QgsGeometryEngine
     static GEOSGeometry *asGeos( const QgsAbstractGeometry *geom, double precision = 0 );
     static QgsPoint coordSeqPoint( const GEOSCoordSequence *cs, int i, bool hasZ, bool hasM );
 
+    /**
+     * Returns the GEOS context handle for the current thread. Every thread has a context
+     * of its own, so that GEOS operations can safely run in parallel. Geometries can
+     * be passed between threads.
+     */
     static GEOSContextHandle_t getGEOSHandler();
 
 
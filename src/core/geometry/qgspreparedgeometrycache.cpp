@@ -0,0 +1,57 @@
+/***************************************************************************
+                         qgspreparedgeometrycache.cpp
+                         ----------------------------
+    begin                : October 2017
+    copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgspreparedgeometrycache.h"
+#include "qgsabstractgeometry.h"
+#include "qgsgeometry.h"
+
+#include <algorithm>
+
+QgsPreparedGeometryCache::QgsPreparedGeometryCache( int maxVertices )
+  : mEngines( maxVertices )
+{
+}
+
+QgsGeometryEngine *QgsPreparedGeometryCache::engine( QgsFeatureId id, const QgsGeometry &geometry )
+{
+  mUncachedEngine.reset();
+
+  if ( QgsGeometryEngine *cached = mEngines.object( id ) )
+    return cached;
+
+  if ( geometry.isNull() || geometry.isEmpty() )
+    return nullptr;
+
+  std::unique_ptr< QgsGeometryEngine > engine( QgsGeometry::createGeometryEngine( geometry.geometry() ) );
+  engine->prepareGeometry();
+
+  const int cost = std::max( 1, geometry.geometry()->nCoordinates() );
+  if ( cost > mEngines.maxCost() )
+  {
+    mUncachedEngine = std::move( engine );
+    return mUncachedEngine.get();
+  }
+
+  QgsGeometryEngine *result = engine.get();
+  mEngines.insert( id, engine.release(), cost );
+  return result;
+}
+
+void QgsPreparedGeometryCache::clear()
+{
+  mEngines.clear();
+  mUncachedEngine.reset();
+}
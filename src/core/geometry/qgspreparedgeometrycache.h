@@ -0,0 +1,88 @@
+/***************************************************************************
+                         qgspreparedgeometrycache.h
+                         --------------------------
+    begin                : October 2017
+    copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSPREPAREDGEOMETRYCACHE_H
+#define QGSPREPAREDGEOMETRYCACHE_H
+
+#define SIP_NO_FILE
+
+#include "qgis_core.h"
+#include "qgsfeature.h"
+#include "qgsgeometryengine.h"
+
+#include <QCache>
+#include <memory>
+
+/**
+ * \ingroup core
+ * A cache of prepared geometry engines for the features of a layer (or feature source),
+ * keyed by feature id.
+ *
+ * Tests of spatial predicates with prepared geometries are much faster than with plain
+ * geometries, but converting and preparing a geometry is expensive. When the same
+ * features are tested again and again, e.g. the overlay features of a select by
+ * location, the cache keeps the prepared engines around. When the vertices of the cached
+ * geometries exceed the maximum cost, the least recently used engines are removed.
+ *
+ * The cache is not thread safe and the returned engines must not be used from
+ * several threads at the same time, so every thread needs a cache of its own.
+ *
+ * \note not available in Python bindings
+ * \since QGIS 3.0
+ */
+class CORE_EXPORT QgsPreparedGeometryCache
+{
+  public:
+
+    /**
+     * Constructor for QgsPreparedGeometryCache, keeping engines for geometries with up to
+     * \a maxVertices vertices in total.
+     */
+    explicit QgsPreparedGeometryCache( int maxVertices = 5000000 );
+
+    //! QgsPreparedGeometryCache cannot be copied
+    QgsPreparedGeometryCache( const QgsPreparedGeometryCache &rh ) = delete;
+    //! QgsPreparedGeometryCache cannot be copied
+    QgsPreparedGeometryCache &operator=( const QgsPreparedGeometryCache &rh ) = delete;
+
+    /**
+     * Returns a prepared engine for the feature with the specified \a id, preparing
+     * its \a geometry if the engine is not cached yet. The \a geometry must be the same
+     * for all calls with the same \a id.
+     *
+     * The engine is owned by the cache and valid until the next call to engine() or clear().
+     * Returns nullptr for empty geometries.
+     */
+    QgsGeometryEngine *engine( QgsFeatureId id, const QgsGeometry &geometry );
+
+    //! Returns true if an engine for the feature with the specified \a id is cached
+    bool contains( QgsFeatureId id ) const { return mEngines.contains( id ); }
+
+    //! Returns the number of cached engines
+    int count() const { return mEngines.count(); }
+
+    //! Removes all cached engines
+    void clear();
+
+  private:
+
+    QCache< QgsFeatureId, QgsGeometryEngine > mEngines;
+
+    //! Engine for a geometry which is too large to be cached
+    std::unique_ptr< QgsGeometryEngine > mUncachedEngine;
+};
+
+#endif // QGSPREPAREDGEOMETRYCACHE_H
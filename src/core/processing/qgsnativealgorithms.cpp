@@ -24,6 +24,8 @@
 #include "qgsgeometry.h"
 #include "qgsgeometryengine.h"
 #include "qgswkbtypes.h"
+#include "qgspreparedgeometrycache.h"
+#include "qgsspatialindex.h"
 
 #include <functional>
 
@@ -578,8 +580,8 @@ QVariantMap QgsClipAlgorithm::processAlgorithm( const QVariantMap &parameters, Q
       QgsGeometry newGeometry;
       if ( !engine->contains( inputFeature.geometry().geometry() ) )
       {
-        QgsGeometry currentGeometry = inputFeature.geometry();
-        newGeometry = combinedClipGeom.intersection( currentGeometry );
+        // reuse the engine, so that the (possibly huge) clip geometry is not converted again for every feature
+        newGeometry = QgsGeometry( engine->intersection( inputFeature.geometry().geometry() ) );
         if ( newGeometry.wkbType() == QgsWkbTypes::Unknown || QgsWkbTypes::flatType( newGeometry.geometry()->wkbType() ) == QgsWkbTypes::GeometryCollection )
         {
           QgsGeometry intCom = inputFeature.geometry().combine( newGeometry );
@@ -640,16 +642,21 @@ bool QgsTransformAlgorithm::prepareAlgorithm( const QVariantMap &parameters, Qgs
 QgsFeature QgsTransformAlgorithm::processFeature( const QgsFeature &f, QgsProcessingFeedback * )
 {
   QgsFeature feature = f;
-  if ( !mCreatedTransform )
+  QgsCoordinateTransform transform;
   {
-    mCreatedTransform = true;
-    mTransform = QgsCoordinateTransform( sourceCrs(), mDestCrs );
+    QMutexLocker locker( &mTransformMutex );
+    if ( !mCreatedTransform )
+    {
+      mCreatedTransform = true;
+      mTransform = QgsCoordinateTransform( sourceCrs(), mDestCrs );
+    }
+    transform = mTransform;
   }
 
   if ( feature.hasGeometry() )
   {
     QgsGeometry g = feature.geometry();
-    if ( g.transform( mTransform ) == 0 )
+    if ( g.transform( transform ) == 0 )
     {
       feature.setGeometry( g );
     }
@@ -1463,6 +1470,9 @@ QVariantMap QgsSelectByLocationAlgorithm::processAlgorithm( const QVariantMap &p
   return results;
 }
 
+// minimum number of target features for which testing the targets against indexed intersect features pays off
+static const long TARGET_BASED_LOCATION_MIN_FEATURES = 1000;
+
 void QgsLocationBasedAlgorithm::process( QgsFeatureSource *targetSource,
     QgsFeatureSource *intersectSource,
     const QList< int > &selectedPredicates,
@@ -1479,6 +1489,24 @@ void QgsLocationBasedAlgorithm::process( QgsFeatureSource *targetSource,
     predicates << reversePredicate( static_cast< Predicate >( i ) );
   }
 
+  // when selecting e.g. points within polygons, there are usually many more target than intersect
+  // features. Requesting the target features for every intersect feature then dominates, so it's
+  // faster to index the (few) intersect features and to read the targets only once
+  const long intersectCount = intersectSource->featureCount();
+  const long targetCount = targetSource->featureCount();
+  if ( intersectCount >= 0 && targetCount > intersectCount && targetCount >= TARGET_BASED_LOCATION_MIN_FEATURES )
+    processByTargetFeatures( targetSource, intersectSource, predicates, handleFeatureFunction, onlyRequireTargetIds, feedback );
+  else
+    processByIntersectFeatures( targetSource, intersectSource, predicates, handleFeatureFunction, onlyRequireTargetIds, feedback );
+}
+
+void QgsLocationBasedAlgorithm::processByIntersectFeatures( QgsFeatureSource *targetSource,
+    QgsFeatureSource *intersectSource,
+    const QList< Predicate > &predicates,
+    const std::function < void( const QgsFeature & ) > &handleFeatureFunction,
+    bool onlyRequireTargetIds,
+    QgsFeedback *feedback )
+{
   QgsFeatureIds disjointSet;
   if ( predicates.contains( Disjoint ) )
     disjointSet = targetSource->allFeatureIds();
@@ -1590,6 +1618,114 @@ void QgsLocationBasedAlgorithm::process( QgsFeatureSource *targetSource,
   }
 }
 
+void QgsLocationBasedAlgorithm::processByTargetFeatures( QgsFeatureSource *targetSource,
+    QgsFeatureSource *intersectSource,
+    const QList< Predicate > &predicates,
+    const std::function < void( const QgsFeature & ) > &handleFeatureFunction,
+    bool onlyRequireTargetIds,
+    QgsFeedback *feedback )
+{
+  // index the intersect features, keeping their geometries for the prepared geometry cache
+  QHash< QgsFeatureId, QgsGeometry > intersectGeometries;
+  QgsSpatialIndex index;
+  QgsFeatureRequest request = QgsFeatureRequest().setSubsetOfAttributes( QgsAttributeList() ).setDestinationCrs( targetSource->sourceCrs() );
+  QgsFeatureIterator fIt = intersectSource->getFeatures( request );
+  QgsFeature f;
+  while ( fIt.nextFeature( f ) )
+  {
+    if ( feedback->isCanceled() )
+      return;
+
+    if ( !f.hasGeometry() )
+      continue;
+
+    intersectGeometries.insert( f.id(), f.geometry() );
+    index.insertFeature( f );
+  }
+
+  const bool testDisjoint = predicates.contains( Disjoint );
+  QgsPreparedGeometryCache engines;
+
+  request = QgsFeatureRequest();
+  if ( onlyRequireTargetIds )
+    request.setSubsetOfAttributes( QgsAttributeList() );
+  QgsFeatureIterator targetIt = targetSource->getFeatures( request );
+  const long targetCount = targetSource->featureCount();
+  double step = targetCount > 0 ? 100.0 / targetCount : 1;
+  int current = 0;
+  QgsFeature targetFeature;
+  while ( targetIt.nextFeature( targetFeature ) )
+  {
+    if ( feedback->isCanceled() )
+      break;
+
+    current++;
+    if ( current % 1000 == 0 )
+      feedback->setProgress( current * step );
+
+    if ( !targetFeature.hasGeometry() )
+    {
+      // can't intersect anything
+      if ( testDisjoint )
+        handleFeatureFunction( targetFeature );
+      continue;
+    }
+
+    const QgsAbstractGeometry *targetGeometry = targetFeature.geometry().geometry();
+    bool isMatch = false;
+    bool intersectsAny = false;
+    const QList< QgsFeatureId > candidates = index.intersects( targetFeature.geometry().boundingBox() );
+    for ( QgsFeatureId candidate : candidates )
+    {
+      QgsGeometryEngine *engine = engines.engine( candidate, intersectGeometries.value( candidate ) );
+      if ( !engine )
+        continue;
+
+      for ( Predicate predicate : qgsAsConst( predicates ) )
+      {
+        switch ( predicate )
+        {
+          case Intersects:
+            isMatch = engine->intersects( targetGeometry );
+            break;
+          case Contains:
+            isMatch = engine->contains( targetGeometry );
+            break;
+          case Disjoint:
+            intersectsAny = intersectsAny || engine->intersects( targetGeometry );
+            break;
+          case IsEqual:
+            isMatch = engine->isEqual( targetGeometry );
+            break;
+          case Touches:
+            isMatch = engine->touches( targetGeometry );
+            break;
+          case Overlaps:
+            isMatch = engine->overlaps( targetGeometry );
+            break;
+          case Within:
+            isMatch = engine->within( targetGeometry );
+            break;
+          case Crosses:
+            isMatch = engine->crosses( targetGeometry );
+            break;
+        }
+        if ( isMatch )
+          break;
+      }
+
+      if ( isMatch || ( intersectsAny && predicates.count() == 1 ) )
+      {
+        // no further tests can change the result for this feature
+        break;
+      }
+    }
+
+    if ( isMatch || ( testDisjoint && !intersectsAny ) )
+      handleFeatureFunction( targetFeature );
+  }
+}
+
 void QgsLocationBasedAlgorithm::addPredicateParameter()
 {
   std::unique_ptr< QgsProcessingParameterEnum > predicateParam( new QgsProcessingParameterEnum( QStringLiteral( "PREDICATE" ),
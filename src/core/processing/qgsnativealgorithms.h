@@ -27,6 +27,8 @@
 #include "qgsprocessingutils.h"
 #include "qgsmaptopixelgeometrysimplifier.h"
 
+#include <QMutex>
+
 ///@cond PRIVATE
 
 class QgsNativeAlgorithms: public QgsProcessingProvider
@@ -95,6 +97,7 @@ class QgsCentroidAlgorithm : public QgsProcessingFeatureBasedAlgorithm
     QgsProcessing::SourceType outputLayerType() const override { return QgsProcessing::TypeVectorPoint; }
     QgsWkbTypes::Type outputWkbType( QgsWkbTypes::Type inputWkbType ) const override { Q_UNUSED( inputWkbType ); return QgsWkbTypes::Point; }
 
+    bool supportsParallelProcessing() const override { return true; }
     QgsFeature processFeature( const QgsFeature &feature, QgsProcessingFeedback *feedback ) override;
 };
 
@@ -121,6 +124,7 @@ class QgsTransformAlgorithm : public QgsProcessingFeatureBasedAlgorithm
     QString outputName() const override { return QObject::tr( "Reprojected" ); }
 
     bool prepareAlgorithm( const QVariantMap &parameters, QgsProcessingContext &context, QgsProcessingFeedback *feedback ) override;
+    bool supportsParallelProcessing() const override { return true; }
     QgsFeature processFeature( const QgsFeature &feature, QgsProcessingFeedback *feedback ) override;
 
   private:
@@ -128,6 +132,8 @@ class QgsTransformAlgorithm : public QgsProcessingFeatureBasedAlgorithm
     bool mCreatedTransform = false;
     QgsCoordinateReferenceSystem mDestCrs;
     QgsCoordinateTransform mTransform;
+    //! Guards the creation of mTransform, as features are processed in parallel
+    QMutex mTransformMutex;
 
 };
 
@@ -324,6 +330,7 @@ class QgsSubdivideAlgorithm : public QgsProcessingFeatureBasedAlgorithm
     QString outputName() const override { return QObject::tr( "Subdivided" ); }
 
     QgsWkbTypes::Type outputWkbType( QgsWkbTypes::Type inputWkbType ) const override;
+    bool supportsParallelProcessing() const override { return true; }
     QgsFeature processFeature( const QgsFeature &feature, QgsProcessingFeedback *feedback ) override;
 
     bool prepareAlgorithm( const QVariantMap &parameters, QgsProcessingContext &context, QgsProcessingFeedback *feedback ) override;
@@ -378,6 +385,7 @@ class QgsPromoteToMultipartAlgorithm : public QgsProcessingFeatureBasedAlgorithm
     QString outputName() const override { return QObject::tr( "Multiparts" ); }
 
     QgsWkbTypes::Type outputWkbType( QgsWkbTypes::Type inputWkbType ) const override;
+    bool supportsParallelProcessing() const override { return true; }
     QgsFeature processFeature( const QgsFeature &feature, QgsProcessingFeedback *feedback ) override;
 
 };
@@ -426,6 +434,7 @@ class QgsBoundingBoxAlgorithm : public QgsProcessingFeatureBasedAlgorithm
     QString outputName() const override { return QObject::tr( "Bounds" ); }
     QgsWkbTypes::Type outputWkbType( QgsWkbTypes::Type ) const override { return QgsWkbTypes::Polygon; }
     QgsFields outputFields( const QgsFields &inputFields ) const override;
+    bool supportsParallelProcessing() const override { return true; }
     QgsFeature processFeature( const QgsFeature &feature, QgsProcessingFeedback *feedback ) override;
 
 };
@@ -450,6 +459,7 @@ class QgsOrientedMinimumBoundingBoxAlgorithm : public QgsProcessingFeatureBasedA
     QString outputName() const override { return QObject::tr( "Bounding boxes" ); }
     QgsWkbTypes::Type outputWkbType( QgsWkbTypes::Type ) const override { return QgsWkbTypes::Polygon; }
     QgsFields outputFields( const QgsFields &inputFields ) const override;
+    bool supportsParallelProcessing() const override { return true; }
     QgsFeature processFeature( const QgsFeature &feature, QgsProcessingFeedback *feedback ) override;
 
 };
@@ -476,6 +486,7 @@ class QgsMinimumEnclosingCircleAlgorithm : public QgsProcessingFeatureBasedAlgor
     QgsWkbTypes::Type outputWkbType( QgsWkbTypes::Type ) const override { return QgsWkbTypes::Polygon; }
     QgsFields outputFields( const QgsFields &inputFields ) const override;
     bool prepareAlgorithm( const QVariantMap &parameters, QgsProcessingContext &context, QgsProcessingFeedback *feedback ) override;
+    bool supportsParallelProcessing() const override { return true; }
     QgsFeature processFeature( const QgsFeature &feature, QgsProcessingFeedback *feedback ) override;
 
   private:
@@ -503,6 +514,7 @@ class QgsConvexHullAlgorithm : public QgsProcessingFeatureBasedAlgorithm
     QString outputName() const override { return QObject::tr( "Convex hulls" ); }
     QgsWkbTypes::Type outputWkbType( QgsWkbTypes::Type ) const override { return QgsWkbTypes::Polygon; }
     QgsFields outputFields( const QgsFields &inputFields ) const override;
+    bool supportsParallelProcessing() const override { return true; }
     QgsFeature processFeature( const QgsFeature &feature, QgsProcessingFeedback *feedback ) override;
 
 };
@@ -532,6 +544,21 @@ class QgsLocationBasedAlgorithm : public QgsProcessingAlgorithm
     Predicate reversePredicate( Predicate predicate ) const;
     QStringList predicateOptionsList() const;
     void process( QgsFeatureSource *targetSource, QgsFeatureSource *intersectSource, const QList<int> &selectedPredicates, const std::function< void( const QgsFeature & )> &handleFeatureFunction, bool onlyRequireTargetIds, QgsFeedback *feedback );
+
+  private:
+
+    /**
+     * Tests every intersect feature against the target features within its bounding box.
+     * Each intersect geometry is prepared only once, but every intersect feature needs a request to the target source.
+     */
+    void processByIntersectFeatures( QgsFeatureSource *targetSource, QgsFeatureSource *intersectSource, const QList<Predicate> &predicates, const std::function< void( const QgsFeature & )> &handleFeatureFunction, bool onlyRequireTargetIds, QgsFeedback *feedback );
+
+    /**
+     * Tests every target feature against the intersect features within its bounding box, using an in-memory
+     * spatial index of the intersect features and a cache of their prepared geometries. This reads the
+     * target source only once, so it is much faster when there are far more target than intersect features.
+     */
+    void processByTargetFeatures( QgsFeatureSource *targetSource, QgsFeatureSource *intersectSource, const QList<Predicate> &predicates, const std::function< void( const QgsFeature & )> &handleFeatureFunction, bool onlyRequireTargetIds, QgsFeedback *feedback );
 };
 
 /**
@@ -602,6 +629,7 @@ class QgsFixGeometriesAlgorithm : public QgsProcessingFeatureBasedAlgorithm
     QgsProcessingFeatureSource::Flag sourceFlags() const override { return QgsProcessingFeatureSource::FlagSkipGeometryValidityChecks; }
     QString outputName() const override { return QObject::tr( "Fixed geometries" ); }
     QgsWkbTypes::Type outputWkbType( QgsWkbTypes::Type type ) const override { return QgsWkbTypes::multiType( type ); }
+    bool supportsParallelProcessing() const override { return true; }
     QgsFeature processFeature( const QgsFeature &feature, QgsProcessingFeedback *feedback ) override;
 
 };
@@ -626,6 +654,7 @@ class QgsMergeLinesAlgorithm : public QgsProcessingFeatureBasedAlgorithm
     QString outputName() const override { return QObject::tr( "Merged" ); }
     QgsProcessing::SourceType outputLayerType() const override { return QgsProcessing::TypeVectorLine; }
     QgsWkbTypes::Type outputWkbType( QgsWkbTypes::Type ) const override { return QgsWkbTypes::MultiLineString; }
+    bool supportsParallelProcessing() const override { return true; }
     QgsFeature processFeature( const QgsFeature &feature, QgsProcessingFeedback *feedback ) override;
 
 };
@@ -651,6 +680,7 @@ class QgsSmoothAlgorithm : public QgsProcessingFeatureBasedAlgorithm
     QString outputName() const override { return QObject::tr( "Smoothed" ); }
     QgsProcessing::SourceType outputLayerType() const override { return QgsProcessing::TypeVectorLine; }
     bool prepareAlgorithm( const QVariantMap &parameters, QgsProcessingContext &context, QgsProcessingFeedback *feedback ) override;
+    bool supportsParallelProcessing() const override { return true; }
     QgsFeature processFeature( const QgsFeature &feature, QgsProcessingFeedback *feedback ) override;
 
   private:
@@ -679,6 +709,7 @@ class QgsSimplifyAlgorithm : public QgsProcessingFeatureBasedAlgorithm
   protected:
     QString outputName() const override { return QObject::tr( "Simplified" ); }
     bool prepareAlgorithm( const QVariantMap &parameters, QgsProcessingContext &context, QgsProcessingFeedback *feedback ) override;
+    bool supportsParallelProcessing() const override { return true; }
     QgsFeature processFeature( const QgsFeature &feature, QgsProcessingFeedback *feedback ) override;
 
   private:
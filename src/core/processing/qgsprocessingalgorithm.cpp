@@ -27,6 +27,11 @@
 #include "qgsmessagelog.h"
 #include "qgsprocessingfeedback.h"
 
+#include <QThreadPool>
+#include <QtConcurrentMap>
+#include <exception>
+#include <functional>
+
 QgsProcessingAlgorithm::~QgsProcessingAlgorithm()
 {
   qDeleteAll( mParameters );
@@ -658,24 +663,31 @@ QVariantMap QgsProcessingFeatureBasedAlgorithm::processAlgorithm( const QVariant
 
   long count = mSource->featureCount();
 
-  QgsFeature f;
   QgsFeatureIterator it = mSource->getFeatures( QgsFeatureRequest(), sourceFlags() );
 
-  double step = count > 0 ? 100.0 / count : 1;
-  int current = 0;
-  while ( it.nextFeature( f ) )
+  if ( supportsParallelProcessing() && QThreadPool::globalInstance()->maxThreadCount() > 1 )
   {
-    if ( feedback->isCanceled() )
+    processFeaturesInParallel( it, sink.get(), count, feedback );
+  }
+  else
+  {
+    QgsFeature f;
+    double step = count > 0 ? 100.0 / count : 1;
+    int current = 0;
+    while ( it.nextFeature( f ) )
     {
-      break;
-    }
+      if ( feedback->isCanceled() )
+      {
+        break;
+      }
 
-    QgsFeature transformed = processFeature( f, feedback );
-    if ( transformed.isValid() )
-      sink->addFeature( transformed, QgsFeatureSink::FastInsert );
+      QgsFeature transformed = processFeature( f, feedback );
+      if ( transformed.isValid() )
+        sink->addFeature( transformed, QgsFeatureSink::FastInsert );
 
-    feedback->setProgress( current * step );
-    current++;
+      feedback->setProgress( current * step );
+      current++;
+    }
   }
 
   mSource.reset();
@@ -684,3 +696,175 @@ QVariantMap QgsProcessingFeatureBasedAlgorithm::processAlgorithm( const QVariant
   outputs.insert( QStringLiteral( "OUTPUT" ), dest );
   return outputs;
 }
+
+///@cond PRIVATE
+
+/**
+ * Collects the messages pushed while a feature is processed in a worker thread, so that
+ * they can be reported in order from the thread running the algorithm.
+ */
+class QgsProcessingFeedbackCollector : public QgsProcessingFeedback
+{
+  public:
+
+    enum MessageType
+    {
+      Error,
+      Info,
+      CommandInfo,
+      DebugInfo,
+      ConsoleInfo,
+    };
+
+    void reportError( const QString &error ) override { mMessages << qMakePair( Error, error ); }
+    void pushInfo( const QString &info ) override { mMessages << qMakePair( Info, info ); }
+    void pushCommandInfo( const QString &info ) override { mMessages << qMakePair( CommandInfo, info ); }
+    void pushDebugInfo( const QString &info ) override { mMessages << qMakePair( DebugInfo, info ); }
+    void pushConsoleInfo( const QString &info ) override { mMessages << qMakePair( ConsoleInfo, info ); }
+
+    QList< QPair< MessageType, QString > > mMessages;
+};
+
+//! Result of processing a single feature in a worker thread
+struct QgsParallelProcessedFeature
+{
+  QgsFeature feature;
+  QList< QPair< QgsProcessingFeedbackCollector::MessageType, QString > > messages;
+  bool failed = false;
+  QString error;
+
+  //! Reports the collected messages to \a feedback
+  void reportMessages( QgsProcessingFeedback *feedback ) const
+  {
+    for ( const QPair< QgsProcessingFeedbackCollector::MessageType, QString > &message : messages )
+    {
+      switch ( message.first )
+      {
+        case QgsProcessingFeedbackCollector::Error:
+          feedback->reportError( message.second );
+          break;
+        case QgsProcessingFeedbackCollector::Info:
+          feedback->pushInfo( message.second );
+          break;
+        case QgsProcessingFeedbackCollector::CommandInfo:
+          feedback->pushCommandInfo( message.second );
+          break;
+        case QgsProcessingFeedbackCollector::DebugInfo:
+          feedback->pushDebugInfo( message.second );
+          break;
+        case QgsProcessingFeedbackCollector::ConsoleInfo:
+          feedback->pushConsoleInfo( message.second );
+          break;
+      }
+    }
+  }
+};
+
+///@endcond
+
+void QgsProcessingFeatureBasedAlgorithm::processFeaturesInParallel( QgsFeatureIterator &iterator, QgsFeatureSink *sink, long count, QgsProcessingFeedback *feedback )
+{
+  // large enough batches to keep all threads busy, small enough to keep memory use low
+  const int batchSize = std::max( 1000, 200 * QThreadPool::globalInstance()->maxThreadCount() );
+
+  std::function< QgsParallelProcessedFeature( const QgsFeature & ) > processOne = [this, feedback]( const QgsFeature & feature )
+  {
+    QgsParallelProcessedFeature result;
+    if ( feedback->isCanceled() )
+      return result;
+
+    // the algorithm's feedback may not be used from worker threads
+    QgsProcessingFeedbackCollector collector;
+    try
+    {
+      result.feature = processFeature( feature, &collector );
+    }
+    catch ( QgsException &e )
+    {
+      result.failed = true;
+      result.error = e.what();
+    }
+    catch ( std::exception &e )
+    {
+      result.failed = true;
+      result.error = QString::fromLocal8Bit( e.what() );
+    }
+    catch ( ... )
+    {
+      // exceptions must not escape the worker thread, QtConcurrent would rethrow them as QUnhandledException
+      result.failed = true;
+      result.error = QObject::tr( "Unknown error while processing feature %1" ).arg( feature.id() );
+    }
+    result.messages = collector.mMessages;
+    return result;
+  };
+
+  double step = count > 0 ? 100.0 / count : 1;
+  int current = 0;
+  QFuture< QgsParallelProcessedFeature > pending;
+  bool hasPending = false;
+  QgsFeature f;
+  while ( true )
+  {
+    QgsFeatureList batch;
+    batch.reserve( batchSize );
+    while ( batch.size() < batchSize && !feedback->isCanceled() && iterator.nextFeature( f ) )
+      batch << f;
+
+    // process the new batch while the results of the previous one are added to the sink
+    QFuture< QgsParallelProcessedFeature > next;
+    if ( !batch.isEmpty() )
+      next = QtConcurrent::mapped( batch, processOne );
+
+    if ( hasPending )
+    {
+      QList< QgsParallelProcessedFeature > results;
+      try
+      {
+        pending.waitForFinished();
+        results = pending.results();
+      }
+      catch ( ... )
+      {
+        // the running batch still references this algorithm
+        next.cancel();
+        next.waitForFinished();
+        throw;
+      }
+
+      for ( const QgsParallelProcessedFeature &result : results )
+      {
+        if ( feedback->isCanceled() )
+          break;
+
+        result.reportMessages( feedback );
+        if ( result.failed )
+        {
+          // the running batch still references this algorithm
+          next.cancel();
+          next.waitForFinished();
+          throw QgsProcessingException( result.error );
+        }
+
+        if ( result.feature.isValid() )
+        {
+          QgsFeature processed = result.feature;
+          sink->addFeature( processed, QgsFeatureSink::FastInsert );
+        }
+
+        feedback->setProgress( current * step );
+        current++;
+      }
+    }
+
+    if ( batch.isEmpty() || feedback->isCanceled() )
+    {
+      next.cancel();
+      next.waitForFinished();
+      break;
+    }
+
+    pending = next;
+    hasPending = true;
+  }
+}
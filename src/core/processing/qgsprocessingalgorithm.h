@@ -801,6 +801,22 @@ class CORE_EXPORT QgsProcessingFeatureBasedAlgorithm : public QgsProcessingAlgor
      */
     virtual QgsProcessingFeatureSource::Flag sourceFlags() const { return static_cast<QgsProcessingFeatureSource::Flag>( 0 ); }
 
+    /**
+     * Returns true if processFeature() can safely be called for several features at the same
+     * time from different threads.
+     *
+     * If true, features are processed in batches on the global thread pool. They are still read
+     * from the source and added to the output sink from the thread running the algorithm, in their
+     * original order. Implementations of processFeature() must then not modify the algorithm's
+     * members or rely on the order in which features are processed. Messages pushed to the
+     * feedback object from processFeature() are collected and reported in feature order.
+     *
+     * The default implementation returns false.
+     *
+     * \since QGIS 3.0
+     */
+    virtual bool supportsParallelProcessing() const { return false; }
+
     /**
      * Maps the input WKB geometry type (\a inputWkbType) to the corresponding
      * output WKB type generated by the algorithm. The default behavior is that the algorithm maintains
@@ -872,6 +888,9 @@ class CORE_EXPORT QgsProcessingFeatureBasedAlgorithm : public QgsProcessingAlgor
 
   private:
 
+    //! Processes the features from \a iterator in batches on the global thread pool
+    void processFeaturesInParallel( QgsFeatureIterator &iterator, QgsFeatureSink *sink, long count, QgsProcessingFeedback *feedback );
+
     std::unique_ptr< QgsProcessingFeatureSource > mSource;
 
 };
@@ -22,6 +22,183 @@
 #include "qgsgeometry.h"
 #include "qgsvectorlayer.h"
 
+///@cond PRIVATE
+
+/**
+ * Calculates an aggregate from values which are added one at a time, so that the
+ * values do not need to be collected before calculating the aggregate.
+ */
+class QgsAggregateAccumulator
+{
+  public:
+
+    QgsAggregateAccumulator( QgsAggregateCalculator::Aggregate aggregate, QVariant::Type resultType, const QString &delimiter );
+
+    //! Returns true if the aggregate can be calculated for values of the result type
+    bool isValid() const { return mKind != Invalid; }
+
+    void addValue( const QVariant &value );
+
+    //! Returns the value of the aggregate for all added values
+    QVariant result();
+
+  private:
+
+    enum Kind
+    {
+      Invalid,
+      Array,
+      Numeric,
+      DateTime,
+      Geometry,
+      Concatenate,
+      String
+    };
+
+    Kind mKind = Invalid;
+    QString mDelimiter;
+    QgsStatisticalSummary::Statistic mNumericStat = QgsStatisticalSummary::Count;
+    QgsStringStatisticalSummary::Statistic mStringStat = QgsStringStatisticalSummary::Count;
+    QgsDateTimeStatisticalSummary::Statistic mDateTimeStat = QgsDateTimeStatisticalSummary::Count;
+    QgsStatisticalSummary mNumericSummary;
+    QgsStringStatisticalSummary mStringSummary;
+    QgsDateTimeStatisticalSummary mDateTimeSummary;
+    QVariantList mArray;
+    QList< QgsGeometry > mGeometries;
+    QString mConcatenated;
+};
+
+QgsAggregateAccumulator::QgsAggregateAccumulator( QgsAggregateCalculator::Aggregate aggregate, QVariant::Type resultType, const QString &delimiter )
+  : mDelimiter( delimiter )
+{
+  if ( aggregate == QgsAggregateCalculator::ArrayAggregate )
+  {
+    mKind = Array;
+    return;
+  }
+
+  bool statOk = false;
+  switch ( resultType )
+  {
+    case QVariant::Int:
+    case QVariant::UInt:
+    case QVariant::LongLong:
+    case QVariant::ULongLong:
+    case QVariant::Double:
+      mNumericStat = QgsAggregateCalculator::numericStatFromAggregate( aggregate, &statOk );
+      if ( statOk )
+      {
+        mNumericSummary.setStatistics( mNumericStat );
+        mKind = Numeric;
+      }
+      break;
+
+    case QVariant::Date:
+    case QVariant::DateTime:
+      mDateTimeStat = QgsAggregateCalculator::dateTimeStatFromAggregate( aggregate, &statOk );
+      if ( statOk )
+      {
+        mDateTimeSummary.setStatistics( mDateTimeStat );
+        mKind = DateTime;
+      }
+      break;
+
+    case QVariant::UserType:
+      if ( aggregate == QgsAggregateCalculator::GeometryCollect )
+        mKind = Geometry;
+      break;
+
+    default:
+      // treat as string
+      if ( aggregate == QgsAggregateCalculator::StringConcatenate )
+      {
+        //special case
+        mKind = Concatenate;
+        break;
+      }
+
+      mStringStat = QgsAggregateCalculator::stringStatFromAggregate( aggregate, &statOk );
+      if ( statOk )
+      {
+        mStringSummary.setStatistics( mStringStat );
+        mKind = String;
+      }
+      break;
+  }
+}
+
+void QgsAggregateAccumulator::addValue( const QVariant &value )
+{
+  switch ( mKind )
+  {
+    case Invalid:
+      break;
+
+    case Array:
+      mArray.append( value );
+      break;
+
+    case Numeric:
+      mNumericSummary.addVariant( value );
+      break;
+
+    case DateTime:
+      mDateTimeSummary.addValue( value );
+      break;
+
+    case Geometry:
+      if ( value.canConvert<QgsGeometry>() )
+        mGeometries << value.value<QgsGeometry>();
+      break;
+
+    case Concatenate:
+      if ( !mConcatenated.isEmpty() )
+        mConcatenated += mDelimiter;
+      mConcatenated += value.toString();
+      break;
+
+    case String:
+      mStringSummary.addValue( value );
+      break;
+  }
+}
+
+QVariant QgsAggregateAccumulator::result()
+{
+  switch ( mKind )
+  {
+    case Invalid:
+      return QVariant();
+
+    case Array:
+      return mArray;
+
+    case Numeric:
+    {
+      mNumericSummary.finalize();
+      double val = mNumericSummary.statistic( mNumericStat );
+      return std::isnan( val ) ? QVariant() : val;
+    }
+
+    case DateTime:
+      mDateTimeSummary.finalize();
+      return mDateTimeSummary.statistic( mDateTimeStat );
+
+    case Geometry:
+      return QVariant::fromValue( QgsGeometry::collectGeometry( mGeometries ) );
+
+    case Concatenate:
+      return mConcatenated;
+
+    case String:
+      mStringSummary.finalize();
+      return mStringSummary.statistic( mStringStat );
+  }
+  return QVariant();
+}
+
+///@endcond
+
 
 
 QgsAggregateCalculator::QgsAggregateCalculator( const QgsVectorLayer *layer )
@@ -54,9 +231,140 @@ QVariant QgsAggregateCalculator::calculate( QgsAggregateCalculator::Aggregate ag
   QgsExpressionContext defaultContext = mLayer->createExpressionContext();
   context = context ? context : &defaultContext;
 
+  QgsFeatureRequest request;
+  std::unique_ptr<QgsExpression> expression;
+  int attrNum = -1;
+  QVariant::Type resultType = QVariant::Double;
+  bool hasFeatures = true;
+  if ( !prepareRequest( fieldOrExpression, QStringList(), context, request, expression, attrNum, resultType, hasFeatures ) )
+    return QVariant();
+
+  if ( !hasFeatures )
+  {
+    //no matching features
+    if ( ok )
+      *ok = true;
+    return defaultValue( aggregate );
+  }
+
+  QgsAggregateAccumulator accumulator( aggregate, resultType, mDelimiter );
+  if ( !accumulator.isValid() )
+    return QVariant();
+
+  QgsFeature f;
+  QgsFeatureIterator fit = mLayer->getFeatures( request );
+  while ( fit.nextFeature( f ) )
+  {
+    if ( expression )
+    {
+      context->setFeature( f );
+      accumulator.addValue( expression->evaluate( context ) );
+    }
+    else
+    {
+      accumulator.addValue( f.attribute( attrNum ) );
+    }
+  }
+
+  if ( ok )
+    *ok = true;
+  return accumulator.result();
+}
+
+QVariantMap QgsAggregateCalculator::calculateGrouped( QgsAggregateCalculator::Aggregate aggregate, const QString &fieldOrExpression,
+    const QStringList &groupByFields, QgsExpressionContext *context, bool *ok ) const
+{
+  if ( ok )
+    *ok = false;
+
+  QVariantMap results;
+  if ( !mLayer )
+    return results;
+
+  QVector< int > groupByAttrs;
+  groupByAttrs.reserve( groupByFields.count() );
+  for ( const QString &field : groupByFields )
+  {
+    int idx = mLayer->fields().lookupField( field );
+    if ( idx < 0 )
+      return results;
+    groupByAttrs << idx;
+  }
+
+  QgsExpressionContext defaultContext = mLayer->createExpressionContext();
+  context = context ? context : &defaultContext;
+
+  QgsFeatureRequest request;
   std::unique_ptr<QgsExpression> expression;
+  int attrNum = -1;
+  QVariant::Type resultType = QVariant::Double;
+  bool hasFeatures = true;
+  if ( !prepareRequest( fieldOrExpression, groupByFields, context, request, expression, attrNum, resultType, hasFeatures ) )
+    return results;
 
-  int attrNum = mLayer->fields().lookupField( fieldOrExpression );
+  QgsAggregateAccumulator emptyGroup( aggregate, resultType, mDelimiter );
+  if ( !emptyGroup.isValid() )
+    return results;
+
+  // single pass over the features, adding the values to the aggregate of their group
+  QHash< QString, QgsAggregateAccumulator > groups;
+  if ( hasFeatures )
+  {
+    QVariantList groupValues;
+    groupValues.reserve( groupByAttrs.count() );
+    QgsFeature f;
+    QgsFeatureIterator fit = mLayer->getFeatures( request );
+    while ( fit.nextFeature( f ) )
+    {
+      groupValues.clear();
+      for ( int idx : qgsAsConst( groupByAttrs ) )
+        groupValues << f.attribute( idx );
+
+      const QString key = groupKey( groupValues );
+      QHash< QString, QgsAggregateAccumulator >::iterator group = groups.find( key );
+      if ( group == groups.end() )
+        group = groups.insert( key, emptyGroup );
+
+      if ( expression )
+      {
+        context->setFeature( f );
+        group.value().addValue( expression->evaluate( context ) );
+      }
+      else
+      {
+        group.value().addValue( f.attribute( attrNum ) );
+      }
+    }
+  }
+
+  for ( auto it = groups.begin(); it != groups.end(); ++it )
+  {
+    results.insert( it.key(), it.value().result() );
+  }
+
+  // value for groups without features, consistent with calculate()
+  results.insert( QString(), expression ? defaultValue( aggregate ) : emptyGroup.result() );
+
+  if ( ok )
+    *ok = true;
+  return results;
+}
+
+QString QgsAggregateCalculator::groupKey( const QVariantList &values )
+{
+  QString key;
+  for ( const QVariant &value : values )
+  {
+    // distinguish null values from empty strings
+    key += value.isNull() ? QStringLiteral( "\x1fN" ) : QStringLiteral( "\x1fV" ) + value.toString();
+  }
+  return key;
+}
+
+bool QgsAggregateCalculator::prepareRequest( const QString &fieldOrExpression, const QStringList &extraFields, QgsExpressionContext *context,
+    QgsFeatureRequest &request, std::unique_ptr<QgsExpression> &expression, int &attrNum, QVariant::Type &resultType, bool &hasFeatures ) const
+{
+  attrNum = mLayer->fields().lookupField( fieldOrExpression );
 
   if ( attrNum == -1 )
   {
@@ -67,7 +375,7 @@ QVariant QgsAggregateCalculator::calculate( QgsAggregateCalculator::Aggregate ag
 
     if ( expression->hasParserError() || !expression->prepare( context ) )
     {
-      return QVariant();
+      return false;
     }
   }
 
@@ -76,19 +384,20 @@ QVariant QgsAggregateCalculator::calculate( QgsAggregateCalculator::Aggregate ag
     lst.insert( fieldOrExpression );
   else
     lst = expression->referencedColumns();
+  lst.unite( extraFields.toSet() );
 
-  QgsFeatureRequest request = QgsFeatureRequest()
-                              .setFlags( ( expression && expression->needsGeometry() ) ?
-                                         QgsFeatureRequest::NoFlags :
-                                         QgsFeatureRequest::NoGeometry )
-                              .setSubsetOfAttributes( lst, mLayer->fields() );
+  request = QgsFeatureRequest()
+            .setFlags( ( expression && expression->needsGeometry() ) ?
+                       QgsFeatureRequest::NoFlags :
+                       QgsFeatureRequest::NoGeometry )
+            .setSubsetOfAttributes( lst, mLayer->fields() );
   if ( !mFilterExpression.isEmpty() )
     request.setFilterExpression( mFilterExpression );
   if ( context )
     request.setExpressionContext( *context );
 
   //determine result type
-  QVariant::Type resultType = QVariant::Double;
+  hasFeatures = true;
   if ( attrNum == -1 )
   {
     // evaluate first feature, check result type
@@ -99,9 +408,8 @@ QVariant QgsAggregateCalculator::calculate( QgsAggregateCalculator::Aggregate ag
     if ( !fit.nextFeature( f ) )
     {
       //no matching features
-      if ( ok )
-        *ok = true;
-      return defaultValue( aggregate );
+      hasFeatures = false;
+      return true;
     }
 
     if ( context )
@@ -113,9 +421,7 @@ QVariant QgsAggregateCalculator::calculate( QgsAggregateCalculator::Aggregate ag
   {
     resultType = mLayer->fields().at( attrNum ).type();
   }
-
-  QgsFeatureIterator fit = mLayer->getFeatures( request );
-  return calculate( aggregate, fit, resultType, attrNum, expression.get(), mDelimiter, context, ok );
+  return true;
 }
 
 QgsAggregateCalculator::Aggregate QgsAggregateCalculator::stringToAggregate( const QString &string, bool *ok )
@@ -174,91 +480,6 @@ QgsAggregateCalculator::Aggregate QgsAggregateCalculator::stringToAggregate( con
   return Count;
 }
 
-QVariant QgsAggregateCalculator::calculate( QgsAggregateCalculator::Aggregate aggregate, QgsFeatureIterator &fit, QVariant::Type resultType,
-    int attr, QgsExpression *expression, const QString &delimiter, QgsExpressionContext *context, bool *ok )
-{
-  if ( ok )
-    *ok = false;
-
-  if ( aggregate == QgsAggregateCalculator::ArrayAggregate )
-  {
-    if ( ok )
-      *ok = true;
-    return calculateArrayAggregate( fit, attr, expression, context );
-  }
-
-  switch ( resultType )
-  {
-    case QVariant::Int:
-    case QVariant::UInt:
-    case QVariant::LongLong:
-    case QVariant::ULongLong:
-    case QVariant::Double:
-    {
-      bool statOk = false;
-      QgsStatisticalSummary::Statistic stat = numericStatFromAggregate( aggregate, &statOk );
-      if ( !statOk )
-        return QVariant();
-
-      if ( ok )
-        *ok = true;
-      return calculateNumericAggregate( fit, attr, expression, context, stat );
-    }
-
-    case QVariant::Date:
-    case QVariant::DateTime:
-    {
-      bool statOk = false;
-      QgsDateTimeStatisticalSummary::Statistic stat = dateTimeStatFromAggregate( aggregate, &statOk );
-      if ( !statOk )
-        return QVariant();
-
-      if ( ok )
-        *ok = true;
-      return calculateDateTimeAggregate( fit, attr, expression, context, stat );
-    }
-
-    case QVariant::UserType:
-    {
-      if ( aggregate == GeometryCollect )
-      {
-        if ( ok )
-          *ok = true;
-        return calculateGeometryAggregate( fit, expression, context );
-      }
-      else
-      {
-        return QVariant();
-      }
-    }
-
-    default:
-    {
-      // treat as string
-      if ( aggregate == StringConcatenate )
-      {
-        //special case
-        if ( ok )
-          *ok = true;
-        return concatenateStrings( fit, attr, expression, context, delimiter );
-      }
-
-      bool statOk = false;
-      QgsStringStatisticalSummary::Statistic stat = stringStatFromAggregate( aggregate, &statOk );
-      if ( !statOk )
-        return QVariant();
-
-      if ( ok )
-        *ok = true;
-      return calculateStringAggregate( fit, attr, expression, context, stat );
-    }
-  }
-
-#ifndef _MSC_VER
-  return QVariant();
-#endif
-}
-
 QgsStatisticalSummary::Statistic QgsAggregateCalculator::numericStatFromAggregate( QgsAggregateCalculator::Aggregate aggregate, bool *ok )
 {
   if ( ok )
@@ -410,107 +631,7 @@ QgsDateTimeStatisticalSummary::Statistic QgsAggregateCalculator::dateTimeStatFro
   return QgsDateTimeStatisticalSummary::Count;
 }
 
-QVariant QgsAggregateCalculator::calculateNumericAggregate( QgsFeatureIterator &fit, int attr, QgsExpression *expression,
-    QgsExpressionContext *context, QgsStatisticalSummary::Statistic stat )
-{
-  Q_ASSERT( expression || attr >= 0 );
-
-  QgsStatisticalSummary s( stat );
-  QgsFeature f;
-
-  while ( fit.nextFeature( f ) )
-  {
-    if ( expression )
-    {
-      Q_ASSERT( context );
-      context->setFeature( f );
-      QVariant v = expression->evaluate( context );
-      s.addVariant( v );
-    }
-    else
-    {
-      s.addVariant( f.attribute( attr ) );
-    }
-  }
-  s.finalize();
-  double val = s.statistic( stat );
-  return std::isnan( val ) ? QVariant() : val;
-}
-
-QVariant QgsAggregateCalculator::calculateStringAggregate( QgsFeatureIterator &fit, int attr, QgsExpression *expression,
-    QgsExpressionContext *context, QgsStringStatisticalSummary::Statistic stat )
-{
-  Q_ASSERT( expression || attr >= 0 );
-
-  QgsStringStatisticalSummary s( stat );
-  QgsFeature f;
-
-  while ( fit.nextFeature( f ) )
-  {
-    if ( expression )
-    {
-      Q_ASSERT( context );
-      context->setFeature( f );
-      QVariant v = expression->evaluate( context );
-      s.addValue( v );
-    }
-    else
-    {
-      s.addValue( f.attribute( attr ) );
-    }
-  }
-  s.finalize();
-  return s.statistic( stat );
-}
-
-QVariant QgsAggregateCalculator::calculateGeometryAggregate( QgsFeatureIterator &fit, QgsExpression *expression, QgsExpressionContext *context )
-{
-  Q_ASSERT( expression );
-
-  QgsFeature f;
-  QList< QgsGeometry > geometries;
-  while ( fit.nextFeature( f ) )
-  {
-    Q_ASSERT( context );
-    context->setFeature( f );
-    QVariant v = expression->evaluate( context );
-    if ( v.canConvert<QgsGeometry>() )
-    {
-      geometries << v.value<QgsGeometry>();
-    }
-  }
-
-  return QVariant::fromValue( QgsGeometry::collectGeometry( geometries ) );
-}
-
-QVariant QgsAggregateCalculator::concatenateStrings( QgsFeatureIterator &fit, int attr, QgsExpression *expression,
-    QgsExpressionContext *context, const QString &delimiter )
-{
-  Q_ASSERT( expression || attr >= 0 );
-
-  QgsFeature f;
-  QString result;
-  while ( fit.nextFeature( f ) )
-  {
-    if ( !result.isEmpty() )
-      result += delimiter;
-
-    if ( expression )
-    {
-      Q_ASSERT( context );
-      context->setFeature( f );
-      QVariant v = expression->evaluate( context );
-      result += v.toString();
-    }
-    else
-    {
-      result += f.attribute( attr ).toString();
-    }
-  }
-  return result;
-}
-
-QVariant QgsAggregateCalculator::defaultValue( QgsAggregateCalculator::Aggregate aggregate ) const
+QVariant QgsAggregateCalculator::defaultValue( QgsAggregateCalculator::Aggregate aggregate )
 {
   // value to return when NO features are aggregated:
   switch ( aggregate )
@@ -548,55 +669,3 @@ QVariant QgsAggregateCalculator::defaultValue( QgsAggregateCalculator::Aggregate
   }
   return QVariant();
 }
-
-QVariant QgsAggregateCalculator::calculateDateTimeAggregate( QgsFeatureIterator &fit, int attr, QgsExpression *expression,
-    QgsExpressionContext *context, QgsDateTimeStatisticalSummary::Statistic stat )
-{
-  Q_ASSERT( expression || attr >= 0 );
-
-  QgsDateTimeStatisticalSummary s( stat );
-  QgsFeature f;
-
-  while ( fit.nextFeature( f ) )
-  {
-    if ( expression )
-    {
-      Q_ASSERT( context );
-      context->setFeature( f );
-      QVariant v = expression->evaluate( context );
-      s.addValue( v );
-    }
-    else
-    {
-      s.addValue( f.attribute( attr ) );
-    }
-  }
-  s.finalize();
-  return s.statistic( stat );
-}
-
-QVariant QgsAggregateCalculator::calculateArrayAggregate( QgsFeatureIterator &fit, int attr, QgsExpression *expression,
-    QgsExpressionContext *context )
-{
-  Q_ASSERT( expression || attr >= 0 );
-
-  QgsFeature f;
-
-  QVariantList array;
-
-  while ( fit.nextFeature( f ) )
-  {
-    if ( expression )
-    {
-      Q_ASSERT( context );
-      context->setFeature( f );
-      QVariant v = expression->evaluate( context );
-      array.append( v );
-    }
-    else
-    {
-      array.append( f.attribute( attr ) );
-    }
-  }
-  return array;
-}
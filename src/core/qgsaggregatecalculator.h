@@ -23,9 +23,11 @@
 #include "qgsdatetimestatisticalsummary.h"
 #include "qgsstringstatisticalsummary.h"
 #include <QVariant>
+#include <memory>
 
 
 class QgsFeatureIterator;
+class QgsFeatureRequest;
 class QgsExpression;
 class QgsVectorLayer;
 class QgsExpressionContext;
@@ -134,6 +136,37 @@ class CORE_EXPORT QgsAggregateCalculator
     QVariant calculate( Aggregate aggregate, const QString &fieldOrExpression,
                         QgsExpressionContext *context = nullptr, bool *ok = nullptr ) const;
 
+    /**
+     * Calculates the value of an aggregate for each group of features sharing the same values
+     * for the \a groupByFields, using a single pass over the features of the layer. This is much
+     * faster than calculating the aggregate with a separate filter for each group.
+     * The filter set for the calculator limits the features of all groups.
+     * \param aggregate aggregate to calculate
+     * \param fieldOrExpression source field or expression to use as basis for aggregated values.
+     * If an expression is used, then the context parameter must be set.
+     * \param groupByFields names of the fields to group the features by
+     * \param context expression context for evaluating expressions
+     * \param ok if specified, will be set to true if aggregate calculation was successful
+     * \returns calculated aggregate values by group key, see groupKey(). Groups without features
+     * are not contained in the result, the value to use for them is stored with an empty key.
+     * \since QGIS 3.0
+     */
+    QVariantMap calculateGrouped( Aggregate aggregate, const QString &fieldOrExpression, const QStringList &groupByFields,
+                                   QgsExpressionContext *context = nullptr, bool *ok = nullptr ) const;
+
+    /**
+     * Returns the key of the group of features with the specified group by field \a values,
+     * as used for the results of calculateGrouped().
+     * \since QGIS 3.0
+     */
+    static QString groupKey( const QVariantList &values );
+
+    /**
+     * Returns the value of an \a aggregate when no features are aggregated.
+     * \since QGIS 3.0
+     */
+    static QVariant defaultValue( Aggregate aggregate );
+
     /** Converts a string to a aggregate type.
      * \param string string to convert
      * \param ok if specified, will be set to true if conversion was successful
@@ -156,27 +189,15 @@ class CORE_EXPORT QgsAggregateCalculator
     static QgsStringStatisticalSummary::Statistic stringStatFromAggregate( Aggregate aggregate, bool *ok = nullptr );
     static QgsDateTimeStatisticalSummary::Statistic dateTimeStatFromAggregate( Aggregate aggregate, bool *ok = nullptr );
 
-    static QVariant calculateNumericAggregate( QgsFeatureIterator &fit, int attr, QgsExpression *expression,
-        QgsExpressionContext *context, QgsStatisticalSummary::Statistic stat );
-
-    static QVariant calculateStringAggregate( QgsFeatureIterator &fit, int attr, QgsExpression *expression,
-        QgsExpressionContext *context, QgsStringStatisticalSummary::Statistic stat );
+    friend class QgsAggregateAccumulator;
 
-    static QVariant calculateDateTimeAggregate( QgsFeatureIterator &fit, int attr, QgsExpression *expression,
-        QgsExpressionContext *context, QgsDateTimeStatisticalSummary::Statistic stat );
-    static QVariant calculateGeometryAggregate( QgsFeatureIterator &fit, QgsExpression *expression, QgsExpressionContext *context );
-
-    static QVariant calculateArrayAggregate( QgsFeatureIterator &fit, int attr, QgsExpression *expression,
-        QgsExpressionContext *context );
-
-    static QVariant calculate( Aggregate aggregate, QgsFeatureIterator &fit, QVariant::Type resultType,
-                               int attr, QgsExpression *expression,
-                               const QString &delimiter,
-                               QgsExpressionContext *context, bool *ok = nullptr );
-    static QVariant concatenateStrings( QgsFeatureIterator &fit, int attr, QgsExpression *expression,
-                                        QgsExpressionContext *context, const QString &delimiter );
-
-    QVariant defaultValue( Aggregate aggregate ) const;
+    /**
+     * Prepares the request and the expression for iterating over the features of the layer, and
+     * determines the type of the aggregated values. Returns false if the expression is not valid.
+     */
+    bool prepareRequest( const QString &fieldOrExpression, const QStringList &extraFields, QgsExpressionContext *context,
+                         QgsFeatureRequest &request, std::unique_ptr< QgsExpression > &expression, int &attrNum,
+                         QVariant::Type &resultType, bool &hasFeatures ) const;
 };
 
 #endif //QGSAGGREGATECALCULATOR_H
@@ -0,0 +1,240 @@
+/***************************************************************************
+  qgsapproximatecoordinatetransform.cpp
+  -------------------------------------
+  begin                : October 2017
+  copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsapproximatecoordinatetransform.h"
+#include "qgsexception.h"
+#include "qgslogger.h"
+
+#include <algorithm>
+#include <cmath>
+
+// upper limit for the number of grid rows and columns. Needing more means that the
+// transform is not smooth within the extent (e.g. it crosses the antimeridian)
+static const int MAX_BREAKS = 257;
+
+QgsApproximateCoordinateTransform::QgsApproximateCoordinateTransform( const QgsCoordinateTransform &transform, const QgsRectangle &extent, double tolerance )
+  : mTransform( transform )
+  , mExtent( extent )
+{
+  if ( transform.isValid() && !transform.isShortCircuited() && !extent.isEmpty() && extent.isFinite() && tolerance > 0 )
+    mValid = buildGrid( tolerance );
+
+  if ( !mValid )
+  {
+    QgsDebugMsgLevel( QStringLiteral( "Transform can't be approximated within %1" ).arg( extent.toString() ), 3 );
+    mXBreaks.clear();
+    mYBreaks.clear();
+    mDestX.clear();
+    mDestY.clear();
+  }
+}
+
+void QgsApproximateCoordinateTransform::transformPolygon( QPolygonF &polygon ) const
+{
+  if ( !mValid )
+  {
+    mTransform.transformPolygon( polygon );
+    return;
+  }
+
+  const double xMin = mExtent.xMinimum();
+  const double xMax = mExtent.xMaximum();
+  const double yMin = mExtent.yMinimum();
+  const double yMax = mExtent.yMaximum();
+  QPointF *ptr = polygon.data();
+  for ( int i = 0; i < polygon.size(); ++i, ++ptr )
+  {
+    double x = ptr->x();
+    double y = ptr->y();
+    if ( x >= xMin && x <= xMax && y >= yMin && y <= yMax )
+    {
+      interpolate( x, y );
+    }
+    else
+    {
+      double z = 0;
+      mTransform.transformInPlace( x, y, z );
+    }
+    ptr->setX( x );
+    ptr->setY( y );
+  }
+}
+
+void QgsApproximateCoordinateTransform::transformInPlace( double &x, double &y ) const
+{
+  if ( mValid && mExtent.contains( QgsPointXY( x, y ) ) )
+  {
+    interpolate( x, y );
+  }
+  else
+  {
+    double z = 0;
+    mTransform.transformInPlace( x, y, z );
+  }
+}
+
+bool QgsApproximateCoordinateTransform::buildGrid( double tolerance )
+{
+  mXBreaks = QVector< double >() << mExtent.xMinimum() << mExtent.center().x() << mExtent.xMaximum();
+  mYBreaks = QVector< double >() << mExtent.yMinimum() << mExtent.center().y() << mExtent.yMaximum();
+
+  QVector< double > testX;
+  QVector< double > testY;
+  QVector< double > testZ;
+  // grid column and row intervals which each test point checks, or -1
+  QVector< int > testColumn;
+  QVector< int > testRow;
+
+  while ( true )
+  {
+    if ( !transformControlPoints() )
+      return false;
+
+    const int nx = mXBreaks.size();
+    const int ny = mYBreaks.size();
+
+    // check the middle of the horizontal edges (errors along x), of the vertical edges
+    // (errors along y) and of the cells
+    testX.clear();
+    testY.clear();
+    testColumn.clear();
+    testRow.clear();
+    auto addTest = [&]( double x, double y, int column, int row )
+    {
+      testX << x;
+      testY << y;
+      testColumn << column;
+      testRow << row;
+    };
+    for ( int j = 0; j < ny; ++j )
+    {
+      const double y = mYBreaks.at( j );
+      const double yMid = j + 1 < ny ? 0.5 * ( y + mYBreaks.at( j + 1 ) ) : 0;
+      for ( int i = 0; i < nx; ++i )
+      {
+        const double x = mXBreaks.at( i );
+        const double xMid = i + 1 < nx ? 0.5 * ( x + mXBreaks.at( i + 1 ) ) : 0;
+        if ( i + 1 < nx )
+          addTest( xMid, y, i, -1 );
+        if ( j + 1 < ny )
+          addTest( x, yMid, -1, j );
+        if ( i + 1 < nx && j + 1 < ny )
+          addTest( xMid, yMid, i, j );
+      }
+    }
+
+    QVector< double > expectedX = testX;
+    QVector< double > expectedY = testY;
+    testZ.fill( 0, testX.size() );
+    try
+    {
+      mTransform.transformCoords( expectedX.size(), expectedX.data(), expectedY.data(), testZ.data() );
+    }
+    catch ( QgsCsException & )
+    {
+      return false;
+    }
+
+    QVector< bool > splitColumn( nx - 1, false );
+    QVector< bool > splitRow( ny - 1, false );
+    bool split = false;
+    for ( int k = 0; k < testX.size(); ++k )
+    {
+      double x = testX.at( k );
+      double y = testY.at( k );
+      interpolate( x, y );
+      const double error = std::hypot( x - expectedX.at( k ), y - expectedY.at( k ) );
+      // also catches non finite values
+      if ( error <= tolerance )
+        continue;
+
+      split = true;
+      if ( testColumn.at( k ) >= 0 )
+        splitColumn[ testColumn.at( k )] = true;
+      if ( testRow.at( k ) >= 0 )
+        splitRow[ testRow.at( k )] = true;
+    }
+
+    if ( !split )
+      return true;
+
+    auto refine = []( const QVector< double > &breaks, const QVector< bool > &splits )
+    {
+      QVector< double > result;
+      result.reserve( 2 * breaks.size() );
+      for ( int i = 0; i < breaks.size(); ++i )
+      {
+        result << breaks.at( i );
+        if ( i < splits.size() && splits.at( i ) )
+          result << 0.5 * ( breaks.at( i ) + breaks.at( i + 1 ) );
+      }
+      return result;
+    };
+    mXBreaks = refine( mXBreaks, splitColumn );
+    mYBreaks = refine( mYBreaks, splitRow );
+    if ( mXBreaks.size() > MAX_BREAKS || mYBreaks.size() > MAX_BREAKS )
+      return false;
+  }
+}
+
+bool QgsApproximateCoordinateTransform::transformControlPoints()
+{
+  const int nx = mXBreaks.size();
+  const int ny = mYBreaks.size();
+  mDestX.resize( nx * ny );
+  mDestY.resize( nx * ny );
+  for ( int j = 0; j < ny; ++j )
+  {
+    for ( int i = 0; i < nx; ++i )
+    {
+      mDestX[ j * nx + i ] = mXBreaks.at( i );
+      mDestY[ j * nx + i ] = mYBreaks.at( j );
+    }
+  }
+
+  QVector< double > z( nx * ny, 0 );
+  try
+  {
+    mTransform.transformCoords( nx * ny, mDestX.data(), mDestY.data(), z.data() );
+  }
+  catch ( QgsCsException & )
+  {
+    return false;
+  }
+
+  for ( int k = 0; k < nx * ny; ++k )
+  {
+    if ( !std::isfinite( mDestX.at( k ) ) || !std::isfinite( mDestY.at( k ) ) )
+      return false;
+  }
+  return true;
+}
+
+void QgsApproximateCoordinateTransform::interpolate( double &x, double &y ) const
+{
+  const int nx = mXBreaks.size();
+  const int ny = mYBreaks.size();
+  const int i = qBound( 0, static_cast< int >( std::upper_bound( mXBreaks.constBegin(), mXBreaks.constEnd(), x ) - mXBreaks.constBegin() ) - 1, nx - 2 );
+  const int j = qBound( 0, static_cast< int >( std::upper_bound( mYBreaks.constBegin(), mYBreaks.constEnd(), y ) - mYBreaks.constBegin() ) - 1, ny - 2 );
+
+  const double tx = ( x - mXBreaks.at( i ) ) / ( mXBreaks.at( i + 1 ) - mXBreaks.at( i ) );
+  const double ty = ( y - mYBreaks.at( j ) ) / ( mYBreaks.at( j + 1 ) - mYBreaks.at( j ) );
+
+  const int k00 = j * nx + i;
+  const int k01 = k00 + nx;
+  x = ( 1 - ty ) * ( ( 1 - tx ) * mDestX.at( k00 ) + tx * mDestX.at( k00 + 1 ) )
+      + ty * ( ( 1 - tx ) * mDestX.at( k01 ) + tx * mDestX.at( k01 + 1 ) );
+  y = ( 1 - ty ) * ( ( 1 - tx ) * mDestY.at( k00 ) + tx * mDestY.at( k00 + 1 ) )
+      + ty * ( ( 1 - tx ) * mDestY.at( k01 ) + tx * mDestY.at( k01 + 1 ) );
+}
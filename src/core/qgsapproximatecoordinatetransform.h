@@ -0,0 +1,104 @@
+/***************************************************************************
+  qgsapproximatecoordinatetransform.h
+  -----------------------------------
+  begin                : October 2017
+  copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSAPPROXIMATECOORDINATETRANSFORM_H
+#define QGSAPPROXIMATECOORDINATETRANSFORM_H
+
+#define SIP_NO_FILE
+
+#include "qgis_core.h"
+#include "qgscoordinatetransform.h"
+#include "qgsrectangle.h"
+
+#include <QPolygonF>
+#include <QVector>
+
+/**
+ * \ingroup core
+ * Approximates a coordinate transform within an extent, by bilinear interpolation
+ * between control points which are transformed exactly.
+ *
+ * The control points form a grid which is refined where needed, until the
+ * interpolation error in the middle of the grid cells and their edges is below
+ * a tolerance (in destination units). This is meant for rendering, where errors
+ * below a fraction of a pixel are invisible and a few thousand exact transforms
+ * replace one for every vertex. Points outside of the extent are transformed exactly.
+ *
+ * \note not available in Python bindings
+ * \since QGIS 3.0
+ */
+class CORE_EXPORT QgsApproximateCoordinateTransform
+{
+  public:
+
+    /**
+     * Constructor for QgsApproximateCoordinateTransform, approximating \a transform within
+     * \a extent (in source CRS units) with a maximum error of \a tolerance (in destination
+     * CRS units).
+     *
+     * If the tolerance can't be met with a reasonable number of control points, e.g. because
+     * the transform is discontinuous within the extent, the approximation is not valid.
+     * \see isValid()
+     */
+    QgsApproximateCoordinateTransform( const QgsCoordinateTransform &transform, const QgsRectangle &extent, double tolerance );
+
+    /**
+     * Returns true if the approximation meets the tolerance within its extent. Invalid
+     * approximations transform all points exactly.
+     */
+    bool isValid() const { return mValid; }
+
+    //! Returns the extent (in source CRS units) covered by the approximation
+    QgsRectangle extent() const { return mExtent; }
+
+    //! Returns the number of control points in the grid, or 0 if the approximation is not valid
+    int controlPointCount() const { return mValid ? mXBreaks.size() * mYBreaks.size() : 0; }
+
+    /**
+     * Transforms the points of a \a polygon in place, from the source to the destination CRS.
+     * \throws QgsCsException if the exact transform of a point outside the extent fails
+     */
+    void transformPolygon( QPolygonF &polygon ) const;
+
+    /**
+     * Transforms a point in place, from the source to the destination CRS.
+     * \throws QgsCsException if the exact transform of a point outside the extent fails
+     */
+    void transformInPlace( double &x, double &y ) const;
+
+  private:
+
+    QgsCoordinateTransform mTransform;
+    QgsRectangle mExtent;
+    bool mValid = false;
+
+    //! Sorted x coordinates of the grid columns
+    QVector< double > mXBreaks;
+    //! Sorted y coordinates of the grid rows
+    QVector< double > mYBreaks;
+    //! Transformed control points, row by row
+    QVector< double > mDestX;
+    QVector< double > mDestY;
+
+    //! Refines the grid until the interpolation error is below tolerance
+    bool buildGrid( double tolerance );
+
+    //! Transforms the control points for the current breaks
+    bool transformControlPoints();
+
+    //! Interpolates a point within the extent
+    void interpolate( double &x, double &y ) const;
+};
+
+#endif // QGSAPPROXIMATECOORDINATETRANSFORM_H
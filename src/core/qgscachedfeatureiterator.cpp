@@ -127,6 +127,8 @@ QgsCachedFeatureWriterIterator::QgsCachedFeatureWriterIterator( QgsVectorLayerCa
     mRequest.setFilterRect( mFilterRect );
   }
 
+  // the layer skips the features before the requested offset
+  mOffsetApplied = true;
   mFeatIt = vlCache->layer()->getFeatures( mRequest );
 }
 
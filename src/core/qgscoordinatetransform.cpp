@@ -470,6 +470,11 @@ void QgsCoordinateTransform::transformCoords( int numPoints, double *x, double *
   QgsDebugMsg( QString( "[[[[[[ Number of points to transform: %1 ]]]]]]" ).arg( numPoints ) );
 #endif
 
+  // the most common CRS pairs are transformed without proj (z values are unchanged by these)
+  if ( d->mFastPath != QgsCoordinateTransformPrivate::NoFastPath
+       && d->fastTransform( numPoints, x, y, ( direction == ForwardTransform ) == d->mFastPathSourceIsGeographic ) )
+    return;
+
   // use proj4 to do the transform
 
   // if the source/destination projection is lat/long, convert the points to radians
@@ -27,6 +27,8 @@ extern "C"
 
 #include <QStringList>
 
+#include <cmath>
+
 /// @cond PRIVATE
 
 thread_local QgsProjContextStore QgsCoordinateTransformPrivate::mProjContext;
@@ -178,6 +180,8 @@ bool QgsCoordinateTransformPrivate::initialize()
     mShortCircuit = false;
     QgsDebugMsgLevel( "Source/Dest CRS not equal, shortcircuit is not set.", 3 );
   }
+
+  detectFastPath();
   return mIsValid;
 }
 
@@ -321,6 +325,231 @@ void QgsCoordinateTransformPrivate::setFinder()
 #endif
 }
 
+void QgsCoordinateTransformPrivate::detectFastPath()
+{
+  mFastPath = NoFastPath;
+
+  // custom datum transforms (and grid shifts) are only handled by proj
+  if ( !mIsValid || mShortCircuit || mSourceDatumTransform != -1 || mDestinationDatumTransform != -1 )
+    return;
+
+  const QString sourceAuthId = mSourceCRS.authid().toUpper();
+  const QString destAuthId = mDestCRS.authid().toUpper();
+  QString projectedAuthId;
+  QString projectedProjString;
+  if ( sourceAuthId == QLatin1String( "EPSG:4326" ) )
+  {
+    mFastPathSourceIsGeographic = true;
+    projectedAuthId = destAuthId;
+    projectedProjString = mDestProjString;
+  }
+  else if ( destAuthId == QLatin1String( "EPSG:4326" ) )
+  {
+    mFastPathSourceIsGeographic = false;
+    projectedAuthId = sourceAuthId;
+    projectedProjString = mSourceProjString;
+  }
+  else
+  {
+    return;
+  }
+
+  // guard against modified definitions in the srs database
+  const QString geographicProjString = mFastPathSourceIsGeographic ? mSourceProjString : mDestProjString;
+  if ( !geographicProjString.contains( QLatin1String( "+proj=longlat" ) ) || !geographicProjString.contains( QLatin1String( "+datum=WGS84" ) ) )
+    return;
+
+  if ( projectedAuthId == QLatin1String( "EPSG:3857" ) )
+  {
+    if ( projectedProjString.contains( QLatin1String( "+proj=merc" ) ) )
+      mFastPath = WebMercator;
+    return;
+  }
+
+#if defined(PJ_VERSION) && PJ_VERSION >= 500
+  if ( !projectedAuthId.startsWith( QLatin1String( "EPSG:32" ) ) || !projectedProjString.contains( QLatin1String( "+proj=utm" ) ) )
+    return;
+
+  bool ok = false;
+  const int code = projectedAuthId.midRef( 5 ).toInt( &ok );
+  const int zone = code % 100;
+  if ( !ok || zone < 1 || zone > 60 || ( code - zone != 32600 && code - zone != 32700 ) )
+    return;
+
+  mUtmCentralMeridian = zone * 6 - 183;
+  mUtmSouth = code > 32700;
+  mFastPath = Utm;
+#else
+  // before proj 5 +proj=utm uses an older series, which deviates from the Krueger
+  // series by more than a centimeter a few degrees away from the central meridian
+#endif
+}
+
+// WGS 84 ellipsoid and UTM constants
+static const double WGS84_A = 6378137.0;
+static const double WGS84_F = 1 / 298.257223563;
+static const double UTM_K0 = 0.9996;
+static const double UTM_FALSE_EASTING = 500000.0;
+static const double UTM_FALSE_NORTHING_SOUTH = 10000000.0;
+static const double DEG_TO_RADIANS = M_PI / 180.0;
+static const double RADIANS_TO_DEG = 180.0 / M_PI;
+
+/**
+ * Coefficients of the Krueger series for the transverse mercator projection on the
+ * WGS 84 ellipsoid, to the fourth order of the third flattening. The series is
+ * accurate to well below a millimeter within the extent of a UTM zone.
+ */
+struct QgsUtmSeries
+{
+  QgsUtmSeries()
+  {
+    const double n = WGS84_F / ( 2 - WGS84_F );
+    const double n2 = n * n;
+    const double n3 = n2 * n;
+    const double n4 = n3 * n;
+    e = 2 * std::sqrt( n ) / ( 1 + n );
+    kA = UTM_K0 * WGS84_A / ( 1 + n ) * ( 1 + n2 / 4 + n4 / 64 );
+    alpha[0] = n / 2 - 2 * n2 / 3 + 5 * n3 / 16 + 41 * n4 / 180;
+    alpha[1] = 13 * n2 / 48 - 3 * n3 / 5 + 557 * n4 / 1440;
+    alpha[2] = 61 * n3 / 240 - 103 * n4 / 140;
+    alpha[3] = 49561 * n4 / 161280;
+    beta[0] = n / 2 - 2 * n2 / 3 + 37 * n3 / 96 - n4 / 360;
+    beta[1] = n2 / 48 + n3 / 15 - 437 * n4 / 1440;
+    beta[2] = 17 * n3 / 480 - 37 * n4 / 840;
+    beta[3] = 4397 * n4 / 161280;
+  }
+
+  //! First eccentricity
+  double e;
+  //! Scale factor multiplied by the rectifying radius
+  double kA;
+  double alpha[4];
+  double beta[4];
+};
+
+static const QgsUtmSeries &utmSeries()
+{
+  static const QgsUtmSeries series;
+  return series;
+}
+
+bool QgsCoordinateTransformPrivate::fastTransform( int numPoints, double *x, double *y, bool toProjected ) const
+{
+  // validate all points first, so that a failure leaves the coordinates untouched for proj.
+  // The checks are written so that nan values fail them.
+  switch ( mFastPath )
+  {
+    case NoFastPath:
+      return false;
+
+    case WebMercator:
+    {
+      const double maxX = M_PI * WGS84_A;
+      for ( int i = 0; i < numPoints; ++i )
+      {
+        if ( toProjected && !( std::fabs( x[i] ) <= 180.0 && std::fabs( y[i] ) < 89.9999 ) )
+          return false;
+        else if ( !toProjected && !( std::fabs( x[i] ) <= maxX && std::isfinite( y[i] ) ) )
+          return false;
+      }
+
+      if ( toProjected )
+      {
+        for ( int i = 0; i < numPoints; ++i )
+        {
+          x[i] = WGS84_A * x[i] * DEG_TO_RADIANS;
+          y[i] = WGS84_A * std::log( std::tan( M_PI_4 + 0.5 * y[i] * DEG_TO_RADIANS ) );
+        }
+      }
+      else
+      {
+        for ( int i = 0; i < numPoints; ++i )
+        {
+          x[i] = x[i] / WGS84_A * RADIANS_TO_DEG;
+          y[i] = ( M_PI_2 - 2.0 * std::atan( std::exp( -y[i] / WGS84_A ) ) ) * RADIANS_TO_DEG;
+        }
+      }
+      return true;
+    }
+
+    case Utm:
+    {
+      const QgsUtmSeries &series = utmSeries();
+      const double falseNorthing = mUtmSouth ? UTM_FALSE_NORTHING_SOUTH : 0.0;
+
+      // restricted to a band around the zone, where the series matches proj to a tenth of
+      // a millimeter and proj does not need to wrap longitudes
+      for ( int i = 0; i < numPoints; ++i )
+      {
+        if ( toProjected && !( std::fabs( x[i] - mUtmCentralMeridian ) <= 12.0 && std::fabs( y[i] ) <= 85.0 ) )
+          return false;
+        else if ( !toProjected && !( std::fabs( x[i] - UTM_FALSE_EASTING ) <= 1300000.0 && std::fabs( y[i] - falseNorthing ) <= 9500000.0 ) )
+          return false;
+      }
+
+      const double e = series.e;
+      if ( toProjected )
+      {
+        for ( int i = 0; i < numPoints; ++i )
+        {
+          const double lambda = ( x[i] - mUtmCentralMeridian ) * DEG_TO_RADIANS;
+          const double sinPhi = std::sin( y[i] * DEG_TO_RADIANS );
+          const double t = std::sinh( std::atanh( sinPhi ) - e * std::atanh( e * sinPhi ) );
+          const double xiPrime = std::atan2( t, std::cos( lambda ) );
+          const double etaPrime = std::atanh( std::sin( lambda ) / std::sqrt( 1 + t * t ) );
+
+          double xi = xiPrime;
+          double eta = etaPrime;
+          for ( int j = 0; j < 4; ++j )
+          {
+            const double k = 2.0 * ( j + 1 );
+            xi += series.alpha[j] * std::sin( k * xiPrime ) * std::cosh( k * etaPrime );
+            eta += series.alpha[j] * std::cos( k * xiPrime ) * std::sinh( k * etaPrime );
+          }
+          x[i] = UTM_FALSE_EASTING + series.kA * eta;
+          y[i] = falseNorthing + series.kA * xi;
+        }
+      }
+      else
+      {
+        for ( int i = 0; i < numPoints; ++i )
+        {
+          const double xi = ( y[i] - falseNorthing ) / series.kA;
+          const double eta = ( x[i] - UTM_FALSE_EASTING ) / series.kA;
+
+          double xiPrime = xi;
+          double etaPrime = eta;
+          for ( int j = 0; j < 4; ++j )
+          {
+            const double k = 2.0 * ( j + 1 );
+            xiPrime -= series.beta[j] * std::sin( k * xi ) * std::cosh( k * eta );
+            etaPrime -= series.beta[j] * std::cos( k * xi ) * std::sinh( k * eta );
+          }
+
+          // conformal latitude, then the geodetic latitude by fixed point iteration
+          const double chi = std::asin( std::sin( xiPrime ) / std::cosh( etaPrime ) );
+          const double lambda = std::atan2( std::sinh( etaPrime ), std::cos( xiPrime ) );
+          const double tanChi = std::tan( M_PI_4 + 0.5 * chi );
+          double phi = chi;
+          for ( int iteration = 0; iteration < 15; ++iteration )
+          {
+            const double eSinPhi = e * std::sin( phi );
+            const double next = 2.0 * std::atan( tanChi * std::pow( ( 1 + eSinPhi ) / ( 1 - eSinPhi ), 0.5 * e ) ) - M_PI_2;
+            const bool converged = std::fabs( next - phi ) < 1e-14;
+            phi = next;
+            if ( converged )
+              break;
+          }
+          x[i] = mUtmCentralMeridian + lambda * RADIANS_TO_DEG;
+          y[i] = phi * RADIANS_TO_DEG;
+        }
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
 void QgsCoordinateTransformPrivate::freeProj()
 {
   mProjLock.lockForWrite();
@@ -72,6 +72,26 @@ class QgsCoordinateTransformPrivate : public QSharedData
 
     QPair< projPJ, projPJ > threadLocalProjData();
 
+    /**
+     * Built-in closed form transforms, used instead of proj for the most common
+     * pairs of coordinate reference systems.
+     */
+    enum FastPath
+    {
+      NoFastPath, //!< Transform with proj
+      WebMercator, //!< EPSG:4326 <-> EPSG:3857
+      Utm, //!< EPSG:4326 <-> WGS 84 / UTM zones (EPSG:326xx and EPSG:327xx), with proj 5 or later
+    };
+
+    /**
+     * Transforms \a numPoints coordinates using the built-in transform for the CRS pair.
+     * If \a toProjected is true, the coordinates are transformed from geographic WGS 84
+     * coordinates (in degrees) to the projected CRS, otherwise the other way round.
+     * Returns false without modifying the coordinates if any point lies outside the area
+     * where the built-in transform matches proj, in which case proj must be used.
+     */
+    bool fastTransform( int numPoints, double *x, double *y, bool toProjected ) const;
+
     //! Flag to indicate whether the transform is valid (ie has a valid
     //! source and destination crs)
     bool mIsValid = false;
@@ -94,6 +114,18 @@ class QgsCoordinateTransformPrivate : public QSharedData
     int mSourceDatumTransform = -1;
     int mDestinationDatumTransform = -1;
 
+    //! Built-in transform for the CRS pair, if any
+    FastPath mFastPath = NoFastPath;
+
+    //! True if the source CRS is the geographic one of the fast path
+    bool mFastPathSourceIsGeographic = false;
+
+    //! Central meridian (in degrees) of the UTM zone for the fast path
+    double mUtmCentralMeridian = 0;
+
+    //! True if the UTM zone for the fast path is on the southern hemisphere
+    bool mUtmSouth = false;
+
     /**
      * Thread local proj context storage. A new proj context will be created
      * for every thread.
@@ -115,6 +147,9 @@ class QgsCoordinateTransformPrivate : public QSharedData
 
     void setFinder();
 
+    //! Detects whether a built-in transform can be used for the CRS pair
+    void detectFastPath();
+
     void freeProj();
 };
 
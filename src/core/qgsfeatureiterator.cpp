@@ -32,12 +32,32 @@ QgsAbstractFeatureIterator::QgsAbstractFeatureIterator( const QgsFeatureRequest
 
 bool QgsAbstractFeatureIterator::nextFeature( QgsFeature &f )
 {
-  bool dataOk = false;
   if ( mRequest.limit() >= 0 && mFetchedCount >= mRequest.limit() )
   {
     return false;
   }
 
+  // skip the features before the requested offset, unless the provider already did so
+  if ( !mOffsetApplied )
+  {
+    while ( mSkippedCount < mRequest.offset() )
+    {
+      if ( !nextFilteredFeature( f ) )
+        return false;
+      mSkippedCount++;
+    }
+  }
+
+  bool dataOk = nextFilteredFeature( f );
+  if ( dataOk )
+    mFetchedCount++;
+
+  return dataOk;
+}
+
+bool QgsAbstractFeatureIterator::nextFilteredFeature( QgsFeature &f )
+{
+  bool dataOk = false;
   if ( mUseCachedFeatures )
   {
     if ( mFeatureIterator != mCachedFeatures.constEnd() )
@@ -70,10 +90,6 @@ bool QgsAbstractFeatureIterator::nextFeature( QgsFeature &f )
         break;
     }
   }
-
-  if ( dataOk )
-    mFetchedCount++;
-
   return dataOk;
 }
 
@@ -181,7 +197,8 @@ void QgsAbstractFeatureIterator::setupOrderBy( const QList<QgsFeatureRequest::Or
     QgsIndexedFeature indexedFeature;
     indexedFeature.mIndexes.resize( preparedOrderBys.size() );
 
-    while ( nextFeature( indexedFeature.mFeature ) )
+    // the offset applies to the ordered features, so it must not be skipped during this pre-fetch
+    while ( nextFilteredFeature( indexedFeature.mFeature ) )
     {
       expressionContext->setFeature( indexedFeature.mFeature );
       int i = 0;
@@ -190,9 +207,6 @@ void QgsAbstractFeatureIterator::setupOrderBy( const QList<QgsFeatureRequest::Or
         indexedFeature.mIndexes.replace( i++, orderBy.expression().evaluate( expressionContext ) );
       }
 
-      // We need all features, to ignore the limit for this pre-fetch
-      // keep the fetched count at 0.
-      mFetchedCount = 0;
       mCachedFeatures.append( indexedFeature );
     }
 
@@ -163,6 +163,14 @@ class CORE_EXPORT QgsAbstractFeatureIterator
     //! Number of features already fetched by iterator
     long mFetchedCount;
 
+    /**
+     * Set to true by iterators which already skip the features before QgsFeatureRequest::offset()
+     * on the data source. Must only be set if the provider also handles the request's filter
+     * and order by clauses, otherwise the features are skipped locally.
+     * \since QGIS 3.0
+     */
+    bool mOffsetApplied = false;
+
     //! Status of compilation of filter expression
     CompileStatus mCompileStatus;
 
@@ -171,12 +179,17 @@ class CORE_EXPORT QgsAbstractFeatureIterator
 
   private:
     bool mUseCachedFeatures;
+    //! Number of features skipped to honor the request's offset
+    long mSkippedCount = 0;
     QList<QgsIndexedFeature> mCachedFeatures;
     QList<QgsIndexedFeature>::ConstIterator mFeatureIterator;
 
     //! returns whether the iterator supports simplify geometries on provider side
     virtual bool providerCanSimplify( QgsSimplifyMethod::MethodType methodType ) const;
 
+    //! Fetches the next feature matching the request's filter, from the provider or the local order by cache
+    bool nextFilteredFeature( QgsFeature &f );
+
     /**
      * Should be overwritten by providers which implement an own order by strategy
      * If the own order by strategy is successful, return true, if not, return false
@@ -332,7 +345,10 @@ inline bool QgsFeatureIterator::nextFeature( QgsFeature &f )
 inline bool QgsFeatureIterator::rewind()
 {
   if ( mIter )
+  {
     mIter->mFetchedCount = 0;
+    mIter->mSkippedCount = 0;
+  }
 
   return mIter ? mIter->rewind() : false;
 }
@@ -340,7 +356,10 @@ inline bool QgsFeatureIterator::rewind()
 inline bool QgsFeatureIterator::close()
 {
   if ( mIter )
+  {
     mIter->mFetchedCount = 0;
+    mIter->mSkippedCount = 0;
+  }
 
   return mIter ? mIter->close() : false;
 }
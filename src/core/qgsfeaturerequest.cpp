@@ -82,6 +82,7 @@ QgsFeatureRequest &QgsFeatureRequest::operator=( const QgsFeatureRequest &rh )
   mAttrs = rh.mAttrs;
   mSimplifyMethod = rh.mSimplifyMethod;
   mLimit = rh.mLimit;
+  mOffset = rh.mOffset;
   mOrderBy = rh.mOrderBy;
   mCrs = rh.mCrs;
   mTransformErrorCallback = rh.mTransformErrorCallback;
@@ -175,6 +176,12 @@ QgsFeatureRequest &QgsFeatureRequest::setLimit( long limit )
   return *this;
 }
 
+QgsFeatureRequest &QgsFeatureRequest::setOffset( long offset )
+{
+  mOffset = offset;
+  return *this;
+}
+
 QgsFeatureRequest &QgsFeatureRequest::setFlags( QgsFeatureRequest::Flags flags )
 {
   mFlags = flags;
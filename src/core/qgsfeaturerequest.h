@@ -473,6 +473,26 @@ class CORE_EXPORT QgsFeatureRequest
      */
     long limit() const { return mLimit; }
 
+    /**
+     * Sets the number of features to skip before the first feature is returned.
+     *
+     * Features are skipped after filtering and ordering, so together with setLimit()
+     * this allows requesting a single page of results. Providers which support it
+     * skip the features on the data source (e.g. with an SQL OFFSET clause), which
+     * avoids fetching them at all.
+     * \param offset number of features to skip, or 0 to start with the first feature
+     * \see offset()
+     * \since QGIS 3.0
+     */
+    QgsFeatureRequest &setOffset( long offset );
+
+    /**
+     * Returns the number of features to skip before the first feature is returned.
+     * \see setOffset()
+     * \since QGIS 3.0
+     */
+    long offset() const { return mOffset; }
+
     //! Set flags that affect how features will be fetched
     QgsFeatureRequest &setFlags( QgsFeatureRequest::Flags flags );
     const Flags &flags() const { return mFlags; }
@@ -595,6 +615,7 @@ class CORE_EXPORT QgsFeatureRequest
     QgsAttributeList mAttrs;
     QgsSimplifyMethod mSimplifyMethod;
     long mLimit = -1;
+    long mOffset = 0;
     OrderBy mOrderBy;
     InvalidGeometryCheck mInvalidGeometryFilter = GeometryNoCheck;
     std::function< void( const QgsFeature & ) > mInvalidGeometryCallback;
@@ -0,0 +1,129 @@
+/***************************************************************************
+  qgsfontmetricscache.cpp
+  -----------------------
+  begin                : October 2017
+  copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsfontmetricscache.h"
+
+#include <QCache>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThreadStorage>
+
+#include <algorithm>
+
+///@cond PRIVATE
+
+//! Maximum number of cached font metrics per thread
+static const int MAX_FONT_METRICS = 100;
+//! Maximum number of cached text widths
+static const int MAX_TEXT_WIDTHS = 100000;
+//! Maximum number of path elements of the cached text paths
+static const int MAX_PATH_ELEMENTS = 2000000;
+
+struct QgsFontMetricsCacheData
+{
+  QMutex mutex;
+  QCache< QString, double > widths { MAX_TEXT_WIDTHS };
+  QCache< QString, QPainterPath > paths { MAX_PATH_ELEMENTS };
+};
+
+Q_GLOBAL_STATIC( QgsFontMetricsCacheData, sCacheData )
+
+// QFontMetricsF must not be shared between threads
+static QThreadStorage< QCache< QString, QFontMetricsF > * > sThreadFontMetrics;
+
+static QCache< QString, QFontMetricsF > *_threadFontMetrics()
+{
+  if ( !sThreadFontMetrics.hasLocalData() )
+    sThreadFontMetrics.setLocalData( new QCache< QString, QFontMetricsF >( MAX_FONT_METRICS ) );
+  return sThreadFontMetrics.localData();
+}
+
+static QString _textKey( const QFont &font, const QString &text )
+{
+  return QgsFontMetricsCache::fontKey( font ) + QChar( 0x1f ) + text;
+}
+
+///@endcond
+
+QString QgsFontMetricsCache::fontKey( const QFont &font )
+{
+  // QFont::key() does not include the spacing and capitalization, which affect the text layout
+  return QStringLiteral( "%1,%2,%3,%4,%5,%6,%7" ).arg( font.key() )
+         .arg( font.letterSpacing() )
+         .arg( static_cast< int >( font.letterSpacingType() ) )
+         .arg( font.wordSpacing() )
+         .arg( static_cast< int >( font.capitalization() ) )
+         .arg( font.stretch() )
+         .arg( static_cast< int >( font.hintingPreference() ) );
+}
+
+QFontMetricsF QgsFontMetricsCache::fontMetrics( const QFont &font )
+{
+  QCache< QString, QFontMetricsF > *cache = _threadFontMetrics();
+  const QString key = fontKey( font );
+  if ( QFontMetricsF *fm = cache->object( key ) )
+    return *fm;
+
+  QFontMetricsF *fm = new QFontMetricsF( font );
+  cache->insert( key, fm );
+  return QFontMetricsF( *fm );
+}
+
+double QgsFontMetricsCache::width( const QFont &font, const QString &text )
+{
+  const QString key = _textKey( font, text );
+  QgsFontMetricsCacheData *data = sCacheData();
+  {
+    QMutexLocker locker( &data->mutex );
+    if ( double *width = data->widths.object( key ) )
+      return *width;
+  }
+
+  // measure outside of the lock, the metrics are per thread
+  double width = fontMetrics( font ).width( text );
+
+  QMutexLocker locker( &data->mutex );
+  data->widths.insert( key, new double( width ) );
+  return width;
+}
+
+QPainterPath QgsFontMetricsCache::textPath( const QFont &font, const QString &text )
+{
+  const QString key = _textKey( font, text );
+  QgsFontMetricsCacheData *data = sCacheData();
+  {
+    QMutexLocker locker( &data->mutex );
+    if ( QPainterPath *path = data->paths.object( key ) )
+      return *path;
+  }
+
+  QPainterPath path;
+  path.setFillRule( Qt::WindingFill );
+  path.addText( 0, 0, font, text );
+
+  QMutexLocker locker( &data->mutex );
+  data->paths.insert( key, new QPainterPath( path ), std::max( 1, path.elementCount() ) );
+  return path;
+}
+
+void QgsFontMetricsCache::clear()
+{
+  if ( sThreadFontMetrics.hasLocalData() )
+    sThreadFontMetrics.localData()->clear();
+
+  QgsFontMetricsCacheData *data = sCacheData();
+  QMutexLocker locker( &data->mutex );
+  data->widths.clear();
+  data->paths.clear();
+}
@@ -0,0 +1,74 @@
+/***************************************************************************
+  qgsfontmetricscache.h
+  ---------------------
+  begin                : October 2017
+  copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSFONTMETRICSCACHE_H
+#define QGSFONTMETRICSCACHE_H
+
+#define SIP_NO_FILE
+
+#include "qgis_core.h"
+
+#include <QFont>
+#include <QFontMetricsF>
+#include <QPainterPath>
+#include <QString>
+
+/**
+ * \ingroup core
+ * Thread safe cache of font metrics, text widths and text outline paths, shared by
+ * labeling and QgsTextRenderer.
+ *
+ * Creating QFontMetricsF objects, laying out text for measuring its width and converting
+ * text to a QPainterPath are expensive, and the same fonts and strings are used over and
+ * over when rendering labels. Widths and paths are shared between all threads, font
+ * metrics are cached per thread as Qt's font engines are not thread safe.
+ *
+ * \note not available in Python bindings
+ * \since QGIS 3.0
+ */
+class CORE_EXPORT QgsFontMetricsCache
+{
+  public:
+
+    /**
+     * Returns the font metrics for \a font. The returned metrics must only be used
+     * in the calling thread.
+     */
+    static QFontMetricsF fontMetrics( const QFont &font );
+
+    /**
+     * Returns the width of \a text drawn with \a font, as returned by QFontMetricsF::width().
+     * Caching the width of single characters gives their advance, as used for curved labels.
+     */
+    static double width( const QFont &font, const QString &text );
+
+    /**
+     * Returns the outline path of \a text drawn with \a font at the origin, as created
+     * by QPainterPath::addText(). The fill rule of the path is Qt::WindingFill.
+     */
+    static QPainterPath textPath( const QFont &font, const QString &text );
+
+    /**
+     * Removes all cached widths and paths, and the font metrics of the calling thread.
+     */
+    static void clear();
+
+    /**
+     * Returns the key used for caching the metrics of \a font. Fonts with the same key
+     * have identical metrics.
+     */
+    static QString fontKey( const QFont &font );
+};
+
+#endif // QGSFONTMETRICSCACHE_H
@@ -87,7 +87,13 @@ bool QgsMapRendererCache::init( const QgsRectangle &extent, double scale )
        qgsDoubleNear( scale, mScale ) )
     return true;
 
-  clearInternal();
+  // keep the images if the map has only been panned, they are still valid
+  // for the part of the map which remains visible
+  const bool panned = qgsDoubleNear( scale, mScale )
+                      && qgsDoubleNear( extent.width(), mExtent.width(), mExtent.width() * 1e-9 )
+                      && qgsDoubleNear( extent.height(), mExtent.height(), mExtent.height() * 1e-9 );
+  if ( !panned )
+    clearInternal();
 
   // set new params
   mExtent = extent;
@@ -102,6 +108,7 @@ void QgsMapRendererCache::setCacheImage( const QString &cacheKey, const QImage &
 
   CacheParameters params;
   params.cachedImage = image;
+  params.extent = mExtent;
 
   // connect to the layer to listen to layer's repaintRequested() signals
   Q_FOREACH ( QgsMapLayer *layer, dependentLayers )
@@ -123,13 +130,28 @@ void QgsMapRendererCache::setCacheImage( const QString &cacheKey, const QImage &
 
 bool QgsMapRendererCache::hasCacheImage( const QString &cacheKey ) const
 {
-  return mCachedImages.contains( cacheKey );
+  QMutexLocker lock( &mMutex );
+  QMap<QString, CacheParameters>::const_iterator it = mCachedImages.constFind( cacheKey );
+  return it != mCachedImages.constEnd() && it.value().extent == mExtent;
 }
 
 QImage QgsMapRendererCache::cacheImage( const QString &cacheKey ) const
 {
   QMutexLocker lock( &mMutex );
-  return mCachedImages.value( cacheKey ).cachedImage;
+  QMap<QString, CacheParameters>::const_iterator it = mCachedImages.constFind( cacheKey );
+  if ( it == mCachedImages.constEnd() || it.value().extent != mExtent )
+    return QImage();
+  return it.value().cachedImage;
+}
+
+QImage QgsMapRendererCache::pannedCacheImage( const QString &cacheKey, QgsRectangle &extent ) const
+{
+  QMutexLocker lock( &mMutex );
+  QMap<QString, CacheParameters>::const_iterator it = mCachedImages.constFind( cacheKey );
+  if ( it == mCachedImages.constEnd() || it.value().extent == mExtent )
+    return QImage();
+  extent = it.value().extent;
+  return it.value().cachedImage;
 }
 
 QList< QgsMapLayer * > QgsMapRendererCache::dependentLayers( const QString &cacheKey ) const
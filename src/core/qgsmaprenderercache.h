@@ -17,6 +17,7 @@
 #define QGSMAPRENDERERCACHE_H
 
 #include "qgis_core.h"
+#include "qgis_sip.h"
 #include <QMap>
 #include <QImage>
 #include <QMutex>
@@ -54,6 +55,10 @@ class CORE_EXPORT QgsMapRendererCache : public QObject
     /**
      * Initialize cache: set new parameters and clears the cache if any
      * parameters have changed since last initialization.
+     *
+     * If only the position of the extent has changed (i.e. the map has been panned),
+     * the cached images are kept, but are only available through pannedCacheImage().
+     *
      * \returns flag whether the parameters are the same as last time
      */
     bool init( const QgsRectangle &extent, double scale );
@@ -84,6 +89,18 @@ class CORE_EXPORT QgsMapRendererCache : public QObject
      */
     QImage cacheImage( const QString &cacheKey ) const;
 
+    /**
+     * Returns the image cached for the specified \a cacheKey if it was rendered for
+     * a different extent of the same size and scale as the current one, i.e. before the map
+     * was panned. The extent which the image was rendered for is stored in \a extent.
+     * Returns a null image if there is no such image.
+     *
+     * Images rendered for the current extent are returned by cacheImage() instead.
+     * \see init()
+     * \since QGIS 3.0
+     */
+    QImage pannedCacheImage( const QString &cacheKey, QgsRectangle &extent SIP_OUT ) const;
+
     /**
      * Returns a list of map layers on which an image in the cache depends.
      * \since QGIS 3.0
@@ -105,6 +122,8 @@ class CORE_EXPORT QgsMapRendererCache : public QObject
     struct CacheParameters
     {
       QImage cachedImage;
+      //! Extent which the image was rendered for
+      QgsRectangle extent;
       QgsWeakMapLayerPointerList dependentLayers;
     };
 
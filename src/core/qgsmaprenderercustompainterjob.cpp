@@ -258,8 +258,7 @@ void QgsMapRendererCustomPainterJob::doRender()
 
       if ( job.img )
       {
-        job.img->fill( 0 );
-        job.imageInitialized = true;
+        initializeJobImage( job );
       }
 
       job.renderer->render();
@@ -267,6 +266,12 @@ void QgsMapRendererCustomPainterJob::doRender()
       job.renderingTime = layerTime.elapsed();
     }
 
+    // tile jobs precede the job of their layer, into whose image they are composited
+    if ( job.tileParentJob >= 0 )
+      continue;
+
+    composeTileJobs( mLayerJobs, it - mLayerJobs.begin() );
+
     if ( job.img )
     {
       // If we flattened this layer for alternate blend modes, composite it now
@@ -21,6 +21,7 @@
 #include <QtConcurrentMap>
 
 #include "qgslogger.h"
+#include "qgsapproximatecoordinatetransform.h"
 #include "qgsrendercontext.h"
 #include "qgsmaplayer.h"
 #include "qgsproject.h"
@@ -36,11 +37,25 @@
 #include "qgsmaplayerlistutils.h"
 #include "qgsvectorlayerlabeling.h"
 #include "qgssettings.h"
+#include "qgsrenderer.h"
+#include "qgspainteffect.h"
+
+#include <cmath>
 
 ///@cond PRIVATE
 
 const QString QgsMapRendererJob::LABEL_CACHE_ID = QStringLiteral( "_labels_" );
 
+//! Maximum error (in pixels) of approximate vector layer transforms
+static const double APPROXIMATE_TRANSFORM_TOLERANCE = 0.25;
+
+/**
+ * Margin (in pixels) for symbols crossing the border of the newly exposed parts of a panned map.
+ * A band of this width of the previously rendered image next to the exposed parts is rendered
+ * again, and features within this margin around the rendered parts are rendered.
+ */
+static const int PAN_RENDER_MARGIN = 64;
+
 QgsMapRendererJob::QgsMapRendererJob( const QgsMapSettings &settings )
   : mSettings( settings )
 
@@ -328,12 +343,30 @@ LayerRenderJobs QgsMapRendererJob::prepareJobs( QPainter *painter, QgsLabelingEn
       job.context.setPainter( mypPainter );
     }
 
+    if ( ml->type() == QgsMapLayer::VectorLayer && mSettings.testFlag( QgsMapSettings::ApproximateVectorTransform )
+         && ct.isValid() && !ct.isShortCircuited() )
+    {
+      // geometries are clipped to the extent grown by 10% on each side before being transformed,
+      // see QgsSymbol::_getLineString()
+      QgsRectangle gridExtent = r1;
+      gridExtent.scale( 1.2 );
+      std::shared_ptr< const QgsApproximateCoordinateTransform > approximation = std::make_shared< QgsApproximateCoordinateTransform >( ct, gridExtent, APPROXIMATE_TRANSFORM_TOLERANCE * mSettings.mapUnitsPerPixel() );
+      if ( approximation->isValid() )
+        job.context.setApproximateTransform( approximation );
+    }
+
     bool hasStyleOverride = mSettings.layerStyleOverrides().contains( ml->id() );
     if ( hasStyleOverride )
       ml->styleManager()->setOverrideStyle( mSettings.layerStyleOverrides().value( ml->id() ) );
 
     job.renderer = ml->createMapRenderer( job.context );
 
+    // if the map has only been panned, reuse the part of the layer which is still visible
+    if ( mCache && job.img && preparePannedJob( layerJobs ) )
+    {
+      QgsDebugMsgLevel( "reusing panned cache image for " + ml->id(), 3 );
+    }
+
     if ( hasStyleOverride )
       ml->styleManager()->restoreOverrideStyle();
 
@@ -342,6 +375,171 @@ LayerRenderJobs QgsMapRendererJob::prepareJobs( QPainter *painter, QgsLabelingEn
   return layerJobs;
 }
 
+bool QgsMapRendererJob::preparePannedJob( LayerRenderJobs &jobs )
+{
+  LayerRenderJob &job = jobs.last();
+  if ( !canRenderLayerInParts( job ) || !qgsDoubleNear( mSettings.rotation(), 0.0 ) )
+    return false;
+
+  QgsRectangle pannedExtent;
+  const QImage pannedImage = mCache->pannedCacheImage( job.layer->id(), pannedExtent );
+  if ( pannedImage.isNull() || pannedImage.size() != job.img->size() || pannedImage.format() != job.img->format() )
+    return false;
+
+  const QgsRectangle extent = mSettings.visibleExtent();
+  const double mupp = mSettings.mapUnitsPerPixel();
+  const double dx = ( pannedExtent.xMinimum() - extent.xMinimum() ) / mupp;
+  const double dy = ( extent.yMaximum() - pannedExtent.yMaximum() ) / mupp;
+  const int offsetX = static_cast< int >( std::round( dx ) );
+  const int offsetY = static_cast< int >( std::round( dy ) );
+  const int width = job.img->width();
+  const int height = job.img->height();
+
+  // the image can only be reused without resampling if it is shifted by whole pixels
+  if ( std::fabs( dx - offsetX ) > 0.01 || std::fabs( dy - offsetY ) > 0.01 )
+    return false;
+  if ( ( offsetX == 0 && offsetY == 0 ) || std::abs( offsetX ) >= width || std::abs( offsetY ) >= height )
+    return false;
+
+  // the newly exposed parts of the map are a strip at the left or right side over the
+  // full height, and a strip at the top or bottom over the remaining width. Symbols of features
+  // within the exposed parts may reach into the previous image, which does not contain these
+  // features, so the strips are widened by a band of the previous image which is rendered again.
+  const int stripWidth = offsetX != 0 ? std::abs( offsetX ) + PAN_RENDER_MARGIN : 0;
+  const int stripHeight = offsetY != 0 ? std::abs( offsetY ) + PAN_RENDER_MARGIN : 0;
+  if ( stripWidth >= width || stripHeight >= height )
+    return false;
+
+  QList< QRect > parts;
+  if ( offsetX != 0 )
+    parts << QRect( offsetX > 0 ? 0 : width - stripWidth, 0, stripWidth, height );
+  if ( offsetY != 0 )
+  {
+    const int left = offsetX > 0 ? stripWidth : 0;
+    const int right = offsetX < 0 ? width - stripWidth : width;
+    parts << QRect( left, offsetY > 0 ? 0 : height - stripHeight, right - left, stripHeight );
+  }
+
+  const QgsCoordinateTransform ct = job.context.coordinateTransform();
+  QList< QgsRectangle > layerExtents;
+  for ( const QRect &part : qgsAsConst( parts ) )
+  {
+    QgsRectangle layerExtent( extent.xMinimum() + ( part.left() - PAN_RENDER_MARGIN ) * mupp,
+                              extent.yMaximum() - ( part.top() + part.height() + PAN_RENDER_MARGIN ) * mupp,
+                              extent.xMinimum() + ( part.left() + part.width() + PAN_RENDER_MARGIN ) * mupp,
+                              extent.yMaximum() - ( part.top() - PAN_RENDER_MARGIN ) * mupp );
+    QgsRectangle r2;
+    if ( ct.isValid() )
+    {
+      reprojectToLayerExtent( job.layer.data(), ct, layerExtent, r2 );
+    }
+    if ( !layerExtent.isFinite() || !r2.isFinite() )
+      return false;
+    layerExtents << layerExtent;
+  }
+
+  if ( parts.count() > 1 )
+  {
+    QImage *img = new QImage( parts.at( 1 ).size(), mSettings.outputImageFormat() );
+    if ( img->isNull() )
+    {
+      delete img;
+      return false;
+    }
+
+    // the tile job is placed before the layer's own job, so that it is finished when the
+    // layer job is done in sequential rendering
+    jobs.insert( jobs.count() - 1, LayerRenderJob() );
+    LayerRenderJob &tileJob = jobs[ jobs.count() - 2 ];
+    tileJob.cached = false;
+    tileJob.blendMode = job.blendMode;
+    tileJob.opacity = job.opacity;
+    tileJob.layer = job.layer;
+    tileJob.renderingTime = -1;
+    tileJob.tileParentJob = jobs.count() - 1;
+    tileJob.tileOffset = parts.at( 1 ).topLeft();
+
+    tileJob.context = job.context;
+    tileJob.img = img;
+    QPainter *painter = new QPainter( img );
+    painter->setRenderHint( QPainter::Antialiasing, mSettings.testFlag( QgsMapSettings::Antialiasing ) );
+    painter->translate( -tileJob.tileOffset );
+    tileJob.context.setPainter( painter );
+    tileJob.renderer = tileJob.layer->createMapRenderer( tileJob.context );
+    tileJob.context.setExtent( layerExtents.at( 1 ) );
+  }
+
+  job.pannedImage = pannedImage;
+  job.panOffset = QPoint( offsetX, offsetY );
+  job.panRenderedParts = parts;
+  job.context.painter()->setClipRect( parts.at( 0 ) );
+  job.context.setExtent( layerExtents.at( 0 ) );
+  return true;
+}
+
+bool QgsMapRendererJob::canRenderLayerInParts( const LayerRenderJob &job )
+{
+  QgsVectorLayer *vl = qobject_cast< QgsVectorLayer * >( job.layer.data() );
+  if ( !vl || !vl->renderer() || !dynamic_cast< QgsVectorLayerRenderer * >( job.renderer ) )
+    return false;
+
+  // effects are applied to the whole rendered layer, they would be cut at the edges of the parts
+  if ( vl->renderer()->paintEffect() && vl->renderer()->paintEffect()->enabled() )
+    return false;
+
+  // these renderers place or shade features depending on their neighbors, which may be in other parts
+  const QString rendererType = vl->renderer()->type();
+  return rendererType != QLatin1String( "pointDisplacement" )
+         && rendererType != QLatin1String( "pointCluster" )
+         && rendererType != QLatin1String( "heatmapRenderer" );
+}
+
+void QgsMapRendererJob::initializeJobImage( LayerRenderJob &job )
+{
+  job.img->fill( 0 );
+  if ( !job.pannedImage.isNull() && job.context.painter() )
+  {
+    // the job's painter is already active on the image, and clipped to the exposed parts of the map
+    QPainter *painter = job.context.painter();
+    painter->save();
+    painter->resetTransform();
+    painter->setClipping( false );
+    painter->setCompositionMode( QPainter::CompositionMode_Source );
+    painter->setOpacity( 1.0 );
+    painter->drawImage( job.panOffset, job.pannedImage );
+    // the parts which are rendered again must not contain the features of the previous image twice
+    for ( const QRect &part : qgsAsConst( job.panRenderedParts ) )
+      painter->fillRect( part, Qt::transparent );
+    painter->restore();
+  }
+  job.imageInitialized = true;
+}
+
+void QgsMapRendererJob::composeTileJobs( const LayerRenderJobs &jobs, int parentJob )
+{
+  for ( LayerRenderJobs::const_iterator it = jobs.constBegin(); it != jobs.constEnd(); ++it )
+  {
+    const LayerRenderJob &job = *it;
+    if ( job.tileParentJob < 0 || !job.imageInitialized || !job.img )
+      continue;
+    if ( parentJob >= 0 && job.tileParentJob != parentJob )
+      continue;
+
+    const LayerRenderJob &layerJob = jobs.at( job.tileParentJob );
+    QPainter *painter = layerJob.context.painter();
+    if ( !layerJob.imageInitialized || !painter )
+      continue;
+
+    painter->save();
+    painter->resetTransform();
+    painter->setClipping( false );
+    painter->setCompositionMode( QPainter::CompositionMode_SourceOver );
+    painter->setOpacity( 1.0 );
+    painter->drawImage( job.tileOffset, *job.img );
+    painter->restore();
+  }
+}
+
 LabelRenderJob QgsMapRendererJob::prepareLabelingJob( QPainter *painter, QgsLabelingEngine *labelingEngine2, bool canUseLabelCache )
 {
   LabelRenderJob job;
@@ -394,7 +592,8 @@ void QgsMapRendererJob::cleanupJobs( LayerRenderJobs &jobs )
       delete job.context.painter();
       job.context.setPainter( nullptr );
 
-      if ( mCache && !job.cached && !job.context.renderingStopped() && job.layer )
+      // images of tile jobs are only partial renders of a layer, never cache them
+      if ( mCache && !job.cached && !job.context.renderingStopped() && job.layer && job.tileParentJob < 0 )
       {
         QgsDebugMsg( "caching image for " + ( job.layer ? job.layer->id() : QString() ) );
         mCache->setCacheImage( job.layer->id(), *job.img, QList< QgsMapLayer * >() << job.layer );
@@ -446,6 +645,9 @@ QImage QgsMapRendererJob::composeImage( const QgsMapSettings &settings, const La
   {
     const LayerRenderJob &job = *it;
 
+    if ( job.tileParentJob >= 0 )
+      continue; // tile images are composited into the layer's own image
+
     if ( job.layer && job.layer->customProperty( QStringLiteral( "rendering/renderAboveLabels" ) ).toBool() )
       continue; // skip layer for now, it will be rendered after labels
 
@@ -475,6 +677,9 @@ QImage QgsMapRendererJob::composeImage( const QgsMapSettings &settings, const La
   {
     const LayerRenderJob &job = *it;
 
+    if ( job.tileParentJob >= 0 )
+      continue;
+
     if ( !job.layer || !job.layer->customProperty( QStringLiteral( "rendering/renderAboveLabels" ) ).toBool() )
       continue;
 
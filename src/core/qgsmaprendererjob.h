@@ -54,6 +54,24 @@ struct LayerRenderJob
   bool cached; // if true, img already contains cached image from previous rendering
   QgsWeakMapLayerPointer layer;
   int renderingTime; //!< Time it took to render the layer in ms (it is -1 if not rendered or still rendering)
+
+  /**
+   * For jobs rendering a single strip of a layer which has been split across several renderers:
+   * index of the layer's own job, into whose image this job's image is composited. -1 for regular layer jobs.
+   */
+  int tileParentJob = -1;
+  //! Position of the tile image within the image of the parent job (only used if tileParentJob is set)
+  QPoint tileOffset;
+
+  /**
+   * Image of the layer rendered before the map was panned, which is drawn into img at panOffset
+   * before rendering. Only the parts of the map which have been newly exposed are rendered then.
+   */
+  QImage pannedImage;
+  //! Position of pannedImage within img, in pixels
+  QPoint panOffset;
+  //! Parts of img which are rendered again, the pannedImage is cleared there (only used if pannedImage is set)
+  QList< QRect > panRenderedParts;
 };
 
 typedef QList<LayerRenderJob> LayerRenderJobs;
@@ -263,18 +281,48 @@ class CORE_EXPORT QgsMapRendererJob : public QObject
     //! \note not available in Python bindings
     static void drawLabeling( const QgsMapSettings &settings, QgsRenderContext &renderContext, QgsLabelingEngine *labelingEngine2, QPainter *painter ) SIP_SKIP;
 
-  private:
-
     /** Convenience function to project an extent into the layer source
      * CRS, but also split it into two extents if it crosses
      * the +/- 180 degree line. Modifies the given extent to be in the
      * source CRS coordinates, and if it was split, returns true, and
      * also sets the contents of the r2 parameter
+     * \note not available in Python bindings
+     */
+    static bool reprojectToLayerExtent( const QgsMapLayer *ml, const QgsCoordinateTransform &ct, QgsRectangle &extent, QgsRectangle &r2 ) SIP_SKIP;
+
+    /**
+     * Returns true if the layer of a \a job can be rendered in separate parts of the map
+     * (e.g. strips) by separate renderers, with the same result as rendering it at once.
+     * \note not available in Python bindings
      */
-    static bool reprojectToLayerExtent( const QgsMapLayer *ml, const QgsCoordinateTransform &ct, QgsRectangle &extent, QgsRectangle &r2 );
+    static bool canRenderLayerInParts( const LayerRenderJob &job ) SIP_SKIP;
+
+    /**
+     * Fills the image of a \a job with transparent pixels, or with the image from before
+     * the map was panned, before the job is rendered.
+     * \note not available in Python bindings
+     */
+    static void initializeJobImage( LayerRenderJob &job ) SIP_SKIP;
+
+    /**
+     * Composites the images of finished tile jobs into the images of their layer jobs.
+     * If \a parentJob is not -1, only the tiles of the job with that index are composited.
+     * \note not available in Python bindings
+     */
+    static void composeTileJobs( const LayerRenderJobs &jobs, int parentJob = -1 ) SIP_SKIP;
+
+  private:
 
     bool needTemporaryImage( QgsMapLayer *ml );
 
+    /**
+     * Sets up the last job in \a jobs to reuse the image of its layer from before the map
+     * was panned, so that only the newly exposed parts of the map are rendered. If they
+     * form two strips, a tile job for the second one is inserted before the layer job.
+     * Returns false if the cached image can't be reused.
+     */
+    bool preparePannedJob( LayerRenderJobs &jobs );
+
     const QgsFeatureFilterProvider *mFeatureFilterProvider = nullptr;
 };
 
@@ -22,6 +22,9 @@
 #include "qgsproject.h"
 #include "qgsmaplayer.h"
 #include "qgsmaplayerlistutils.h"
+#include "qgsmaplayerstylemanager.h"
+#include "qgsvectorlayer.h"
+#include "qgsvectorlayerrenderer.h"
 
 #include <QtConcurrentMap>
 #include <QtConcurrentRun>
@@ -60,6 +63,7 @@ void QgsMapRendererParallelJob::start()
   bool canUseLabelCache = prepareLabelCache();
   mLayerJobs = prepareJobs( nullptr, mLabelingEngineV2.get() );
   mLabelJob = prepareLabelingJob( nullptr, mLabelingEngineV2.get(), canUseLabelCache );
+  prepareTileJobs();
 
   QgsDebugMsg( QString( "QThreadPool max thread count is %1" ).arg( QThreadPool::globalInstance()->maxThreadCount() ) );
 
@@ -195,6 +199,8 @@ void QgsMapRendererParallelJob::renderLayersFinished()
 {
   Q_ASSERT( mStatus == RenderingLayers );
 
+  composeTileJobs( mLayerJobs );
+
   // compose final image
   mFinalImage = composeImage( mSettings, mLayerJobs, mLabelJob );
 
@@ -234,6 +240,147 @@ void QgsMapRendererParallelJob::renderingFinished()
   emit finished();
 }
 
+bool QgsMapRendererParallelJob::canSplitLayerJob( const LayerRenderJob &job ) const
+{
+  // jobs reusing a panned image only render parts of the map already
+  if ( job.cached || !job.renderer || !job.img || !job.context.painter() || job.tileParentJob >= 0 || !job.pannedImage.isNull() )
+    return false;
+
+  if ( !canRenderLayerInParts( job ) )
+    return false;
+
+  QgsVectorLayer *vl = qobject_cast< QgsVectorLayer * >( job.layer.data() );
+  return vl->featureCount() >= mSettings.layerRenderTileFeatureThreshold();
+}
+
+void QgsMapRendererParallelJob::prepareTileJobs()
+{
+  const int tileCount = mSettings.layerRenderTileCount();
+  if ( tileCount < 2 || !qgsDoubleNear( mSettings.rotation(), 0.0 ) )
+    return;
+
+  const int width = mSettings.outputSize().width();
+  const int height = mSettings.outputSize().height();
+  const int strips = std::min( tileCount, height );
+  if ( strips < 2 )
+    return;
+
+  const QgsRectangle visibleExtent = mSettings.visibleExtent();
+  const double mupp = mSettings.mapUnitsPerPixel();
+
+  const int layerJobCount = mLayerJobs.count();
+  for ( int i = 0; i < layerJobCount; ++i )
+  {
+    if ( !canSplitLayerJob( mLayerJobs.at( i ) ) )
+      continue;
+
+    QgsVectorLayer *vl = qobject_cast< QgsVectorLayer * >( mLayerJobs.at( i ).layer.data() );
+    const QgsCoordinateTransform ct = mLayerJobs.at( i ).context.coordinateTransform();
+
+    QList< QgsRectangle > stripExtents;
+    QList< QgsRectangle > layerExtents;
+    bool extentsFinite = true;
+    for ( int strip = 0; strip < strips; ++strip )
+    {
+      const int top = strip * height / strips;
+      const int bottom = ( strip + 1 ) * height / strips;
+      const QgsRectangle stripExtent( visibleExtent.xMinimum(),
+                                      strip == strips - 1 ? visibleExtent.yMinimum() : visibleExtent.yMaximum() - bottom * mupp,
+                                      visibleExtent.xMaximum(),
+                                      visibleExtent.yMaximum() - top * mupp );
+      QgsRectangle layerExtent = stripExtent, r2;
+      if ( ct.isValid() )
+      {
+        reprojectToLayerExtent( vl, ct, layerExtent, r2 );
+      }
+      if ( !layerExtent.isFinite() || !r2.isFinite() )
+      {
+        extentsFinite = false;
+        break;
+      }
+      stripExtents << stripExtent;
+      layerExtents << layerExtent;
+    }
+
+    if ( !extentsFinite )
+    {
+      // the whole layer's extent could be transformed, so the layer is still rendered unsplit
+      QgsDebugMsg( QString( "Could not transform the strip extents of layer %1, layer not split" ).arg( vl->id() ) );
+      continue;
+    }
+
+    // allocate all strip images first, so that the layer is either split completely or not at all
+    QList< QImage * > images;
+    for ( int strip = 1; strip < strips; ++strip )
+    {
+      const int top = strip * height / strips;
+      const int bottom = ( strip + 1 ) * height / strips;
+      QImage *img = new QImage( width, bottom - top, mSettings.outputImageFormat() );
+      if ( img->isNull() )
+      {
+        delete img;
+        break;
+      }
+      images << img;
+    }
+    if ( images.count() != strips - 1 )
+    {
+      qDeleteAll( images );
+      QgsDebugMsg( QString( "Insufficient memory to split layer %1 into strips" ).arg( vl->id() ) );
+      continue;
+    }
+
+    bool hasStyleOverride = mSettings.layerStyleOverrides().contains( vl->id() );
+    if ( hasStyleOverride )
+      vl->styleManager()->setOverrideStyle( mSettings.layerStyleOverrides().value( vl->id() ) );
+
+    for ( int strip = 1; strip < strips; ++strip )
+    {
+      const int top = strip * height / strips;
+
+      mLayerJobs.append( LayerRenderJob() );
+      LayerRenderJob &job = mLayerJobs.last();
+      const LayerRenderJob &parentJob = mLayerJobs.at( i );
+      job.cached = false;
+      job.blendMode = parentJob.blendMode;
+      job.opacity = parentJob.opacity;
+      job.layer = parentJob.layer;
+      job.renderingTime = -1;
+      job.tileParentJob = i;
+      job.tileOffset = QPoint( 0, top );
+
+      job.context = parentJob.context;
+      job.img = images.at( strip - 1 );
+      QPainter *painter = new QPainter( job.img );
+      painter->setRenderHint( QPainter::Antialiasing, mSettings.testFlag( QgsMapSettings::Antialiasing ) );
+      painter->translate( 0, -top );
+      job.context.setPainter( painter );
+
+      // the strip renderers do not get label and diagram providers of their own, all strips
+      // register their features with the providers of the layer's own renderer instead
+      job.context.setLabelingEngine( nullptr );
+      job.renderer = vl->createMapRenderer( job.context );
+      job.context.setLabelingEngine( parentJob.context.labelingEngine() );
+
+      job.context.setExtent( layerExtents.at( strip ) );
+      QgsVectorLayerRenderer *renderer = static_cast< QgsVectorLayerRenderer * >( job.renderer );
+      renderer->setLabelProviders( static_cast< QgsVectorLayerRenderer * >( parentJob.renderer ) );
+      renderer->setLabelRegion( stripExtents.at( strip ), visibleExtent );
+    }
+
+    if ( hasStyleOverride )
+      vl->styleManager()->restoreOverrideStyle();
+
+    // the layer's own job renders the first strip directly into the layer image
+    LayerRenderJob &job = mLayerJobs[i];
+    job.context.painter()->setClipRect( QRect( 0, 0, width, height / strips ) );
+    job.context.setExtent( layerExtents.at( 0 ) );
+    static_cast< QgsVectorLayerRenderer * >( job.renderer )->setLabelRegion( stripExtents.at( 0 ), visibleExtent );
+
+    QgsDebugMsgLevel( QString( "layer %1 split into %2 strips" ).arg( vl->id() ).arg( strips ), 2 );
+  }
+}
+
 void QgsMapRendererParallelJob::renderLayerStatic( LayerRenderJob &job )
 {
   if ( job.context.renderingStopped() )
@@ -244,8 +391,7 @@ void QgsMapRendererParallelJob::renderLayerStatic( LayerRenderJob &job )
 
   if ( job.img )
   {
-    job.img->fill( 0 );
-    job.imageInitialized = true;
+    initializeJobImage( job );
   }
 
   QTime t;
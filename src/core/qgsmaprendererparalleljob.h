@@ -26,6 +26,9 @@
  * The resulting map image can be retrieved with renderedImage() function.
  * It is safe to call that function while rendering is active to see preview of the map.
  *
+ * Large vector layers may additionally be split into several horizontal strips which are
+ * rendered in parallel by separate renderers, see QgsMapSettings::setLayerRenderTileCount().
+ *
  * \since QGIS 2.4
  */
 class CORE_EXPORT QgsMapRendererParallelJob : public QgsMapRendererQImageJob
@@ -60,6 +63,16 @@ class CORE_EXPORT QgsMapRendererParallelJob : public QgsMapRendererQImageJob
     //! \note not available in Python bindings
     static void renderLabelsStatic( QgsMapRendererParallelJob *self ) SIP_SKIP;
 
+    /**
+     * Splits jobs of large vector layers into strips rendered by separate renderers,
+     * see QgsMapSettings::layerRenderTileCount(). The extra jobs are appended to mLayerJobs.
+     * \note not available in Python bindings
+     */
+    void prepareTileJobs() SIP_SKIP;
+
+    //! Returns true if the layer job may be split into several strips
+    bool canSplitLayerJob( const LayerRenderJob &job ) const SIP_SKIP;
+
     QImage mFinalImage;
 
     //! \note not available in Python bindings
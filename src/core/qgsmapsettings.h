@@ -188,6 +188,7 @@ class CORE_EXPORT QgsMapSettings
       DrawSymbolBounds         = 0x80,  //!< Draw bounds of symbols (for debugging/testing)
       RenderMapTile            = 0x100, //!< Draw map such that there are no problems between adjacent tiles
       RenderPartialOutput      = 0x200, //!< Whether to make extra effort to update map image with partially rendered layers (better for interactive map canvas). Added in QGIS 3.0
+      ApproximateVectorTransform = 0x400, //!< Allow reprojecting vector layers approximately, with errors below a fraction of a pixel. Added in QGIS 3.0
       // TODO: ignore scale-based visibility (overview)
     };
     Q_DECLARE_FLAGS( Flags, Flag )
@@ -331,6 +332,42 @@ class CORE_EXPORT QgsMapSettings
      */
     const QgsLabelingEngineSettings &labelingEngineSettings() const { return mLabelingEngineSettings; }
 
+    /**
+     * Sets the number of horizontal strips into which a single vector layer is split
+     * when rendered by QgsMapRendererParallelJob. Each strip is rendered by its own
+     * layer renderer in a separate thread and the strips are then composited into the
+     * layer's image. A value of 1 (the default) disables splitting.
+     * \see layerRenderTileCount()
+     * \see setLayerRenderTileFeatureThreshold()
+     * \since QGIS 3.0
+     */
+    void setLayerRenderTileCount( int count ) { mLayerRenderTileCount = count; }
+
+    /**
+     * Returns the number of horizontal strips into which a single vector layer is split
+     * when rendered by QgsMapRendererParallelJob.
+     * \see setLayerRenderTileCount()
+     * \since QGIS 3.0
+     */
+    int layerRenderTileCount() const { return mLayerRenderTileCount; }
+
+    /**
+     * Sets the minimum number of features a vector layer must contain before it is split
+     * into strips by QgsMapRendererParallelJob. Smaller layers are rendered by a single renderer.
+     * \see layerRenderTileFeatureThreshold()
+     * \see setLayerRenderTileCount()
+     * \since QGIS 3.0
+     */
+    void setLayerRenderTileFeatureThreshold( long count ) { mLayerRenderTileFeatureThreshold = count; }
+
+    /**
+     * Returns the minimum number of features a vector layer must contain before it is split
+     * into strips by QgsMapRendererParallelJob.
+     * \see setLayerRenderTileFeatureThreshold()
+     * \since QGIS 3.0
+     */
+    long layerRenderTileFeatureThreshold() const { return mLayerRenderTileFeatureThreshold; }
+
   protected:
 
     double mDpi;
@@ -365,6 +402,9 @@ class CORE_EXPORT QgsMapSettings
 
     QgsLabelingEngineSettings mLabelingEngineSettings;
 
+    int mLayerRenderTileCount = 1;
+    long mLayerRenderTileFeatureThreshold = 100000;
+
     // derived properties
     bool mValid = false; //!< Whether the actual settings are valid (set in updateDerived())
     QgsRectangle mVisibleExtent; //!< Extent with some additional white space that matches the output aspect ratio
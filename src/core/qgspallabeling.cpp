@@ -40,6 +40,7 @@
 
 #include "diagram/qgsdiagram.h"
 #include "qgsdiagramrenderer.h"
+#include "qgsfontmetricscache.h"
 #include "qgsfontutils.h"
 #include "qgslabelsearchtree.h"
 #include "qgsexpression.h"
@@ -1025,7 +1026,7 @@ bool QgsPalLayerSettings::checkMinimumSizeMM( const QgsRenderContext &ct, const
   return QgsPalLabeling::checkMinimumSizeMM( ct, geom, minSize );
 }
 
-void QgsPalLayerSettings::calculateLabelSize( const QFontMetricsF *fm, QString text, double &labelX, double &labelY, QgsFeature *f, QgsRenderContext *context )
+void QgsPalLayerSettings::calculateLabelSize( const QFontMetricsF *fm, QString text, double &labelX, double &labelY, QgsFeature *f, QgsRenderContext *context, const QFont *font )
 {
   if ( !fm || !f )
   {
@@ -1042,6 +1043,12 @@ void QgsPalLayerSettings::calculateLabelSize( const QFontMetricsF *fm, QString t
   }
   QgsRenderContext *rc = context ? context : scopedRc.get();
 
+  // the widths of the same strings are measured over and over, use the cache when the font is known
+  auto textWidth = [fm, font]( const QString & string ) -> double
+  {
+    return font ? QgsFontMetricsCache::width( *font, string ) : fm->width( string );
+  };
+
   QString wrapchr = wrapChar;
   double multilineH = mFormat.lineHeight();
 
@@ -1123,7 +1130,7 @@ void QgsPalLayerSettings::calculateLabelSize( const QFontMetricsF *fm, QString t
   {
     QString dirSym = leftDirSymb;
 
-    if ( fm->width( rightDirSymb ) > fm->width( dirSym ) )
+    if ( textWidth( rightDirSymb ) > textWidth( dirSym ) )
       dirSym = rightDirSymb;
 
     if ( placeDirSymb == QgsPalLayerSettings::SymbolLeftRight )
@@ -1146,7 +1153,7 @@ void QgsPalLayerSettings::calculateLabelSize( const QFontMetricsF *fm, QString t
 
   for ( int i = 0; i < lines; ++i )
   {
-    double width = fm->width( multiLineSplit.at( i ) );
+    double width = textWidth( multiLineSplit.at( i ) );
     if ( width > w )
     {
       w = width;
@@ -1390,9 +1397,9 @@ void QgsPalLayerSettings::registerFeature( QgsFeature &f, QgsRenderContext &cont
   }
 
   // NOTE: this should come AFTER any option that affects font metrics
-  std::unique_ptr<QFontMetricsF> labelFontMetrics( new QFontMetricsF( labelFont ) );
+  QFontMetricsF labelFontMetrics = QgsFontMetricsCache::fontMetrics( labelFont );
   double labelX, labelY; // will receive label size
-  calculateLabelSize( labelFontMetrics.get(), labelText, labelX, labelY, mCurFeat, &context );
+  calculateLabelSize( &labelFontMetrics, labelText, labelX, labelY, mCurFeat, &context, &labelFont );
 
 
   // maximum angle between curved label characters (hardcoded defaults used in QGIS <2.0)
@@ -1745,14 +1752,14 @@ void QgsPalLayerSettings::registerFeature( QgsFeature &f, QgsRenderContext &cont
             }
             else
             {
-              double descentRatio = labelFontMetrics->descent() / labelFontMetrics->height();
+              double descentRatio = labelFontMetrics.descent() / labelFontMetrics.height();
               if ( valiString.compare( QLatin1String( "Base" ), Qt::CaseInsensitive ) == 0 )
               {
                 ydiff -= labelY * descentRatio;
               }
               else //'Cap' or 'Half'
               {
-                double capHeightRatio = ( labelFontMetrics->boundingRect( 'H' ).height() + 1 + labelFontMetrics->descent() ) / labelFontMetrics->height();
+                double capHeightRatio = ( labelFontMetrics.boundingRect( 'H' ).height() + 1 + labelFontMetrics.descent() ) / labelFontMetrics.height();
                 ydiff -= labelY * capHeightRatio;
                 if ( valiString.compare( QLatin1String( "Half" ), Qt::CaseInsensitive ) == 0 )
                 {
@@ -1860,8 +1867,8 @@ void QgsPalLayerSettings::registerFeature( QgsFeature &f, QgsRenderContext &cont
 
   //set label's visual margin so that top visual margin is the leading, and bottom margin is the font's descent
   //this makes labels align to the font's baseline or highest character
-  double topMargin = std::max( 0.25 * labelFontMetrics->ascent(), 0.0 );
-  double bottomMargin = 1.0 + labelFontMetrics->descent();
+  double topMargin = std::max( 0.25 * labelFontMetrics.ascent(), 0.0 );
+  double bottomMargin = 1.0 + labelFontMetrics.descent();
   QgsMargins vm( 0.0, topMargin, 0.0, bottomMargin );
   vm *= xform->mapUnitsPerPixel();
   ( *labelFeature )->setVisualMargin( vm );
@@ -1873,7 +1880,7 @@ void QgsPalLayerSettings::registerFeature( QgsFeature &f, QgsRenderContext &cont
   // TODO: only for placement which needs character info
   // account for any data defined font metrics adjustments
   lf->calculateInfo( placement == QgsPalLayerSettings::Curved || placement == QgsPalLayerSettings::PerimeterCurved,
-                     labelFontMetrics.get(), xform, maxcharanglein, maxcharangleout );
+                     labelFont, &labelFontMetrics, xform, maxcharanglein, maxcharangleout );
   // for labelFeature the LabelInfo is passed to feat when it is registered
 
   // TODO: allow layer-wide feature dist in PAL...?
@@ -720,8 +720,12 @@ class CORE_EXPORT QgsPalLayerSettings
     //! Z-Index of label, where labels with a higher z-index are rendered on top of labels with a lower z-index
     double zIndex;
 
-    // called from register feature hook
-    void calculateLabelSize( const QFontMetricsF *fm, QString text, double &labelX, double &labelY, QgsFeature *f = nullptr, QgsRenderContext *context = nullptr );
+    /**
+     * Calculates the size of the label \a text of the feature \a f in map units, from the font metrics \a fm.
+     * If \a font is set, \a fm must be the metrics of this font and the text widths are taken from the
+     * shared QgsFontMetricsCache. Called from registerFeature().
+     */
+    void calculateLabelSize( const QFontMetricsF *fm, QString text, double &labelX, double &labelY, QgsFeature *f = nullptr, QgsRenderContext *context = nullptr, const QFont *font SIP_PYARGREMOVE = nullptr );
 
     /** Register a feature for labeling.
      * \param f feature to label
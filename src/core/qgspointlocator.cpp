@@ -17,14 +17,24 @@
 
 #include "qgsfeatureiterator.h"
 #include "qgsgeometry.h"
+#include "qgsgeometrycollection.h"
+#include "qgsgeometryutils.h"
+#include "qgslinestring.h"
+#include "qgsmultipolygon.h"
+#include "qgspoint.h"
+#include "qgspolygon.h"
 #include "qgsvectorlayer.h"
-#include "qgswkbptr.h"
+#include "qgsvectorlayerfeatureiterator.h"
 #include "qgis.h"
 #include "qgslogger.h"
 
 #include <SpatialIndex.h>
 
+#include <QAtomicInt>
 #include <QLinkedListIterator>
+#include <QtConcurrentRun>
+
+#include <limits>
 
 using namespace SpatialIndex;
 
@@ -54,6 +64,295 @@ static const double POINT_LOC_EPSILON = 1e-12;
 ////////////////////////////////////////////////////////////////////////////
 
 
+/** \ingroup core
+ * Helper class which keeps the vertices of the indexed geometries in a single, contiguous
+ * coordinate buffer instead of a QgsGeometry copy for each feature. Vertices are numbered
+ * the same way as in QgsGeometry, so the matches refer to the vertices of the layer's geometries.
+ * Geometries which are not made of points and line strings (e.g. curves) are kept as copies.
+ * @note not available in Python bindings
+*/
+class QgsPointLocator_GeometryStore
+{
+  public:
+
+    //! A point, line string or polygon ring stored in the coordinate buffer
+    struct Ring
+    {
+      int firstVertex; //!< Index of the first vertex in the coordinate buffer
+      int vertexCount;
+      bool partStart; //!< Whether the ring starts a new part, i.e. it is not an interior ring
+    };
+
+    //! Stores the geometry of a feature, replacing the previous one
+    void addGeometry( QgsFeatureId fid, const QgsGeometry &geometry, const QgsRectangle &bbox )
+    {
+      removeGeometry( fid );
+
+      Entry entry;
+      entry.firstRing = mRings.size();
+      entry.firstVertex = mCoords.size() / 2;
+      entry.bbox = bbox;
+      if ( !appendRings( geometry.geometry() ) )
+      {
+        // roll back the rings of the unsupported geometry and keep a copy instead
+        mRings.resize( entry.firstRing );
+        mCoords.resize( entry.firstVertex * 2 );
+        mCurvedGeometries.insert( fid, geometry );
+      }
+      else
+      {
+        entry.ringCount = mRings.size() - entry.firstRing;
+        entry.vertexCount = mCoords.size() / 2 - entry.firstVertex;
+      }
+      mEntries.insert( fid, entry );
+    }
+
+    //! Removes the geometry of a feature, returns false if it is not stored
+    bool removeGeometry( QgsFeatureId fid, QgsRectangle *bbox = nullptr )
+    {
+      QHash< QgsFeatureId, Entry >::iterator it = mEntries.find( fid );
+      if ( it == mEntries.end() )
+        return false;
+
+      if ( bbox )
+        *bbox = it->bbox;
+      mUnusedRings += it->ringCount;
+      mUnusedVertices += it->vertexCount;
+      mCurvedGeometries.remove( fid );
+      mEntries.erase( it );
+
+      // the buffers only grow when features are edited, compact them once half of them is unused
+      if ( mUnusedVertices > 1024 && mUnusedVertices > mCoords.size() / 4 )
+        compact();
+      return true;
+    }
+
+    int count() const { return mEntries.count(); }
+
+    //! Returns the geometry copy if the geometry is not stored in the coordinate buffer
+    const QgsGeometry *curvedGeometry( QgsFeatureId fid ) const
+    {
+      QHash< QgsFeatureId, QgsGeometry >::const_iterator it = mCurvedGeometries.constFind( fid );
+      return it != mCurvedGeometries.constEnd() ? &it.value() : nullptr;
+    }
+
+    /**
+     * Finds the closest vertex of the feature's geometry, like QgsGeometry::closestVertex().
+     * Returns false if the geometry has no vertices.
+     */
+    bool closestVertex( QgsFeatureId fid, const QgsPointXY &point, QgsPointXY &vertex, int &vertexIndex, double &sqrDist ) const
+    {
+      if ( const QgsGeometry *geom = curvedGeometry( fid ) )
+      {
+        int beforeVertex, afterVertex;
+        vertex = geom->closestVertex( point, vertexIndex, beforeVertex, afterVertex, sqrDist );
+        return sqrDist >= 0;
+      }
+
+      const Entry entry = mEntries.value( fid );
+      if ( entry.vertexCount == 0 )
+        return false;
+
+      const double *coords = mCoords.constData() + 2 * entry.firstVertex;
+      double minDist = std::numeric_limits<double>::max();
+      int minIndex = 0;
+      for ( int i = 0; i < entry.vertexCount; ++i )
+      {
+        const double dx = coords[2 * i] - point.x();
+        const double dy = coords[2 * i + 1] - point.y();
+        const double dist = dx * dx + dy * dy;
+        // <= on purpose, same as QgsGeometryUtils::closestVertex(): the closing vertex wins
+        if ( dist <= minDist )
+        {
+          minDist = dist;
+          minIndex = i;
+        }
+      }
+      vertexIndex = minIndex;
+      vertex = QgsPointXY( coords[2 * minIndex], coords[2 * minIndex + 1] );
+      sqrDist = minDist;
+      return true;
+    }
+
+    /**
+     * Finds the closest segment of the feature's geometry, like QgsGeometry::closestSegmentWithContext().
+     * Returns a negative value if the geometry has no segments.
+     */
+    double closestSegment( QgsFeatureId fid, const QgsPointXY &point, QgsPointXY &minDistPoint, int &afterVertex, QgsPointXY *edgePoints, double epsilon ) const
+    {
+      if ( const QgsGeometry *geom = curvedGeometry( fid ) )
+      {
+        double sqrDist = geom->closestSegmentWithContext( point, minDistPoint, afterVertex, nullptr, epsilon );
+        if ( sqrDist >= 0 )
+        {
+          edgePoints[0] = geom->vertexAt( afterVertex - 1 );
+          edgePoints[1] = geom->vertexAt( afterVertex );
+        }
+        return sqrDist;
+      }
+
+      const Entry entry = mEntries.value( fid );
+      double minDist = std::numeric_limits<double>::max();
+      int minVertex = -1;
+      double segmentX, segmentY;
+      for ( int r = entry.firstRing; r < entry.firstRing + entry.ringCount; ++r )
+      {
+        const Ring &ring = mRings.at( r );
+        const double *coords = mCoords.constData() + 2 * ring.firstVertex;
+        for ( int i = 1; i < ring.vertexCount; ++i )
+        {
+          const double dist = QgsGeometryUtils::sqrDistToLine( point.x(), point.y(), coords[2 * i - 2], coords[2 * i - 1],
+                              coords[2 * i], coords[2 * i + 1], segmentX, segmentY, epsilon );
+          if ( dist < minDist )
+          {
+            minDist = dist;
+            minDistPoint = QgsPointXY( segmentX, segmentY );
+            minVertex = ring.firstVertex + i;
+          }
+        }
+      }
+      if ( minVertex < 0 )
+        return -1; // no segments
+
+      edgePoints[0] = QgsPointXY( mCoords.at( 2 * minVertex - 2 ), mCoords.at( 2 * minVertex - 1 ) );
+      edgePoints[1] = QgsPointXY( mCoords.at( 2 * minVertex ), mCoords.at( 2 * minVertex + 1 ) );
+      afterVertex = minVertex - entry.firstVertex;
+      return minDist;
+    }
+
+    //! Returns the segments of the feature's geometry which intersect the rectangle
+    QgsPointLocator::MatchList segmentsInRect( QgsFeatureId fid, const QgsRectangle &rect, QgsVectorLayer *vl ) const;
+
+    //! Returns the (2D) geometry of the feature
+    QgsGeometry geometry( QgsFeatureId fid ) const
+    {
+      if ( const QgsGeometry *geom = curvedGeometry( fid ) )
+        return *geom;
+
+      // only used for point in polygon tests, so only polygons are rebuilt
+      const Entry entry = mEntries.value( fid );
+      std::unique_ptr< QgsMultiPolygonV2 > multiPolygon( new QgsMultiPolygonV2() );
+      QgsPolygonV2 *polygon = nullptr;
+      for ( int r = entry.firstRing; r < entry.firstRing + entry.ringCount; ++r )
+      {
+        const Ring &ring = mRings.at( r );
+        QVector< double > x( ring.vertexCount );
+        QVector< double > y( ring.vertexCount );
+        for ( int i = 0; i < ring.vertexCount; ++i )
+        {
+          x[i] = mCoords.at( 2 * ( ring.firstVertex + i ) );
+          y[i] = mCoords.at( 2 * ( ring.firstVertex + i ) + 1 );
+        }
+        if ( ring.partStart )
+        {
+          polygon = new QgsPolygonV2();
+          polygon->setExteriorRing( new QgsLineString( x, y ) );
+          multiPolygon->addGeometry( polygon );
+        }
+        else if ( polygon )
+        {
+          polygon->addInteriorRing( new QgsLineString( x, y ) );
+        }
+      }
+      return QgsGeometry( multiPolygon.release() );
+    }
+
+  private:
+
+    struct Entry
+    {
+      int firstRing = 0;
+      int ringCount = 0;
+      int firstVertex = 0;
+      int vertexCount = 0;
+      QgsRectangle bbox;
+    };
+
+    bool appendRings( const QgsAbstractGeometry *geom, bool partStart = true )
+    {
+      if ( !geom )
+        return true;
+
+      if ( const QgsPoint *point = qgsgeometry_cast< const QgsPoint * >( geom ) )
+      {
+        mRings << Ring { mCoords.size() / 2, 1, partStart };
+        mCoords << point->x() << point->y();
+        return true;
+      }
+      else if ( const QgsLineString *line = qgsgeometry_cast< const QgsLineString * >( geom ) )
+      {
+        const int vertexCount = line->numPoints();
+        mRings << Ring { mCoords.size() / 2, vertexCount, partStart };
+        for ( int i = 0; i < vertexCount; ++i )
+          mCoords << line->xAt( i ) << line->yAt( i );
+        return true;
+      }
+      else if ( const QgsCurvePolygon *polygon = qgsgeometry_cast< const QgsCurvePolygon * >( geom ) )
+      {
+        if ( !polygon->exteriorRing() )
+          return true;
+        const QgsLineString *exterior = qgsgeometry_cast< const QgsLineString * >( polygon->exteriorRing() );
+        if ( !exterior || !appendRings( exterior, true ) )
+          return false;
+        for ( int i = 0; i < polygon->numInteriorRings(); ++i )
+        {
+          const QgsLineString *ring = qgsgeometry_cast< const QgsLineString * >( polygon->interiorRing( i ) );
+          if ( !ring || !appendRings( ring, false ) )
+            return false;
+        }
+        return true;
+      }
+      else if ( const QgsGeometryCollection *collection = qgsgeometry_cast< const QgsGeometryCollection * >( geom ) )
+      {
+        for ( int i = 0; i < collection->numGeometries(); ++i )
+        {
+          if ( !appendRings( collection->geometryN( i ), true ) )
+            return false;
+        }
+        return true;
+      }
+      return false; // curves
+    }
+
+    //! Removes the unused parts of the buffers
+    void compact()
+    {
+      QVector< double > coords;
+      QVector< Ring > rings;
+      coords.reserve( mCoords.size() - 2 * mUnusedVertices );
+      rings.reserve( mRings.size() - mUnusedRings );
+      for ( QHash< QgsFeatureId, Entry >::iterator it = mEntries.begin(); it != mEntries.end(); ++it )
+      {
+        Entry &entry = it.value();
+        const int vertexOffset = coords.size() / 2 - entry.firstVertex;
+        for ( int r = entry.firstRing; r < entry.firstRing + entry.ringCount; ++r )
+        {
+          Ring ring = mRings.at( r );
+          ring.firstVertex += vertexOffset;
+          rings << ring;
+        }
+        entry.firstRing = rings.size() - entry.ringCount;
+        coords.append( mCoords.mid( 2 * entry.firstVertex, 2 * entry.vertexCount ) );
+        entry.firstVertex += vertexOffset;
+      }
+      mCoords = coords;
+      mRings = rings;
+      mUnusedVertices = 0;
+      mUnusedRings = 0;
+    }
+
+    QHash< QgsFeatureId, Entry > mEntries;
+    //! x and y of all vertices
+    QVector< double > mCoords;
+    QVector< Ring > mRings;
+    QHash< QgsFeatureId, QgsGeometry > mCurvedGeometries;
+    int mUnusedVertices = 0;
+    int mUnusedRings = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////
+
+
 /** \ingroup core
  * Helper class for bulk loading of R-trees.
  * @note not available in Python bindings
@@ -81,6 +380,138 @@ class QgsPointLocator_Stream : public IDataStream
 ////////////////////////////////////////////////////////////////////////////
 
 
+/** \ingroup core
+ * Helper class which reads the features of a layer and builds the index of a point locator.
+ * It works on a copy of the layer's data, so it may be run in a worker thread.
+ * @note not available in Python bindings
+*/
+class QgsPointLocator_IndexBuilder
+{
+  public:
+    QgsPointLocator_IndexBuilder( QgsVectorLayer *layer, const QgsCoordinateTransform &transform, const QgsRectangle *extent, int maxFeaturesToIndex )
+      : mSource( new QgsVectorLayerFeatureSource( layer ) )
+      , mTransform( transform )
+      , mMaxFeaturesToIndex( maxFeaturesToIndex )
+      , geometries( new QgsPointLocator_GeometryStore() )
+    {
+      mRequest.setSubsetOfAttributes( QgsAttributeList() );
+      if ( extent )
+      {
+        QgsRectangle rect = *extent;
+        if ( mTransform.isValid() )
+        {
+          try
+          {
+            rect = mTransform.transformBoundingBox( rect, QgsCoordinateTransform::ReverseTransform );
+          }
+          catch ( const QgsException &e )
+          {
+            Q_UNUSED( e );
+            // See https://issues.qgis.org/issues/12634
+            QgsDebugMsg( QString( "could not transform bounding box to map, skipping the snap filter (%1)" ).arg( e.what() ) );
+          }
+        }
+        mRequest.setFilterRect( rect );
+      }
+    }
+
+    ~QgsPointLocator_IndexBuilder()
+    {
+      delete rTree;
+      delete storage;
+    }
+
+    //! Builds the index. Sets ok to false if the limit of features has been exceeded.
+    void run()
+    {
+      QLinkedList<RTree::Data *> dataList;
+      QgsFeature f;
+      QgsFeatureIterator fi = mSource->getFeatures( mRequest );
+      int indexedCount = 0;
+      while ( fi.nextFeature( f ) )
+      {
+        if ( mCanceled.load() )
+        {
+          qDeleteAll( dataList );
+          ok = false;
+          return;
+        }
+
+        if ( !f.hasGeometry() )
+          continue;
+
+        QgsGeometry geom = f.geometry();
+        if ( mTransform.isValid() )
+        {
+          try
+          {
+            geom.transform( mTransform );
+          }
+          catch ( const QgsException &e )
+          {
+            Q_UNUSED( e );
+            // See https://issues.qgis.org/issues/12634
+            QgsDebugMsg( QString( "could not transform geometry to map, skipping the snap for it (%1)" ).arg( e.what() ) );
+            continue;
+          }
+        }
+
+        const QgsRectangle bbox = geom.boundingBox();
+        dataList << new RTree::Data( 0, nullptr, rect2region( bbox ), f.id() );
+        geometries->addGeometry( f.id(), geom, bbox );
+        ++indexedCount;
+
+        if ( mMaxFeaturesToIndex != -1 && indexedCount > mMaxFeaturesToIndex )
+        {
+          qDeleteAll( dataList );
+          ok = false;
+          return;
+        }
+      }
+
+      if ( dataList.isEmpty() )
+      {
+        isEmptyLayer = true;
+        return; // no features
+      }
+
+      // R-Tree parameters
+      double fillFactor = 0.7;
+      unsigned long indexCapacity = 10;
+      unsigned long leafCapacity = 10;
+      unsigned long dimension = 2;
+      RTree::RTreeVariant variant = RTree::RV_RSTAR;
+      SpatialIndex::id_type indexId;
+
+      QgsPointLocator_Stream stream( dataList );
+      storage = StorageManager::createNewMemoryStorageManager();
+      rTree = RTree::createAndBulkLoadNewRTree( RTree::BLM_STR, stream, *storage, fillFactor, indexCapacity,
+              leafCapacity, dimension, variant, indexId );
+    }
+
+    //! Stops building of the index, may be called from any thread
+    void cancel() { mCanceled.store( 1 ); }
+
+  private:
+    std::unique_ptr< QgsVectorLayerFeatureSource > mSource;
+    QgsFeatureRequest mRequest;
+    QgsCoordinateTransform mTransform;
+    int mMaxFeaturesToIndex = -1;
+    QAtomicInt mCanceled;
+
+  public:
+    // results, taken over by the locator
+    bool ok = true;
+    bool isEmptyLayer = false;
+    std::unique_ptr< QgsPointLocator_GeometryStore > geometries;
+    SpatialIndex::IStorageManager *storage = nullptr;
+    SpatialIndex::ISpatialIndex *rTree = nullptr;
+};
+
+
+////////////////////////////////////////////////////////////////////////////
+
+
 /** \ingroup core
  * Helper class used when traversing the index looking for vertices - builds a list of matches.
  * @note not available in Python bindings
@@ -101,12 +532,11 @@ class QgsPointLocator_VisitorNearestVertex : public IVisitor
     void visitData( const IData &d ) override
     {
       QgsFeatureId id = d.getIdentifier();
-      QgsGeometry *geom = mLocator->mGeoms.value( id );
-      int vertexIndex, beforeVertex, afterVertex;
+      QgsPointXY pt;
+      int vertexIndex;
       double sqrDist;
 
-      QgsPointXY pt = geom->closestVertex( mSrcPoint, vertexIndex, beforeVertex, afterVertex, sqrDist );
-      if ( sqrDist < 0 )
+      if ( !mLocator->mGeoms->closestVertex( id, mSrcPoint, pt, vertexIndex, sqrDist ) )
         return;  // probably empty geometry
 
       QgsPointLocator::Match m( QgsPointLocator::Vertex, mLocator->mLayer, id, std::sqrt( sqrDist ), pt, vertexIndex );
@@ -149,16 +579,13 @@ class QgsPointLocator_VisitorNearestEdge : public IVisitor
     void visitData( const IData &d ) override
     {
       QgsFeatureId id = d.getIdentifier();
-      QgsGeometry *geom = mLocator->mGeoms.value( id );
       QgsPointXY pt;
       int afterVertex;
-      double sqrDist = geom->closestSegmentWithContext( mSrcPoint, pt, afterVertex, nullptr, POINT_LOC_EPSILON );
+      QgsPointXY edgePoints[2];
+      double sqrDist = mLocator->mGeoms->closestSegment( id, mSrcPoint, pt, afterVertex, edgePoints, POINT_LOC_EPSILON );
       if ( sqrDist < 0 )
         return;
 
-      QgsPointXY edgePoints[2];
-      edgePoints[0] = geom->vertexAt( afterVertex - 1 );
-      edgePoints[1] = geom->vertexAt( afterVertex );
       QgsPointLocator::Match m( QgsPointLocator::Edge, mLocator->mLayer, id, std::sqrt( sqrDist ), pt, afterVertex - 1, edgePoints );
       // in range queries the filter may reject some matches
       if ( mFilter && !mFilter->acceptMatch( m ) )
@@ -199,8 +626,7 @@ class QgsPointLocator_VisitorArea : public IVisitor
     void visitData( const IData &d ) override
     {
       QgsFeatureId id = d.getIdentifier();
-      QgsGeometry *g = mLocator->mGeoms.value( id );
-      if ( g->intersects( mGeomPt ) )
+      if ( mLocator->mGeoms->geometry( id ).intersects( mGeomPt ) )
         mList << QgsPointLocator::Match( QgsPointLocator::Area, mLocator->mLayer, id, 0, QgsPointXY() );
     }
   private:
@@ -321,202 +747,34 @@ struct _CohenSutherland
 };
 
 
-static QgsPointLocator::MatchList _geometrySegmentsInRect( QgsGeometry *geom, const QgsRectangle &rect, QgsVectorLayer *vl, QgsFeatureId fid )
+QgsPointLocator::MatchList QgsPointLocator_GeometryStore::segmentsInRect( QgsFeatureId fid, const QgsRectangle &rect, QgsVectorLayer *vl ) const
 {
-  // this code is stupidly based on QgsGeometry::closestSegmentWithContext
-  // we need iterator for segments...
-
+  // only linear geometries are supported
   QgsPointLocator::MatchList lst;
-  QByteArray wkb( geom->exportToWkb() );
-  if ( wkb.isEmpty() )
+  if ( curvedGeometry( fid ) )
     return lst;
 
   _CohenSutherland cs( rect );
-
-  QgsConstWkbPtr wkbPtr( wkb );
-  wkbPtr.readHeader();
-
-  QgsWkbTypes::Type wkbType = geom->wkbType();
-
-  bool hasZValue = false;
-  switch ( wkbType )
+  const Entry entry = mEntries.value( fid );
+  for ( int r = entry.firstRing; r < entry.firstRing + entry.ringCount; ++r )
   {
-    case QgsWkbTypes::Point25D:
-    case QgsWkbTypes::Point:
-    case QgsWkbTypes::MultiPoint25D:
-    case QgsWkbTypes::MultiPoint:
+    const Ring &ring = mRings.at( r );
+    const double *coords = mCoords.constData() + 2 * ring.firstVertex;
+    for ( int i = 1; i < ring.vertexCount; ++i )
     {
-      // Points have no lines
-      return lst;
-    }
-
-    case QgsWkbTypes::LineString25D:
-      hasZValue = true;
-      //intentional fall-through
-      FALLTHROUGH;
-    case QgsWkbTypes::LineString:
-    {
-      int nPoints;
-      wkbPtr >> nPoints;
-
-      double prevx = 0.0, prevy = 0.0;
-      for ( int index = 0; index < nPoints; ++index )
+      const double prevX = coords[2 * i - 2];
+      const double prevY = coords[2 * i - 1];
+      const double thisX = coords[2 * i];
+      const double thisY = coords[2 * i + 1];
+      if ( cs.isSegmentInRect( prevX, prevY, thisX, thisY ) )
       {
-        double thisx = 0.0, thisy = 0.0;
-        wkbPtr >> thisx >> thisy;
-        if ( hasZValue )
-          wkbPtr += sizeof( double );
-
-        if ( index > 0 )
-        {
-          if ( cs.isSegmentInRect( prevx, prevy, thisx, thisy ) )
-          {
-            QgsPointXY edgePoints[2];
-            edgePoints[0].set( prevx, prevy );
-            edgePoints[1].set( thisx, thisy );
-            lst << QgsPointLocator::Match( QgsPointLocator::Edge, vl, fid, 0, QgsPointXY(), index - 1, edgePoints );
-          }
-        }
-
-        prevx = thisx;
-        prevy = thisy;
+        QgsPointXY edgePoints[2];
+        edgePoints[0].set( prevX, prevY );
+        edgePoints[1].set( thisX, thisY );
+        lst << QgsPointLocator::Match( QgsPointLocator::Edge, vl, fid, 0, QgsPointXY(), ring.firstVertex - entry.firstVertex + i - 1, edgePoints );
       }
-      break;
     }
-
-    case QgsWkbTypes::MultiLineString25D:
-      hasZValue = true;
-      //intentional fall-through
-      FALLTHROUGH;
-    case QgsWkbTypes::MultiLineString:
-    {
-      int nLines;
-      wkbPtr >> nLines;
-      for ( int linenr = 0, pointIndex = 0; linenr < nLines; ++linenr )
-      {
-        wkbPtr.readHeader();
-        int nPoints;
-        wkbPtr >> nPoints;
-
-        double prevx = 0.0, prevy = 0.0;
-        for ( int pointnr = 0; pointnr < nPoints; ++pointnr )
-        {
-          double thisx = 0.0, thisy = 0.0;
-          wkbPtr >> thisx >> thisy;
-          if ( hasZValue )
-            wkbPtr += sizeof( double );
-
-          if ( pointnr > 0 )
-          {
-            if ( cs.isSegmentInRect( prevx, prevy, thisx, thisy ) )
-            {
-              QgsPointXY edgePoints[2];
-              edgePoints[0].set( prevx, prevy );
-              edgePoints[1].set( thisx, thisy );
-              lst << QgsPointLocator::Match( QgsPointLocator::Edge, vl, fid, 0, QgsPointXY(), pointIndex - 1, edgePoints );
-            }
-          }
-
-          prevx = thisx;
-          prevy = thisy;
-          ++pointIndex;
-        }
-      }
-      break;
-    }
-
-    case QgsWkbTypes::Polygon25D:
-      hasZValue = true;
-      //intentional fall-through
-      FALLTHROUGH;
-    case QgsWkbTypes::Polygon:
-    {
-      int nRings;
-      wkbPtr >> nRings;
-
-      for ( int ringnr = 0, pointIndex = 0; ringnr < nRings; ++ringnr )//loop over rings
-      {
-        int nPoints;
-        wkbPtr >> nPoints;
-
-        double prevx = 0.0, prevy = 0.0;
-        for ( int pointnr = 0; pointnr < nPoints; ++pointnr )//loop over points in a ring
-        {
-          double thisx = 0.0, thisy = 0.0;
-          wkbPtr >> thisx >> thisy;
-          if ( hasZValue )
-            wkbPtr += sizeof( double );
-
-          if ( pointnr > 0 )
-          {
-            if ( cs.isSegmentInRect( prevx, prevy, thisx, thisy ) )
-            {
-              QgsPointXY edgePoints[2];
-              edgePoints[0].set( prevx, prevy );
-              edgePoints[1].set( thisx, thisy );
-              lst << QgsPointLocator::Match( QgsPointLocator::Edge, vl, fid, 0, QgsPointXY(), pointIndex - 1, edgePoints );
-            }
-          }
-
-          prevx = thisx;
-          prevy = thisy;
-          ++pointIndex;
-        }
-      }
-      break;
-    }
-
-    case QgsWkbTypes::MultiPolygon25D:
-      hasZValue = true;
-      //intentional fall-through
-      FALLTHROUGH;
-    case QgsWkbTypes::MultiPolygon:
-    {
-      int nPolygons;
-      wkbPtr >> nPolygons;
-      for ( int polynr = 0, pointIndex = 0; polynr < nPolygons; ++polynr )
-      {
-        wkbPtr.readHeader();
-        int nRings;
-        wkbPtr >> nRings;
-        for ( int ringnr = 0; ringnr < nRings; ++ringnr )
-        {
-          int nPoints;
-          wkbPtr >> nPoints;
-
-          double prevx = 0.0, prevy = 0.0;
-          for ( int pointnr = 0; pointnr < nPoints; ++pointnr )
-          {
-            double thisx = 0.0, thisy = 0.0;
-            wkbPtr >> thisx >> thisy;
-            if ( hasZValue )
-              wkbPtr += sizeof( double );
-
-            if ( pointnr > 0 )
-            {
-              if ( cs.isSegmentInRect( prevx, prevy, thisx, thisy ) )
-              {
-                QgsPointXY edgePoints[2];
-                edgePoints[0].set( prevx, prevy );
-                edgePoints[1].set( thisx, thisy );
-                lst << QgsPointLocator::Match( QgsPointLocator::Edge, vl, fid, 0, QgsPointXY(), pointIndex - 1, edgePoints );
-              }
-            }
-
-            prevx = thisx;
-            prevy = thisy;
-            ++pointIndex;
-          }
-        }
-      }
-      break;
-    }
-
-    case QgsWkbTypes::Unknown:
-    default:
-      return lst;
-  } // switch (wkbType)
-
+  }
   return lst;
 }
 
@@ -540,9 +798,8 @@ class QgsPointLocator_VisitorEdgesInRect : public IVisitor
     void visitData( const IData &d ) override
     {
       QgsFeatureId id = d.getIdentifier();
-      QgsGeometry *geom = mLocator->mGeoms.value( id );
 
-      Q_FOREACH ( const QgsPointLocator::Match &m, _geometrySegmentsInRect( geom, mSrcRect, mLocator->mLayer, id ) )
+      Q_FOREACH ( const QgsPointLocator::Match &m, mLocator->mGeoms->segmentsInRect( id, mSrcRect, mLocator->mLayer ) )
       {
         // in range queries the filter may reject some matches
         if ( mFilter && !mFilter->acceptMatch( m ) )
@@ -615,7 +872,8 @@ class QgsPointLocator_DumpTree : public SpatialIndex::IQueryStrategy
 
 
 QgsPointLocator::QgsPointLocator( QgsVectorLayer *layer, const QgsCoordinateReferenceSystem &destCRS, const QgsRectangle *extent )
-  : mIsEmptyLayer( false )
+  : mGeoms( new QgsPointLocator_GeometryStore() )
+  , mIsEmptyLayer( false )
   , mLayer( layer )
 {
   if ( destCRS.isValid() )
@@ -625,19 +883,17 @@ QgsPointLocator::QgsPointLocator( QgsVectorLayer *layer, const QgsCoordinateRefe
 
   setExtent( extent );
 
-  mStorage = StorageManager::createNewMemoryStorageManager();
-
   connect( mLayer, &QgsVectorLayer::featureAdded, this, &QgsPointLocator::onFeatureAdded );
   connect( mLayer, &QgsVectorLayer::featureDeleted, this, &QgsPointLocator::onFeatureDeleted );
   connect( mLayer, &QgsVectorLayer::geometryChanged, this, &QgsPointLocator::onGeometryChanged );
   connect( mLayer, &QgsVectorLayer::dataChanged, this, &QgsPointLocator::destroyIndex );
+  connect( &mIndexingWatcher, &QFutureWatcher<void>::finished, this, &QgsPointLocator::onIndexingFinished );
 }
 
 
 QgsPointLocator::~QgsPointLocator()
 {
   destroyIndex();
-  delete mStorage;
   delete mExtent;
 }
 
@@ -657,9 +913,30 @@ void QgsPointLocator::setExtent( const QgsRectangle *extent )
 }
 
 
-bool QgsPointLocator::init( int maxFeaturesToIndex )
+bool QgsPointLocator::init( int maxFeaturesToIndex, bool relaxed )
 {
-  return hasIndex() ? true : rebuildIndex( maxFeaturesToIndex );
+  if ( mIsIndexing )
+  {
+    if ( relaxed )
+      return true;
+    waitForIndexingFinished();
+  }
+
+  if ( hasIndex() )
+    return true;
+
+  if ( !relaxed )
+    return rebuildIndex( maxFeaturesToIndex );
+
+  destroyIndex();
+  if ( mLayer->geometryType() == QgsWkbTypes::NullGeometry )
+    return true; // nothing to index
+
+  // read the features in a worker thread, the layer's changes are applied once the index is built
+  mIsIndexing = true;
+  mIndexBuilder.reset( new QgsPointLocator_IndexBuilder( mLayer, mTransform, mExtent, maxFeaturesToIndex ) );
+  mIndexingWatcher.setFuture( QtConcurrent::run( mIndexBuilder.get(), &QgsPointLocator_IndexBuilder::run ) );
+  return true;
 }
 
 
@@ -669,111 +946,132 @@ bool QgsPointLocator::hasIndex() const
 }
 
 
+void QgsPointLocator::waitForIndexingFinished()
+{
+  if ( !mIsIndexing )
+    return;
+
+  mIndexingWatcher.waitForFinished();
+  onIndexingFinished();
+}
+
+
 bool QgsPointLocator::rebuildIndex( int maxFeaturesToIndex )
 {
   destroyIndex();
 
-  QLinkedList<RTree::Data *> dataList;
-  QgsFeature f;
   QgsWkbTypes::GeometryType geomType = mLayer->geometryType();
   if ( geomType == QgsWkbTypes::NullGeometry )
     return true; // nothing to index
 
-  QgsFeatureRequest request;
-  request.setSubsetOfAttributes( QgsAttributeList() );
-  if ( mExtent )
-  {
-    QgsRectangle rect = *mExtent;
-    if ( mTransform.isValid() )
-    {
-      try
-      {
-        rect = mTransform.transformBoundingBox( rect, QgsCoordinateTransform::ReverseTransform );
-      }
-      catch ( const QgsException &e )
-      {
-        Q_UNUSED( e );
-        // See https://issues.qgis.org/issues/12634
-        QgsDebugMsg( QString( "could not transform bounding box to map, skipping the snap filter (%1)" ).arg( e.what() ) );
-      }
-    }
-    request.setFilterRect( rect );
-  }
-  QgsFeatureIterator fi = mLayer->getFeatures( request );
-  int indexedCount = 0;
-  while ( fi.nextFeature( f ) )
-  {
-    if ( !f.hasGeometry() )
-      continue;
+  QgsPointLocator_IndexBuilder builder( mLayer, mTransform, mExtent, maxFeaturesToIndex );
+  builder.run();
+  return takeIndex( builder );
+}
 
-    if ( mTransform.isValid() )
-    {
-      try
-      {
-        QgsGeometry transformedGeometry = f.geometry();
-        transformedGeometry.transform( mTransform );
-        f.setGeometry( transformedGeometry );
-      }
-      catch ( const QgsException &e )
-      {
-        Q_UNUSED( e );
-        // See https://issues.qgis.org/issues/12634
-        QgsDebugMsg( QString( "could not transform geometry to map, skipping the snap for it (%1)" ).arg( e.what() ) );
-        continue;
-      }
-    }
 
-    SpatialIndex::Region r( rect2region( f.geometry().boundingBox() ) );
-    dataList << new RTree::Data( 0, nullptr, r, f.id() );
+bool QgsPointLocator::takeIndex( QgsPointLocator_IndexBuilder &builder )
+{
+  if ( !builder.ok )
+    return false;
+
+  mStorage = builder.storage;
+  mRTree = builder.rTree;
+  builder.storage = nullptr;
+  builder.rTree = nullptr;
+  mGeoms = std::move( builder.geometries );
+  mIsEmptyLayer = builder.isEmptyLayer;
+  return true;
+}
 
-    if ( mGeoms.contains( f.id() ) )
-      delete mGeoms.take( f.id() );
-    mGeoms[f.id()] = new QgsGeometry( f.geometry() );
-    ++indexedCount;
 
-    if ( maxFeaturesToIndex != -1 && indexedCount > maxFeaturesToIndex )
-    {
-      qDeleteAll( dataList );
-      destroyIndex();
-      return false;
-    }
-  }
+void QgsPointLocator::onIndexingFinished()
+{
+  // nothing to do if already handled by waitForIndexingFinished()
+  if ( !mIsIndexing || !mIndexingWatcher.future().isFinished() )
+    return;
 
-  // R-Tree parameters
-  double fillFactor = 0.7;
-  unsigned long indexCapacity = 10;
-  unsigned long leafCapacity = 10;
-  unsigned long dimension = 2;
-  RTree::RTreeVariant variant = RTree::RV_RSTAR;
-  SpatialIndex::id_type indexId;
+  mIsIndexing = false;
+  std::unique_ptr< QgsPointLocator_IndexBuilder > builder( std::move( mIndexBuilder ) );
+  const QSet< QgsFeatureId > updates = mPendingUpdates;
+  mPendingUpdates.clear();
 
-  if ( dataList.isEmpty() )
+  const bool ok = takeIndex( *builder );
+  if ( ok )
   {
-    mIsEmptyLayer = true;
-    return true; // no features
+    // bring the index up to date with the changes made while it was built
+    for ( QgsFeatureId fid : updates )
+    {
+      onFeatureDeleted( fid );
+      onFeatureAdded( fid );
+    }
   }
-
-  QgsPointLocator_Stream stream( dataList );
-  mRTree = RTree::createAndBulkLoadNewRTree( RTree::BLM_STR, stream, *mStorage, fillFactor, indexCapacity,
-           leafCapacity, dimension, variant, indexId );
-  return true;
+  emit initFinished( ok );
 }
 
 
 void QgsPointLocator::destroyIndex()
 {
+  if ( mIsIndexing )
+  {
+    // the index being built is outdated already
+    mIndexBuilder->cancel();
+    mIndexingWatcher.waitForFinished();
+    mIndexBuilder.reset();
+    mPendingUpdates.clear();
+    mIsIndexing = false;
+  }
+
   delete mRTree;
   mRTree = nullptr;
 
+  delete mStorage;
+  mStorage = nullptr;
+
   mIsEmptyLayer = false;
 
-  qDeleteAll( mGeoms );
+  mGeoms.reset( new QgsPointLocator_GeometryStore() );
+}
 
-  mGeoms.clear();
+int QgsPointLocator::cachedGeometryCount() const
+{
+  return mGeoms->count();
+}
+
+void QgsPointLocator::addFeatureToIndex( const QgsFeature &feature )
+{
+  QgsGeometry geom = feature.geometry();
+  if ( mTransform.isValid() )
+  {
+    try
+    {
+      geom.transform( mTransform );
+    }
+    catch ( const QgsException &e )
+    {
+      Q_UNUSED( e );
+      // See https://issues.qgis.org/issues/12634
+      QgsDebugMsg( QString( "could not transform geometry to map, skipping the snap for it (%1)" ).arg( e.what() ) );
+      return;
+    }
+  }
+
+  QgsRectangle bbox = geom.boundingBox();
+  if ( !bbox.isNull() )
+  {
+    mRTree->insertData( 0, nullptr, rect2region( bbox ), feature.id() );
+    mGeoms->addGeometry( feature.id(), geom, bbox );
+  }
 }
 
 void QgsPointLocator::onFeatureAdded( QgsFeatureId fid )
 {
+  if ( mIsIndexing )
+  {
+    mPendingUpdates << fid;
+    return;
+  }
+
   if ( !mRTree )
   {
     if ( mIsEmptyLayer )
@@ -782,51 +1080,30 @@ void QgsPointLocator::onFeatureAdded( QgsFeatureId fid )
   }
 
   QgsFeature f;
-  if ( mLayer->getFeatures( QgsFeatureRequest( fid ) ).nextFeature( f ) )
+  if ( mLayer->getFeatures( QgsFeatureRequest( fid ).setSubsetOfAttributes( QgsAttributeList() ) ).nextFeature( f ) )
   {
     if ( !f.hasGeometry() )
       return;
 
-    if ( mTransform.isValid() )
-    {
-      try
-      {
-        QgsGeometry transformedGeom = f.geometry();
-        transformedGeom.transform( mTransform );
-        f.setGeometry( transformedGeom );
-      }
-      catch ( const QgsException &e )
-      {
-        Q_UNUSED( e );
-        // See https://issues.qgis.org/issues/12634
-        QgsDebugMsg( QString( "could not transform geometry to map, skipping the snap for it (%1)" ).arg( e.what() ) );
-        return;
-      }
-    }
-
-    QgsRectangle bbox = f.geometry().boundingBox();
-    if ( !bbox.isNull() )
-    {
-      SpatialIndex::Region r( rect2region( bbox ) );
-      mRTree->insertData( 0, nullptr, r, f.id() );
-
-      if ( mGeoms.contains( f.id() ) )
-        delete mGeoms.take( f.id() );
-      mGeoms[fid] = new QgsGeometry( f.geometry() );
-    }
+    onFeatureDeleted( fid );
+    addFeatureToIndex( f );
   }
 }
 
 void QgsPointLocator::onFeatureDeleted( QgsFeatureId fid )
 {
+  if ( mIsIndexing )
+  {
+    mPendingUpdates << fid;
+    return;
+  }
+
   if ( !mRTree )
     return; // nothing to do if we are not initialized yet
 
-  if ( mGeoms.contains( fid ) )
-  {
-    mRTree->deleteData( rect2region( mGeoms[fid]->boundingBox() ), fid );
-    delete mGeoms.take( fid );
-  }
+  QgsRectangle bbox;
+  if ( mGeoms->removeGeometry( fid, &bbox ) )
+    mRTree->deleteData( rect2region( bbox ), fid );
 }
 
 void QgsPointLocator::onGeometryChanged( QgsFeatureId fid, const QgsGeometry &geom )
@@ -836,9 +1113,11 @@ void QgsPointLocator::onGeometryChanged( QgsFeatureId fid, const QgsGeometry &ge
   onFeatureAdded( fid );
 }
 
-
 QgsPointLocator::Match QgsPointLocator::nearestVertex( const QgsPointXY &point, double tolerance, MatchFilter *filter )
 {
+  if ( mIsIndexing )
+    return Match(); // index not ready yet
+
   if ( !mRTree )
   {
     init();
@@ -857,6 +1136,9 @@ QgsPointLocator::Match QgsPointLocator::nearestVertex( const QgsPointXY &point,
 
 QgsPointLocator::Match QgsPointLocator::nearestEdge( const QgsPointXY &point, double tolerance, MatchFilter *filter )
 {
+  if ( mIsIndexing )
+    return Match(); // index not ready yet
+
   if ( !mRTree )
   {
     init();
@@ -879,6 +1161,9 @@ QgsPointLocator::Match QgsPointLocator::nearestEdge( const QgsPointXY &point, do
 
 QgsPointLocator::MatchList QgsPointLocator::edgesInRect( const QgsRectangle &rect, QgsPointLocator::MatchFilter *filter )
 {
+  if ( mIsIndexing )
+    return MatchList(); // index not ready yet
+
   if ( !mRTree )
   {
     init();
@@ -906,6 +1191,9 @@ QgsPointLocator::MatchList QgsPointLocator::edgesInRect( const QgsPointXY &point
 
 QgsPointLocator::MatchList QgsPointLocator::pointInPolygon( const QgsPointXY &point )
 {
+  if ( mIsIndexing )
+    return MatchList(); // index not ready yet
+
   if ( !mRTree )
   {
     init();
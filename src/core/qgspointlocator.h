@@ -25,10 +25,16 @@ class QgsVectorLayer;
 #include "qgscoordinatereferencesystem.h"
 #include "qgscoordinatetransform.h"
 
+#include <QFutureWatcher>
+#include <QSet>
+#include <memory>
+
 class QgsPointLocator_VisitorNearestVertex;
 class QgsPointLocator_VisitorNearestEdge;
 class QgsPointLocator_VisitorArea;
 class QgsPointLocator_VisitorEdgesInRect;
+class QgsPointLocator_GeometryStore;
+class QgsPointLocator_IndexBuilder;
 
 namespace SpatialIndex SIP_SKIP
 {
@@ -91,12 +97,31 @@ class CORE_EXPORT QgsPointLocator : public QObject
     /** Prepare the index for queries. Does nothing if the index already exists.
      * If the number of features is greater than the value of maxFeaturesToIndex, creation of index is stopped
      * to make sure we do not run out of memory. If maxFeaturesToIndex is -1, no limits are used. Returns
-     * false if the creation of index has been prematurely stopped due to the limit of features, otherwise true */
-    bool init( int maxFeaturesToIndex = -1 );
+     * false if the creation of index has been prematurely stopped due to the limit of features, otherwise true.
+     *
+     * If \a relaxed is true, the index is built in a background thread and the method returns true immediately.
+     * Until initFinished() is emitted, isIndexing() returns true and the queries do not return any matches.
+     * Changes of the layer made in the meantime are applied to the index once it is built.
+     */
+    bool init( int maxFeaturesToIndex = -1, bool relaxed = false );
 
     //! Indicate whether the data have been already indexed
     bool hasIndex() const;
 
+    /**
+     * Returns true if the index is currently being built in a background thread.
+     * \see init()
+     * \since QGIS 3.0
+     */
+    bool isIndexing() const { return mIsIndexing; }
+
+    /**
+     * Blocks until the background indexing started by init() has finished.
+     * Does nothing if no indexing is in progress.
+     * \since QGIS 3.0
+     */
+    void waitForIndexingFinished();
+
     struct Match
     {
         //! construct invalid match
@@ -214,7 +239,16 @@ class CORE_EXPORT QgsPointLocator : public QObject
 
     //! Return how many geometries are cached in the index
     //! \since QGIS 2.14
-    int cachedGeometryCount() const { return mGeoms.count(); }
+    int cachedGeometryCount() const;
+
+  signals:
+
+    /**
+     * Emitted when the background indexing started by init() has finished.
+     * \a ok is false if the indexing has been stopped due to the limit of features.
+     * \since QGIS 3.0
+     */
+    void initFinished( bool ok );
 
   protected:
     bool rebuildIndex( int maxFeaturesToIndex = -1 );
@@ -224,17 +258,31 @@ class CORE_EXPORT QgsPointLocator : public QObject
     void onFeatureAdded( QgsFeatureId fid );
     void onFeatureDeleted( QgsFeatureId fid );
     void onGeometryChanged( QgsFeatureId fid, const QgsGeometry &geom );
+    void onIndexingFinished();
 
   private:
+    //! Takes over the index built by the builder, returns false if it has been stopped
+    bool takeIndex( QgsPointLocator_IndexBuilder &builder );
+    //! Adds a feature (in destination CRS) to the index
+    void addFeatureToIndex( const QgsFeature &feature );
+
     //! Storage manager
     SpatialIndex::IStorageManager *mStorage = nullptr;
 
-    QHash<QgsFeatureId, QgsGeometry *> mGeoms;
+    //! Vertices of the indexed geometries
+    std::unique_ptr< QgsPointLocator_GeometryStore > mGeoms;
     SpatialIndex::ISpatialIndex *mRTree = nullptr;
 
     //! flag whether the layer is currently empty (i.e. mRTree is null but it is not necessary to rebuild it)
     bool mIsEmptyLayer;
 
+    //! Index being built in a background thread
+    std::unique_ptr< QgsPointLocator_IndexBuilder > mIndexBuilder;
+    QFutureWatcher< void > mIndexingWatcher;
+    bool mIsIndexing = false;
+    //! Features changed while the index is being built in background
+    QSet< QgsFeatureId > mPendingUpdates;
+
     //! R-tree containing spatial index
     QgsCoordinateTransform mTransform;
     QgsVectorLayer *mLayer = nullptr;
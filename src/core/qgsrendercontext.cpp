@@ -18,6 +18,7 @@
 
 #include "qgsrendercontext.h"
 
+#include "qgsapproximatecoordinatetransform.h"
 #include "qgsmapsettings.h"
 #include "qgsexpression.h"
 #include "qgsvectorlayer.h"
@@ -41,6 +42,7 @@ QgsRenderContext::QgsRenderContext( const QgsRenderContext &rh )
   : mFlags( rh.mFlags )
   , mPainter( rh.mPainter )
   , mCoordTransform( rh.mCoordTransform )
+  , mApproximateTransform( rh.mApproximateTransform )
   , mDistanceArea( rh.mDistanceArea )
   , mExtent( rh.mExtent )
   , mMapToPixel( rh.mMapToPixel )
@@ -63,6 +65,7 @@ QgsRenderContext &QgsRenderContext::operator=( const QgsRenderContext &rh )
   mFlags = rh.mFlags;
   mPainter = rh.mPainter;
   mCoordTransform = rh.mCoordTransform;
+  mApproximateTransform = rh.mApproximateTransform;
   mExtent = rh.mExtent;
   mMapToPixel = rh.mMapToPixel;
   mRenderingStopped = rh.mRenderingStopped;
@@ -176,6 +179,17 @@ bool QgsRenderContext::showSelection() const
 void QgsRenderContext::setCoordinateTransform( const QgsCoordinateTransform &t )
 {
   mCoordTransform = t;
+  mApproximateTransform.reset();
+}
+
+const QgsApproximateCoordinateTransform *QgsRenderContext::approximateTransform() const
+{
+  return mApproximateTransform.get();
+}
+
+void QgsRenderContext::setApproximateTransform( const std::shared_ptr< const QgsApproximateCoordinateTransform > &approximation )
+{
+  mApproximateTransform = approximation;
 }
 
 void QgsRenderContext::setDrawEditingInformation( bool b )
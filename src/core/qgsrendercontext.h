@@ -37,6 +37,7 @@ class QPainter;
 class QgsAbstractGeometry;
 class QgsLabelingEngine;
 class QgsMapSettings;
+class QgsApproximateCoordinateTransform;
 
 
 /** \ingroup core
@@ -115,6 +116,15 @@ class CORE_EXPORT QgsRenderContext
      */
     QgsCoordinateTransform coordinateTransform() const {return mCoordTransform;}
 
+    /**
+     * Returns the approximation of coordinateTransform() which should be used to transform
+     * vector geometries for rendering, or nullptr if they should be transformed exactly.
+     * \see setApproximateTransform()
+     * \note not available in Python bindings
+     * \since QGIS 3.0
+     */
+    const QgsApproximateCoordinateTransform *approximateTransform() const SIP_SKIP;
+
     /**
      * A general purpose distance and area calculator, capable of performing ellipsoid based calculations.
      * \since QGIS 3.0
@@ -170,8 +180,20 @@ class CORE_EXPORT QgsRenderContext
 
     //setters
 
-    //! Sets coordinate transformation.
+    /**
+     * Sets coordinate transformation. This also clears any approximate transform.
+     * \see setApproximateTransform()
+     */
     void setCoordinateTransform( const QgsCoordinateTransform &t );
+
+    /**
+     * Sets an \a approximation of the coordinateTransform() which should be used to transform
+     * vector geometries for rendering. Pass nullptr to transform them exactly.
+     * \see approximateTransform()
+     * \note not available in Python bindings
+     * \since QGIS 3.0
+     */
+    void setApproximateTransform( const std::shared_ptr< const QgsApproximateCoordinateTransform > &approximation ) SIP_SKIP;
     void setMapToPixel( const QgsMapToPixel &mtp ) {mMapToPixel = mtp;}
     void setExtent( const QgsRectangle &extent ) {mExtent = extent;}
 
@@ -330,6 +352,9 @@ class CORE_EXPORT QgsRenderContext
     //! For transformation between coordinate systems. Can be invalid if on-the-fly reprojection is not used
     QgsCoordinateTransform mCoordTransform;
 
+    //! Approximation of mCoordTransform for rendering vector geometries, shared between copies
+    std::shared_ptr< const QgsApproximateCoordinateTransform > mApproximateTransform;
+
     /**
      * A general purpose distance and area calculator, capable of performing ellipsoid based calculations.
      * Will be used to convert meter distances to active MapUnit values for QgsUnitTypes::RenderMetersInMapUnits
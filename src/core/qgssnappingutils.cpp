@@ -40,6 +40,7 @@ QgsPointLocator *QgsSnappingUtils::locatorForLayer( QgsVectorLayer *vl )
   if ( !mLocators.contains( vl ) )
   {
     QgsPointLocator *vlpl = new QgsPointLocator( vl, destinationCrs() );
+    connect( vlpl, &QgsPointLocator::initFinished, this, &QgsSnappingUtils::onInitFinished );
     mLocators.insert( vl, vlpl );
   }
   return mLocators.value( vl );
@@ -337,6 +338,9 @@ void QgsSnappingUtils::prepareIndex( const QList<LayerAndAreaOfInterest> &layers
     if ( vl->geometryType() == QgsWkbTypes::NullGeometry || mStrategy == IndexNeverFull )
       continue;
 
+    if ( mBackgroundIndexing && locatorForLayer( vl )->isIndexing() )
+      continue; // temporary locators are used until the index is built
+
     if ( !isIndexPrepared( vl, entry.second ) )
       layersToIndex << entry;
   }
@@ -357,7 +361,7 @@ void QgsSnappingUtils::prepareIndex( const QList<LayerAndAreaOfInterest> &layers
       {
         QgsRectangle rect( mMapSettings.extent() );
         loc->setExtent( &rect );
-        loc->init();
+        loc->init( -1, mBackgroundIndexing );
       }
       else if ( mStrategy == IndexHybrid )
       {
@@ -384,7 +388,7 @@ void QgsSnappingUtils::prepareIndex( const QList<LayerAndAreaOfInterest> &layers
         if ( indexReasonableArea == -1 )
         {
           // we can safely index the whole layer
-          loc->init();
+          loc->init( -1, mBackgroundIndexing );
         }
         else
         {
@@ -396,7 +400,8 @@ void QgsSnappingUtils::prepareIndex( const QList<LayerAndAreaOfInterest> &layers
           loc->setExtent( &rect );
 
           // see if it's possible build index for this area
-          if ( !loc->init( mHybridPerLayerFeatureLimit ) )
+          // (when built in background, the failure is handled by onInitFinished())
+          if ( !loc->init( mHybridPerLayerFeatureLimit, mBackgroundIndexing ) )
           {
             // hmm that didn't work out - too many features!
             // let's make the allowed area smaller for the next time
@@ -406,7 +411,7 @@ void QgsSnappingUtils::prepareIndex( const QList<LayerAndAreaOfInterest> &layers
 
       }
       else  // full index strategy
-        loc->init();
+        loc->init( -1, mBackgroundIndexing );
 
       QgsDebugMsg( QString( "Index init: %1 ms (%2)" ).arg( tt.elapsed() ).arg( vl->id() ) );
       prepareIndexProgress( ++i );
@@ -416,6 +421,22 @@ void QgsSnappingUtils::prepareIndex( const QList<LayerAndAreaOfInterest> &layers
   mIsIndexing = false;
 }
 
+void QgsSnappingUtils::onInitFinished( bool ok )
+{
+  if ( ok )
+    return;
+
+  QgsPointLocator *loc = qobject_cast<QgsPointLocator *>( sender() );
+  if ( !loc || !loc->layer() )
+    return;
+
+  // the partial index of the hybrid strategy has too many features
+  // let's make the allowed area smaller for the next time
+  const QString layerId = loc->layer()->id();
+  if ( mHybridMaxAreaPerLayer.value( layerId, -1 ) > 0 )
+    mHybridMaxAreaPerLayer[layerId] /= 4;
+}
+
 QgsSnappingConfig QgsSnappingUtils::config() const
 {
   return mSnappingConfig;
@@ -91,6 +91,24 @@ class CORE_EXPORT QgsSnappingUtils : public QObject
     //! Find out which strategy is used for indexing - by default hybrid indexing is used
     IndexingStrategy indexingStrategy() const { return mStrategy; }
 
+    /**
+     * Sets whether the indexes of layers are built in background threads. This applies to
+     * the indexes of whole layers as well as to the partial indexes of the hybrid and extent
+     * strategies. While a layer is being indexed, snapping uses temporary indexes of small areas
+     * around the snapped points, so large layers do not block the snapping.
+     * Disabled by default.
+     * \see isBackgroundIndexingEnabled()
+     * \since QGIS 3.0
+     */
+    void setBackgroundIndexingEnabled( bool enabled ) { mBackgroundIndexing = enabled; }
+
+    /**
+     * Returns whether the indexes of whole layers are built in background threads.
+     * \see setBackgroundIndexingEnabled()
+     * \since QGIS 3.0
+     */
+    bool isBackgroundIndexingEnabled() const { return mBackgroundIndexing; }
+
     /**
      * Configures how a certain layer should be handled in a snapping operation
      */
@@ -180,6 +198,10 @@ class CORE_EXPORT QgsSnappingUtils : public QObject
     //! Called when finished indexing a layer. When index == count the indexing is complete
     virtual void prepareIndexProgress( int index ) { Q_UNUSED( index ); }
 
+  private slots:
+    //! Lowers the area of the hybrid partial index of a layer if it could not be built in background
+    void onInitFinished( bool ok );
+
   private:
     void onIndividualLayerSettingsChanged( const QHash<QgsVectorLayer *, QgsSnappingConfig::IndividualLayerSettings> &layerSettings );
     //! Get destination CRS from map settings, or an invalid CRS if projections are disabled
@@ -233,6 +255,8 @@ class CORE_EXPORT QgsSnappingUtils : public QObject
 
     //! internal flag that an indexing process is going on. Prevents starting two processes in parallel.
     bool mIsIndexing = false;
+    //! whether indexes of layers are built in background
+    bool mBackgroundIndexing = false;
 };
 
 
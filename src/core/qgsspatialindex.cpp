@@ -25,8 +25,23 @@
 
 #include "SpatialIndex.h"
 
+#include <QDataStream>
+#include <QFile>
+#include <QHash>
+#include <QSaveFile>
+#include <QSet>
+#include <QSysInfo>
+
+#include <memory>
+#include <vector>
+
 using namespace SpatialIndex;
 
+//! Magic bytes at the start of spatial index files
+static const char SPATIAL_INDEX_FILE_MAGIC[] = "QGSSIDX\n";
+//! Version of the spatial index file format
+static const quint32 SPATIAL_INDEX_FILE_VERSION = 1;
+
 
 
 /** \ingroup core
@@ -149,6 +164,260 @@ class QgsFeatureIteratorDataStream : public IDataStream
 };
 
 
+/** \ingroup core
+ * \class QgsSpatialIndexEntryCollector
+ * \brief Custom visitor that collects bounding boxes and ids of all index entries.
+ * \note not available in Python bindings
+ */
+class QgsSpatialIndexEntryCollector : public SpatialIndex::IVisitor
+{
+  public:
+    explicit QgsSpatialIndexEntryCollector( std::vector< std::pair< SpatialIndex::Region, SpatialIndex::id_type > > &entries )
+      : mEntries( entries ) {}
+
+    void visitNode( const INode &n ) override
+    { Q_UNUSED( n ); }
+
+    void visitData( const IData &d ) override
+    {
+      SpatialIndex::IShape *shape = nullptr;
+      d.getShape( &shape );
+      SpatialIndex::Region r;
+      shape->getMBR( r );
+      delete shape;
+      mEntries.push_back( std::make_pair( r, d.getIdentifier() ) );
+    }
+
+    void visitData( std::vector<const IData *> &v ) override
+    { Q_UNUSED( v ); }
+
+  private:
+    std::vector< std::pair< SpatialIndex::Region, SpatialIndex::id_type > > &mEntries;
+};
+
+/** \ingroup core
+ * \class QgsSpatialIndexEntryDataStream
+ * \brief Utility class for bulk loading of R-trees from collected entries. Not a part of public API.
+ * \note not available in Python bindings
+ */
+class QgsSpatialIndexEntryDataStream : public IDataStream
+{
+  public:
+    explicit QgsSpatialIndexEntryDataStream( const std::vector< std::pair< SpatialIndex::Region, SpatialIndex::id_type > > &entries )
+      : mEntries( entries )
+    {}
+
+    IData *getNext() override
+    {
+      if ( mPos >= mEntries.size() )
+        return nullptr;
+
+      const std::pair< SpatialIndex::Region, SpatialIndex::id_type > &entry = mEntries[ mPos++ ];
+      return new RTree::Data( 0, nullptr, entry.first, entry.second );
+    }
+
+    bool hasNext() override { return mPos < mEntries.size(); }
+
+    uint32_t size() override { return static_cast< uint32_t >( mEntries.size() ); }
+
+    void rewind() override { mPos = 0; }
+
+  private:
+    const std::vector< std::pair< SpatialIndex::Region, SpatialIndex::id_type > > &mEntries;
+    std::size_t mPos = 0;
+};
+
+
+/** \ingroup core
+ * \class QgsSpatialIndexPageStorage
+ * \brief Storage manager for R-tree pages which can be written to and memory mapped from a file.
+ *
+ * Pages stored in this process are kept in memory, other pages are read from the
+ * memory mapped file (if any). The file is never modified.
+ *
+ * \note not available in Python bindings
+ */
+class QgsSpatialIndexPageStorage : public SpatialIndex::IStorageManager
+{
+  public:
+
+    QgsSpatialIndexPageStorage() = default;
+
+    ~QgsSpatialIndexPageStorage()
+    {
+      if ( mMapped )
+        mFile.unmap( const_cast< uchar * >( mMapped ) );
+    }
+
+    void loadByteArray( const id_type page, uint32_t &len, uint8_t **data ) override
+    {
+      const uint8_t *src = nullptr;
+      QHash< id_type, QByteArray >::const_iterator it = mPages.constFind( page );
+      if ( it != mPages.constEnd() )
+      {
+        src = reinterpret_cast< const uint8_t * >( it->constData() );
+        len = static_cast< uint32_t >( it->size() );
+      }
+      else if ( mMapped && page >= 0 && page < mFilePages.size() && !mDeleted.contains( page ) && mFilePages.at( page ).second > 0 )
+      {
+        src = mMapped + mFilePages.at( page ).first;
+        len = mFilePages.at( page ).second;
+      }
+      else
+      {
+        throw Tools::InvalidPageException( page );
+      }
+
+      // ownership of the data is passed to the caller, which deletes it with delete[]
+      *data = new uint8_t[len];
+      memcpy( *data, src, len );
+    }
+
+    void storeByteArray( id_type &page, const uint32_t len, const uint8_t *const data ) override
+    {
+      if ( page == StorageManager::NewPage )
+        page = mNextPage++;
+      else if ( !mPages.contains( page ) && !( page >= 0 && page < mFilePages.size() && !mDeleted.contains( page ) ) )
+        throw Tools::InvalidPageException( page );
+
+      mPages.insert( page, QByteArray( reinterpret_cast< const char * >( data ), static_cast< int >( len ) ) );
+    }
+
+    void deleteByteArray( const id_type page ) override
+    {
+      if ( mPages.remove( page ) == 0 && ( page < 0 || page >= mFilePages.size() || mDeleted.contains( page ) ) )
+        throw Tools::InvalidPageException( page );
+
+      if ( page >= 0 && page < mFilePages.size() )
+        mDeleted.insert( page );
+    }
+
+    // pure virtual in newer libspatialindex releases only - deliberately without override
+    virtual void flush() {}
+
+    /**
+     * Writes all pages stored in memory to \a filePath. The index identifier
+     * of the R-tree must be passed in \a indexId.
+     */
+    bool writeToFile( const QString &filePath, const QString &stamp, id_type indexId ) const
+    {
+      QSaveFile file( filePath );
+      if ( !file.open( QIODevice::WriteOnly ) )
+        return false;
+
+      QDataStream out( &file );
+      out.writeRawData( SPATIAL_INDEX_FILE_MAGIC, 8 );
+      out << SPATIAL_INDEX_FILE_VERSION;
+      out << static_cast< quint8 >( QSysInfo::ByteOrder );
+      out << stamp;
+      out << static_cast< qint64 >( indexId );
+      out << static_cast< quint32 >( mNextPage );
+
+      // page table: offset relative to the start of page data and length of every page
+      quint64 offset = 0;
+      for ( id_type page = 0; page < mNextPage; ++page )
+      {
+        const quint32 length = static_cast< quint32 >( mPages.value( page ).size() );
+        out << offset << length;
+        offset += length;
+      }
+
+      for ( id_type page = 0; page < mNextPage; ++page )
+      {
+        const QByteArray data = mPages.value( page );
+        if ( !data.isEmpty() )
+          out.writeRawData( data.constData(), data.size() );
+      }
+
+      if ( out.status() != QDataStream::Ok )
+      {
+        file.cancelWriting();
+        return false;
+      }
+
+      return file.commit();
+    }
+
+    /**
+     * Memory maps the index file at \a filePath. Returns false if the file cannot be read,
+     * is not a valid index file or was not written with the same \a stamp.
+     * The index identifier of the stored R-tree is returned in \a indexId.
+     */
+    bool openFile( const QString &filePath, const QString &stamp, id_type &indexId )
+    {
+      mFile.setFileName( filePath );
+      if ( !mFile.open( QIODevice::ReadOnly ) )
+        return false;
+
+      QDataStream in( &mFile );
+      char magic[8];
+      if ( in.readRawData( magic, 8 ) != 8 || memcmp( magic, SPATIAL_INDEX_FILE_MAGIC, 8 ) != 0 )
+        return false;
+
+      quint32 version = 0;
+      quint8 byteOrder = 0;
+      QString fileStamp;
+      qint64 fileIndexId = 0;
+      quint32 pageCount = 0;
+      in >> version >> byteOrder >> fileStamp >> fileIndexId >> pageCount;
+      if ( in.status() != QDataStream::Ok || version != SPATIAL_INDEX_FILE_VERSION
+           || byteOrder != static_cast< quint8 >( QSysInfo::ByteOrder ) )
+        return false;
+
+      if ( fileStamp != stamp )
+      {
+        QgsDebugMsg( QString( "Spatial index file %1 is outdated" ).arg( filePath ) );
+        return false;
+      }
+
+      QVector< QPair< quint64, quint32 > > pages;
+      pages.reserve( static_cast< int >( pageCount ) );
+      for ( quint32 page = 0; page < pageCount; ++page )
+      {
+        quint64 offset = 0;
+        quint32 length = 0;
+        in >> offset >> length;
+        pages << qMakePair( offset, length );
+      }
+      if ( in.status() != QDataStream::Ok )
+        return false;
+
+      const qint64 dataStart = mFile.pos();
+      const quint64 dataSize = static_cast< quint64 >( mFile.size() - dataStart );
+      for ( int page = 0; page < pages.size(); ++page )
+      {
+        if ( pages.at( page ).first + pages.at( page ).second > dataSize )
+          return false;
+        pages[page].first += static_cast< quint64 >( dataStart );
+      }
+
+      mMapped = mFile.map( 0, mFile.size() );
+      if ( !mMapped )
+        return false;
+
+      mFilePages = pages;
+      mNextPage = pageCount;
+      indexId = fileIndexId;
+      return true;
+    }
+
+  private:
+
+    //! Pages created or modified in this process
+    QHash< id_type, QByteArray > mPages;
+
+    //! Pages of the mapped file deleted in this process
+    QSet< id_type > mDeleted;
+
+    QFile mFile;
+    const uchar *mMapped = nullptr;
+    //! Absolute offset and length of pages stored in the mapped file
+    QVector< QPair< quint64, quint32 > > mFilePages;
+
+    id_type mNextPage = 0;
+};
+
+
 /** \ingroup core
  *  \class QgsSpatialIndexData
  * \brief Data of spatial index that may be implicitly shared
@@ -176,6 +445,16 @@ class QgsSpatialIndexData : public QSharedData
       initTree( &fids );
     }
 
+    /**
+     * Constructor for QgsSpatialIndexData which takes ownership of an existing \a storage
+     * and the R-tree \a tree loaded from it.
+     */
+    QgsSpatialIndexData( SpatialIndex::IStorageManager *storage, SpatialIndex::ISpatialIndex *tree )
+      : mStorage( storage )
+      , mRTree( tree )
+    {
+    }
+
     QgsSpatialIndexData( const QgsSpatialIndexData &other )
       : QSharedData( other )
     {
@@ -202,6 +481,13 @@ class QgsSpatialIndexData : public QSharedData
       // for now only memory manager
       mStorage = StorageManager::createNewMemoryStorageManager();
 
+      SpatialIndex::id_type indexId;
+      mRTree = createTree( *mStorage, inputStream, indexId );
+    }
+
+    //! Creates a new R-tree in \a storage, optionally bulk loaded from \a inputStream
+    static SpatialIndex::ISpatialIndex *createTree( SpatialIndex::IStorageManager &storage, IDataStream *inputStream, SpatialIndex::id_type &indexId )
+    {
       // R-Tree parameters
       double fillFactor = 0.7;
       unsigned long indexCapacity = 10;
@@ -210,14 +496,12 @@ class QgsSpatialIndexData : public QSharedData
       RTree::RTreeVariant variant = RTree::RV_RSTAR;
 
       // create R-tree
-      SpatialIndex::id_type indexId;
-
       if ( inputStream )
-        mRTree = RTree::createAndBulkLoadNewRTree( RTree::BLM_STR, *inputStream, *mStorage, fillFactor, indexCapacity,
-                 leafCapacity, dimension, variant, indexId );
+        return RTree::createAndBulkLoadNewRTree( RTree::BLM_STR, *inputStream, storage, fillFactor, indexCapacity,
+               leafCapacity, dimension, variant, indexId );
       else
-        mRTree = RTree::createNewRTree( *mStorage, fillFactor, indexCapacity,
-                                        leafCapacity, dimension, variant, indexId );
+        return RTree::createNewRTree( storage, fillFactor, indexCapacity,
+                                      leafCapacity, dimension, variant, indexId );
     }
 
     //! Storage manager
@@ -363,6 +647,67 @@ QList<QgsFeatureId> QgsSpatialIndex::nearestNeighbor( const QgsPointXY &point, i
   return list;
 }
 
+bool QgsSpatialIndex::writeToFile( const QString &filePath, const QString &stamp ) const
+{
+  std::vector< std::pair< SpatialIndex::Region, SpatialIndex::id_type > > entries;
+  QgsSpatialIndexEntryCollector collector( entries );
+  double low[]  = { -DBL_MAX, -DBL_MAX };
+  double high[] = { DBL_MAX, DBL_MAX };
+  d->mRTree->intersectsWithQuery( SpatialIndex::Region( low, high, 2 ), collector );
+
+  QgsSpatialIndexPageStorage storage;
+  SpatialIndex::id_type indexId;
+  try
+  {
+    QgsSpatialIndexEntryDataStream stream( entries );
+    // the tree writes its header page to the storage when destroyed
+    std::unique_ptr< SpatialIndex::ISpatialIndex > tree( QgsSpatialIndexData::createTree( storage, entries.empty() ? nullptr : &stream, indexId ) );
+  }
+  catch ( Tools::Exception &e )
+  {
+    Q_UNUSED( e );
+    QgsDebugMsg( QString( "Tools::Exception caught: %1" ).arg( e.what().c_str() ) );
+    return false;
+  }
+  catch ( const std::exception &e )
+  {
+    Q_UNUSED( e );
+    QgsDebugMsg( QString( "std::exception caught: %1" ).arg( e.what() ) );
+    return false;
+  }
+
+  return storage.writeToFile( filePath, stamp, indexId );
+}
+
+bool QgsSpatialIndex::readFromFile( const QString &filePath, const QString &stamp )
+{
+  std::unique_ptr< QgsSpatialIndexPageStorage > storage( new QgsSpatialIndexPageStorage() );
+  SpatialIndex::id_type indexId;
+  if ( !storage->openFile( filePath, stamp, indexId ) )
+    return false;
+
+  SpatialIndex::ISpatialIndex *tree = nullptr;
+  try
+  {
+    tree = RTree::loadRTree( *storage, indexId );
+  }
+  catch ( Tools::Exception &e )
+  {
+    Q_UNUSED( e );
+    QgsDebugMsg( QString( "Tools::Exception caught: %1" ).arg( e.what().c_str() ) );
+    return false;
+  }
+  catch ( const std::exception &e )
+  {
+    Q_UNUSED( e );
+    QgsDebugMsg( QString( "std::exception caught: %1" ).arg( e.what() ) );
+    return false;
+  }
+
+  d = new QgsSpatialIndexData( storage.release(), tree );
+  return true;
+}
+
 QAtomicInt QgsSpatialIndex::refs() const
 {
   return d->ref;
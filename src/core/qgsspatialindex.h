@@ -51,6 +51,11 @@ class QgsFeatureSource;
 
 /** \ingroup core
  * \class QgsSpatialIndex
+ *
+ * A spatial index may be written to a file with writeToFile() and later reopened
+ * with readFromFile(). Reopened indexes are memory mapped from the file, so that the
+ * index pages are shared between all processes which open the same file instead of
+ * being held in each process' heap.
  */
 class CORE_EXPORT QgsSpatialIndex
 {
@@ -119,6 +124,50 @@ class CORE_EXPORT QgsSpatialIndex
     //! Returns nearest neighbors (their count is specified by second parameter)
     QList<QgsFeatureId> nearestNeighbor( const QgsPointXY &point, int neighbors ) const;
 
+    /* persistence */
+
+    /**
+     * Writes the index to the file at \a filePath, replacing any existing file.
+     *
+     * The \a stamp string identifies the state of the indexed data (e.g. the source's
+     * data modification timestamp) and must be passed to readFromFile() for the
+     * index file to be accepted again. The index is bulk loaded into the file,
+     * so the written index is also optimally packed.
+     *
+     * Index files are only portable between platforms of the same byte order.
+     *
+     * \returns true if the index was written successfully
+     * \see readFromFile()
+     * \since QGIS 3.0
+     */
+    bool writeToFile( const QString &filePath, const QString &stamp = QString() ) const;
+
+    /**
+     * Replaces the content of the index by the index stored in the file at \a filePath,
+     * previously created by writeToFile().
+     *
+     * The file is memory mapped read-only. Changes made to the index after reading
+     * (insertFeature(), deleteFeature()) are kept in memory and never written back
+     * to the file.
+     *
+     * If the file does not exist, is not a valid index file or was written with a different
+     * \a stamp (i.e. the indexed data has changed since), false is returned and the index
+     * is left unchanged, so that callers can fall back to building the index from the source
+     * and writing it again:
+     *
+     * \code{.py}
+     * stamp = layer.dataProvider().dataTimestamp().toString(Qt.ISODate)
+     * index = QgsSpatialIndex()
+     * if not index.readFromFile(path, stamp):
+     *     index = QgsSpatialIndex(layer.getFeatures())
+     *     index.writeToFile(path, stamp)
+     * \endcode
+     *
+     * \see writeToFile()
+     * \since QGIS 3.0
+     */
+    bool readFromFile( const QString &filePath, const QString &stamp = QString() );
+
     /* debugging */
 
     //! get reference count - just for debugging!
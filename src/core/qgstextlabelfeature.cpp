@@ -15,6 +15,7 @@
 
 #include "qgstextlabelfeature.h"
 
+#include "qgsfontmetricscache.h"
 #include "qgsgeometry.h"
 #include "qgspallabeling.h"
 #include "qgsmaptopixel.h"
@@ -44,7 +45,7 @@ QString QgsTextLabelFeature::text( int partId ) const
 }
 
 
-void QgsTextLabelFeature::calculateInfo( bool curvedLabeling, QFontMetricsF *fm, const QgsMapToPixel *xform, double maxinangle, double maxoutangle )
+void QgsTextLabelFeature::calculateInfo( bool curvedLabeling, const QFont &font, QFontMetricsF *fm, const QgsMapToPixel *xform, double maxinangle, double maxoutangle )
 {
   if ( mInfo )
     return;
@@ -81,7 +82,8 @@ void QgsTextLabelFeature::calculateInfo( bool curvedLabeling, QFontMetricsF *fm,
   {
     // reconstruct how Qt creates word spacing, then adjust per individual stored character
     // this will allow PAL to create each candidate width = character width + correct spacing
-    charWidth = fm->width( mClusters[i] );
+    // character advances are cached, as the same characters are measured for every label
+    charWidth = QgsFontMetricsCache::width( font, mClusters[i] );
     if ( curvedLabeling )
     {
       wordSpaceFix = qreal( 0.0 );
@@ -100,7 +102,7 @@ void QgsTextLabelFeature::calculateInfo( bool curvedLabeling, QFontMetricsF *fm,
         wordSpaceFix -= wordSpacing;
       }
 
-      charWidth = fm->width( QString( mClusters[i] ) ) + wordSpaceFix;
+      charWidth += wordSpaceFix;
     }
 
     double labelWidth = mapScale * charWidth;
@@ -40,8 +40,11 @@ class QgsTextLabelFeature : public QgsLabelFeature
      */
     QString text( int partId ) const;
 
-    //! calculate data for info(). setDefinedFont() must have been called already.
-    void calculateInfo( bool curvedLabeling, QFontMetricsF *fm, const QgsMapToPixel *xform, double maxinangle, double maxoutangle );
+    /**
+     * Calculate data for info(). setDefinedFont() must have been called already.
+     * \a fm must be the metrics of \a font, which is used for looking up the character widths in QgsFontMetricsCache.
+     */
+    void calculateInfo( bool curvedLabeling, const QFont &font, QFontMetricsF *fm, const QgsMapToPixel *xform, double maxinangle, double maxoutangle );
 
     //! Get data-defined values
     const QMap< QgsPalLayerSettings::Property, QVariant > &dataDefinedValues() const { return mDataDefinedValues; }
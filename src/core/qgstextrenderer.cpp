@@ -17,6 +17,7 @@
 #include "qgstextrenderer.h"
 #include "qgis.h"
 #include "qgstextrenderer_p.h"
+#include "qgsfontmetricscache.h"
 #include "qgsfontutils.h"
 #include "qgspathresolver.h"
 #include "qgsreadwritecontext.h"
@@ -1768,7 +1769,7 @@ void QgsTextRenderer::drawPart( const QRectF &rect, double rotation, HAlignment
     case Text:
     case Shadow:
     {
-      QFontMetricsF fm( format.scaledFont( context ) );
+      QFontMetricsF fm = QgsFontMetricsCache::fontMetrics( format.scaledFont( context ) );
       drawTextInternal( part, context, format, component,
                         textLines,
                         &fm,
@@ -1812,7 +1813,7 @@ void QgsTextRenderer::drawPart( const QPointF &origin, double rotation, QgsTextR
     case Text:
     case Shadow:
     {
-      QFontMetricsF fm( format.scaledFont( context ) );
+      QFontMetricsF fm = QgsFontMetricsCache::fontMetrics( format.scaledFont( context ) );
       drawTextInternal( part, context, format, component,
                         textLines,
                         &fm,
@@ -1832,9 +1833,7 @@ void QgsTextRenderer::drawBuffer( QgsRenderContext &context, const QgsTextRender
 
   double penSize = context.convertToPainterUnits( buffer.size(), buffer.sizeUnit(), buffer.sizeMapUnitScale() );
 
-  QPainterPath path;
-  path.setFillRule( Qt::WindingFill );
-  path.addText( 0, 0, format.scaledFont( context ), component.text );
+  QPainterPath path = QgsFontMetricsCache::textPath( format.scaledFont( context ), component.text );
   QColor bufferColor = buffer.color();
   bufferColor.setAlphaF( buffer.opacity() );
   QPen pen( bufferColor );
@@ -1900,17 +1899,14 @@ void QgsTextRenderer::drawBuffer( QgsRenderContext &context, const QgsTextRender
 double QgsTextRenderer::textWidth( const QgsRenderContext &context, const QgsTextFormat &format, const QStringList &textLines, QFontMetricsF *fm )
 {
   //calculate max width of text lines
-  std::unique_ptr< QFontMetricsF > newFm;
+  QFont scaledFont;
   if ( !fm )
-  {
-    newFm.reset( new QFontMetricsF( format.scaledFont( context ) ) );
-    fm = newFm.get();
-  }
+    scaledFont = format.scaledFont( context );
 
   double maxWidth = 0;
   Q_FOREACH ( const QString &line, textLines )
   {
-    maxWidth = std::max( maxWidth, fm->width( line ) );
+    maxWidth = std::max( maxWidth, fm ? fm->width( line ) : QgsFontMetricsCache::width( scaledFont, line ) );
   }
   return maxWidth;
 }
@@ -1921,7 +1917,7 @@ double QgsTextRenderer::textHeight( const QgsRenderContext &context, const QgsTe
   std::unique_ptr< QFontMetricsF > newFm;
   if ( !fm )
   {
-    newFm.reset( new QFontMetricsF( format.scaledFont( context ) ) );
+    newFm.reset( new QFontMetricsF( QgsFontMetricsCache::fontMetrics( format.scaledFont( context ) ) ) );
     fm = newFm.get();
   }
 
@@ -1977,8 +1973,8 @@ void QgsTextRenderer::drawBackground( QgsRenderContext &context, QgsTextRenderer
   if ( mode != Label )
   {
     // need to calculate size of text
-    QFontMetricsF fm( format.scaledFont( context ) );
-    double width = textWidth( context, format, textLines, &fm );
+    QFontMetricsF fm = QgsFontMetricsCache::fontMetrics( format.scaledFont( context ) );
+    double width = textWidth( context, format, textLines );
     double height = textHeight( context, format, textLines, mode, &fm );
 
     switch ( mode )
@@ -2572,9 +2568,7 @@ void QgsTextRenderer::drawTextInternal( TextPart drawType,
     else
     {
       // draw text, QPainterPath method
-      QPainterPath path;
-      path.setFillRule( Qt::WindingFill );
-      path.addText( 0, 0, format.scaledFont( context ), subComponent.text );
+      QPainterPath path = QgsFontMetricsCache::textPath( format.scaledFont( context ), subComponent.text );
 
       // store text's drawing in QPicture for drop shadow call
       QPicture textPict;
@@ -21,12 +21,70 @@
 #include "qgsvectorlayereditbuffer.h"
 #include "qgsvectorlayer.h"
 #include "qgsvectorlayerjoinbuffer.h"
+#include "qgsexpression.h"
 #include "qgsexpressioncontext.h"
 #include "qgsdistancearea.h"
 #include "qgsproject.h"
 #include "qgsmessagelog.h"
 #include "qgsexception.h"
 
+//! Number of features for which the joined attributes are fetched with a single request
+static const int JOIN_BATCH_SIZE = 1000;
+
+//! Returns the join value as literal for a filter expression
+static QString _joinValueLiteral( const QVariant &joinValue )
+{
+  QString v = joinValue.toString();
+  switch ( joinValue.type() )
+  {
+    case QVariant::Int:
+    case QVariant::LongLong:
+    case QVariant::Double:
+      break;
+
+    default:
+    case QVariant::String:
+      v.replace( '\'', QLatin1String( "''" ) );
+      v.prepend( '\'' ).append( '\'' );
+      break;
+  }
+  return v;
+}
+
+//! Returns the attributes of the joined feature which are added to the target features, in the memory cache format
+static QgsAttributes _joinedAttributes( const QgsVectorLayerFeatureIterator::FetchJoinInfo &info, const QgsAttributes &attr, const QVector<int> &subsetIndices )
+{
+  QgsAttributes joined;
+  if ( info.joinInfo->joinFieldNamesSubset() )
+  {
+    joined.reserve( subsetIndices.count() );
+    for ( int i = 0; i < subsetIndices.count(); ++i )
+      joined << attr.at( subsetIndices.at( i ) );
+  }
+  else
+  {
+    // use all fields except for the one used for join (has same value as exiting field in target layer)
+    joined.reserve( attr.count() );
+    for ( int i = 0; i < attr.count(); ++i )
+    {
+      if ( i == info.joinField )
+        continue;
+
+      joined << attr.at( i );
+    }
+  }
+  return joined;
+}
+
+static void _setJoinedAttributes( QgsFeature &f, int indexOffset, const QgsAttributes &joined )
+{
+  int index = indexOffset;
+  for ( int i = 0; i < joined.count(); ++i )
+  {
+    f.setAttribute( index++, joined.at( i ) );
+  }
+}
+
 QgsVectorLayerFeatureSource::QgsVectorLayerFeatureSource( const QgsVectorLayer *layer )
 {
   QMutexLocker locker( &layer->mFeatureSourceConstructorMutex );
@@ -208,6 +266,23 @@ QgsVectorLayerFeatureIterator::QgsVectorLayerFeatureIterator( QgsVectorLayerFeat
     }
   }
 
+  if ( mProviderRequest.offset() > 0 )
+  {
+    if ( !mSource->mHasEditBuffer && mProviderRequest.filterType() == mRequest.filterType()
+         && mRequest.invalidGeometryCheck() == QgsFeatureRequest::GeometryNoCheck )
+    {
+      // all features come straight from the provider, so it can skip them
+      mOffsetApplied = true;
+    }
+    else
+    {
+      // features are added or filtered locally, so they need to be skipped here
+      if ( mProviderRequest.limit() >= 0 )
+        mProviderRequest.setLimit( mProviderRequest.limit() + mProviderRequest.offset() );
+      mProviderRequest.setOffset( 0 );
+    }
+  }
+
   if ( mSource->mHasEditBuffer )
   {
     mChangedFeaturesRequest = mProviderRequest;
@@ -327,18 +402,11 @@ bool QgsVectorLayerFeatureIterator::fetchFeature( QgsFeature &f )
     mProviderIterator.setInterruptionChecker( mInterruptionChecker );
   }
 
-  while ( mProviderIterator.nextFeature( f ) )
+  while ( fetchNextProviderFeature( f ) )
   {
     if ( mFetchConsidered.contains( f.id() ) )
       continue;
 
-    // TODO[MD]: just one resize of attributes
-    f.setFields( mSource->mFields );
-
-    // update attributes
-    if ( mSource->mHasEditBuffer )
-      updateChangedAttributes( f );
-
     if ( mHasVirtualAttributes )
       addVirtualAttributes( f );
 
@@ -383,6 +451,7 @@ bool QgsVectorLayerFeatureIterator::rewind()
   else
   {
     mProviderIterator.rewind();
+    mProviderFeatureQueue.clear();
     rewindEditBuffer();
   }
 
@@ -395,6 +464,7 @@ bool QgsVectorLayerFeatureIterator::close()
     return false;
 
   mProviderIterator.close();
+  mProviderFeatureQueue.clear();
 
   iteratorClosed();
 
@@ -674,6 +744,23 @@ void QgsVectorLayerFeatureIterator::prepareFields()
   if ( !mFetchJoinInfo.empty() )
   {
     createOrderedJoinList();
+    prepareBatchedJoins();
+  }
+}
+
+void QgsVectorLayerFeatureIterator::prepareBatchedJoins()
+{
+  mBatchedJoins.clear();
+  for ( int i = 0; i < mOrderedJoinInfoList.size(); ++i )
+  {
+    const FetchJoinInfo &info = mOrderedJoinInfoList.at( i );
+    if ( !info.joinInfo->cachedAttributes.isEmpty() || info.joinField < 0 )
+      continue; // memory cache is used
+
+    // the join values must be known when the features are read from the provider
+    QgsFields::FieldOrigin origin = mSource->mFields.fieldOrigin( info.targetField );
+    if ( origin == QgsFields::OriginProvider || origin == QgsFields::OriginEdit )
+      mBatchedJoins.insert( i, BatchedJoinAttributes() );
   }
 }
 
@@ -808,18 +895,29 @@ void QgsVectorLayerFeatureIterator::prepareField( int fieldIdx )
 
 void QgsVectorLayerFeatureIterator::addJoinedAttributes( QgsFeature &f )
 {
-  QList< FetchJoinInfo >::const_iterator joinIt = mOrderedJoinInfoList.constBegin();
-  for ( ; joinIt != mOrderedJoinInfoList.constEnd(); ++joinIt )
+  for ( int i = 0; i < mOrderedJoinInfoList.size(); ++i )
   {
-    QVariant targetFieldValue = f.attribute( joinIt->targetField );
+    const FetchJoinInfo &info = mOrderedJoinInfoList.at( i );
+    QVariant targetFieldValue = f.attribute( info.targetField );
     if ( !targetFieldValue.isValid() )
       continue;
 
-    const QHash< QString, QgsAttributes> &memoryCache = joinIt->joinInfo->cachedAttributes;
-    if ( memoryCache.isEmpty() )
-      joinIt->addJoinedAttributesDirect( f, targetFieldValue );
-    else
-      joinIt->addJoinedAttributesCached( f, targetFieldValue );
+    const QHash< QString, QgsAttributes> &memoryCache = info.joinInfo->cachedAttributes;
+    if ( !memoryCache.isEmpty() )
+    {
+      info.addJoinedAttributesCached( f, targetFieldValue );
+      continue;
+    }
+
+    QHash< int, BatchedJoinAttributes >::const_iterator batchIt = mBatchedJoins.constFind( i );
+    if ( batchIt != mBatchedJoins.constEnd() && !targetFieldValue.isNull() && batchIt->joinValues.contains( targetFieldValue.toString() ) )
+    {
+      // already fetched together with the other features of the batch
+      _setJoinedAttributes( f, info.indexOffset, batchIt->attributes.value( targetFieldValue.toString() ) );
+      continue;
+    }
+
+    info.addJoinedAttributesDirect( f, targetFieldValue );
   }
 }
 
@@ -899,13 +997,7 @@ void QgsVectorLayerFeatureIterator::FetchJoinInfo::addJoinedAttributesCached( Qg
   if ( it == memoryCache.constEnd() )
     return; // joined value not found -> leaving the attributes empty (null)
 
-  int index = indexOffset;
-
-  const QgsAttributes &featureAttributes = it.value();
-  for ( int i = 0; i < featureAttributes.count(); ++i )
-  {
-    f.setAttribute( index++, featureAttributes.at( i ) );
-  }
+  _setJoinedAttributes( f, indexOffset, it.value() );
 }
 
 
@@ -925,28 +1017,13 @@ void QgsVectorLayerFeatureIterator::FetchJoinInfo::addJoinedAttributesDirect( Qg
   }
   else
   {
-    QString v = joinValue.toString();
-    switch ( joinValue.type() )
-    {
-      case QVariant::Int:
-      case QVariant::LongLong:
-      case QVariant::Double:
-        break;
-
-      default:
-      case QVariant::String:
-        v.replace( '\'', QLatin1String( "''" ) );
-        v.prepend( '\'' ).append( '\'' );
-        break;
-    }
-    subsetString += '=' + v;
+    subsetString += '=' + _joinValueLiteral( joinValue );
   }
 
   // maybe user requested just a subset of layer's attributes
   // so we do not have to cache everything
-  bool hasSubset = joinInfo->joinFieldNamesSubset();
   QVector<int> subsetIndices;
-  if ( hasSubset )
+  if ( joinInfo->joinFieldNamesSubset() )
     subsetIndices = QgsVectorLayerJoinBuffer::joinSubsetIndices( joinLayer, *joinInfo->joinFieldNamesSubset() );
 
   // select (no geometry)
@@ -961,24 +1038,7 @@ void QgsVectorLayerFeatureIterator::FetchJoinInfo::addJoinedAttributesDirect( Qg
   QgsFeature fet;
   if ( fi.nextFeature( fet ) )
   {
-    int index = indexOffset;
-    QgsAttributes attr = fet.attributes();
-    if ( hasSubset )
-    {
-      for ( int i = 0; i < subsetIndices.count(); ++i )
-        f.setAttribute( index++, attr.at( subsetIndices.at( i ) ) );
-    }
-    else
-    {
-      // use all fields except for the one used for join (has same value as exiting field in target layer)
-      for ( int i = 0; i < attr.count(); ++i )
-      {
-        if ( i == joinField )
-          continue;
-
-        f.setAttribute( index++, attr.at( i ) );
-      }
-    }
+    _setJoinedAttributes( f, indexOffset, _joinedAttributes( *this, fet.attributes(), subsetIndices ) );
   }
   else
   {
@@ -986,8 +1046,106 @@ void QgsVectorLayerFeatureIterator::FetchJoinInfo::addJoinedAttributesDirect( Qg
   }
 }
 
+bool QgsVectorLayerFeatureIterator::fetchNextProviderFeature( QgsFeature &f )
+{
+  if ( mBatchedJoins.isEmpty() )
+  {
+    if ( !mProviderIterator.nextFeature( f ) )
+      return false;
+  }
+  else
+  {
+    if ( mProviderFeatureQueue.isEmpty() )
+    {
+      // read ahead a batch of features, so that their joined attributes
+      // are fetched with a single request instead of one request per feature
+      int batchSize = JOIN_BATCH_SIZE;
+      if ( mRequest.limit() >= 0 )
+        batchSize = std::max( 1, std::min( batchSize, static_cast< int >( mRequest.limit() + mRequest.offset() ) ) );
+
+      QgsFeature feature;
+      while ( mProviderFeatureQueue.size() < batchSize && mProviderIterator.nextFeature( feature ) )
+      {
+        feature.setFields( mSource->mFields );
+        if ( mSource->mHasEditBuffer )
+          updateChangedAttributes( feature );
+        mProviderFeatureQueue.enqueue( feature );
+      }
+
+      fetchBatchedJoinAttributes();
+    }
+
+    if ( mProviderFeatureQueue.isEmpty() )
+      return false;
+
+    f = mProviderFeatureQueue.dequeue();
+    return true;
+  }
+
+  // TODO[MD]: just one resize of attributes
+  f.setFields( mSource->mFields );
+
+  // update attributes
+  if ( mSource->mHasEditBuffer )
+    updateChangedAttributes( f );
+
+  return true;
+}
+
+void QgsVectorLayerFeatureIterator::fetchBatchedJoinAttributes()
+{
+  for ( QHash< int, BatchedJoinAttributes >::iterator batchIt = mBatchedJoins.begin(); batchIt != mBatchedJoins.end(); ++batchIt )
+  {
+    const FetchJoinInfo &info = mOrderedJoinInfoList.at( batchIt.key() );
+    BatchedJoinAttributes &batch = batchIt.value();
+    batch.joinValues.clear();
+    batch.attributes.clear();
+
+    // null values are left to the direct query
+    QStringList literals;
+    for ( const QgsFeature &feature : qgsAsConst( mProviderFeatureQueue ) )
+    {
+      const QVariant value = feature.attribute( info.targetField );
+      if ( !value.isValid() || value.isNull() )
+        continue;
+
+      const QString key = value.toString();
+      if ( batch.joinValues.contains( key ) )
+        continue;
+
+      batch.joinValues << key;
+      literals << _joinValueLiteral( value );
+    }
+
+    if ( literals.isEmpty() )
+      continue;
 
+    QVector<int> subsetIndices;
+    if ( info.joinInfo->joinFieldNamesSubset() )
+      subsetIndices = QgsVectorLayerJoinBuffer::joinSubsetIndices( info.joinLayer, *info.joinInfo->joinFieldNamesSubset() );
 
+    QgsAttributeList attributes = info.attributes;
+    if ( !attributes.contains( info.joinField ) )
+      attributes << info.joinField;
+
+    // select (no geometry), the IN filter can be compiled by the providers
+    QgsFeatureRequest request;
+    request.setFlags( QgsFeatureRequest::NoGeometry );
+    request.setSubsetOfAttributes( attributes );
+    request.setFilterExpression( QStringLiteral( "%1 IN (%2)" ).arg( QgsExpression::quotedColumnRef( info.joinInfo->joinFieldName() ),
+                                 literals.join( ',' ) ) );
+    QgsFeatureIterator fi = info.joinLayer->getFeatures( request );
+
+    QgsFeature fet;
+    while ( fi.nextFeature( fet ) )
+    {
+      const QString key = fet.attribute( info.joinField ).toString();
+      // like the direct query, only the first joined feature is used
+      if ( !batch.attributes.contains( key ) )
+        batch.attributes.insert( key, _joinedAttributes( info, fet.attributes(), subsetIndices ) );
+    }
+  }
+}
 
 bool QgsVectorLayerFeatureIterator::nextFeatureFid( QgsFeature &f )
 {
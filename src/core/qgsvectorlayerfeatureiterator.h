@@ -22,6 +22,7 @@
 #include "qgscoordinatereferencesystem.h"
 #include "qgsfeaturesource.h"
 
+#include <QQueue>
 #include <QSet>
 #include <memory>
 
@@ -243,6 +244,28 @@ class CORE_EXPORT QgsVectorLayerFeatureIterator : public QgsAbstractFeatureItera
     //! Join list sorted by dependency
     QList< FetchJoinInfo > mOrderedJoinInfoList;
 
+    //! Joined attributes fetched for a batch of provider features
+    struct BatchedJoinAttributes
+    {
+      QSet< QString > joinValues; //!< Join values of the features in the batch
+      QHash< QString, QgsAttributes > attributes; //!< Joined attributes by join value, in the memory cache format
+    };
+
+    //! Batched joined attributes for each join in mOrderedJoinInfoList, joins which are not batched are not present
+    QHash< int, BatchedJoinAttributes > mBatchedJoins;
+
+    //! Provider features read ahead to fetch their joined attributes in batches
+    QQueue< QgsFeature > mProviderFeatureQueue;
+
+    //! Finds the joins which are fetched for batches of provider features
+    void prepareBatchedJoins();
+
+    //! Fetches the next feature from the provider and updates its attributes from the edit buffer
+    bool fetchNextProviderFeature( QgsFeature &f );
+
+    //! Fetches the joined attributes of the features in mProviderFeatureQueue, with one request per join
+    void fetchBatchedJoinAttributes();
+
     /**
      * Will always return true. We assume that ordering has been done on provider level already.
      *
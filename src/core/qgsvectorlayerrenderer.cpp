@@ -37,6 +37,10 @@
 #include "qgssettings.h"
 
 #include <QPicture>
+#include <QImage>
+
+#include <memory>
+#include <vector>
 
 
 QgsVectorLayerRenderer::QgsVectorLayerRenderer( QgsVectorLayer *layer, QgsRenderContext &context )
@@ -286,7 +290,7 @@ void QgsVectorLayerRenderer::drawRenderer( QgsFeatureIterator &fit )
       if ( rendered )
       {
         // new labeling engine
-        if ( mContext.labelingEngine() && ( mLabelProvider || mDiagramProvider ) )
+        if ( mContext.labelingEngine() && ( mLabelProvider || mDiagramProvider ) && isInLabelRegion( fet ) )
         {
           QgsGeometry obstacleGeometry;
           QgsSymbolList symbols = mRenderer->originalSymbolsForFeature( fet, mContext );
@@ -301,14 +305,7 @@ void QgsVectorLayerRenderer::drawRenderer( QgsFeatureIterator &fit )
             QgsExpressionContextUtils::updateSymbolScope( symbols.at( 0 ), symbolScope );
           }
 
-          if ( mLabelProvider )
-          {
-            mLabelProvider->registerFeature( fet, mContext, obstacleGeometry );
-          }
-          if ( mDiagramProvider )
-          {
-            mDiagramProvider->registerFeature( fet, mContext, obstacleGeometry );
-          }
+          registerLabelFeature( fet, obstacleGeometry );
         }
       }
     }
@@ -338,10 +335,114 @@ void QgsVectorLayerRenderer::drawRendererLevels( QgsFeatureIterator &fit )
     selRenderer->startRender( mContext, mFields );
   }
 
+  // find out the order
+  QgsSymbolLevelOrder levels;
+  QgsSymbolList symbols = mRenderer->symbols( mContext );
+  for ( int i = 0; i < symbols.count(); i++ )
+  {
+    QgsSymbol *sym = symbols[i];
+    for ( int j = 0; j < sym->symbolLayerCount(); j++ )
+    {
+      int level = sym->symbolLayer( j )->renderingPass();
+      if ( level < 0 || level >= 1000 ) // ignore invalid levels
+        continue;
+      QgsSymbolLevelItem item( sym, j );
+      while ( level >= levels.count() ) // append new empty levels
+        levels.append( QgsSymbolLevel() );
+      levels[level].append( item );
+    }
+  }
+
+  auto drawFeature = [this]( const QgsFeature & feature, int layer )
+  {
+    bool sel = mContext.showSelection() && mSelectedFeatureIds.contains( feature.id() );
+    // maybe vertex markers should be drawn only during the last pass...
+    bool drawMarker = ( mDrawVertexMarkers && mContext.drawEditingInformation() && ( !mVertexMarkerOnlyForSelection || sel ) );
+
+    mContext.expressionContext().setFeature( feature );
+
+    try
+    {
+      mRenderer->renderFeature( feature, mContext, layer, sel, drawMarker );
+    }
+    catch ( const QgsCsException &cse )
+    {
+      Q_UNUSED( cse );
+      QgsDebugMsg( QString( "Failed to transform a point while drawing a feature with ID '%1'. Ignoring this feature. %2" )
+                   .arg( feature.id() ).arg( cse.what() ) );
+    }
+  };
+
+  // when there are too many features to keep them in memory, every level is drawn
+  // into an image of its own while iterating, and the images are composited at the end
+  QPainter *painter = mContext.painter();
+  std::vector< std::unique_ptr< QImage > > levelImages;
+  std::vector< std::unique_ptr< QPainter > > levelPainters;
+  bool drawingToLevelImages = false;
+
+  auto drawFeatureToLevelImages = [&]( const QgsFeature & feature, QgsSymbol * sym )
+  {
+    for ( int l = 0; l < levels.count(); l++ )
+    {
+      const QgsSymbolLevel &level = levels.at( l );
+      for ( int i = 0; i < level.count(); i++ )
+      {
+        if ( level.at( i ).symbol() != sym )
+          continue;
+
+        mContext.setPainter( levelPainters[l].get() );
+        drawFeature( feature, level.at( i ).layer() );
+      }
+    }
+    mContext.setPainter( painter );
+  };
+
+  auto startDrawingToLevelImages = [&]
+  {
+    const QImage *device = static_cast< const QImage * >( painter->device() );
+    for ( int l = 0; l < levels.count(); l++ )
+    {
+      if ( levels.at( l ).isEmpty() )
+      {
+        levelImages.emplace_back( nullptr );
+        levelPainters.emplace_back( nullptr );
+        continue;
+      }
+
+      std::unique_ptr< QImage > image( new QImage( device->size(), QImage::Format_ARGB32_Premultiplied ) );
+      image->setDotsPerMeterX( device->dotsPerMeterX() );
+      image->setDotsPerMeterY( device->dotsPerMeterY() );
+      image->setDevicePixelRatio( device->devicePixelRatio() );
+      image->fill( 0 );
+
+      std::unique_ptr< QPainter > levelPainter( new QPainter( image.get() ) );
+      levelPainter->setRenderHints( painter->renderHints() );
+      levelPainter->setWorldTransform( painter->worldTransform() );
+      levelPainter->setOpacity( painter->opacity() );
+
+      levelImages.emplace_back( std::move( image ) );
+      levelPainters.emplace_back( std::move( levelPainter ) );
+    }
+    drawingToLevelImages = true;
+
+    // draw the features collected so far
+    for ( auto it = features.constBegin(); it != features.constEnd(); ++it )
+    {
+      Q_FOREACH ( const QgsFeature &feature, it.value() )
+      {
+        drawFeatureToLevelImages( feature, it.key() );
+      }
+    }
+    features.clear();
+
+    QgsDebugMsgLevel( QString( "Drawing symbol levels of layer %1 into separate images" ).arg( layerId() ), 2 );
+  };
+
   QgsExpressionContextScope *symbolScope = QgsExpressionContextUtils::updateSymbolScope( nullptr, new QgsExpressionContextScope() );
   mContext.expressionContext().appendScope( symbolScope );
 
   // 1. fetch features
+  int bufferedCount = 0;
   QgsFeature fet;
   while ( fit.nextFeature( fet ) )
   {
@@ -363,14 +464,27 @@ void QgsVectorLayerRenderer::drawRendererLevels( QgsFeatureIterator &fit )
       continue;
     }
 
-    if ( !features.contains( sym ) )
+    if ( drawingToLevelImages )
     {
-      features.insert( sym, QList<QgsFeature>() );
+      drawFeatureToLevelImages( fet, sym );
+    }
+    else
+    {
+      if ( !features.contains( sym ) )
+      {
+        features.insert( sym, QList<QgsFeature>() );
+      }
+      features[sym].append( fet );
+
+      if ( ++bufferedCount > mSymbolLevelsBufferLimit && mSymbolLevelsBufferLimit >= 0 && canDrawLevelsToImages() )
+      {
+        startDrawingToLevelImages();
+        mContext.expressionContext().setFeature( fet );
+      }
     }
-    features[sym].append( fet );
 
     // new labeling engine
-    if ( mContext.labelingEngine() )
+    if ( mContext.labelingEngine() && isInLabelRegion( fet ) )
     {
       QgsGeometry obstacleGeometry;
       QgsSymbolList symbols = mRenderer->originalSymbolsForFeature( fet, mContext );
@@ -385,35 +499,28 @@ void QgsVectorLayerRenderer::drawRendererLevels( QgsFeatureIterator &fit )
         QgsExpressionContextUtils::updateSymbolScope( symbols.at( 0 ), symbolScope );
       }
 
-      if ( mLabelProvider )
-      {
-        mLabelProvider->registerFeature( fet, mContext, obstacleGeometry );
-      }
-      if ( mDiagramProvider )
-      {
-        mDiagramProvider->registerFeature( fet, mContext, obstacleGeometry );
-      }
+      registerLabelFeature( fet, obstacleGeometry );
     }
   }
 
   delete mContext.expressionContext().popScope();
 
-  // find out the order
-  QgsSymbolLevelOrder levels;
-  QgsSymbolList symbols = mRenderer->symbols( mContext );
-  for ( int i = 0; i < symbols.count(); i++ )
+  if ( drawingToLevelImages )
   {
-    QgsSymbol *sym = symbols[i];
-    for ( int j = 0; j < sym->symbolLayerCount(); j++ )
+    // 2. composite the levels in correct order
+    levelPainters.clear();
+    painter->save();
+    painter->resetTransform();
+    painter->setOpacity( 1.0 );
+    for ( const std::unique_ptr< QImage > &image : levelImages )
     {
-      int level = sym->symbolLayer( j )->renderingPass();
-      if ( level < 0 || level >= 1000 ) // ignore invalid levels
-        continue;
-      QgsSymbolLevelItem item( sym, j );
-      while ( level >= levels.count() ) // append new empty levels
-        levels.append( QgsSymbolLevel() );
-      levels[level].append( item );
+      if ( image )
+        painter->drawImage( 0, 0, *image );
     }
+    painter->restore();
+
+    stopRenderer( selRenderer );
+    return;
   }
 
   // 2. draw features in correct order
@@ -439,22 +546,7 @@ void QgsVectorLayerRenderer::drawRendererLevels( QgsFeatureIterator &fit )
           return;
         }
 
-        bool sel = mContext.showSelection() && mSelectedFeatureIds.contains( fit->id() );
-        // maybe vertex markers should be drawn only during the last pass...
-        bool drawMarker = ( mDrawVertexMarkers && mContext.drawEditingInformation() && ( !mVertexMarkerOnlyForSelection || sel ) );
-
-        mContext.expressionContext().setFeature( *fit );
-
-        try
-        {
-          mRenderer->renderFeature( *fit, mContext, layer, sel, drawMarker );
-        }
-        catch ( const QgsCsException &cse )
-        {
-          Q_UNUSED( cse );
-          QgsDebugMsg( QString( "Failed to transform a point while drawing a feature with ID '%1'. Ignoring this feature. %2" )
-                       .arg( fet.id() ).arg( cse.what() ) );
-        }
+        drawFeature( *fit, layer );
       }
     }
   }
@@ -462,6 +554,76 @@ void QgsVectorLayerRenderer::drawRendererLevels( QgsFeatureIterator &fit )
   stopRenderer( selRenderer );
 }
 
+bool QgsVectorLayerRenderer::canDrawLevelsToImages() const
+{
+  // the levels are composited with plain alpha blending, other devices (e.g. pictures
+  // recorded for paint effects or vector output) have to get the features directly
+  const QPainter *painter = mContext.painter();
+  return painter && painter->device() && painter->device()->devType() == QInternal::Image
+         && painter->compositionMode() == QPainter::CompositionMode_SourceOver;
+}
+
+
+void QgsVectorLayerRenderer::setLabelRegion( const QgsRectangle &region, const QgsRectangle &fullExtent )
+{
+  mHasLabelRegion = true;
+  mLabelRegion = region;
+  mLabelFullExtent = fullExtent;
+}
+
+void QgsVectorLayerRenderer::setLabelProviders( QgsVectorLayerRenderer *renderer )
+{
+  mLabelProvider = renderer->mLabelProvider;
+  mDiagramProvider = renderer->mDiagramProvider;
+  // the attributes required by the providers have been added when preparing them
+  mAttrNames.unite( renderer->mAttrNames );
+
+  if ( !renderer->mLabelMutex )
+    renderer->mLabelMutex = std::make_shared< QMutex >();
+  mLabelMutex = renderer->mLabelMutex;
+}
+
+void QgsVectorLayerRenderer::registerLabelFeature( const QgsFeature &feature, const QgsGeometry &obstacleGeometry )
+{
+  // does nothing if the providers are not shared
+  QMutexLocker locker( mLabelMutex.get() );
+
+  if ( mLabelProvider )
+  {
+    mLabelProvider->registerFeature( feature, mContext, obstacleGeometry );
+  }
+  if ( mDiagramProvider )
+  {
+    mDiagramProvider->registerFeature( feature, mContext, obstacleGeometry );
+  }
+}
+
+bool QgsVectorLayerRenderer::isInLabelRegion( const QgsFeature &feature ) const
+{
+  if ( !mHasLabelRegion )
+    return true;
+
+  // features which cannot be transformed are assigned to the top left corner, so that
+  // exactly one region still picks them up
+  QgsPointXY center( mLabelFullExtent.xMinimum(), mLabelFullExtent.yMaximum() );
+  try
+  {
+    center = feature.geometry().boundingBox().center();
+    const QgsCoordinateTransform ct = mContext.coordinateTransform();
+    if ( ct.isValid() )
+      center = ct.transform( center );
+  }
+  catch ( QgsCsException & )
+  {
+    center = QgsPointXY( mLabelFullExtent.xMinimum(), mLabelFullExtent.yMaximum() );
+  }
+
+  const double x = qBound( mLabelFullExtent.xMinimum(), center.x(), mLabelFullExtent.xMaximum() );
+  const double y = qBound( mLabelFullExtent.yMinimum(), center.y(), mLabelFullExtent.yMaximum() );
+
+  return x >= mLabelRegion.xMinimum() && ( x < mLabelRegion.xMaximum() || mLabelRegion.xMaximum() >= mLabelFullExtent.xMaximum() )
+         && y >= mLabelRegion.yMinimum() && ( y < mLabelRegion.yMaximum() || mLabelRegion.yMaximum() >= mLabelFullExtent.yMaximum() );
+}
 
 void QgsVectorLayerRenderer::stopRenderer( QgsSingleSymbolRenderer *selRenderer )
 {
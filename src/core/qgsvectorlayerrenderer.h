@@ -30,8 +30,11 @@ class QgsSingleSymbolRenderer;
 #define SIP_NO_FILE
 
 #include <QList>
+#include <QMutex>
 #include <QPainter>
 
+#include <memory>
+
 typedef QList<int> QgsAttributeList;
 
 #include "qgis.h"
@@ -73,8 +76,58 @@ class QgsVectorLayerRenderer : public QgsMapLayerRenderer
 
     virtual bool render() override;
 
+    /**
+     * Restricts registration of labels and diagrams to features whose bounding box center
+     * (in map coordinates, clamped to \a fullExtent) lies inside \a region.
+     *
+     * Used when a layer is split into several regions which are rendered by separate
+     * renderers, so that every feature is still labeled exactly once. The regions are
+     * treated as half-open, except for edges which coincide with the edges of \a fullExtent.
+     * \since QGIS 3.0
+     */
+    void setLabelRegion( const QgsRectangle &region, const QgsRectangle &fullExtent );
+
+    /**
+     * Registers labels and diagrams with the label and diagram providers of \a renderer instead
+     * of providers of its own.
+     *
+     * Used for renderers which draw other regions of the same layer (see setLabelRegion()), so
+     * that the features of all regions are labeled by a single provider and every feature
+     * of the whole extent is an obstacle for all labels of the layer. The renderer must have
+     * been created without a labeling engine, and both renderers may run in different threads.
+     * \since QGIS 3.0
+     */
+    void setLabelProviders( QgsVectorLayerRenderer *renderer );
+
+    /**
+     * Sets the maximum number of features which are kept in memory when drawing with symbol levels.
+     *
+     * Symbol levels are normally drawn by collecting all features first and then drawing them level
+     * by level. Once more than \a limit features have been collected, the renderer switches to drawing
+     * every level into an image of its own while iterating over the features, and composites the
+     * images in level order at the end. This keeps the memory use independent of the number of
+     * features. A negative \a limit disables the switch. The switch is only possible when drawing
+     * to an image without a feature blend mode or paint effect.
+     * \see symbolLevelsBufferLimit()
+     * \since QGIS 3.0
+     */
+    void setSymbolLevelsBufferLimit( int limit ) { mSymbolLevelsBufferLimit = limit; }
+
+    /**
+     * Returns the maximum number of features which are kept in memory when drawing with symbol levels.
+     * \see setSymbolLevelsBufferLimit()
+     * \since QGIS 3.0
+     */
+    int symbolLevelsBufferLimit() const { return mSymbolLevelsBufferLimit; }
+
   private:
 
+    //! Returns true if labels and diagrams should be registered for the \a feature, see setLabelRegion()
+    bool isInLabelRegion( const QgsFeature &feature ) const;
+
+    //! Registers the \a feature with the label and diagram providers
+    void registerLabelFeature( const QgsFeature &feature, const QgsGeometry &obstacleGeometry );
+
     /** Registers label and diagram layer
       \param layer diagram layer
       \param attributeNames attributes needed for labeling and diagrams will be added to the list
@@ -90,6 +143,9 @@ class QgsVectorLayerRenderer : public QgsMapLayerRenderer
      */
     void drawRendererLevels( QgsFeatureIterator &fit );
 
+    //! Returns true if symbol levels can be drawn into separate images and composited, see setSymbolLevelsBufferLimit()
+    bool canDrawLevelsToImages() const;
+
     //! Stop version 2 renderer and selected renderer (if required)
     void stopRenderer( QgsSingleSymbolRenderer *selRenderer );
 
@@ -135,6 +191,15 @@ class QgsVectorLayerRenderer : public QgsMapLayerRenderer
 
     QgsVectorSimplifyMethod mSimplifyMethod;
     bool mSimplifyGeometry;
+
+    int mSymbolLevelsBufferLimit = 50000;
+
+    bool mHasLabelRegion = false;
+    QgsRectangle mLabelRegion;
+    QgsRectangle mLabelFullExtent;
+
+    //! Serializes the registration of features for renderers sharing their providers, see setLabelProviders()
+    std::shared_ptr< QMutex > mLabelMutex;
 };
 
 
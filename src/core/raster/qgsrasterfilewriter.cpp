@@ -23,15 +23,222 @@
 #include "qgsrasterprojector.h"
 #include "qgsrasterdataprovider.h"
 #include "qgsrasternuller.h"
+#include "qgsrasterpipe.h"
 
 #include <QCoreApplication>
+#include <QFuture>
+#include <QMutex>
 #include <QProgressDialog>
 #include <QTextStream>
 #include <QMessageBox>
+#include <QThreadPool>
+#include <QtConcurrentMap>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
 
 #include <gdal.h>
 #include <cpl_string.h>
 
+///@cond PRIVATE
+
+//! Maximum size of the parts which are read ahead of the writer, in bytes
+static const qint64 MAX_READ_AHEAD_SIZE = 512 * 1024 * 1024;
+
+/**
+ * Reads the parts of an output raster through a pipe, in the order of QgsRasterIterator.
+ *
+ * When several threads are available, batches of parts are read in parallel through
+ * clones of the pipe, while the parts of the previous batch are handed out to the writer.
+ * The size of the batches is limited, so that at most MAX_READ_AHEAD_SIZE bytes are
+ * read ahead.
+ */
+class QgsRasterPartReader
+{
+  public:
+
+    //! A part of the output raster
+    struct Part
+    {
+      int left = 0;
+      int top = 0;
+      int cols = 0;
+      int rows = 0;
+      QgsRectangle extent;
+      //! One block per band, nullptr if reading was canceled. Owned by the receiver of the part.
+      QList< QgsRasterBlock * > blocks;
+    };
+
+    QgsRasterPartReader( const QgsRasterPipe *pipe, const QgsRasterInterface *input, int bandCount,
+                         int nCols, int nRows, const QgsRectangle &extent, int maxTileWidth, int maxTileHeight,
+                         QgsRasterBlockFeedback *feedback );
+    ~QgsRasterPartReader();
+
+    //! QgsRasterPartReader cannot be copied
+    QgsRasterPartReader( const QgsRasterPartReader &rh ) = delete;
+    //! QgsRasterPartReader cannot be copied
+    QgsRasterPartReader &operator=( const QgsRasterPartReader &rh ) = delete;
+
+    //! Returns the number of parts
+    int partCount() const { return static_cast< int >( mParts.size() ); }
+
+    //! Hands out the next \a part, returns false if all parts have been handed out
+    bool nextPart( Part &part );
+
+  private:
+
+    //! Reads the blocks of \a part from \a input
+    void readPart( Part &part, const QgsRasterInterface *input ) const;
+
+    //! Starts reading the batch following the parts which are available or being read
+    void readAhead();
+
+    const QgsRasterPipe *mPipe = nullptr;
+    const QgsRasterInterface *mInput = nullptr;
+    int mBandCount = 0;
+    QgsRasterBlockFeedback *mFeedback = nullptr;
+
+    std::vector< Part > mParts;
+    //! Index of the next part to hand out
+    int mNextPart = 0;
+
+    bool mParallel = false;
+    int mBatchSize = 1;
+    //! Parts before this index have been read
+    int mAvailableEnd = 0;
+    //! Parts between mAvailableEnd and this index are being read by mFuture
+    int mReadingEnd = 0;
+    QFuture< void > mFuture;
+
+    QMutex mPipeMutex;
+    std::vector< std::unique_ptr< QgsRasterPipe > > mPipeClones;
+    QList< QgsRasterPipe * > mIdlePipes;
+};
+
+QgsRasterPartReader::QgsRasterPartReader( const QgsRasterPipe *pipe, const QgsRasterInterface *input, int bandCount,
+    int nCols, int nRows, const QgsRectangle &extent, int maxTileWidth, int maxTileHeight,
+    QgsRasterBlockFeedback *feedback )
+  : mPipe( pipe )
+  , mInput( input )
+  , mBandCount( bandCount )
+  , mFeedback( feedback )
+{
+  //split the raster into parts like QgsRasterIterator does
+  if ( nCols > 0 && nRows > 0 )
+  {
+    for ( int top = 0; top < nRows; top += maxTileHeight )
+    {
+      for ( int left = 0; left < nCols; left += maxTileWidth )
+      {
+        Part part;
+        part.left = left;
+        part.top = top;
+        part.cols = std::min( maxTileWidth, nCols - left );
+        part.rows = std::min( maxTileHeight, nRows - top );
+
+        double xmin = extent.xMinimum() + left / static_cast< double >( nCols ) * extent.width();
+        double xmax = left + part.cols == nCols ? extent.xMaximum() :  // avoid extra FP math if not necessary
+                      extent.xMinimum() + ( left + part.cols ) / static_cast< double >( nCols ) * extent.width();
+        double ymin = top + part.rows == nRows ? extent.yMinimum() :  // avoid extra FP math if not necessary
+                      extent.yMaximum() - ( top + part.rows ) / static_cast< double >( nRows ) * extent.height();
+        double ymax = extent.yMaximum() - top / static_cast< double >( nRows ) * extent.height();
+        part.extent = QgsRectangle( xmin, ymin, xmax, ymax );
+        mParts.push_back( part );
+      }
+    }
+  }
+
+  // every thread reads through a clone of the pipe, which needs the whole pipe
+  const int threadCount = QThreadPool::globalInstance()->maxThreadCount();
+  mParallel = mPipe && mPipe->last() == mInput && threadCount > 1 && mParts.size() > 1;
+  if ( mParallel )
+  {
+    // the parts of the batch being written and of the batch being read are in memory at the same time
+    const qint64 partSize = static_cast< qint64 >( maxTileWidth ) * maxTileHeight * bandCount
+                            * std::max( 1, QgsRasterBlock::typeSize( mInput->dataType( 1 ) ) );
+    mBatchSize = static_cast< int >( std::max( static_cast< qint64 >( 1 ), std::min( static_cast< qint64 >( threadCount ), MAX_READ_AHEAD_SIZE / ( 2 * partSize ) ) ) );
+    readAhead();
+  }
+}
+
+QgsRasterPartReader::~QgsRasterPartReader()
+{
+  mFuture.waitForFinished();
+  for ( Part &part : mParts )
+  {
+    qDeleteAll( part.blocks );
+  }
+}
+
+bool QgsRasterPartReader::nextPart( Part &part )
+{
+  if ( mNextPart >= partCount() )
+  {
+    return false;
+  }
+
+  if ( !mParallel )
+  {
+    readPart( mParts[mNextPart], mInput );
+  }
+  else if ( mNextPart == mAvailableEnd )
+  {
+    mFuture.waitForFinished();
+    mAvailableEnd = mReadingEnd;
+    readAhead();
+  }
+
+  part = mParts[mNextPart];
+  mParts[mNextPart].blocks.clear();
+  ++mNextPart;
+  return true;
+}
+
+void QgsRasterPartReader::readPart( Part &part, const QgsRasterInterface *input ) const
+{
+  part.blocks.reserve( mBandCount );
+  for ( int i = 1; i <= mBandCount; ++i )
+  {
+    part.blocks << ( mFeedback && mFeedback->isCanceled() ? nullptr : input->block( i, part.extent, part.cols, part.rows, mFeedback ) );
+  }
+}
+
+void QgsRasterPartReader::readAhead()
+{
+  const int start = mReadingEnd;
+  mReadingEnd = std::min( start + mBatchSize, partCount() );
+  if ( start == mReadingEnd )
+  {
+    return;
+  }
+
+  mFuture = QtConcurrent::map( mParts.begin() + start, mParts.begin() + mReadingEnd, [this]( Part & part )
+  {
+    // a pipe can't be used from several threads at once, so every thread reads through a clone of its own
+    QgsRasterPipe *pipe = nullptr;
+    {
+      QMutexLocker locker( &mPipeMutex );
+      if ( !mIdlePipes.isEmpty() )
+      {
+        pipe = mIdlePipes.takeLast();
+      }
+      else
+      {
+        pipe = new QgsRasterPipe( *mPipe );
+        mPipeClones.emplace_back( pipe );
+      }
+    }
+
+    readPart( part, pipe->last() );
+
+    QMutexLocker locker( &mPipeMutex );
+    mIdlePipes << pipe;
+  } );
+}
+
+///@endcond
+
 QgsRasterDataProvider *QgsRasterFileWriter::createOneBandRaster( Qgis::DataType dataType, int width, int height, const QgsRectangle &extent, const QgsCoordinateReferenceSystem &crs )
 {
   if ( mTiledMode )
@@ -332,7 +539,6 @@ QgsRasterFileWriter::WriterError QgsRasterFileWriter::writeDataRaster( const Qgs
     QgsRasterDataProvider *destProvider,
     QgsRasterBlockFeedback *feedback )
 {
-  Q_UNUSED( pipe );
   Q_UNUSED( destHasNoDataValueList );
   QgsDebugMsgLevel( "Entered", 4 );
 
@@ -341,24 +547,18 @@ QgsRasterFileWriter::WriterError QgsRasterFileWriter::writeDataRaster( const Qgs
   int nBands = iface->bandCount();
   QgsDebugMsgLevel( QString( "nBands = %1" ).arg( nBands ), 4 );
 
-  //Get output map units per pixel
-  int iterLeft = 0;
-  int iterTop = 0;
-  int iterCols = 0;
-  int iterRows = 0;
-
-  QList<QgsRasterBlock *> blockList;
-  blockList.reserve( nBands );
   for ( int i = 1; i <= nBands; ++i )
   {
-    iter->startRasterRead( i, nCols, nRows, outputExtent );
-    blockList.push_back( nullptr );
     if ( destProvider && destHasNoDataValueList.value( i - 1 ) ) // no tiles
     {
       destProvider->setNoDataValue( i, destNoDataValueList.value( i - 1 ) );
     }
   }
 
+  // the parts are read in parallel ahead of the writer, and written in order from this thread
+  QgsRasterPartReader reader( pipe, iface, nBands, nCols, nRows, outputExtent, iter->maximumTileWidth(), iter->maximumTileHeight(), nullptr );
+  QgsRasterPartReader::Part part;
+
   int nParts = 0;
   int fileIndex = 0;
   if ( feedback )
@@ -368,49 +568,23 @@ QgsRasterFileWriter::WriterError QgsRasterFileWriter::writeDataRaster( const Qgs
     nParts = nPartsX * nPartsY;
   }
 
-  // hmm why is there a for(;;) here ..
-  // not good coding practice IMHO, it might be better to use [ for() and break ] or  [ while (test) ]
-  Q_FOREVER
+  while ( reader.nextPart( part ) )
   {
-    for ( int i = 1; i <= nBands; ++i )
-    {
-      if ( !iter->readNextRasterPart( i, iterCols, iterRows, &( blockList[i - 1] ), iterLeft, iterTop ) )
-      {
-        // No more parts, create VRT and return
-        if ( mTiledMode )
-        {
-          QString vrtFilePath( mOutputUrl + '/' + vrtFileName() );
-          writeVRT( vrtFilePath );
-          if ( mBuildPyramidsFlag == QgsRaster::PyramidsFlagYes )
-          {
-            buildPyramids( vrtFilePath );
-          }
-        }
-        else
-        {
-          if ( mBuildPyramidsFlag == QgsRaster::PyramidsFlagYes )
-          {
-            buildPyramids( mOutputUrl );
-          }
-        }
-
-        QgsDebugMsgLevel( "Done", 4 );
-        return NoError; //reached last tile, bail out
-      }
-      // TODO: verify if NoDataConflict happened, to do that we need the whole pipe or nuller interface
-    }
+    // TODO: verify if NoDataConflict happened, to do that we need the whole pipe or nuller interface
+    QList<QgsRasterBlock *> &blockList = part.blocks;
+    const int iterLeft = part.left;
+    const int iterTop = part.top;
+    const int iterCols = part.cols;
+    const int iterRows = part.rows;
 
     if ( feedback && fileIndex < ( nParts - 1 ) )
     {
       feedback->setProgress( 100.0 * fileIndex / static_cast< double >( nParts ) );
-      if ( feedback->isCanceled() )
-      {
-        for ( int i = 0; i < nBands; ++i )
-        {
-          delete blockList[i];
-        }
-        break;
-      }
+    }
+    if ( feedback && feedback->isCanceled() )
+    {
+      qDeleteAll( blockList );
+      break;
     }
 
     // It may happen that internal data type (dataType) is wider than destDataType
@@ -465,8 +639,32 @@ QgsRasterFileWriter::WriterError QgsRasterFileWriter::writeDataRaster( const Qgs
     ++fileIndex;
   }
 
+  if ( feedback && feedback->isCanceled() )
+  {
+    QgsDebugMsgLevel( "Canceled", 4 );
+    return WriteCanceled;
+  }
+
+  // No more parts, create VRT and return
+  if ( mTiledMode )
+  {
+    QString vrtFilePath( mOutputUrl + '/' + vrtFileName() );
+    writeVRT( vrtFilePath );
+    if ( mBuildPyramidsFlag == QgsRaster::PyramidsFlagYes )
+    {
+      buildPyramids( vrtFilePath );
+    }
+  }
+  else
+  {
+    if ( mBuildPyramidsFlag == QgsRaster::PyramidsFlagYes )
+    {
+      buildPyramids( mOutputUrl );
+    }
+  }
+
   QgsDebugMsgLevel( "Done", 4 );
-  return ( feedback && feedback->isCanceled() ) ? WriteCanceled : NoError;
+  return NoError;
 }
 
 QgsRasterFileWriter::WriterError QgsRasterFileWriter::writeImageRaster( QgsRasterIterator *iter, int nCols, int nRows, const QgsRectangle &outputExtent,
@@ -495,8 +693,6 @@ QgsRasterFileWriter::WriterError QgsRasterFileWriter::writeImageRaster( QgsRaste
   void *greenData = qgsMalloc( mMaxTileWidth * mMaxTileHeight );
   void *blueData = qgsMalloc( mMaxTileWidth * mMaxTileHeight );
   void *alphaData = qgsMalloc( mMaxTileWidth * mMaxTileHeight );
-  QgsRectangle mapRect;
-  int iterLeft = 0, iterTop = 0, iterCols = 0, iterRows = 0;
   int fileIndex = 0;
 
   //create destProvider for whole dataset here
@@ -507,7 +703,9 @@ QgsRasterFileWriter::WriterError QgsRasterFileWriter::writeImageRaster( QgsRaste
 
   destProvider = initOutput( nCols, nRows, crs, geoTransform, 4, Qgis::Byte );
 
-  iter->startRasterRead( 1, nCols, nRows, outputExtent, feedback );
+  // the parts are read in parallel ahead of the writer, and written in order from this thread
+  QgsRasterPartReader reader( mPipe, iface, 1, nCols, nRows, outputExtent, iter->maximumTileWidth(), iter->maximumTileHeight(), feedback );
+  QgsRasterPartReader::Part part;
 
   int nParts = 0;
   if ( feedback )
@@ -517,22 +715,27 @@ QgsRasterFileWriter::WriterError QgsRasterFileWriter::writeImageRaster( QgsRaste
     nParts = nPartsX * nPartsY;
   }
 
-  QgsRasterBlock *inputBlock = nullptr;
-  while ( iter->readNextRasterPart( 1, iterCols, iterRows, &inputBlock, iterLeft, iterTop ) )
+  while ( reader.nextPart( part ) )
   {
-    if ( !inputBlock )
-    {
-      continue;
-    }
+    QgsRasterBlock *inputBlock = part.blocks.value( 0 );
+    const int iterLeft = part.left;
+    const int iterTop = part.top;
+    const int iterCols = part.cols;
+    const int iterRows = part.rows;
 
     if ( feedback && fileIndex < ( nParts - 1 ) )
     {
       feedback->setProgress( 100.0 * fileIndex / static_cast< double >( nParts ) );
-      if ( feedback->isCanceled() )
-      {
-        delete inputBlock;
-        break;
-      }
+    }
+    if ( feedback && feedback->isCanceled() )
+    {
+      delete inputBlock;
+      break;
+    }
+
+    if ( !inputBlock )
+    {
+      continue;
     }
 
     //fill into red/green/blue/alpha channels
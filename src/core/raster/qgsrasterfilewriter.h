@@ -81,6 +81,7 @@ class CORE_EXPORT QgsRasterFileWriter
         int nBands ) SIP_FACTORY;
 
     /** Write raster file
+        The parts of the raster are read through clones of the pipe in parallel, and written in order.
         \param pipe raster pipe
         \param nCols number of output columns
         \param nRows number of output rows (or -1 to automatically calculate row number to have square pixels)
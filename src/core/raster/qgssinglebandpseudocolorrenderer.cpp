@@ -26,6 +26,149 @@
 #include <QDomElement>
 #include <QImage>
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+///@cond PRIVATE
+
+//! Returns the premultiplied color of \a value, or \a defaultColor if the shader does not handle the value
+static QRgb _shadedColor( QgsRasterShader *shader, double value, QRgb defaultColor )
+{
+  int red, green, blue, alpha;
+  if ( !shader->shade( value, &red, &green, &blue, &alpha ) )
+  {
+    return defaultColor;
+  }
+
+  if ( alpha < 255 )
+  {
+    // Working with premultiplied colors, so multiply values by alpha
+    red *= ( alpha / 255.0 );
+    blue *= ( alpha / 255.0 );
+    green *= ( alpha / 255.0 );
+  }
+  return qRgba( red, green, blue, alpha );
+}
+
+/**
+ * Shades a block of integer values using a color lookup table covering the value
+ * range of the block. Returns false if the value range is too large for a lookup
+ * table to pay off.
+ */
+template <typename T>
+static bool _shadeIntegerBlock( const T *data, qgssize count, const QgsRasterBlock &block, QgsRasterShader *shader, QRgb defaultColor, unsigned int *output )
+{
+  // no data value, if it can be represented by T at all
+  const double noDataValue = block.noDataValue();
+  const bool hasNoDataValue = block.hasNoDataValue() && std::floor( noDataValue ) == noDataValue
+                              && noDataValue >= std::numeric_limits<T>::lowest() && noDataValue <= std::numeric_limits<T>::max();
+  const T noData = hasNoDataValue ? static_cast< T >( noDataValue ) : 0;
+
+  T minValue = std::numeric_limits<T>::max();
+  T maxValue = std::numeric_limits<T>::lowest();
+  for ( qgssize i = 0; i < count; ++i )
+  {
+    const T value = data[i];
+    if ( hasNoDataValue && value == noData )
+      continue;
+    minValue = std::min( minValue, value );
+    maxValue = std::max( maxValue, value );
+  }
+
+  if ( minValue > maxValue )
+  {
+    // no data only
+    std::fill( output, output + count, defaultColor );
+    return true;
+  }
+
+  // building the table costs one shade() call per value, only worth it if there are fewer values than pixels
+  const qint64 tableSize = static_cast< qint64 >( maxValue ) - minValue + 1;
+  if ( static_cast< qgssize >( tableSize ) > count )
+    return false;
+
+  QVector< QRgb > table( tableSize );
+  for ( qint64 i = 0; i < tableSize; ++i )
+  {
+    table[i] = _shadedColor( shader, static_cast< double >( minValue + i ), defaultColor );
+  }
+
+  const QRgb *tableData = table.constData();
+  for ( qgssize i = 0; i < count; ++i )
+  {
+    const T value = data[i];
+    output[i] = hasNoDataValue && value == noData ? defaultColor : tableData[ static_cast< qint64 >( value ) - minValue ];
+  }
+  return true;
+}
+
+//! Number of entries of the quantized color lookup table of floating point blocks
+static const int FLOAT_TABLE_SIZE = 16384;
+
+/**
+ * Shades a block of floating point values. Neighboring pixels often have the
+ * same value (flat areas, classified data), so the last shaded value is reused.
+ *
+ * Interpolated color ramps change smoothly with the value, so for large blocks
+ * the values within the shader's minimum and maximum are quantized to a lookup
+ * table of FLOAT_TABLE_SIZE colors. Discrete and exact color ramps, other shader
+ * functions and the values outside this range are shaded exactly.
+ */
+template <typename T>
+static void _shadeFloatBlock( const T *data, qgssize count, const QgsRasterBlock &block, QgsRasterShader *shader, QRgb defaultColor, unsigned int *output )
+{
+  const bool hasNoDataValue = block.hasNoDataValue();
+  const double noDataValue = block.noDataValue();
+
+  const QgsColorRampShader *rampShader = dynamic_cast< const QgsColorRampShader * >( shader->rasterShaderFunction() );
+  const double tableMin = rampShader ? rampShader->minimumValue() : 0.0;
+  const double tableMax = rampShader ? rampShader->maximumValue() : 0.0;
+  // building the table costs one shade() call per entry, only worth it for blocks with many more pixels
+  const bool useTable = rampShader && rampShader->colorRampType() == QgsColorRampShader::Interpolated
+                        && count >= 4 * static_cast< qgssize >( FLOAT_TABLE_SIZE )
+                        && std::isfinite( tableMin ) && std::isfinite( tableMax ) && tableMin < tableMax;
+  QVector< QRgb > table;
+  double tableScale = 0.0;
+  if ( useTable )
+  {
+    table.resize( FLOAT_TABLE_SIZE );
+    tableScale = FLOAT_TABLE_SIZE / ( tableMax - tableMin );
+    // each entry holds the color of the center of its value interval
+    for ( int i = 0; i < FLOAT_TABLE_SIZE; ++i )
+    {
+      table[i] = _shadedColor( shader, tableMin + ( i + 0.5 ) / tableScale, defaultColor );
+    }
+  }
+  const QRgb *tableData = table.constData();
+
+  double lastValue = std::numeric_limits<double>::quiet_NaN();
+  QRgb lastColor = defaultColor;
+  for ( qgssize i = 0; i < count; ++i )
+  {
+    const double value = data[i];
+    if ( value == lastValue )
+    {
+      output[i] = lastColor;
+    }
+    else if ( hasNoDataValue && QgsRasterBlock::isNoDataValue( value, noDataValue ) )
+    {
+      output[i] = defaultColor;
+    }
+    else
+    {
+      lastValue = value;
+      if ( useTable && value >= tableMin && value <= tableMax )
+        lastColor = tableData[ std::min( static_cast< int >( ( value - tableMin ) * tableScale ), FLOAT_TABLE_SIZE - 1 )];
+      else
+        lastColor = _shadedColor( shader, value, defaultColor );
+      output[i] = lastColor;
+    }
+  }
+}
+
+///@endcond
+
 QgsSingleBandPseudoColorRenderer::QgsSingleBandPseudoColorRenderer( QgsRasterInterface *input, int band, QgsRasterShader *shader )
   : QgsRasterRenderer( input, QStringLiteral( "singlebandpseudocolor" ) )
   , mShader( shader )
@@ -235,6 +378,13 @@ QgsRasterBlock *QgsSingleBandPseudoColorRenderer::block( int bandNo, QgsRectangl
 
   QRgb myDefaultColor = NODATA_COLOR;
 
+  //rows are shaded directly on the block data, avoiding the per pixel data type
+  //dispatch of QgsRasterBlock::value() and QgsRasterBlock::setColor()
+  if ( !hasTransparency && shadeBlock( *inputBlock, outputBlock.get() ) )
+  {
+    return outputBlock.release();
+  }
+
   for ( qgssize i = 0; i < ( qgssize )width * height; i++ )
   {
     if ( inputBlock->isNoData( i ) )
@@ -282,6 +432,60 @@ QgsRasterBlock *QgsSingleBandPseudoColorRenderer::block( int bandNo, QgsRectangl
   return outputBlock.release();
 }
 
+bool QgsSingleBandPseudoColorRenderer::shadeBlock( QgsRasterBlock &inputBlock, QgsRasterBlock *outputBlock ) const
+{
+  const qgssize count = static_cast< qgssize >( inputBlock.width() ) * inputBlock.height();
+  const void *data = inputBlock.bits();
+  unsigned int *outputData = reinterpret_cast< unsigned int * >( outputBlock->bits() );
+  if ( !data || !outputData )
+    return false;
+
+  QgsRasterShader *shader = mShader.get();
+  const QRgb defaultColor = NODATA_COLOR;
+  switch ( inputBlock.dataType() )
+  {
+    case Qgis::Byte:
+      if ( !_shadeIntegerBlock( static_cast< const quint8 * >( data ), count, inputBlock, shader, defaultColor, outputData ) )
+        return false;
+      break;
+    case Qgis::UInt16:
+      if ( !_shadeIntegerBlock( static_cast< const quint16 * >( data ), count, inputBlock, shader, defaultColor, outputData ) )
+        return false;
+      break;
+    case Qgis::Int16:
+      if ( !_shadeIntegerBlock( static_cast< const qint16 * >( data ), count, inputBlock, shader, defaultColor, outputData ) )
+        return false;
+      break;
+    case Qgis::UInt32:
+      if ( !_shadeIntegerBlock( static_cast< const quint32 * >( data ), count, inputBlock, shader, defaultColor, outputData ) )
+        return false;
+      break;
+    case Qgis::Int32:
+      if ( !_shadeIntegerBlock( static_cast< const qint32 * >( data ), count, inputBlock, shader, defaultColor, outputData ) )
+        return false;
+      break;
+    case Qgis::Float32:
+      _shadeFloatBlock( static_cast< const float * >( data ), count, inputBlock, shader, defaultColor, outputData );
+      break;
+    case Qgis::Float64:
+      _shadeFloatBlock( static_cast< const double * >( data ), count, inputBlock, shader, defaultColor, outputData );
+      break;
+    default:
+      return false;
+  }
+
+  // pixels flagged in the no data bitmap rather than by a no data value
+  if ( inputBlock.hasNoData() && !inputBlock.hasNoDataValue() )
+  {
+    for ( qgssize i = 0; i < count; ++i )
+    {
+      if ( inputBlock.isNoData( i ) )
+        outputData[i] = defaultColor;
+    }
+  }
+  return true;
+}
+
 void QgsSingleBandPseudoColorRenderer::writeXml( QDomDocument &doc, QDomElement &parentElem ) const
 {
   if ( parentElem.isNull() )
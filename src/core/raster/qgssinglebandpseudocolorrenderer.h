@@ -105,6 +105,13 @@ class CORE_EXPORT QgsSingleBandPseudoColorRenderer: public QgsRasterRenderer
     std::unique_ptr< QgsRasterShader > mShader;
     int mBand;
 
+    /**
+     * Shades \a inputBlock into \a outputBlock without user defined transparency,
+     * working directly on the block data. Returns false if the block data type
+     * or value range is not supported, in which case nothing is written.
+     */
+    bool shadeBlock( QgsRasterBlock &inputBlock, QgsRasterBlock *outputBlock ) const;
+
     // Minimum and maximum values used for automatic classification, these
     // values are not used by renderer in rendering process
     double mClassificationMin;
@@ -24,6 +24,7 @@
 
 #include "qgslogger.h"
 #include "qgsrendercontext.h" // for bigSymbolPreview
+#include "qgsapproximatecoordinatetransform.h"
 
 #include "qgsproject.h"
 #include "qgsstyle.h"
@@ -122,7 +123,11 @@ QPolygonF QgsSymbol::_getLineString( QgsRenderContext &context, const QgsCurve &
   }
 
   //transform the QPolygonF to screen coordinates
-  if ( ct.isValid() )
+  if ( const QgsApproximateCoordinateTransform *approximateTransform = context.approximateTransform() )
+  {
+    approximateTransform->transformPolygon( pts );
+  }
+  else if ( ct.isValid() )
   {
     ct.transformPolygon( pts );
   }
@@ -158,7 +163,11 @@ QPolygonF QgsSymbol::_getPolygonRing( QgsRenderContext &context, const QgsCurve
   }
 
   //transform the QPolygonF to screen coordinates
-  if ( ct.isValid() )
+  if ( const QgsApproximateCoordinateTransform *approximateTransform = context.approximateTransform() )
+  {
+    approximateTransform->transformPolygon( poly );
+  }
+  else if ( ct.isValid() )
   {
     ct.transformPolygon( poly );
   }
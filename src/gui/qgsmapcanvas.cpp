@@ -139,8 +139,11 @@ QgsMapCanvas::QgsMapCanvas( QWidget *parent )
     mSettings.setEllipsoid( QgsProject::instance()->ellipsoid() );
   } );
 
-  //segmentation parameters
   QgsSettings settings;
+  // approximate (sub-pixel accurate) reprojection of vector layers
+  mSettings.setFlag( QgsMapSettings::ApproximateVectorTransform, settings.value( QStringLiteral( "qgis/approximateVectorTransform" ), false ).toBool() );
+
+  //segmentation parameters
   double segmentationTolerance = settings.value( QStringLiteral( "qgis/segmentationTolerance" ), "0.01745" ).toDouble();
   QgsAbstractGeometry::SegmentationToleranceType toleranceType = QgsAbstractGeometry::SegmentationToleranceType( settings.value( QStringLiteral( "qgis/segmentationToleranceType" ), 0 ).toInt() );
   mSettings.setSegmentationTolerance( segmentationTolerance );
@@ -376,6 +379,9 @@ void QgsMapCanvas::setDestinationCrs( const QgsCoordinateReferenceSystem &crs )
   mSettings.setDestinationCrs( crs );
   updateScale();
 
+  // cached images of a panned map would otherwise be reused if the extent keeps its size
+  clearCache();
+
   QgsDebugMsg( "refreshing after destination CRS changed" );
   refresh();
 
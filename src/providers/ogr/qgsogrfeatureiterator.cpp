@@ -176,6 +176,12 @@ QgsOgrFeatureIterator::QgsOgrFeatureIterator( QgsOgrFeatureSource *source, bool
     OGR_L_SetAttributeFilter( ogrLayer, nullptr );
   }
 
+  // let OGR skip the features before the requested offset, unless features are filtered or ordered locally
+  mOffsetApplied = mRequest.offset() > 0
+                   && ( request.filterType() == QgsFeatureRequest::FilterNone || ( request.filterType() == QgsFeatureRequest::FilterExpression && mExpressionCompiled ) )
+                   && mRequest.orderBy().isEmpty()
+                   && !( mRequest.flags() & QgsFeatureRequest::ExactIntersect )
+                   && mSource->mOgrGeometryTypeFilter == wkbUnknown;
 
   //start with first feature
   rewind();
@@ -290,6 +296,8 @@ bool QgsOgrFeatureIterator::rewind()
     return false;
 
   OGR_L_ResetReading( ogrLayer );
+  if ( mOffsetApplied )
+    OGR_L_SetNextByIndex( ogrLayer, mRequest.offset() );
 
   mFilterFidsIt = mFilterFids.constBegin();
 
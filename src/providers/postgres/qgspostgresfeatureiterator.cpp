@@ -25,6 +25,62 @@
 
 #include <QElapsedTimer>
 #include <QObject>
+#include <QtEndian>
+
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+///@cond PRIVATE
+
+/**
+ * Returns \a value as the double of its shortest decimal representation which gives
+ * the same float, like the text representation of float4 values does. E.g. 0.1f gives
+ * 0.1 rather than 0.100000001490116.
+ */
+static double _shortestFloatValue( float value )
+{
+  if ( value == 0 || !std::isfinite( value ) )
+    return value;
+
+  const double d = value;
+  const int exponent = static_cast< int >( std::floor( std::log10( std::fabs( d ) ) ) );
+  for ( int precision = FLT_DIG; precision <= 9; ++precision )
+  {
+    // round to precision significant digits, ties to even like printf. Powers of ten up to 1e22
+    // are exact doubles, so scaling with them gives the same double as parsing the decimal text.
+    const int scale = precision - 1 - exponent;
+    if ( scale > 22 || scale < -22 )
+      break;
+
+    double rounded;
+    if ( scale >= 0 )
+    {
+      const double factor = std::pow( 10.0, scale );
+      rounded = std::nearbyint( d * factor ) / factor;
+    }
+    else
+    {
+      const double factor = std::pow( 10.0, -scale );
+      rounded = std::nearbyint( d / factor ) * factor;
+    }
+    if ( static_cast< float >( rounded ) == value )
+      return rounded;
+  }
+
+  // very large or small magnitudes, go through the text representation
+  QString text;
+  for ( int precision = FLT_DIG; precision <= 9; ++precision )
+  {
+    text = QString::number( value, 'g', precision );
+    if ( text.toFloat() == value )
+      break;
+  }
+  return text.toDouble();
+}
+
+///@endcond
 
 QgsPostgresFeatureIterator::QgsPostgresFeatureIterator( QgsPostgresFeatureSource *source, bool ownSource, const QgsFeatureRequest &request )
   : QgsAbstractFeatureIteratorFromSource<QgsPostgresFeatureSource>( source, ownSource, request )
@@ -70,6 +126,7 @@ QgsPostgresFeatureIterator::QgsPostgresFeatureIterator( QgsPostgresFeatureSource
   }
 
   mCursorName = mConn->uniqueCursorName();
+  initAttributeEncodings();
   QString whereClause;
 
   bool limitAtProvider = ( mRequest.limit() >= 0 );
@@ -192,10 +249,16 @@ QgsPostgresFeatureIterator::QgsPostgresFeatureIterator( QgsPostgresFeatureSource
     mRequest.setSubsetOfAttributes( attrs );
   }
 
-  if ( !mOrderByCompiled )
+  // limit and offset can only be applied by the server if it also filters and orders the features
+  const bool pagingAtProvider = ( mRequest.filterType() != QgsFeatureRequest::FilterExpression || mExpressionCompiled )
+                                && ( mOrderByCompiled || mRequest.orderBy().isEmpty() );
+  if ( !pagingAtProvider )
     limitAtProvider = false;
+  const bool offsetAtProvider = pagingAtProvider && mRequest.offset() > 0;
 
-  bool success = declareCursor( whereClause, limitAtProvider ? mRequest.limit() : -1, false, orderByParts.join( QStringLiteral( "," ) ) );
+  bool success = declareCursor( whereClause, limitAtProvider ? mRequest.limit() : -1, false, orderByParts.join( QStringLiteral( "," ) ), offsetAtProvider ? mRequest.offset() : 0 );
+  if ( success )
+    mOffsetApplied = offsetAtProvider;
   if ( !success && useFallbackWhereClause )
   {
     //try with the fallback where clause, e.g., for cases when using compiled expression failed to prepare
@@ -252,14 +315,10 @@ bool QgsPostgresFeatureIterator::fetchFeature( QgsFeature &feature )
     QElapsedTimer timer;
     timer.start();
 
-    QString fetch = QStringLiteral( "FETCH FORWARD %1 FROM %2" ).arg( mFeatureQueueSize ).arg( mCursorName );
-    QgsDebugMsgLevel( QString( "fetching %1 features." ).arg( mFeatureQueueSize ), 4 );
-
     lock();
-    if ( mConn->PQsendQuery( fetch ) == 0 ) // fetch features asynchronously
-    {
-      QgsMessageLog::logMessage( QObject::tr( "Fetching from cursor %1 failed\nDatabase error: %2" ).arg( mCursorName, mConn->PQerrorMessage() ), QObject::tr( "PostGIS" ) );
-    }
+    if ( !mFetchPending )
+      sendFetch();
+    mFetchPending = false;
 
     QgsPostgresResult queryResult;
     for ( ;; )
@@ -278,7 +337,7 @@ bool QgsPostgresFeatureIterator::fetchFeature( QgsFeature &feature )
       if ( rows == 0 )
         continue;
 
-      mLastFetch = rows < mFeatureQueueSize;
+      mLastFetch = rows < mRequestedFetchSize;
 
       for ( int row = 0; row < rows; row++ )
       {
@@ -286,7 +345,6 @@ bool QgsPostgresFeatureIterator::fetchFeature( QgsFeature &feature )
         getFeature( queryResult, row, mFeatureQueue.back() );
       } // for each row in queue
     }
-    unlock();
 
     if ( timer.elapsed() > 500 && mFeatureQueueSize > 1 )
     {
@@ -296,6 +354,14 @@ bool QgsPostgresFeatureIterator::fetchFeature( QgsFeature &feature )
     {
       mFeatureQueueSize *= 2;
     }
+
+    // if enabled, let the server prepare the next batch while this one is consumed. This is
+    // only possible on connections which are not shared with other iterators.
+    if ( mSource->mPrefetch && !mLastFetch && !mFeatureQueue.empty() && !mIsTransactionConnection )
+    {
+      mFetchPending = sendFetch();
+    }
+    unlock();
   }
 
   if ( mFeatureQueue.empty() )
@@ -318,6 +384,35 @@ bool QgsPostgresFeatureIterator::fetchFeature( QgsFeature &feature )
   return true;
 }
 
+bool QgsPostgresFeatureIterator::sendFetch()
+{
+  mRequestedFetchSize = mFeatureQueueSize;
+  QString fetch = QStringLiteral( "FETCH FORWARD %1 FROM %2" ).arg( mFeatureQueueSize ).arg( mCursorName );
+  QgsDebugMsgLevel( QString( "fetching %1 features." ).arg( mFeatureQueueSize ), 4 );
+
+  if ( mConn->PQsendQuery( fetch ) == 0 ) // fetch features asynchronously
+  {
+    QgsMessageLog::logMessage( QObject::tr( "Fetching from cursor %1 failed\nDatabase error: %2" ).arg( mCursorName, mConn->PQerrorMessage() ), QObject::tr( "PostGIS" ) );
+    return false;
+  }
+  return true;
+}
+
+void QgsPostgresFeatureIterator::discardPendingFetch()
+{
+  if ( !mFetchPending )
+    return;
+
+  // the connection cannot be used for other queries until all results have been read
+  QgsPostgresResult queryResult;
+  do
+  {
+    queryResult = mConn->PQgetResult();
+  }
+  while ( queryResult.result() );
+  mFetchPending = false;
+}
+
 bool QgsPostgresFeatureIterator::nextFeatureFilterExpression( QgsFeature &f )
 {
   if ( !mExpressionCompiled )
@@ -379,6 +474,7 @@ bool QgsPostgresFeatureIterator::rewind()
   // move cursor to first record
 
   lock();
+  discardPendingFetch();
   mConn->PQexecNR( QStringLiteral( "move absolute 0 in %1" ).arg( mCursorName ) );
   unlock();
   mFeatureQueue.clear();
@@ -394,6 +490,7 @@ bool QgsPostgresFeatureIterator::close()
     return false;
 
   lock();
+  discardPendingFetch();
   mConn->closeCursor( mCursorName );
   unlock();
 
@@ -487,7 +584,7 @@ QString QgsPostgresFeatureIterator::whereClauseRect()
 
 
 
-bool QgsPostgresFeatureIterator::declareCursor( const QString &whereClause, long limit, bool closeOnFail, const QString &orderBy )
+bool QgsPostgresFeatureIterator::declareCursor( const QString &whereClause, long limit, bool closeOnFail, const QString &orderBy, long offset )
 {
   mFetchGeometry = ( !( mRequest.flags() & QgsFeatureRequest::NoGeometry ) || mFilterRequiresGeometry ) && !mSource->mGeometryColumn.isNull();
 #if 0
@@ -640,7 +737,7 @@ bool QgsPostgresFeatureIterator::declareCursor( const QString &whereClause, long
     if ( mSource->mPrimaryKeyAttrs.contains( idx ) )
       continue;
 
-    query += delim + mConn->fieldExpression( mSource->mFields.at( idx ) );
+    query += delim + attributeExpression( idx );
   }
 
   query += " FROM " + mSource->mQuery;
@@ -648,11 +745,14 @@ bool QgsPostgresFeatureIterator::declareCursor( const QString &whereClause, long
   if ( !whereClause.isEmpty() )
     query += QStringLiteral( " WHERE %1" ).arg( whereClause );
 
+  if ( !orderBy.isEmpty() )
+    query += QStringLiteral( " ORDER BY %1" ).arg( orderBy );
+
   if ( limit >= 0 )
     query += QStringLiteral( " LIMIT %1" ).arg( limit );
 
-  if ( !orderBy.isEmpty() )
-    query += QStringLiteral( " ORDER BY %1 " ).arg( orderBy );
+  if ( offset > 0 )
+    query += QStringLiteral( " OFFSET %1" ).arg( offset );
 
   lock();
   if ( !mConn->openCursor( mCursorName, query ) )
@@ -816,13 +916,142 @@ void QgsPostgresFeatureIterator::getFeatureAttribute( int idx, QgsPostgresResult
   if ( mSource->mPrimaryKeyAttrs.contains( idx ) )
     return;
 
-  const QgsField fld = mSource->mFields.at( idx );
-  QVariant v = QgsPostgresProvider::convertValue( fld.type(), fld.subType(), queryResult.PQgetvalue( row, col ) );
-  feature.setAttribute( idx, v );
+  const AttributeEncoding encoding = mAttributeEncodings.at( idx );
+  if ( encoding == EncodingText )
+  {
+    const QgsField fld = mSource->mFields.at( idx );
+    QVariant v = QgsPostgresProvider::convertValue( fld.type(), fld.subType(), queryResult.PQgetvalue( row, col ) );
+    feature.setAttribute( idx, v );
+  }
+  else if ( queryResult.PQgetisnull( row, col ) )
+  {
+    feature.setAttribute( idx, QVariant( mSource->mFields.at( idx ).type() ) );
+  }
+  else
+  {
+    // binary values are always sent in network byte order
+    const uchar *data = reinterpret_cast< const uchar * >( ::PQgetvalue( queryResult.result(), row, col ) );
+    QVariant v;
+    switch ( encoding )
+    {
+      case EncodingInt2:
+        v = static_cast< int >( qFromBigEndian<qint16>( data ) );
+        break;
+
+      case EncodingInt4:
+        v = qFromBigEndian<qint32>( data );
+        break;
+
+      case EncodingInt8:
+        v = qFromBigEndian<qint64>( data );
+        break;
+
+      case EncodingFloat4:
+      {
+        const quint32 bits = qFromBigEndian<quint32>( data );
+        float value;
+        memcpy( &value, &bits, sizeof( value ) );
+        v = _shortestFloatValue( value );
+        break;
+      }
+
+      case EncodingFloat8:
+      {
+        const quint64 bits = qFromBigEndian<quint64>( data );
+        double value;
+        memcpy( &value, &bits, sizeof( value ) );
+        v = value;
+        break;
+      }
+
+      case EncodingDate:
+      {
+        const qint32 days = qFromBigEndian<qint32>( data );
+        // +/- infinity are sent as the extreme values
+        if ( days == std::numeric_limits<qint32>::max() || days == std::numeric_limits<qint32>::min() )
+          v = QVariant( QVariant::Date );
+        else
+          v = QDate( 2000, 1, 1 ).addDays( days );
+        break;
+      }
+
+      case EncodingTime:
+        v = QTime( 0, 0 ).addMSecs( static_cast< int >( qFromBigEndian<qint64>( data ) / 1000 ) );
+        break;
+
+      case EncodingTimestamp:
+      {
+        const qint64 usecs = qFromBigEndian<qint64>( data );
+        if ( usecs == std::numeric_limits<qint64>::max() || usecs == std::numeric_limits<qint64>::min() )
+        {
+          v = QVariant( QVariant::DateTime );
+        }
+        else
+        {
+          // round towards negative infinity, so that times before 2000 stay on the right day
+          qint64 msecs = usecs / 1000;
+          if ( usecs % 1000 < 0 )
+            msecs--;
+          // timestamps without time zone are local times, calculate them in UTC so that
+          // daylight saving time changes are not applied
+          const QDateTime utc = QDateTime( QDate( 2000, 1, 1 ), QTime( 0, 0 ), Qt::UTC ).addMSecs( msecs );
+          v = QDateTime( utc.date(), utc.time() );
+        }
+        break;
+      }
+
+      case EncodingText:
+        break;
+    }
+    feature.setAttribute( idx, v );
+  }
 
   col++;
 }
 
+void QgsPostgresFeatureIterator::initAttributeEncodings()
+{
+  // date and time values are only sent as integers if the server was built with
+  // integer datetimes (the default since PostgreSQL 8.4), otherwise they are doubles
+  const char *integerDatetimes = ::PQparameterStatus( mConn->pgConnection(), "integer_datetimes" );
+  const bool binaryDatetimes = integerDatetimes && qstrcmp( integerDatetimes, "on" ) == 0;
+
+  mAttributeEncodings.fill( EncodingText, mSource->mFields.count() );
+  for ( int idx = 0; idx < mSource->mFields.count(); ++idx )
+  {
+    const QgsField &fld = mSource->mFields.at( idx );
+    const QString typeName = fld.typeName();
+
+    // only decode types whose QGIS field type matches the native value
+    if ( fld.type() == QVariant::Int && typeName == QLatin1String( "int2" ) )
+      mAttributeEncodings[ idx ] = EncodingInt2;
+    else if ( fld.type() == QVariant::Int && ( typeName == QLatin1String( "int4" ) || typeName == QLatin1String( "serial" ) ) )
+      mAttributeEncodings[ idx ] = EncodingInt4;
+    else if ( fld.type() == QVariant::LongLong && ( typeName == QLatin1String( "int8" ) || typeName == QLatin1String( "serial8" ) ) )
+      mAttributeEncodings[ idx ] = EncodingInt8;
+    else if ( fld.type() == QVariant::Double && ( typeName == QLatin1String( "float4" ) || typeName == QLatin1String( "real" ) ) )
+      mAttributeEncodings[ idx ] = EncodingFloat4;
+    else if ( fld.type() == QVariant::Double && ( typeName == QLatin1String( "float8" ) || typeName == QLatin1String( "double precision" ) ) )
+      mAttributeEncodings[ idx ] = EncodingFloat8;
+    else if ( fld.type() == QVariant::Date && typeName == QLatin1String( "date" ) )
+      mAttributeEncodings[ idx ] = EncodingDate;
+    else if ( binaryDatetimes && fld.type() == QVariant::Time && typeName == QLatin1String( "time" ) )
+      mAttributeEncodings[ idx ] = EncodingTime;
+    else if ( binaryDatetimes && fld.type() == QVariant::DateTime && typeName == QLatin1String( "timestamp" ) )
+      mAttributeEncodings[ idx ] = EncodingTimestamp;
+  }
+}
+
+QString QgsPostgresFeatureIterator::attributeExpression( int idx ) const
+{
+  const QgsField &fld = mSource->mFields.at( idx );
+  if ( mAttributeEncodings.at( idx ) == EncodingText )
+    return mConn->fieldExpression( fld );
+
+  // fetch the native value, which the binary cursor transfers without formatting it as text
+  return QgsPostgresConn::quotedIdentifier( fld.name() );
+}
+
 
 //  ------------------
 
@@ -842,6 +1071,7 @@ QgsPostgresFeatureSource::QgsPostgresFeatureSource( const QgsPostgresProvider *p
   , mQuery( p->mQuery )
   , mCrs( p->crs() )
   , mShared( p->mShared )
+  , mPrefetch( p->mPrefetch )
 {
   if ( mSqlWhereClause.startsWith( QLatin1String( " WHERE " ) ) )
     mSqlWhereClause = mSqlWhereClause.mid( 7 );
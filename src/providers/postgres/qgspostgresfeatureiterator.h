@@ -55,6 +55,9 @@ class QgsPostgresFeatureSource : public QgsAbstractFeatureSource
 
     std::shared_ptr<QgsPostgresSharedData> mShared;
 
+    //! Whether the next batch of features is requested while the current one is read
+    bool mPrefetch = false;
+
     /* The transaction connection (if any) gets refed/unrefed when creating/
      * destroying the QgsPostgresFeatureSource, to ensure that the transaction
      * connection remains valid during the life time of the feature source
@@ -89,10 +92,28 @@ class QgsPostgresFeatureIterator : public QgsAbstractFeatureIteratorFromSource<Q
     QgsPostgresConn *mConn = nullptr;
 
 
+    //! How an attribute value is transferred by the binary cursor
+    enum AttributeEncoding
+    {
+      EncodingText, //!< Cast to text on the server and converted by QgsPostgresProvider::convertValue
+      EncodingInt2, //!< Native smallint in network byte order
+      EncodingInt4, //!< Native integer or oid in network byte order
+      EncodingInt8, //!< Native bigint in network byte order
+      EncodingFloat4, //!< Native real in network byte order
+      EncodingFloat8, //!< Native double precision in network byte order
+      EncodingDate, //!< Native date, days since 2000-01-01
+      EncodingTime, //!< Native time, microseconds since midnight
+      EncodingTimestamp, //!< Native timestamp without time zone, microseconds since 2000-01-01
+    };
+
     QString whereClauseRect();
+    void initAttributeEncodings();
+    QString attributeExpression( int idx ) const;
+    bool sendFetch();
+    void discardPendingFetch();
     bool getFeature( QgsPostgresResult &queryResult, int row, QgsFeature &feature );
     void getFeatureAttribute( int idx, QgsPostgresResult &queryResult, int row, int &col, QgsFeature &feature );
-    bool declareCursor( const QString &whereClause, long limit = -1, bool closeOnFail = true, const QString &orderBy = QString() );
+    bool declareCursor( const QString &whereClause, long limit = -1, bool closeOnFail = true, const QString &orderBy = QString(), long offset = 0 );
 
     QString mCursorName;
 
@@ -105,6 +126,15 @@ class QgsPostgresFeatureIterator : public QgsAbstractFeatureIteratorFromSource<Q
     //! Maximal size of the feature queue
     int mFeatureQueueSize;
 
+    //! Number of features requested by the last FETCH sent to the server
+    int mRequestedFetchSize = 0;
+
+    //! Set to true, if a FETCH has been sent ahead of time and its result has not been read yet
+    bool mFetchPending = false;
+
+    //! Encoding of each attribute in the cursor
+    QVector<AttributeEncoding> mAttributeEncodings;
+
     //! Number of retrieved features
     int mFetched;
 
@@ -117,6 +117,11 @@ QgsPostgresProvider::QgsPostgresProvider( QString const &uri )
     }
   }
 
+  if ( mUri.hasParam( QStringLiteral( "prefetch" ) ) )
+  {
+    mPrefetch = mUri.param( QStringLiteral( "prefetch" ) ).compare( QLatin1String( "1" ) ) == 0;
+  }
+
   if ( mSchemaName.isEmpty() && mTableName.startsWith( '(' ) && mTableName.endsWith( ')' ) )
   {
     mIsQuery = true;
@@ -437,6 +437,9 @@ class QgsPostgresProvider : public QgsVectorDataProvider
 
     bool mCheckPrimaryKeyUnicity = true;
 
+    //! Whether feature iterators request the next batch of features ahead of time ("prefetch" uri parameter)
+    bool mPrefetch = false;
+
     std::unique_ptr< QgsPostgresListener > mListener;
 };
 
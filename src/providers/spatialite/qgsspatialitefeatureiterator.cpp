@@ -57,9 +57,9 @@ QgsSpatiaLiteFeatureIterator::QgsSpatiaLiteFeatureIterator( QgsSpatiaLiteFeature
     return;
   }
 
-  //beware - limitAtProvider needs to be set to false if the request cannot be completely handled
+  //beware - pagingAtProvider needs to be set to false if the request cannot be completely handled
   //by the provider (e.g., utilising QGIS expression filters)
-  bool limitAtProvider = ( mRequest.limit() >= 0 );
+  bool pagingAtProvider = true;
 
   if ( !mFilterRect.isNull() && !mSource->mGeometryColumn.isNull() )
   {
@@ -134,13 +134,13 @@ QgsSpatiaLiteFeatureIterator::QgsSpatiaLiteFeatureIterator( QgsSpatiaLiteFeature
       }
       if ( result != QgsSqlExpressionCompiler::Complete )
       {
-        //can't apply limit at provider side as we need to check all results using QGIS expressions
-        limitAtProvider = false;
+        //can't apply limit and offset at provider side as we need to check all results using QGIS expressions
+        pagingAtProvider = false;
       }
     }
     else
     {
-      limitAtProvider = false;
+      pagingAtProvider = false;
     }
   }
 
@@ -187,7 +187,7 @@ QgsSpatiaLiteFeatureIterator::QgsSpatiaLiteFeatureIterator( QgsSpatiaLiteFeature
   }
 
   if ( !mOrderByCompiled )
-    limitAtProvider = false;
+    pagingAtProvider = false;
 
   // also need attributes required by order by
   if ( !mOrderByCompiled && mRequest.flags() & QgsFeatureRequest::SubsetOfAttributes && !mRequest.orderBy().isEmpty() )
@@ -202,7 +202,9 @@ QgsSpatiaLiteFeatureIterator::QgsSpatiaLiteFeatureIterator( QgsSpatiaLiteFeature
   }
 
   // preparing the SQL statement
-  bool success = prepareStatement( whereClause, limitAtProvider ? mRequest.limit() : -1, orderByParts.join( QStringLiteral( "," ) ) );
+  bool success = prepareStatement( whereClause, pagingAtProvider ? mRequest.limit() : -1, orderByParts.join( QStringLiteral( "," ) ), pagingAtProvider ? mRequest.offset() : 0 );
+  if ( success )
+    mOffsetApplied = pagingAtProvider;
   if ( !success && useFallbackWhereClause )
   {
     //try with the fallback where clause, e.g., for cases when using compiled expression failed to prepare
@@ -305,7 +307,7 @@ bool QgsSpatiaLiteFeatureIterator::close()
 ////
 
 
-bool QgsSpatiaLiteFeatureIterator::prepareStatement( const QString &whereClause, long limit, const QString &orderBy )
+bool QgsSpatiaLiteFeatureIterator::prepareStatement( const QString &whereClause, long limit, const QString &orderBy, long offset )
 {
   if ( !mHandle )
     return false;
@@ -347,8 +349,12 @@ bool QgsSpatiaLiteFeatureIterator::prepareStatement( const QString &whereClause,
     if ( !orderBy.isEmpty() )
       sql += QStringLiteral( " ORDER BY %1" ).arg( orderBy );
 
-    if ( limit >= 0 )
-      sql += QStringLiteral( " LIMIT %1" ).arg( limit );
+    // SQLite only accepts an offset after a limit, where -1 means no limit
+    if ( limit >= 0 || offset > 0 )
+      sql += QStringLiteral( " LIMIT %1" ).arg( limit >= 0 ? limit : -1 );
+
+    if ( offset > 0 )
+      sql += QStringLiteral( " OFFSET %1" ).arg( offset );
 
     if ( sqlite3_prepare_v2( mHandle->handle(), sql.toUtf8().constData(), -1, &sqliteStatement, nullptr ) != SQLITE_OK )
     {
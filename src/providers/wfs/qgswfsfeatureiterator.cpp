@@ -807,7 +807,12 @@ QgsWFSFeatureIterator::QgsWFSFeatureIterator( QgsWFSFeatureSource *source,
   QgsFeatureRequest requestCache;
   if ( mRequest.filterType() == QgsFeatureRequest::FilterFid ||
        mRequest.filterType() == QgsFeatureRequest::FilterFids )
+  {
     requestCache = mRequest;
+    // the offset and limit are applied by this iterator, not by the cache
+    requestCache.setOffset( 0 );
+    requestCache.setLimit( -1 );
+  }
   else
   {
     if ( mRequest.filterType() == QgsFeatureRequest::FilterExpression )
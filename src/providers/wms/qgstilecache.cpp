@@ -17,45 +17,177 @@
 
 #include "qgsnetworkaccessmanager.h"
 #include "qgsapplication.h"
+#include "qgssettings.h"
+#include "qgstilestore.h"
 #include <QAbstractNetworkCache>
 #include <QImage>
+#include <QtConcurrentMap>
 
 QCache<QUrl, QImage> QgsTileCache::sTileCache( 256 );
 QMutex QgsTileCache::sTileCacheMutex;
+std::unique_ptr<QgsTileStore> QgsTileCache::sTileStore;
+bool QgsTileCache::sTileStoreInitialized = false;
+QMutex QgsTileCache::sTileStoreMutex;
 
 
-void QgsTileCache::insertTile( const QUrl &url, const QImage &image )
+static QImage decodeTile( const QByteArray &data )
 {
+  return QImage::fromData( data );
+}
+
+void QgsTileCache::insertTile( const QUrl &url, const QImage &image, const QByteArray &data )
+{
+  {
+    QMutexLocker locker( &sTileCacheMutex );
+    sTileCache.insert( url, new QImage( image ) );
+  }
+
+  if ( !data.isEmpty() )
+  {
+    if ( QgsTileStore *store = tileStore() )
+      store->insertTileData( url, data );
+  }
+}
+
+bool QgsTileCache::tile( const QUrl &url, QImage &image )
+{
+  {
+    QMutexLocker locker( &sTileCacheMutex );
+    if ( QImage *i = sTileCache.object( url ) )
+    {
+      image = *i;
+      return true;
+    }
+  }
+
+  // decode without holding the lock, other threads may use the in-memory cache meanwhile
+  QByteArray imageData = cachedTileData( url );
+  if ( imageData.isEmpty() )
+    return false;
+
+  image = decodeTile( imageData );
+
+  // cache it as well
+  // Check for null because it could be a redirect (see: https://issues.qgis.org/issues/16427 )
+  if ( image.isNull() )
+    return false;
+
   QMutexLocker locker( &sTileCacheMutex );
   sTileCache.insert( url, new QImage( image ) );
+  return true;
 }
 
-bool QgsTileCache::tile( const QUrl &url, QImage &image )
+QList<QImage> QgsTileCache::tiles( const QList<QUrl> &urls )
 {
+  QList<QImage> images;
+  images.reserve( urls.size() );
+  QList<int> missing;
+  {
+    QMutexLocker locker( &sTileCacheMutex );
+    for ( int i = 0; i < urls.size(); ++i )
+    {
+      if ( QImage *image = sTileCache.object( urls.at( i ) ) )
+      {
+        images << *image;
+      }
+      else
+      {
+        images << QImage();
+        missing << i;
+      }
+    }
+  }
+
+  // the disk caches have to be read from this thread (the network disk cache
+  // belongs to this thread's network access manager), only decoding is spread
+  QList<int> toDecode;
+  QList<QByteArray> data;
+  Q_FOREACH ( int i, missing )
+  {
+    QByteArray imageData = cachedTileData( urls.at( i ) );
+    if ( imageData.isEmpty() )
+      continue;
+
+    toDecode << i;
+    data << imageData;
+  }
+
+  if ( data.isEmpty() )
+    return images;
+
+  QList<QImage> decoded;
+  if ( data.size() == 1 )
+    decoded << decodeTile( data.at( 0 ) );
+  else
+    decoded = QtConcurrent::blockingMapped< QList<QImage> >( data, decodeTile );
+
   QMutexLocker locker( &sTileCacheMutex );
-  bool success = false;
-  if ( QImage *i = sTileCache.object( url ) )
+  for ( int k = 0; k < toDecode.size(); ++k )
   {
-    image = *i;
-    success = true;
+    const QImage &image = decoded.at( k );
+    // Check for null because it could be a redirect (see: https://issues.qgis.org/issues/16427 )
+    if ( image.isNull() )
+      continue;
+
+    images[ toDecode.at( k )] = image;
+    sTileCache.insert( urls.at( toDecode.at( k ) ), new QImage( image ) );
   }
-  else if ( QgsNetworkAccessManager::instance()->cache()->metaData( url ).isValid() )
+  return images;
+}
+
+bool QgsTileCache::hasTile( const QUrl &url )
+{
+  QMutexLocker locker( &sTileCacheMutex );
+  return sTileCache.contains( url );
+}
+
+QgsTileStore *QgsTileCache::tileStore()
+{
+  QMutexLocker locker( &sTileStoreMutex );
+  if ( !sTileStoreInitialized )
   {
-    if ( QIODevice *data = QgsNetworkAccessManager::instance()->cache()->data( url ) )
+    sTileStoreInitialized = true;
+
+    QgsSettings settings;
+    const qint64 size = settings.value( QStringLiteral( "cache/tileStoreSize" ), 0 ).toLongLong();
+    if ( size > 0 )
     {
-      QByteArray imageData = data->readAll();
-      delete data;
+      QString path = settings.value( QStringLiteral( "cache/tileStorePath" ) ).toString();
+      if ( path.isEmpty() )
+        path = QgsApplication::qgisSettingsDirPath() + "tiles.sqlite";
 
-      image = QImage::fromData( imageData );
+      sTileStore.reset( new QgsTileStore( path, size ) );
+      if ( !sTileStore->isValid() )
+        sTileStore.reset();
+    }
+  }
+  return sTileStore.get();
+}
 
-      // cache it as well (mutex is already locked)
-      // Check for null because it could be a redirect (see: https://issues.qgis.org/issues/16427 )
-      if ( ! image.isNull( ) )
-      {
-        sTileCache.insert( url, new QImage( image ) );
-        success = true;
-      }
+void QgsTileCache::setTileStore( QgsTileStore *store )
+{
+  QMutexLocker locker( &sTileStoreMutex );
+  sTileStoreInitialized = true;
+  sTileStore.reset( store );
+}
+
+QByteArray QgsTileCache::cachedTileData( const QUrl &url )
+{
+  QByteArray imageData;
+  QAbstractNetworkCache *cache = QgsNetworkAccessManager::instance()->cache();
+  if ( cache && cache->metaData( url ).isValid() )
+  {
+    if ( QIODevice *data = cache->data( url ) )
+    {
+      imageData = data->readAll();
+      delete data;
     }
   }
-  return success;
+
+  if ( imageData.isEmpty() )
+  {
+    if ( QgsTileStore *store = tileStore() )
+      imageData = store->tileData( url );
+  }
+  return imageData;
 }
@@ -18,13 +18,19 @@
 
 
 #include <QCache>
+#include <QList>
 #include <QMutex>
 
+#include <memory>
+
+class QByteArray;
 class QImage;
 class QUrl;
+class QgsTileStore;
 
 /** A simple tile cache implementation. Tiles are cached according to their URL.
- * There is a small in-memory cache and a secondary caching in the local disk.
+ * There is a small in-memory cache and a secondary caching in the local disk
+ * (the network disk cache and, if enabled, the persistent tile store).
  * The in-memory cache is there to save CPU time otherwise wasted to read and
  * uncompress data saved on the disk.
  *
@@ -34,23 +40,51 @@ class QgsTileCache
 {
   public:
 
-    //! Add a tile image with given URL to the cache
-    static void insertTile( const QUrl &url, const QImage &image );
+    //! Add a tile image with given URL to the cache. If the encoded tile \a data
+    //! is given, the tile is also written to the persistent tile store.
+    static void insertTile( const QUrl &url, const QImage &image, const QByteArray &data = QByteArray() );
 
     //! Try to access a tile and load it into "image" argument
     //! \returns true if the tile exists in the cache
     static bool tile( const QUrl &url, QImage &image );
 
+    //! Try to access the tiles for a list of URLs. Tiles which are only cached
+    //! on the disk are decoded in parallel on the global thread pool.
+    //! \returns the tile images in the order of the URLs, null images for tiles which are not cached
+    static QList<QImage> tiles( const QList<QUrl> &urls );
+
+    //! Returns true if the tile for the URL is in the in-memory cache
+    static bool hasTile( const QUrl &url );
+
+    //! Returns the persistent tile store, or nullptr if it is disabled.
+    //! The store is configured by the "cache/tileStorePath" and "cache/tileStoreSize" (in bytes) settings.
+    static QgsTileStore *tileStore();
+
+    //! Replaces the persistent tile store (ownership is transferred), nullptr disables it.
+    //! Must not be called while tiles are being loaded.
+    static void setTileStore( QgsTileStore *store );
+
     //! how many tiles are stored in the in-memory cache
     static int totalCost() { return sTileCache.totalCost(); }
     //! how many tiles can be stored in the in-memory cache
     static int maxCost() { return sTileCache.maxCost(); }
 
   private:
+
+    //! Reads the encoded tile from the network disk cache or the tile store
+    static QByteArray cachedTileData( const QUrl &url );
+
     //! in-memory cache
     static QCache<QUrl, QImage> sTileCache;
     //! mutex to protect the in-memory cache
     static QMutex sTileCacheMutex;
+
+    //! persistent tile store
+    static std::unique_ptr<QgsTileStore> sTileStore;
+    //! whether the tile store has been set up from the settings
+    static bool sTileStoreInitialized;
+    //! mutex to protect the initialization of the tile store
+    static QMutex sTileStoreMutex;
 };
 
 #endif // QGSTILECACHE_H
@@ -0,0 +1,141 @@
+/***************************************************************************
+  qgstileprefetcher.cpp
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstileprefetcher.h"
+
+#include "qgslogger.h"
+#include "qgsnetworkaccessmanager.h"
+#include "qgstilecache.h"
+
+#include <QCoreApplication>
+#include <QImage>
+#include <QNetworkReply>
+#include <QThread>
+
+//! Maximum number of prefetch requests running at the same time
+static const int MAX_RUNNING_REQUESTS = 4;
+
+QgsTilePrefetcher *QgsTilePrefetcher::instance()
+{
+  static QgsTilePrefetcher *sInstance = nullptr;
+  static QMutex sInstanceMutex;
+
+  QMutexLocker locker( &sInstanceMutex );
+  if ( !sInstance )
+  {
+    QThread *thread = new QThread();
+    thread->setObjectName( QStringLiteral( "QgsTilePrefetcher" ) );
+    sInstance = new QgsTilePrefetcher();
+    sInstance->moveToThread( thread );
+    QObject::connect( thread, &QThread::finished, sInstance, &QObject::deleteLater );
+    if ( QCoreApplication *app = QCoreApplication::instance() )
+    {
+      // stop downloading when the application quits
+      thread->moveToThread( app->thread() );
+      QObject::connect( app, &QCoreApplication::aboutToQuit, thread, [thread]
+      {
+        thread->quit();
+        thread->wait();
+      } );
+    }
+    thread->start();
+  }
+  return sInstance;
+}
+
+void QgsTilePrefetcher::prefetch( const QList<QNetworkRequest> &requests )
+{
+  {
+    QMutexLocker locker( &mMutex );
+    mQueue.clear();
+    Q_FOREACH ( const QNetworkRequest &request, requests )
+    {
+      if ( !mRunning.contains( request.url() ) && !QgsTileCache::hasTile( request.url() ) )
+        mQueue << request;
+    }
+    if ( mQueue.isEmpty() )
+      return;
+  }
+
+  QMetaObject::invokeMethod( this, "startRequests", Qt::QueuedConnection );
+}
+
+int QgsTilePrefetcher::pendingCount() const
+{
+  QMutexLocker locker( &mMutex );
+  return mQueue.count() + mRunning.count();
+}
+
+void QgsTilePrefetcher::startRequests()
+{
+  while ( true )
+  {
+    QNetworkRequest request;
+    {
+      QMutexLocker locker( &mMutex );
+      if ( mQueue.isEmpty() || mRunning.count() >= MAX_RUNNING_REQUESTS )
+        return;
+
+      request = mQueue.takeFirst();
+      if ( mRunning.contains( request.url() ) )
+        continue;
+      mRunning << request.url();
+    }
+
+    // tiles which are already on the disk only need to be decoded
+    QImage image;
+    if ( QgsTileCache::tile( request.url(), image ) )
+    {
+      QMutexLocker locker( &mMutex );
+      mRunning.remove( request.url() );
+      continue;
+    }
+
+    request.setPriority( QNetworkRequest::LowPriority );
+    request.setAttribute( QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::PreferCache );
+    request.setAttribute( QNetworkRequest::CacheSaveControlAttribute, true );
+    request.setAttribute( QNetworkRequest::FollowRedirectsAttribute, true );
+    QNetworkReply *reply = QgsNetworkAccessManager::instance()->get( request );
+    connect( reply, &QNetworkReply::finished, this, &QgsTilePrefetcher::replyFinished );
+  }
+}
+
+void QgsTilePrefetcher::replyFinished()
+{
+  QNetworkReply *reply = qobject_cast<QNetworkReply *>( sender() );
+  const QUrl url = reply->request().url();
+
+  const QVariant status = reply->attribute( QNetworkRequest::HttpStatusCodeAttribute );
+  if ( reply->error() == QNetworkReply::NoError && ( status.isNull() || status.toInt() < 400 ) )
+  {
+    // decode right away, so that the tile is ready when the view moves
+    const QByteArray data = reply->readAll();
+    const QImage image = QImage::fromData( data );
+    if ( !image.isNull() )
+      QgsTileCache::insertTile( url, image, data );
+    else
+      QgsDebugMsgLevel( QString( "Prefetched tile is not an image: %1" ).arg( url.toString() ), 2 );
+  }
+  else
+  {
+    QgsDebugMsgLevel( QString( "Prefetching tile failed: %1 (%2)" ).arg( url.toString(), reply->errorString() ), 2 );
+  }
+  reply->deleteLater();
+
+  {
+    QMutexLocker locker( &mMutex );
+    mRunning.remove( url );
+  }
+  startRequests();
+}
@@ -0,0 +1,74 @@
+/***************************************************************************
+  qgstileprefetcher.h
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSTILEPREFETCHER_H
+#define QGSTILEPREFETCHER_H
+
+#include <QObject>
+#include <QList>
+#include <QMutex>
+#include <QNetworkRequest>
+#include <QSet>
+#include <QUrl>
+
+class QNetworkReply;
+
+/** Fetches tiles which are likely to be needed soon (the parents and neighbours
+ * of the tiles in view) into the tile cache.
+ *
+ * Rendering of tiled layers blocks until the tiles in view are loaded, so
+ * the prefetcher runs its own thread with an event loop, where downloads
+ * continue after the render job has finished. Downloaded tiles are decoded
+ * and put into the tile cache, tiles which are already in the disk caches are
+ * only decoded.
+ *
+ * The class is thread safe (prefetch() can be called from any thread).
+ */
+class QgsTilePrefetcher : public QObject
+{
+    Q_OBJECT
+
+  public:
+
+    //! Returns the prefetcher, starting its thread on first use
+    static QgsTilePrefetcher *instance();
+
+    /**
+     * Queues \a requests for prefetching. Tiles which were queued before but have
+     * not been requested yet are dropped, as the view has moved on.
+     */
+    void prefetch( const QList<QNetworkRequest> &requests );
+
+    //! Returns the number of queued and running requests
+    int pendingCount() const;
+
+  private slots:
+
+    //! Starts requests from the queue, up to the maximum number of parallel requests
+    void startRequests();
+
+    void replyFinished();
+
+  private:
+
+    QgsTilePrefetcher() = default;
+
+    mutable QMutex mMutex;
+    //! Requests waiting to be started (protected by the mutex)
+    QList<QNetworkRequest> mQueue;
+    //! URLs being requested (protected by the mutex)
+    QSet<QUrl> mRunning;
+};
+
+#endif // QGSTILEPREFETCHER_H
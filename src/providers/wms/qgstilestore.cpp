@@ -0,0 +1,226 @@
+/***************************************************************************
+  qgstilestore.cpp
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstilestore.h"
+
+#include "qgslogger.h"
+#include "qgsmessagelog.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QObject>
+#include <QUrl>
+
+#include <sqlite3.h>
+
+//! Fraction of the maximum size the store is reduced to when it gets full
+static const double EVICTION_TARGET = 0.9;
+
+QgsTileStore::QgsTileStore( const QString &path, qint64 maxSize )
+  : mPath( path )
+  , mMaxSize( maxSize )
+{
+  QDir().mkpath( QFileInfo( path ).absolutePath() );
+
+  if ( sqlite3_open( path.toUtf8().constData(), &mDatabase ) != SQLITE_OK )
+  {
+    QgsMessageLog::logMessage( QObject::tr( "Could not open tile store %1: %2" ).arg( path, QString::fromUtf8( sqlite3_errmsg( mDatabase ) ) ), QObject::tr( "WMS" ) );
+    sqlite3_close( mDatabase );
+    mDatabase = nullptr;
+    return;
+  }
+
+  // the store only holds copies of server data, durability is not worth slow writes
+  ( void )execute( "PRAGMA journal_mode=WAL" );
+  ( void )execute( "PRAGMA synchronous=NORMAL" );
+  if ( !execute( "CREATE TABLE IF NOT EXISTS tiles (url TEXT PRIMARY KEY, tile_data BLOB NOT NULL, size INTEGER NOT NULL, last_access INTEGER NOT NULL)" ) ||
+       !execute( "CREATE INDEX IF NOT EXISTS tiles_last_access ON tiles (last_access)" ) )
+  {
+    sqlite3_close( mDatabase );
+    mDatabase = nullptr;
+    return;
+  }
+
+  sqlite3_stmt *stmt = nullptr;
+  if ( sqlite3_prepare_v2( mDatabase, "SELECT COUNT(*), TOTAL(size), MAX(last_access) FROM tiles", -1, &stmt, nullptr ) == SQLITE_OK
+       && sqlite3_step( stmt ) == SQLITE_ROW )
+  {
+    mTileCount = sqlite3_column_int( stmt, 0 );
+    mSize = static_cast< qint64 >( sqlite3_column_double( stmt, 1 ) );
+    mAccessCounter = sqlite3_column_int64( stmt, 2 );
+  }
+  sqlite3_finalize( stmt );
+
+  QgsDebugMsg( QString( "Opened tile store %1 with %2 tiles, %3 bytes" ).arg( path ).arg( mTileCount ).arg( mSize ) );
+
+  if ( mSize > mMaxSize )
+    evict();
+}
+
+QgsTileStore::~QgsTileStore()
+{
+  sqlite3_close( mDatabase );
+}
+
+qint64 QgsTileStore::size() const
+{
+  QMutexLocker locker( &mMutex );
+  return mSize;
+}
+
+int QgsTileStore::tileCount() const
+{
+  QMutexLocker locker( &mMutex );
+  return mTileCount;
+}
+
+QByteArray QgsTileStore::tileData( const QUrl &url )
+{
+  QMutexLocker locker( &mMutex );
+  if ( !mDatabase )
+    return QByteArray();
+
+  const QByteArray key = url.toEncoded();
+  QByteArray data;
+  sqlite3_stmt *stmt = nullptr;
+  if ( sqlite3_prepare_v2( mDatabase, "SELECT tile_data FROM tiles WHERE url=?", -1, &stmt, nullptr ) == SQLITE_OK )
+  {
+    sqlite3_bind_text( stmt, 1, key.constData(), key.size(), SQLITE_STATIC );
+    if ( sqlite3_step( stmt ) == SQLITE_ROW )
+    {
+      data = QByteArray( static_cast< const char * >( sqlite3_column_blob( stmt, 0 ) ), sqlite3_column_bytes( stmt, 0 ) );
+    }
+  }
+  sqlite3_finalize( stmt );
+
+  if ( data.isEmpty() )
+    return data;
+
+  // remember the access, so that the tile is not evicted soon
+  if ( sqlite3_prepare_v2( mDatabase, "UPDATE tiles SET last_access=? WHERE url=?", -1, &stmt, nullptr ) == SQLITE_OK )
+  {
+    sqlite3_bind_int64( stmt, 1, ++mAccessCounter );
+    sqlite3_bind_text( stmt, 2, key.constData(), key.size(), SQLITE_STATIC );
+    ( void )sqlite3_step( stmt );
+  }
+  sqlite3_finalize( stmt );
+
+  return data;
+}
+
+void QgsTileStore::insertTileData( const QUrl &url, const QByteArray &data )
+{
+  QMutexLocker locker( &mMutex );
+  if ( !mDatabase || data.isEmpty() || data.size() > mMaxSize )
+    return;
+
+  const QByteArray key = url.toEncoded();
+  sqlite3_stmt *stmt = nullptr;
+
+  // account for the tile we are about to replace
+  if ( sqlite3_prepare_v2( mDatabase, "SELECT size FROM tiles WHERE url=?", -1, &stmt, nullptr ) == SQLITE_OK )
+  {
+    sqlite3_bind_text( stmt, 1, key.constData(), key.size(), SQLITE_STATIC );
+    if ( sqlite3_step( stmt ) == SQLITE_ROW )
+    {
+      mSize -= sqlite3_column_int64( stmt, 0 );
+      mTileCount--;
+    }
+  }
+  sqlite3_finalize( stmt );
+
+  bool inserted = false;
+  if ( sqlite3_prepare_v2( mDatabase, "INSERT OR REPLACE INTO tiles (url, tile_data, size, last_access) VALUES (?, ?, ?, ?)", -1, &stmt, nullptr ) == SQLITE_OK )
+  {
+    sqlite3_bind_text( stmt, 1, key.constData(), key.size(), SQLITE_STATIC );
+    sqlite3_bind_blob( stmt, 2, data.constData(), data.size(), SQLITE_STATIC );
+    sqlite3_bind_int64( stmt, 3, data.size() );
+    sqlite3_bind_int64( stmt, 4, ++mAccessCounter );
+    inserted = sqlite3_step( stmt ) == SQLITE_DONE;
+  }
+  sqlite3_finalize( stmt );
+
+  if ( !inserted )
+  {
+    QgsDebugMsg( QString( "Could not store tile %1: %2" ).arg( url.toString(), QString::fromUtf8( sqlite3_errmsg( mDatabase ) ) ) );
+    return;
+  }
+
+  mSize += data.size();
+  mTileCount++;
+  if ( mSize > mMaxSize )
+    evict();
+}
+
+void QgsTileStore::clear()
+{
+  QMutexLocker locker( &mMutex );
+  if ( !mDatabase )
+    return;
+
+  if ( execute( "DELETE FROM tiles" ) )
+  {
+    mSize = 0;
+    mTileCount = 0;
+  }
+}
+
+void QgsTileStore::evict()
+{
+  // find the access counter below which the tiles have to go
+  const qint64 excess = mSize - static_cast< qint64 >( EVICTION_TARGET * mMaxSize );
+  qint64 removedSize = 0;
+  int removedCount = 0;
+  qint64 lastAccess = -1;
+
+  sqlite3_stmt *stmt = nullptr;
+  if ( sqlite3_prepare_v2( mDatabase, "SELECT size, last_access FROM tiles ORDER BY last_access", -1, &stmt, nullptr ) == SQLITE_OK )
+  {
+    while ( removedSize < excess && sqlite3_step( stmt ) == SQLITE_ROW )
+    {
+      removedSize += sqlite3_column_int64( stmt, 0 );
+      lastAccess = sqlite3_column_int64( stmt, 1 );
+      removedCount++;
+    }
+  }
+  sqlite3_finalize( stmt );
+
+  if ( lastAccess < 0 )
+    return;
+
+  if ( sqlite3_prepare_v2( mDatabase, "DELETE FROM tiles WHERE last_access<=?", -1, &stmt, nullptr ) == SQLITE_OK )
+  {
+    sqlite3_bind_int64( stmt, 1, lastAccess );
+    if ( sqlite3_step( stmt ) == SQLITE_DONE )
+    {
+      mSize -= removedSize;
+      mTileCount -= removedCount;
+    }
+  }
+  sqlite3_finalize( stmt );
+
+  QgsDebugMsg( QString( "Evicted %1 tiles (%2 bytes) from tile store" ).arg( removedCount ).arg( removedSize ) );
+}
+
+bool QgsTileStore::execute( const char *sql )
+{
+  char *errorMessage = nullptr;
+  if ( sqlite3_exec( mDatabase, sql, nullptr, nullptr, &errorMessage ) != SQLITE_OK )
+  {
+    QgsDebugMsg( QString( "Tile store statement %1 failed: %2" ).arg( QString::fromUtf8( sql ), QString::fromUtf8( errorMessage ) ) );
+    sqlite3_free( errorMessage );
+    return false;
+  }
+  return true;
+}
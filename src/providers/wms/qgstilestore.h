@@ -0,0 +1,93 @@
+/***************************************************************************
+  qgstilestore.h
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSTILESTORE_H
+#define QGSTILESTORE_H
+
+#include <QByteArray>
+#include <QMutex>
+#include <QString>
+
+class QUrl;
+struct sqlite3;
+
+/** A persistent tile store, keeping encoded tiles in a single SQLite database.
+ * Unlike the network disk cache the tiles do not expire, so that they
+ * survive restarts of the application even for servers which do not allow
+ * caching of their responses. Tiles are keyed by their URL, as tiles
+ * of WMS-C layers or layers in different tile matrix sets can't be
+ * identified by zoom level, column and row alone.
+ *
+ * When the size of the stored tiles exceeds the maximum size, the least
+ * recently used tiles are removed.
+ *
+ * The class is thread safe (its methods can be called from any thread).
+ */
+class QgsTileStore
+{
+  public:
+
+    //! Opens (or creates) the store in the database at \a path, limited to \a maxSize bytes
+    QgsTileStore( const QString &path, qint64 maxSize );
+    ~QgsTileStore();
+
+    //! QgsTileStore cannot be copied
+    QgsTileStore( const QgsTileStore &rh ) = delete;
+    //! QgsTileStore cannot be copied
+    QgsTileStore &operator=( const QgsTileStore &rh ) = delete;
+
+    //! Returns true if the database could be opened
+    bool isValid() const { return mDatabase; }
+
+    //! Returns the path of the database
+    QString path() const { return mPath; }
+
+    //! Returns the maximum size of the stored tiles (in bytes)
+    qint64 maxSize() const { return mMaxSize; }
+
+    //! Returns the size of the stored tiles (in bytes)
+    qint64 size() const;
+
+    //! Returns the number of stored tiles
+    int tileCount() const;
+
+    //! Returns the encoded tile for \a url, or an empty array if it is not stored
+    QByteArray tileData( const QUrl &url );
+
+    //! Stores the encoded tile \a data for \a url, replacing any previous tile
+    void insertTileData( const QUrl &url, const QByteArray &data );
+
+    //! Removes all tiles
+    void clear();
+
+  private:
+
+    //! Removes the least recently used tiles until the store is well below its maximum size
+    void evict();
+
+    //! Executes a statement without results, returns true on success
+    bool execute( const char *sql );
+
+    QString mPath;
+    qint64 mMaxSize = 0;
+    qint64 mSize = 0;
+    int mTileCount = 0;
+    //! Increasing counter, used instead of times to order the tiles by their last access
+    qint64 mAccessCounter = 0;
+
+    sqlite3 *mDatabase = nullptr;
+    mutable QMutex mMutex;
+};
+
+#endif // QGSTILESTORE_H
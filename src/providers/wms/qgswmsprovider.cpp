@@ -41,6 +41,7 @@
 #include "qgsnetworkaccessmanager.h"
 #include "qgsnetworkreplyparser.h"
 #include "qgstilecache.h"
+#include "qgstileprefetcher.h"
 #include "qgsgml.h"
 #include "qgsgmlschema.h"
 #include "qgswmscapabilities.h"
@@ -69,6 +70,8 @@
 #include <QScriptValueIterator>
 #include <QNetworkDiskCache>
 #include <QTimer>
+#include <QFutureWatcher>
+#include <QtConcurrentRun>
 
 #include <ogr_api.h>
 
@@ -85,6 +88,9 @@ static QString WMS_DESCRIPTION = QStringLiteral( "OGC Web Map Service version 1.
 
 static QString DEFAULT_LATLON_CRS = QStringLiteral( "CRS:84" );
 
+//! Maximum number of tiles queued for prefetching after drawing a view
+static const int MAX_PREFETCH_TILES = 64;
+
 QMap<QString, QgsWmsStatistics::Stat> QgsWmsStatistics::sData;
 
 //! a helper class for ordering tile requests according to the distance from view center
@@ -547,11 +553,17 @@ void QgsWmsProvider::fetchOtherResTiles( QgsTileMode tileMode, const QgsRectangl
       break;
   }
 
-  QList<QRectF> missingRectsToDelete;
+  QList<QUrl> urls;
   Q_FOREACH ( const TileRequest &r, requests )
+    urls << r.url;
+  const QList<QImage> cachedImages = QgsTileCache::tiles( urls );
+
+  QList<QRectF> missingRectsToDelete;
+  for ( int i = 0; i < requests.size(); ++i )
   {
-    QImage localImage;
-    if ( ! QgsTileCache::tile( r.url, localImage ) )
+    const TileRequest &r = requests.at( i );
+    const QImage &localImage = cachedImages.at( i );
+    if ( localImage.isNull() )
       continue;
 
     double cr = viewExtent.width() / imageWidth;
@@ -588,6 +600,94 @@ void QgsWmsProvider::fetchOtherResTiles( QgsTileMode tileMode, const QgsRectangl
                .arg( otherResTiles.count() ) );
 }
 
+void QgsWmsProvider::prefetchTiles( QgsTileMode tileMode, const QgsWmtsTileMatrix *tm, const QgsWmtsTileMatrixLimits *tml, const QgsRectangle &viewExtent, int col0, int row0, int col1, int row1 )
+{
+  auto createRequests = [this, tileMode]( const QgsWmtsTileMatrix * matrix, const TilePositions & tiles, TileRequests & requests )
+  {
+    switch ( tileMode )
+    {
+      case WMSC:
+        createTileRequestsWMSC( matrix, tiles, requests );
+        break;
+
+      case WMTS:
+        createTileRequestsWMTS( matrix, tiles, requests );
+        break;
+
+      case XYZ:
+        createTileRequestsXYZ( matrix, tiles, requests );
+        break;
+    }
+  };
+
+  TileRequests requests;
+
+  // the tiles one level up are used for previews when zooming out
+  const QgsWmtsTileMatrix *parent = mTileMatrixSet ? mTileMatrixSet->findOtherResolution( tm->tres, 1 ) : nullptr;
+  if ( parent )
+  {
+    const QgsWmtsTileMatrixLimits *parentLimits = nullptr;
+    if ( mTileLayer &&
+         mTileLayer->setLinks.contains( mTileMatrixSet->identifier ) &&
+         mTileLayer->setLinks[ mTileMatrixSet->identifier ].limits.contains( parent->identifier ) )
+    {
+      parentLimits = &mTileLayer->setLinks[ mTileMatrixSet->identifier ].limits[ parent->identifier ];
+    }
+
+    int pc0, pr0, pc1, pr1;
+    parent->viewExtentIntersection( viewExtent, parentLimits, pc0, pr0, pc1, pr1 );
+    TilePositions tiles;
+    for ( int row = pr0; row <= pr1; row++ )
+    {
+      for ( int col = pc0; col <= pc1; col++ )
+      {
+        tiles << TilePosition( row, col );
+      }
+    }
+    createRequests( parent, tiles, requests );
+  }
+
+  // the ring of tiles around the view is needed when panning
+  int minCol = 0;
+  int maxCol = tm->matrixWidth - 1;
+  int minRow = 0;
+  int maxRow = tm->matrixHeight - 1;
+  if ( tml )
+  {
+    minCol = tml->minTileCol;
+    maxCol = tml->maxTileCol;
+    minRow = tml->minTileRow;
+    maxRow = tml->maxTileRow;
+  }
+
+  TilePositions neighbours;
+  for ( int row = std::max( row0 - 1, minRow ); row <= std::min( row1 + 1, maxRow ); row++ )
+  {
+    for ( int col = std::max( col0 - 1, minCol ); col <= std::min( col1 + 1, maxCol ); col++ )
+    {
+      if ( row >= row0 && row <= row1 && col >= col0 && col <= col1 )
+        continue;  // in view, already loaded
+
+      neighbours << TilePosition( row, col );
+    }
+  }
+  createRequests( tm, neighbours, requests );
+
+  QList<QNetworkRequest> networkRequests;
+  Q_FOREACH ( const TileRequest &r, requests )
+  {
+    if ( networkRequests.count() >= MAX_PREFETCH_TILES )
+      break;
+
+    QNetworkRequest request( r.url );
+    mSettings.authorization().setAuthorization( request );
+    networkRequests << request;
+  }
+
+  QgsDebugMsg( QString( "prefetching %1 tiles" ).arg( networkRequests.count() ) );
+  QgsTilePrefetcher::instance()->prefetch( networkRequests );
+}
+
 uint qHash( QgsWmsProvider::TilePosition tp )
 {
   return ( uint ) tp.col + ( ( uint ) tp.row << 16 );
@@ -753,11 +853,17 @@ QImage *QgsWmsProvider::draw( QgsRectangle const &viewExtent, int pixelWidth, in
 
     QTime t;
     t.start();
-    TileRequests requestsFinal;
+    QList<QUrl> urls;
     Q_FOREACH ( const TileRequest &r, requests )
+      urls << r.url;
+    const QList<QImage> cachedImages = QgsTileCache::tiles( urls );
+
+    TileRequests requestsFinal;
+    for ( int i = 0; i < requests.size(); ++i )
     {
-      QImage localImage;
-      if ( QgsTileCache::tile( r.url, localImage ) )
+      const TileRequest &r = requests.at( i );
+      const QImage &localImage = cachedImages.at( i );
+      if ( !localImage.isNull() )
       {
         double cr = viewExtent.width() / image->width();
 
@@ -855,6 +961,12 @@ QImage *QgsWmsProvider::draw( QgsRectangle const &viewExtent, int pixelWidth, in
       handler.downloadBlocking();
     }
 
+    if ( !( feedback && ( feedback->isPreviewOnly() || feedback->isCanceled() ) ) &&
+         QgsSettings().value( QStringLiteral( "qgis/tilePrefetch" ), false ).toBool() )
+    {
+      prefetchTiles( tileMode, tm, tml, viewExtent, col0, row0, col1, row1 );
+    }
+
     QgsDebugMsg( QString( "TILE CACHE total: %1 / %2" ).arg( QgsTileCache::totalCost() ).arg( QgsTileCache::maxCost() ) );
 
 #if 0
@@ -3702,6 +3814,11 @@ void QgsWmsImageDownloadHandler::canceled()
 // ----------
 
 
+static QImage _decodeTile( const QByteArray &data )
+{
+  return QImage::fromData( data );
+}
+
 QgsWmsTiledImageDownloadHandler::QgsWmsTiledImageDownloadHandler( const QString &providerUri, const QgsWmsAuthorization &auth, int tileReqNo, const QgsWmsProvider::TileRequests &requests, QImage *image, const QgsRectangle &viewExtent, bool smoothPixmapTransform, QgsRasterBlockFeedback *feedback )
   : mProviderUri( providerUri )
   , mAuth( auth )
@@ -3851,7 +3968,7 @@ void QgsWmsTiledImageDownloadHandler::tileReplyFinished()
       mReplies.removeOne( reply );
       reply->deleteLater();
 
-      if ( mReplies.isEmpty() )
+      if ( mReplies.isEmpty() && mDecodingTiles == 0 )
         finish();
 
       return;
@@ -3890,7 +4007,7 @@ void QgsWmsTiledImageDownloadHandler::tileReplyFinished()
       mReplies.removeOne( reply );
       reply->deleteLater();
 
-      if ( mReplies.isEmpty() )
+      if ( mReplies.isEmpty() && mDecodingTiles == 0 )
         finish();
 
       return;
@@ -3908,34 +4025,21 @@ void QgsWmsTiledImageDownloadHandler::tileReplyFinished()
 
       QgsDebugMsg( QString( "tile reply: length %1" ).arg( reply->bytesAvailable() ) );
 
-      QImage myLocalImage = QImage::fromData( reply->readAll() );
-
-      if ( !myLocalImage.isNull() )
-      {
-        QPainter p( mImage );
-        if ( mSmoothPixmapTransform )
-          p.setRenderHint( QPainter::SmoothPixmapTransform, true );
-        p.drawImage( dst, myLocalImage );
-#if 0
-        myLocalImage.save( QString( "%1/%2-tile-%3.png" ).arg( QDir::tempPath() ).arg( mTileReqNo ).arg( tileNo ) );
-        p.drawRect( dst ); // show tile bounds
-        p.drawText( dst, Qt::AlignCenter, QString( "(%1)\n%2,%3\n%4,%5\n%6x%7" )
-                    .arg( tileNo )
-                    .arg( r.left() ).arg( r.bottom() )
-                    .arg( r.right() ).arg( r.top() )
-                    .arg( r.width() ).arg( r.height() ) );
-#endif
-
-        QgsTileCache::insertTile( reply->url(), myLocalImage );
-
-        if ( mFeedback )
-          mFeedback->onNewData();
-      }
-      else
+      // decode on the thread pool, meanwhile the event loop keeps handling the other replies
+      const QByteArray data = reply->readAll();
+      const QUrl url = reply->url();
+      QFutureWatcher<QImage> *watcher = new QFutureWatcher<QImage>( this );
+      connect( watcher, &QFutureWatcherBase::finished, this, [ = ]
       {
-        QgsMessageLog::logMessage( tr( "Returned image is flawed [Content-Type:%1; URL: %2]" )
-                                   .arg( contentType, reply->url().toString() ), tr( "WMS" ) );
-      }
+        tileDecoded( watcher->result(), data, url, dst, contentType );
+        watcher->deleteLater();
+
+        mDecodingTiles--;
+        if ( mReplies.isEmpty() && mDecodingTiles == 0 )
+          finish();
+      } );
+      mDecodingTiles++;
+      watcher->setFuture( QtConcurrent::run( _decodeTile, data ) );
     }
     else
     {
@@ -3945,7 +4049,7 @@ void QgsWmsTiledImageDownloadHandler::tileReplyFinished()
     mReplies.removeOne( reply );
     reply->deleteLater();
 
-    if ( mReplies.isEmpty() )
+    if ( mReplies.isEmpty() && mDecodingTiles == 0 )
       finish();
 
   }
@@ -3968,7 +4072,7 @@ void QgsWmsTiledImageDownloadHandler::tileReplyFinished()
     mReplies.removeOne( reply );
     reply->deleteLater();
 
-    if ( mReplies.isEmpty() )
+    if ( mReplies.isEmpty() && mDecodingTiles == 0 )
       finish();
   }
 
@@ -3982,6 +4086,27 @@ void QgsWmsTiledImageDownloadHandler::tileReplyFinished()
 #endif
 }
 
+void QgsWmsTiledImageDownloadHandler::tileDecoded( const QImage &image, const QByteArray &data, const QUrl &url, const QRectF &dst, const QString &contentType )
+{
+  if ( !image.isNull() )
+  {
+    QPainter p( mImage );
+    if ( mSmoothPixmapTransform )
+      p.setRenderHint( QPainter::SmoothPixmapTransform, true );
+    p.drawImage( dst, image );
+
+    QgsTileCache::insertTile( url, image, data );
+
+    if ( mFeedback )
+      mFeedback->onNewData();
+  }
+  else
+  {
+    QgsMessageLog::logMessage( tr( "Returned image is flawed [Content-Type:%1; URL: %2]" )
+                               .arg( contentType, url.toString() ), tr( "WMS" ) );
+  }
+}
+
 void QgsWmsTiledImageDownloadHandler::canceled()
 {
   QgsDebugMsg( "Caught canceled() signal" );
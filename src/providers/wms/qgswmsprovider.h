@@ -339,6 +339,12 @@ class QgsWmsProvider : public QgsRasterDataProvider
     //! Get tiles from a different resolution to cover the missing areas
     void fetchOtherResTiles( QgsTileMode tileMode, const QgsRectangle &viewExtent, int imageWidth, QList<QRectF> &missing, double tres, int resOffset, QList<TileImage> &otherResTiles );
 
+    /**
+     * Queues the tiles around the view (tiles \a col0 to \a col1 and \a row0 to \a row1 of \a tm)
+     * and the tiles covering the view one level up for prefetching into the tile cache.
+     */
+    void prefetchTiles( QgsTileMode tileMode, const QgsWmtsTileMatrix *tm, const QgsWmtsTileMatrixLimits *tml, const QgsRectangle &viewExtent, int col0, int row0, int col1, int row1 );
+
     /** Return the full url to request legend graphic
      * The visibleExtent isi only used if provider supports contextual
      * legends according to the QgsWmsSettings
@@ -514,6 +520,9 @@ class QgsWmsTiledImageDownloadHandler : public QObject
      */
     void repeatTileRequest( QNetworkRequest const &oldRequest );
 
+    //! Draws a decoded tile into the image and adds it to the tile cache
+    void tileDecoded( const QImage &image, const QByteArray &data, const QUrl &url, const QRectF &dst, const QString &contentType );
+
     void finish() { QMetaObject::invokeMethod( mEventLoop, "quit", Qt::QueuedConnection ); }
 
     QString mProviderUri;
@@ -531,6 +540,9 @@ class QgsWmsTiledImageDownloadHandler : public QObject
     //! Running tile requests
     QList<QNetworkReply *> mReplies;
 
+    //! Number of tiles being decoded on the thread pool
+    int mDecodingTiles = 0;
+
     QgsRasterBlockFeedback *mFeedback = nullptr;
 };
 
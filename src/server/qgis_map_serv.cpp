@@ -21,9 +21,15 @@
 #include "qgsserver.h"
 #include "qgsfcgiserverresponse.h"
 #include "qgsfcgiserverrequest.h"
+#include "qgsmessagelog.h"
 
 #include <fcgi_stdio.h>
 #include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include <QMutex>
+#include <QThread>
 
 int fcgi_accept()
 {
@@ -37,6 +43,66 @@ int fcgi_accept()
 #endif
 }
 
+/**
+ * Handles a single accepted request, either the one set up by FCGI_Accept()
+ * or \a fcgiRequest when set.
+ */
+void handleFcgiRequest( QgsServer &server, FCGX_Request *fcgiRequest = nullptr )
+{
+  QgsFcgiServerRequest  request( fcgiRequest );
+  QgsFcgiServerResponse response( request.method(), fcgiRequest );
+  if ( ! request.hasError() )
+  {
+    server.handleRequest( request, response );
+  }
+  else
+  {
+    response.sendError( 400, "Bad request" );
+  }
+}
+
+/**
+ * Thread accepting and handling FastCGI requests until the listen socket is closed.
+ *
+ * Each worker has its own QgsServer. The cached projects are shared read only by all
+ * workers, and the services work on copies of the layers they change. Map settings and
+ * layer renderers are created per request anyway.
+ */
+class QgsFcgiWorker : public QThread
+{
+  public:
+    explicit QgsFcgiWorker( QMutex *acceptMutex )
+      : mAcceptMutex( acceptMutex )
+    {}
+
+  protected:
+    void run() override
+    {
+      QgsServer server;
+
+      FCGX_Request fcgiRequest;
+      FCGX_InitRequest( &fcgiRequest, 0, 0 );
+
+      while ( true )
+      {
+        int rc = 0;
+        {
+          // some platforms require accept() serialization
+          QMutexLocker locker( mAcceptMutex );
+          rc = FCGX_Accept_r( &fcgiRequest );
+        }
+        if ( rc < 0 )
+          break;
+
+        handleFcgiRequest( server, &fcgiRequest );
+        FCGX_Finish_r( &fcgiRequest );
+      }
+    }
+
+  private:
+    QMutex *mAcceptMutex = nullptr;
+};
+
 int main( int argc, char *argv[] )
 {
   QgsApplication app( argc, argv, getenv( "DISPLAY" ), QString(), QStringLiteral( "server" ) );
@@ -44,21 +110,53 @@ int main( int argc, char *argv[] )
 #ifdef HAVE_SERVER_PYTHON_PLUGINS
   server.initPython();
 #endif
-  // Starts FCGI loop
-  while ( fcgi_accept() >= 0 )
+
+  int workers = server.serverInterface()->serverSettings()->fcgiWorkers();
+  if ( workers > 1 && FCGX_IsCGI() )
+  {
+    workers = 1;
+  }
+#ifdef HAVE_SERVER_PYTHON_PLUGINS
+  if ( workers > 1 && !QgsServerPlugins::serverPlugins().isEmpty() )
+  {
+    // plugins and their filters are not thread safe
+    QgsMessageLog::logMessage( QStringLiteral( "Server plugins are loaded, FastCGI requests are handled in a single thread" ), QStringLiteral( "Server" ), QgsMessageLog::WARNING );
+    workers = 1;
+  }
+#endif
+
+  if ( workers <= 1 )
   {
-    QgsFcgiServerRequest  request;
-    QgsFcgiServerResponse response( request.method() );
-    if ( ! request.hasError() )
+    // Starts FCGI loop
+    while ( fcgi_accept() >= 0 )
     {
-      server.handleRequest( request, response );
+      handleFcgiRequest( server );
     }
-    else
+  }
+  else
+  {
+    FCGX_Init();
+
+    QMutex acceptMutex;
+    std::vector< std::unique_ptr< QgsFcgiWorker > > threads;
+    int running = workers;
+    for ( int i = 0; i < workers; ++i )
     {
-      response.sendError( 400, "Bad request" );
+      threads.emplace_back( new QgsFcgiWorker( &acceptMutex ) );
+      QObject::connect( threads.back().get(), &QThread::finished, &app, [&running]
+      {
+        if ( --running == 0 )
+          QCoreApplication::quit();
+      } );
+      threads.back()->start();
     }
+
+    // the main thread delivers log messages and file system watcher notifications
+    app.exec();
+
+    for ( const std::unique_ptr< QgsFcgiWorker > &thread : threads )
+      thread->wait();
   }
   app.exitQgis();
   return 0;
 }
-
@@ -28,9 +28,13 @@ const QDomDocument *QgsCapabilitiesCache::searchCapabilitiesDocument( const QStr
 {
   QCoreApplication::processEvents(); //get updates from file system watcher
 
+  QMutexLocker locker( &mMutex );
   if ( mCachedCapabilities.contains( configFilePath ) && mCachedCapabilities[ configFilePath ].contains( key ) )
   {
-    return &mCachedCapabilities[ configFilePath ][ key ];
+    // hand out a shallow copy, so that the document stays alive if another thread removes the entry
+    QDomDocument &doc = mThreadDocuments.localData();
+    doc = mCachedCapabilities[ configFilePath ][ key ];
+    return &doc;
   }
   else
   {
@@ -40,32 +44,47 @@ const QDomDocument *QgsCapabilitiesCache::searchCapabilitiesDocument( const QStr
 
 void QgsCapabilitiesCache::insertCapabilitiesDocument( const QString &configFilePath, const QString &key, const QDomDocument *doc )
 {
+  QDomDocument clone = doc->cloneNode().toDocument();
+
+  QMutexLocker locker( &mMutex );
   if ( mCachedCapabilities.size() > 40 )
   {
     //remove another cache entry to avoid memory problems
     QHash<QString, QHash<QString, QDomDocument> >::iterator capIt = mCachedCapabilities.begin();
-    mFileSystemWatcher.removePath( capIt.key() );
+    QMetaObject::invokeMethod( this, "unwatchPath", Q_ARG( QString, capIt.key() ) );
     mCachedCapabilities.erase( capIt );
   }
 
   if ( !mCachedCapabilities.contains( configFilePath ) )
   {
-    mFileSystemWatcher.addPath( configFilePath );
+    QMetaObject::invokeMethod( this, "watchPath", Q_ARG( QString, configFilePath ) );
     mCachedCapabilities.insert( configFilePath, QHash<QString, QDomDocument>() );
   }
 
-  mCachedCapabilities[ configFilePath ].insert( key, doc->cloneNode().toDocument() );
+  mCachedCapabilities[ configFilePath ].insert( key, clone );
 }
 
 void QgsCapabilitiesCache::removeCapabilitiesDocument( const QString &path )
 {
+  QMutexLocker locker( &mMutex );
   mCachedCapabilities.remove( path );
-  mFileSystemWatcher.removePath( path );
+  QMetaObject::invokeMethod( this, "unwatchPath", Q_ARG( QString, path ) );
 }
 
 void QgsCapabilitiesCache::removeChangedEntry( const QString &path )
 {
   QgsDebugMsg( "Remove capabilities cache entry because file changed" );
+  QMutexLocker locker( &mMutex );
   mCachedCapabilities.remove( path );
   mFileSystemWatcher.removePath( path );
 }
+
+void QgsCapabilitiesCache::watchPath( const QString &path )
+{
+  mFileSystemWatcher.addPath( path );
+}
+
+void QgsCapabilitiesCache::unwatchPath( const QString &path )
+{
+  mFileSystemWatcher.removePath( path );
+}
@@ -21,7 +21,9 @@
 #include <QDomDocument>
 #include <QFileSystemWatcher>
 #include <QHash>
+#include <QMutex>
 #include <QObject>
+#include <QThreadStorage>
 #include "qgis_server.h"
 
 /** \ingroup server
@@ -34,6 +36,9 @@ class SERVER_EXPORT QgsCapabilitiesCache : public QObject
     QgsCapabilitiesCache();
 
     /** Returns cached capabilities document (or 0 if document for configuration file not in cache)
+     *
+     * The returned document is owned by the calling thread and stays valid until the next
+     * call to this method from the same thread, even if the entry is removed from the cache.
      * \param configFilePath the progect file path
      * \param key key used to separate different version in different cache
      */
@@ -56,9 +61,21 @@ class SERVER_EXPORT QgsCapabilitiesCache : public QObject
     QHash< QString, QHash< QString, QDomDocument > > mCachedCapabilities;
     QFileSystemWatcher mFileSystemWatcher;
 
+    //! Protects the cached documents, which may be accessed from several FastCGI worker threads
+    QMutex mMutex;
+
+    //! Documents handed out by searchCapabilitiesDocument(), per thread
+    QThreadStorage< QDomDocument > mThreadDocuments;
+
   private slots:
     //! Removes changed entry from this cache
     void removeChangedEntry( const QString &path );
+
+    //! Adds a path to the file system watcher, which must be modified from its own thread only
+    void watchPath( const QString &path );
+
+    //! Removes a path from the file system watcher
+    void unwatchPath( const QString &path );
 };
 
 #endif // QGSCAPABILITIESCACHE_H
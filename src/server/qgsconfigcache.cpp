@@ -22,6 +22,7 @@
 #include "qgsproject.h"
 
 #include <QFile>
+#include <QThread>
 
 QgsConfigCache *QgsConfigCache::instance()
 {
@@ -40,17 +41,41 @@ QgsConfigCache::QgsConfigCache()
 
 const QgsProject *QgsConfigCache::project( const QString &path )
 {
-  if ( ! mProjectCache[ path ] )
+  return sharedProject( path ).get();
+}
+
+std::shared_ptr< const QgsProject > QgsConfigCache::sharedProject( const QString &path )
+{
   {
-    std::unique_ptr<QgsProject> prj( new QgsProject() );
-    if ( prj->read( path ) )
-    {
-      mProjectCache.insert( path, prj.release() );
-      mFileSystemWatcher.addPath( path );
-    }
+    QMutexLocker locker( &mMutex );
+    if ( std::shared_ptr< QgsProject > *project = mProjectCache.object( path ) )
+      return *project;
   }
 
-  return mProjectCache[ path ];
+  // the project is read without holding the lock, so that requests for other projects are not blocked
+  std::shared_ptr< QgsProject > prj( new QgsProject(), []( QgsProject * project )
+  {
+    // the last request using the project may be handled by another thread than the one of the cache
+    if ( project->thread() == QThread::currentThread() )
+      delete project;
+    else
+      project->deleteLater();
+  } );
+  if ( !prj->read( path ) )
+    return nullptr;
+
+  // the project is shared by all threads, it must not belong to the thread handling the current request
+  prj->moveToThread( thread() );
+
+  QMutexLocker locker( &mMutex );
+  if ( std::shared_ptr< QgsProject > *project = mProjectCache.object( path ) )
+  {
+    // another request has read the project in the meantime
+    return *project;
+  }
+  mProjectCache.insert( path, new std::shared_ptr< QgsProject >( prj ) );
+  QMetaObject::invokeMethod( this, "watchPath", Q_ARG( QString, path ) );
+  return prj;
 }
 
 QDomDocument *QgsConfigCache::xmlDocument( const QString &filePath )
@@ -70,6 +95,7 @@ QDomDocument *QgsConfigCache::xmlDocument( const QString &filePath )
   }
 
   // first get cache
+  QMutexLocker locker( &mMutex );
   QDomDocument *xmlDoc = mXmlDocumentCache.object( filePath );
   if ( !xmlDoc )
   {
@@ -85,7 +111,7 @@ QDomDocument *QgsConfigCache::xmlDocument( const QString &filePath )
       return nullptr;
     }
     mXmlDocumentCache.insert( filePath, xmlDoc );
-    mFileSystemWatcher.addPath( filePath );
+    QMetaObject::invokeMethod( this, "watchPath", Q_ARG( QString, filePath ) );
     xmlDoc = mXmlDocumentCache.object( filePath );
     Q_ASSERT( xmlDoc );
   }
@@ -94,12 +120,15 @@ QDomDocument *QgsConfigCache::xmlDocument( const QString &filePath )
 
 void QgsConfigCache::removeChangedEntry( const QString &path )
 {
+  QMutexLocker locker( &mMutex );
+
+  // requests still using the project keep it alive until they are finished
   mProjectCache.remove( path );
 
   //xml document must be removed last, as other config cache destructors may require it
   mXmlDocumentCache.remove( path );
 
-  mFileSystemWatcher.removePath( path );
+  QMetaObject::invokeMethod( this, "unwatchPath", Q_ARG( QString, path ) );
 }
 
 
@@ -108,3 +137,12 @@ void QgsConfigCache::removeEntry( const QString &path )
   removeChangedEntry( path );
 }
 
+void QgsConfigCache::watchPath( const QString &path )
+{
+  mFileSystemWatcher.addPath( path );
+}
+
+void QgsConfigCache::unwatchPath( const QString &path )
+{
+  mFileSystemWatcher.removePath( path );
+}
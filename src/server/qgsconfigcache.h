@@ -23,9 +23,12 @@
 #include <QCache>
 #include <QFileSystemWatcher>
 #include <QMap>
+#include <QMutex>
 #include <QObject>
 #include <QDomDocument>
 
+#include <memory>
+
 #include "qgis_server.h"
 #include "qgis_sip.h"
 #include "qgsproject.h"
@@ -36,6 +39,10 @@ class SERVER_EXPORT QgsConfigCache : public QObject
 {
     Q_OBJECT
   public:
+
+    /**
+     * Returns the cache, which is shared by all threads handling requests.
+     */
     static QgsConfigCache *instance();
 
     void removeEntry( const QString &path );
@@ -43,11 +50,22 @@ class SERVER_EXPORT QgsConfigCache : public QObject
     /** If the project is not cached yet, then the project is read thank to the
      *  path. If the project is not available, then a nullptr is returned.
      * \param path the filename of the QGIS project
-     * \returns the project or nullptr if an error happened
+     * \returns the project or nullptr if an error happened. The project is only valid
+     * until it is removed from the cache, see sharedProject().
      * \since QGIS 3.0
      */
     const QgsProject *project( const QString &path );
 
+    /**
+     * Returns the project at \a path like project(), shared with all other requests.
+     * The project stays valid as long as the returned pointer is kept, even if it is
+     * removed from the cache in the meantime. It must not be changed, requests have
+     * to work on copies of the layers they change.
+     * \note not available in Python bindings
+     * \since QGIS 3.0
+     */
+    std::shared_ptr< const QgsProject > sharedProject( const QString &path ) SIP_SKIP;
+
   private:
     QgsConfigCache() SIP_FORCE;
 
@@ -58,11 +76,20 @@ class SERVER_EXPORT QgsConfigCache : public QObject
     QDomDocument *xmlDocument( const QString &filePath );
 
     QCache<QString, QDomDocument> mXmlDocumentCache;
-    QCache<QString, QgsProject> mProjectCache;
+    QCache<QString, std::shared_ptr< QgsProject > > mProjectCache;
+
+    //! Protects the caches
+    QMutex mMutex;
 
   private slots:
     //! Removes changed entry from this cache
     void removeChangedEntry( const QString &path );
+
+    //! Watches the file at \a path, called in the thread of the cache
+    void watchPath( const QString &path );
+
+    //! Stops watching the file at \a path, called in the thread of the cache
+    void unwatchPath( const QString &path );
 };
 
 #endif // QGSCONFIGCACHE_H
@@ -26,6 +26,8 @@
 
 #include <QBuffer>
 
+struct FCGX_Request;
+
 /**
  * \ingroup server
  * QgsFcgiServerResquest
@@ -34,7 +36,16 @@
 class SERVER_EXPORT QgsFcgiServerRequest: public QgsServerRequest
 {
   public:
-    QgsFcgiServerRequest();
+
+    /**
+     * Constructor for QgsFcgiServerRequest.
+     *
+     * If \a fcgiRequest is set, the request parameters and data are read from
+     * this (already accepted) FastCGI request, which allows to handle requests
+     * in several threads. Otherwise they are read from the process environment
+     * and standard input set up by FCGI_Accept().
+     */
+    explicit QgsFcgiServerRequest( FCGX_Request *fcgiRequest = nullptr );
 
     virtual QByteArray data() const override;
 
@@ -46,11 +57,15 @@ class SERVER_EXPORT QgsFcgiServerRequest: public QgsServerRequest
   private:
     void readData();
 
+    //! Returns the value of the CGI parameter \a name, or nullptr if it is not set
+    const char *param( const char *name ) const;
+
     // Log request info: print debug infos
     // about the request
     void printRequestInfos();
 
 
+    FCGX_Request *mFcgiRequest = nullptr;
     QByteArray mData;
     bool       mHasError;
 };
@@ -30,8 +30,9 @@
 // QgsFcgiServerResponse
 //
 
-QgsFcgiServerResponse::QgsFcgiServerResponse( QgsServerRequest::Method method )
-  : mMethod( method )
+QgsFcgiServerResponse::QgsFcgiServerResponse( QgsServerRequest::Method method, FCGX_Request *fcgiRequest )
+  : mFcgiRequest( fcgiRequest )
+  , mMethod( method )
 {
   mBuffer.open( QIODevice::ReadWrite );
   setDefaultHeaders();
@@ -110,14 +111,16 @@ void QgsFcgiServerResponse::flush()
   {
     // Send all headers
     QMap<QString, QString>::const_iterator it;
+    QByteArray headers;
     for ( it = mHeaders.constBegin(); it != mHeaders.constEnd(); ++it )
     {
-      fputs( it.key().toUtf8(), FCGI_stdout );
-      fputs( ": ", FCGI_stdout );
-      fputs( it.value().toUtf8(), FCGI_stdout );
-      fputs( "\n", FCGI_stdout );
+      headers.append( it.key().toUtf8() );
+      headers.append( ": " );
+      headers.append( it.value().toUtf8() );
+      headers.append( "\n" );
     }
-    fputs( "\n", FCGI_stdout );
+    headers.append( "\n" );
+    sendData( headers.constData(), headers.size() );
     mHeadersSent = true;
   }
 
@@ -131,14 +134,31 @@ void QgsFcgiServerResponse::flush()
   else if ( mBuffer.bytesAvailable() > 0 )
   {
     QByteArray &ba = mBuffer.buffer();
-    size_t count   = fwrite( ( void * )ba.data(), ba.size(), 1, FCGI_stdout );
+    sendData( ba.constData(), ba.size() );
+    // Reset the internal buffer
+    ba.clear();
+  }
+}
+
+void QgsFcgiServerResponse::sendData( const char *data, int size )
+{
+  if ( mFcgiRequest )
+  {
+    int count = FCGX_PutStr( data, size, mFcgiRequest->out );
 #ifdef QGISDEBUG
-    qDebug() << QStringLiteral( "Sent %1 blocks of %2 bytes" ).arg( count ).arg( ba.size() );
+    qDebug() << QStringLiteral( "Sent %1 of %2 bytes" ).arg( count ).arg( size );
+#else
+    Q_UNUSED( count );
+#endif
+  }
+  else
+  {
+    size_t count = fwrite( ( void * )data, size, 1, FCGI_stdout );
+#ifdef QGISDEBUG
+    qDebug() << QStringLiteral( "Sent %1 blocks of %2 bytes" ).arg( count ).arg( size );
 #else
     Q_UNUSED( count );
 #endif
-    // Reset the internal buffer
-    ba.clear();
   }
 }
 
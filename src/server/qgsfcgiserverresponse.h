@@ -27,6 +27,8 @@
 
 #include <QBuffer>
 
+struct FCGX_Request;
+
 /**
  * \ingroup server
  * QgsFcgiServerResponse
@@ -36,7 +38,14 @@ class SERVER_EXPORT QgsFcgiServerResponse: public QgsServerResponse
 {
   public:
 
-    QgsFcgiServerResponse( QgsServerRequest::Method method = QgsServerRequest::GetMethod );
+    /**
+     * Constructor for QgsFcgiServerResponse.
+     *
+     * If \a fcgiRequest is set, the response is written to the output stream of
+     * this FastCGI request, otherwise it is written to the standard output set up
+     * by FCGI_Accept().
+     */
+    QgsFcgiServerResponse( QgsServerRequest::Method method = QgsServerRequest::GetMethod, FCGX_Request *fcgiRequest = nullptr );
 
     void setHeader( const QString &key, const QString &value ) override;
 
@@ -72,6 +81,10 @@ class SERVER_EXPORT QgsFcgiServerResponse: public QgsServerResponse
     void setDefaultHeaders();
 
   private:
+    //! Writes \a size bytes of \a data to the FastCGI output stream
+    void sendData( const char *data, int size );
+
+    FCGX_Request *mFcgiRequest = nullptr;
     QMap<QString, QString> mHeaders;
     QBuffer mBuffer;
     bool mFinished    = false;
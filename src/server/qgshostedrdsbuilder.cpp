@@ -18,7 +18,6 @@
 
 #include "qgshostedrdsbuilder.h"
 #include "qgslogger.h"
-#include "qgsmslayercache.h"
 #include "qgsrasterlayer.h"
 #include "qgscoordinatereferencesystem.h"
 
@@ -49,7 +48,7 @@ QgsMapLayer *QgsHostedRDSBuilder::createMapLayer( const QDomElement &elem,
     QgsRasterLayer *rl = nullptr;
     if ( allowCaching )
     {
-      rl = qobject_cast<QgsRasterLayer *>( QgsMSLayerCache::instance()->searchLayer( uri, layerName ) );
+      rl = qobject_cast<QgsRasterLayer *>( cachedLayer( uri, layerName, layersToRemove ) );
     }
     if ( !rl || !rl->isValid() )
     {
@@ -57,7 +56,7 @@ QgsMapLayer *QgsHostedRDSBuilder::createMapLayer( const QDomElement &elem,
       rl = new QgsRasterLayer( uri, layerNameFromUri( uri ) );
       if ( allowCaching )
       {
-        QgsMSLayerCache::instance()->insertLayer( uri, layerName, rl );
+        rl = qobject_cast<QgsRasterLayer *>( cacheLayer( uri, layerName, rl, layersToRemove ) );
       }
       else
       {
@@ -16,7 +16,6 @@
  ***************************************************************************/
 
 #include "qgshostedvdsbuilder.h"
-#include "qgsmslayercache.h"
 #include "qgslogger.h"
 #include "qgscoordinatereferencesystem.h"
 #include "qgsvectorlayer.h"
@@ -48,7 +47,7 @@ QgsMapLayer *QgsHostedVDSBuilder::createMapLayer( const QDomElement &elem,
   if ( allowCaching ) //take layer from cache if allowed
   {
     QgsDebugMsg( "Taking hostedvds layer from cash" );
-    ml = QgsMSLayerCache::instance()->searchLayer( uri, layerName );
+    ml = cachedLayer( uri, layerName, layersToRemove );
   }
 
   if ( !ml )
@@ -65,7 +64,7 @@ QgsMapLayer *QgsHostedVDSBuilder::createMapLayer( const QDomElement &elem,
 
     if ( allowCaching )
     {
-      QgsMSLayerCache::instance()->insertLayer( uri, layerName, ml );
+      ml = cacheLayer( uri, layerName, ml, layersToRemove );
     }
     else
     {
@@ -16,6 +16,7 @@
  ***************************************************************************/
 
 #include "qgsmslayerbuilder.h"
+#include "qgsmslayercache.h"
 #include "qgsraster.h"
 #include "qgsrasterlayer.h"
 #include "qgsrasterrendererregistry.h"
@@ -89,3 +90,24 @@ void QgsMSLayerBuilder::clearRasterSymbology( QgsRasterLayer *rl ) const
     }
   }
 }
+
+QgsMapLayer *QgsMSLayerBuilder::cachedLayer( const QString &url, const QString &layerName, QList<QgsMapLayer *> &layersToRemove ) const
+{
+  std::shared_ptr< QgsMapLayer > layer = QgsMSLayerCache::instance()->searchLayer( url, layerName );
+  if ( !layer )
+    return nullptr;
+
+  QgsMapLayer *copy = layer->clone();
+  if ( copy )
+    layersToRemove.push_back( copy );
+  return copy;
+}
+
+QgsMapLayer *QgsMSLayerBuilder::cacheLayer( const QString &url, const QString &layerName, QgsMapLayer *layer, QList<QgsMapLayer *> &layersToRemove ) const
+{
+  QgsMapLayer *copy = layer->clone();
+  QgsMSLayerCache::instance()->insertLayer( url, layerName, layer );
+  if ( copy )
+    layersToRemove.push_back( copy );
+  return copy;
+}
@@ -26,6 +26,7 @@
 class QgsMapLayer;
 class QgsRasterLayer;
 class QDomElement;
+class QString;
 class QTemporaryFile;
 
 #include <QList>
@@ -59,6 +60,15 @@ class QgsMSLayerBuilder
     /** Resets the former symbology of a raster layer. This is important for single band layers (e.g. dems)
      coming from the cash*/
     void clearRasterSymbology( QgsRasterLayer *rl ) const;
+
+    /** Returns a copy of the layer cached for \a url and \a layerName, or nullptr if no such layer is cached.
+     The cached layers are shared by all requests, so each request works on a copy of its own, which is
+     appended to \a layersToRemove*/
+    QgsMapLayer *cachedLayer( const QString &url, const QString &layerName, QList<QgsMapLayer *> &layersToRemove ) const;
+
+    /** Inserts \a layer into the layer cache, which takes ownership of it, and returns a copy of the layer
+     for the current request. The copy is appended to \a layersToRemove*/
+    QgsMapLayer *cacheLayer( const QString &url, const QString &layerName, QgsMapLayer *layer, QList<QgsMapLayer *> &layersToRemove ) const;
 };
 
 #endif
@@ -17,12 +17,49 @@
 
 #include "qgsmslayercache.h"
 #include "qgsmessagelog.h"
-#include "qgsproject.h"
 #include "qgsmaplayer.h"
 #include "qgsvectorlayer.h"
 #include "qgslogger.h"
 #include "qgsserversettings.h"
 #include <QFile>
+#include <QThread>
+
+///@cond PRIVATE
+
+//! Deletes a cached layer and its temporary files once the layer is not in use anymore
+class QgsMSLayerCacheDeleter
+{
+  public:
+    explicit QgsMSLayerCacheDeleter( const QList<QString> &temporaryFiles )
+      : mTemporaryFiles( temporaryFiles )
+    {}
+
+    void operator()( QgsMapLayer *layer ) const
+    {
+      // the last request using the layer may be handled by another thread than the one of the cache
+      if ( layer->thread() == QThread::currentThread() )
+        delete layer;
+      else
+        layer->deleteLater();
+
+      //remove the temporary files of a layer
+      Q_FOREACH ( const QString &file, mTemporaryFiles )
+      {
+        //remove the temporary file
+        QFile removeFile( file );
+        if ( !removeFile.remove() )
+        {
+          QgsDebugMsg( "could not remove file: " + file );
+          QgsDebugMsg( removeFile.errorString() );
+        }
+      }
+    }
+
+  private:
+    QList<QString> mTemporaryFiles;
+};
+
+///@endcond
 
 QgsMSLayerCache *QgsMSLayerCache::instance()
 {
@@ -40,21 +77,19 @@ QgsMSLayerCache::QgsMSLayerCache()
 QgsMSLayerCache::~QgsMSLayerCache()
 {
   QgsDebugMsg( "removing all entries" );
-  Q_FOREACH ( QgsMSLayerCacheEntry entry, mEntries )
-  {
-    delete entry.layerPointer;
-  }
   mEntries.clear();
 }
 
 void QgsMSLayerCache::setMaxCacheLayers( int maxCacheLayers )
 {
+  QMutexLocker locker( &mMutex );
   mDefaultMaxLayers = maxCacheLayers;
 }
 
 void QgsMSLayerCache::insertLayer( const QString &url, const QString &layerName, QgsMapLayer *layer, const QString &configFile, const QList<QString> &tempFiles )
 {
   QgsMessageLog::logMessage( "Layer cache: insert Layer '" + layerName + "' configFile: " + configFile, QStringLiteral( "Server" ), QgsMessageLog::INFO );
+  QMutexLocker locker( &mMutex );
   if ( mEntries.size() > std::max( mDefaultMaxLayers, mProjectMaxLayers ) ) //force cache layer examination after 10 inserted layers
   {
     updateEntries();
@@ -62,8 +97,11 @@ void QgsMSLayerCache::insertLayer( const QString &url, const QString &layerName,
 
   QPair<QString, QString> urlLayerPair = qMakePair( url, layerName );
 
+  // the layer is shared by all threads, it must not belong to the thread handling the current request
+  layer->moveToThread( thread() );
+
   QgsMSLayerCacheEntry newEntry;
-  newEntry.layerPointer = layer;
+  newEntry.layer = std::shared_ptr< QgsMapLayer >( layer, QgsMSLayerCacheDeleter( tempFiles ) );
   newEntry.url = url;
   newEntry.creationTime = time( nullptr );
   newEntry.lastUsedTime = time( nullptr );
@@ -79,7 +117,7 @@ void QgsMSLayerCache::insertLayer( const QString &url, const QString &layerName,
     if ( configIt == mConfigFiles.constEnd() )
     {
       mConfigFiles.insert( configFile, 1 );
-      mFileSystemWatcher.addPath( configFile );
+      QMetaObject::invokeMethod( this, "watchPath", Q_ARG( QString, configFile ) );
     }
     else
     {
@@ -88,8 +126,9 @@ void QgsMSLayerCache::insertLayer( const QString &url, const QString &layerName,
   }
 }
 
-QgsMapLayer *QgsMSLayerCache::searchLayer( const QString &url, const QString &layerName, const QString &configFile )
+std::shared_ptr< QgsMapLayer > QgsMSLayerCache::searchLayer( const QString &url, const QString &layerName, const QString &configFile )
 {
+  QMutexLocker locker( &mMutex );
   QPair<QString, QString> urlNamePair = qMakePair( url, layerName );
   if ( !mEntries.contains( urlNamePair ) )
   {
@@ -106,7 +145,7 @@ QgsMapLayer *QgsMSLayerCache::searchLayer( const QString &url, const QString &la
       {
         layerIt->lastUsedTime = time( nullptr );
         QgsMessageLog::logMessage( "Layer '" + layerName + "' configFile: " + configFile + " found in layer cache", QStringLiteral( "Server" ), QgsMessageLog::INFO );
-        return layerIt->layerPointer;
+        return layerIt->layer;
       }
     }
     QgsMessageLog::logMessage( "Layer '" + layerName + "' configFile: " + configFile + " not found in layer cache'", QStringLiteral( "Server" ), QgsMessageLog::INFO );
@@ -116,6 +155,7 @@ QgsMapLayer *QgsMSLayerCache::searchLayer( const QString &url, const QString &la
 
 void QgsMSLayerCache::removeProjectFileLayers( const QString &project )
 {
+  QMutexLocker locker( &mMutex );
   QgsMessageLog::logMessage( "Removing cache entries for project file: " + project, QStringLiteral( "Server" ), QgsMessageLog::INFO );
   QVector< QPair< QString, QString > > removeEntries;
   QVector< QgsMSLayerCacheEntry > removeEntriesValues;
@@ -175,30 +215,15 @@ void QgsMSLayerCache::removeLeastUsedEntry()
     }
   }
 
-  QgsMessageLog::logMessage( "Removing last accessed layer '" + lowest_it.value().layerPointer->name() + "' project file " + lowest_it.value().configFile + " from cache", QStringLiteral( "Server" ), QgsMessageLog::INFO );
+  QgsMessageLog::logMessage( "Removing last accessed layer '" + lowest_it.value().layer->name() + "' project file " + lowest_it.value().configFile + " from cache", QStringLiteral( "Server" ), QgsMessageLog::INFO );
   freeEntryResources( *lowest_it );
   mEntries.erase( lowest_it );
 }
 
 void QgsMSLayerCache::freeEntryResources( QgsMSLayerCacheEntry &entry )
 {
-  // remove layer from QgsProject before delete it
-  if ( QgsProject::instance()->mapLayer( entry.layerPointer->id() ) )
-    QgsProject::instance()->removeMapLayer( entry.layerPointer->id() );
-
-  delete entry.layerPointer;
-
-  //remove the temporary files of a layer
-  Q_FOREACH ( const QString &file, entry.temporaryFiles )
-  {
-    //remove the temporary file
-    QFile removeFile( file );
-    if ( !removeFile.remove() )
-    {
-      QgsDebugMsg( "could not remove file: " + file );
-      QgsDebugMsg( removeFile.errorString() );
-    }
-  }
+  // the layer and its temporary files are deleted together with the last copy of the
+  // entry, or later if a request still uses the layer
 
   //counter
   if ( !entry.configFile.isEmpty() )
@@ -207,7 +232,7 @@ void QgsMSLayerCache::freeEntryResources( QgsMSLayerCacheEntry &entry )
     if ( configFileCount < 2 )
     {
       mConfigFiles.remove( entry.configFile );
-      mFileSystemWatcher.removePath( entry.configFile );
+      QMetaObject::invokeMethod( this, "unwatchPath", Q_ARG( QString, entry.configFile ) );
     }
     else
     {
@@ -218,11 +243,12 @@ void QgsMSLayerCache::freeEntryResources( QgsMSLayerCacheEntry &entry )
 
 void QgsMSLayerCache::logCacheContents() const
 {
+  QMutexLocker locker( &mMutex );
   QgsMessageLog::logMessage( QStringLiteral( "Layer cache contents:" ), QStringLiteral( "Server" ), QgsMessageLog::INFO );
   QHash<QPair<QString, QString>, QgsMSLayerCacheEntry>::const_iterator it = mEntries.constBegin();
   for ( ; it != mEntries.constEnd(); ++it )
   {
-    QgsMessageLog::logMessage( "Url: " + it.value().url + " Layer name: " + it.value().layerPointer->name() + " Project: " + it.value().configFile, QStringLiteral( "Server" ), QgsMessageLog::INFO );
+    QgsMessageLog::logMessage( "Url: " + it.value().url + " Layer name: " + it.value().layer->name() + " Project: " + it.value().configFile, QStringLiteral( "Server" ), QgsMessageLog::INFO );
   }
 }
 
@@ -231,3 +257,13 @@ void QgsMSLayerCache::removeProjectLayers( const QString &path )
 {
   removeProjectFileLayers( path );
 }
+
+void QgsMSLayerCache::watchPath( const QString &path )
+{
+  mFileSystemWatcher.addPath( path );
+}
+
+void QgsMSLayerCache::unwatchPath( const QString &path )
+{
+  mFileSystemWatcher.removePath( path );
+}
@@ -24,10 +24,13 @@
 #include <ctime>
 #include <QFileSystemWatcher>
 #include <QMultiHash>
+#include <QMutex>
 #include <QObject>
 #include <QPair>
 #include <QString>
 
+#include <memory>
+
 class QgsMapLayer;
 
 struct QgsMSLayerCacheEntry
@@ -35,7 +38,7 @@ struct QgsMSLayerCacheEntry
   time_t creationTime; //time this layer was created
   time_t lastUsedTime; //last time this layer was in use
   QString url; //datasource url
-  QgsMapLayer *layerPointer = nullptr;
+  std::shared_ptr< QgsMapLayer > layer; //the layer, which is deleted together with its temporary files once it is not in use anymore
   QList<QString> temporaryFiles; //path to the temporary files written for the layer
   QString configFile; //path to the project file associated with the layer
 
@@ -44,14 +47,15 @@ struct QgsMSLayerCacheEntry
     return ( creationTime == other.creationTime
              && lastUsedTime == other.lastUsedTime
              && url == other.url
-             && layerPointer == other.layerPointer
+             && layer == other.layer
              && temporaryFiles == other.temporaryFiles
              && configFile == other.configFile );
   }
 };
 
 /** A singleton class that caches layer objects for the
-QGIS mapserver*/
+QGIS mapserver. The cache is shared by all threads handling requests. The cached
+layers must not be changed, requests work on copies of them.*/
 class QgsMSLayerCache: public QObject
 {
     Q_OBJECT
@@ -70,12 +74,14 @@ class QgsMSLayerCache: public QObject
     \param url the layer datasource
     \param layerName the layer name (to distinguish between different layers in a request using the same datasource
     \param configFile path of the config file (to invalidate entries if file changes). Can be empty (e.g. layers from sld)
-    \param tempFiles some layers have temporary files. The cash makes sure they are removed when removing the layer from the cash*/
+    \param tempFiles some layers have temporary files. The cash makes sure they are removed when removing the layer from the cash
+    The cache takes ownership of the layer, which is moved to the thread of the cache.*/
     void insertLayer( const QString &url, const QString &layerName, QgsMapLayer *layer, const QString &configFile = QString(), const QList<QString> &tempFiles = QList<QString>() );
 
     /** Searches for the layer with the given url.
-     \returns a pointer to the layer or 0 if no such layer*/
-    QgsMapLayer *searchLayer( const QString &url, const QString &layerName, const QString &configFile = QString() );
+     \returns the layer or nullptr if no such layer. The layer stays valid as long as the returned pointer is kept,
+     even if it is removed from the cache in the meantime. It must not be changed.*/
+    std::shared_ptr< QgsMapLayer > searchLayer( const QString &url, const QString &layerName, const QString &configFile = QString() );
 
     int projectsMaxLayers() const { return mProjectMaxLayers; }
 
@@ -97,7 +103,8 @@ class QgsMSLayerCache: public QObject
     void updateEntries();
     //! Removes the cash entry with the lowest 'lastUsedTime'
     void removeLeastUsedEntry();
-    //! Frees memory and removes temporary files of an entry
+    /** Frees the resources of an entry which is removed. The layer and its temporary files
+     are deleted once the last request using the layer is finished*/
     void freeEntryResources( QgsMSLayerCacheEntry &entry );
 
   private:
@@ -119,10 +126,19 @@ class QgsMSLayerCache: public QObject
     //! Maximum number of layers in the cache, overrides DEFAULT_MAX_N_LAYERS if larger
     int mProjectMaxLayers = 100;
 
+    //! Protects the entries and config files
+    mutable QMutex mMutex;
+
   private slots:
 
     //! Removes entries from a project (e.g. if a project file has changed)
     void removeProjectFileLayers( const QString &project );
+
+    //! Watches the file at \a path, called in the thread of the cache
+    void watchPath( const QString &path );
+
+    //! Stops watching the file at \a path, called in the thread of the cache
+    void unwatchPath( const QString &path );
 };
 
 #endif
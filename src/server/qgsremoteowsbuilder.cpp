@@ -18,7 +18,6 @@
 #include "qgsdatasourceuri.h"
 #include "qgsremoteowsbuilder.h"
 #include "qgslogger.h"
-#include "qgsmslayercache.h"
 #include "qgsrasterlayer.h"
 #include "qgsvectorlayer.h"
 #include <QDomElement>
@@ -92,7 +91,7 @@ QgsMapLayer *QgsRemoteOWSBuilder::createMapLayer(
 
     if ( allowCaching )
     {
-      result = QgsMSLayerCache::instance()->searchLayer( url, layerName );
+      result = cachedLayer( url, layerName, layersToRemove );
     }
     if ( result )
     {
@@ -103,7 +102,7 @@ QgsMapLayer *QgsRemoteOWSBuilder::createMapLayer(
     {
       if ( allowCaching )
       {
-        QgsMSLayerCache::instance()->insertLayer( url, layerName, result );
+        result = cacheLayer( url, layerName, result, layersToRemove );
       }
       else
       {
@@ -147,7 +146,7 @@ QgsRasterLayer *QgsRemoteOWSBuilder::wmsLayerFromUrl( const QString &url, const
 
   if ( allowCaching )
   {
-    result = qobject_cast<QgsRasterLayer *>( QgsMSLayerCache::instance()->searchLayer( url, layerName ) );
+    result = qobject_cast<QgsRasterLayer *>( cachedLayer( url, layerName, layersToRemove ) );
   }
 
   if ( result )
@@ -209,7 +208,7 @@ QgsRasterLayer *QgsRemoteOWSBuilder::wmsLayerFromUrl( const QString &url, const
   //insert into cache
   if ( allowCaching )
   {
-    QgsMSLayerCache::instance()->insertLayer( url, layerName, result );
+    result = qobject_cast<QgsRasterLayer *>( cacheLayer( url, layerName, result, layersToRemove ) );
   }
   else
   {
@@ -279,7 +278,7 @@ QgsVectorLayer *QgsRemoteOWSBuilder::sosLayer( const QDomElement &remoteOWSElem,
   QgsVectorLayer *sosLayer = nullptr;
   if ( allowCaching )
   {
-    sosLayer = qobject_cast<QgsVectorLayer *>( QgsMSLayerCache::instance()->searchLayer( providerUrl, layerName ) );
+    sosLayer = qobject_cast<QgsVectorLayer *>( cachedLayer( providerUrl, layerName, layersToRemove ) );
     if ( sosLayer )
     {
       return sosLayer;
@@ -297,7 +296,7 @@ QgsVectorLayer *QgsRemoteOWSBuilder::sosLayer( const QDomElement &remoteOWSElem,
   {
     if ( allowCaching )
     {
-      QgsMSLayerCache::instance()->insertLayer( providerUrl, layerName, sosLayer );
+      sosLayer = qobject_cast<QgsVectorLayer *>( cacheLayer( providerUrl, layerName, sosLayer, layersToRemove ) );
     }
     else
     {
@@ -348,8 +348,9 @@ void QgsServer::handleRequest( QgsServerRequest &request, QgsServerResponse &res
       //Config file path
       QString configFilePath = configPath( *sConfigFilePath, parameterMap );
 
-      // load the project if needed and not empty
-      const QgsProject *project = mConfigCache->project( configFilePath );
+      // load the project if needed and not empty, the project is shared with the
+      // requests handled by other threads and kept alive until the request is finished
+      std::shared_ptr< const QgsProject > project = mConfigCache->sharedProject( configFilePath );
       if ( ! project )
       {
         throw QgsServerException( QStringLiteral( "Project file error" ) );
@@ -383,7 +384,7 @@ void QgsServer::handleRequest( QgsServerRequest &request, QgsServerResponse &res
       QgsService *service = sServiceRegistry.getService( serviceString, versionString );
       if ( service )
       {
-        service->executeRequest( request, responseDecorator, project );
+        service->executeRequest( request, responseDecorator, project.get() );
       }
       else
       {
@@ -16,6 +16,13 @@
  ***************************************************************************/
 
 #include "qgsserverprojectutils.h"
+#include "qgsapplication.h"
+#include "qgspluginlayerregistry.h"
+#include "qgsrasterlayer.h"
+#include "qgsreadwritecontext.h"
+#include "qgsvectorlayer.h"
+
+#include <memory>
 
 bool QgsServerProjectUtils::owsServiceCapabilities( const QgsProject &project )
 {
@@ -343,3 +350,38 @@ QStringList QgsServerProjectUtils::wcsLayerIds( const QgsProject &project )
 {
   return project.readListEntry( QStringLiteral( "WCSLayers" ), QStringLiteral( "/" ) );
 }
+
+QgsMapLayer *QgsServerProjectUtils::cloneLayer( const QgsMapLayer &layer, const QgsProject &project )
+{
+  QgsReadWriteContext context;
+  context.setPathResolver( project.pathResolver() );
+
+  QDomDocument document;
+  QDomElement layerElem = document.createElement( QStringLiteral( "maplayer" ) );
+  if ( !layer.writeLayerXml( layerElem, document, context ) )
+    return nullptr;
+
+  std::unique_ptr< QgsMapLayer > clone;
+  QString type = layerElem.attribute( QStringLiteral( "type" ) );
+  if ( type == QLatin1String( "vector" ) )
+  {
+    std::unique_ptr< QgsVectorLayer > vl( new QgsVectorLayer() );
+    vl->setReadExtentFromXml( project.trustLayerMetadata() );
+    clone.reset( vl.release() );
+  }
+  else if ( type == QLatin1String( "raster" ) )
+  {
+    clone.reset( new QgsRasterLayer() );
+  }
+  else if ( type == QLatin1String( "plugin" ) )
+  {
+    clone.reset( QgsApplication::pluginLayerRegistry()->createLayer( layerElem.attribute( QStringLiteral( "name" ) ) ) );
+  }
+
+  if ( !clone || !clone->readLayerXml( layerElem, context ) || !clone->isValid() )
+    return nullptr;
+
+  // joins refer to other layers of the project, which are only read
+  clone->resolveReferences( const_cast< QgsProject * >( &project ) );
+  return clone.release();
+}
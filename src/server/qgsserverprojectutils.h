@@ -301,6 +301,16 @@ namespace QgsServerProjectUtils
     * \returns the Layer ids list.
     */
   SERVER_EXPORT QStringList wcsLayerIds( const QgsProject &project );
+
+  /** Returns a copy of a layer of the project, which a request may change (e.g. its style or filter).
+    * The projects are shared by all requests, so their layers must not be changed.
+    * The copy is made through the layer's XML, so it has the same id, styles and subset string as the layer.
+    * \param layer the layer to copy
+    * \param project the QGIS project of the layer
+    * \returns the copy, or nullptr if the layer could not be loaded again
+    * \since QGIS 3.0
+    */
+  SERVER_EXPORT QgsMapLayer *cloneLayer( const QgsMapLayer &layer, const QgsProject &project ) SIP_FACTORY;
 };
 
 #endif
@@ -130,6 +130,17 @@ void QgsServerSettings::initSettings()
                                QVariant()
                              };
   mSettings[ sCacheSize.envVar ] = sCacheSize;
+
+  // fcgi workers
+  const Setting sFcgiWorkers = { QgsServerSettingsEnv::QGIS_SERVER_FCGI_WORKERS,
+                                 QgsServerSettingsEnv::DEFAULT_VALUE,
+                                 "Number of threads accepting FastCGI requests",
+                                 "/qgis/fcgi_workers",
+                                 QVariant::Int,
+                                 QVariant( 1 ),
+                                 QVariant()
+                               };
+  mSettings[ sFcgiWorkers.envVar ] = sFcgiWorkers;
 }
 
 void QgsServerSettings::load()
@@ -276,6 +287,11 @@ int QgsServerSettings::maxThreads() const
   return value( QgsServerSettingsEnv::QGIS_SERVER_MAX_THREADS ).toInt();
 }
 
+int QgsServerSettings::fcgiWorkers() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_FCGI_WORKERS ).toInt();
+}
+
 QString QgsServerSettings::logFile() const
 {
   return value( QgsServerSettingsEnv::QGIS_SERVER_LOG_FILE ).toString();
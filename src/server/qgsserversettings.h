@@ -56,7 +56,8 @@ class SERVER_EXPORT QgsServerSettingsEnv : public QObject
       QGIS_PROJECT_FILE,
       MAX_CACHE_LAYERS,
       QGIS_SERVER_CACHE_DIRECTORY,
-      QGIS_SERVER_CACHE_SIZE
+      QGIS_SERVER_CACHE_SIZE,
+      QGIS_SERVER_FCGI_WORKERS
     };
     Q_ENUM( EnvVar )
 };
@@ -113,6 +114,14 @@ class SERVER_EXPORT QgsServerSettings
       */
     int maxThreads() const;
 
+    /**
+      * Returns the number of worker threads accepting FastCGI requests.
+      * \returns the number of worker threads, 1 means that requests are handled
+      * one after the other in the main thread.
+      * \since QGIS 3.0
+      */
+    int fcgiWorkers() const;
+
     /**
       * Returns the maximum number of cached layers.
       * \returns the number of cached layers.
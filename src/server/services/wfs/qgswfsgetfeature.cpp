@@ -31,12 +31,14 @@
 #include "qgsvectorlayer.h"
 #include "qgsfilterrestorer.h"
 #include "qgsproject.h"
+#include "qgsmaplayerstore.h"
 #include "qgsogcutils.h"
 #include "qgsjsonutils.h"
 
 #include "qgswfsgetfeature.h"
 
 #include <QStringList>
+#include <QTextStream>
 
 namespace QgsWfs
 {
@@ -48,13 +50,23 @@ namespace QgsWfs
                                   const QSet<QString> &excludedAttributes, const QString &typeName, bool withGeom,
                                   const QString &geometryName );
 
-    QDomElement createFeatureGML2( QgsFeature *feat, QDomDocument &doc, int prec, QgsCoordinateReferenceSystem &crs,
-                                   const QgsAttributeList &attrIndexes, const QSet<QString> &excludedAttributes, const QString &typeName,
-                                   bool withGeom, const QString &geometryName );
+    QString createFeatureGML2( QgsFeature *feat, int prec, QgsCoordinateReferenceSystem &crs,
+                               const QgsAttributeList &attrIndexes, const QSet<QString> &excludedAttributes, const QString &typeName,
+                               bool withGeom, const QString &geometryName );
 
-    QDomElement createFeatureGML3( QgsFeature *feat, QDomDocument &doc, int prec, QgsCoordinateReferenceSystem &crs,
-                                   const QgsAttributeList &attrIndexes, const QSet<QString> &excludedAttributes, const QString &typeName,
-                                   bool withGeom, const QString geometryName );
+    QString createFeatureGML3( QgsFeature *feat, int prec, QgsCoordinateReferenceSystem &crs,
+                               const QgsAttributeList &attrIndexes, const QSet<QString> &excludedAttributes, const QString &typeName,
+                               bool withGeom, const QString &geometryName );
+
+    void writeGMLFeatureEnd( QString &gml, const QgsFeature *feat, const QgsAttributeList &attrIndexes, const QSet<QString> &excludedAttributes,
+                             const QString &typeName, bool hasContent );
+
+    void writeGMLFragment( QString &gml, const QDomElement &element, int depth );
+
+    QString encodeXmlText( const QString &text, bool attributeValue );
+
+    //! Size of the output buffered before it is flushed to the client
+    const qint64 STREAM_CHUNK_SIZE = 64 * 1024;
 
     void startGetFeature( const QgsServerRequest &request, QgsServerResponse &response, const QgsProject *project, const QString &format,
                           int prec, QgsCoordinateReferenceSystem &crs, QgsRectangle *rect, const QStringList &typeNames );
@@ -158,13 +170,17 @@ namespace QgsWfs
 
     QgsAccessControl *accessControl = serverIface->accessControls();
 
+    // the project is shared by all requests, so the filters are applied to copies of the layers
+    QgsMapLayerStore requestLayers;
+
     //scoped pointer to restore all original layer filters (subsetStrings) when pointer goes out of scope
     //there's LOTS of potential exit paths here, so we avoid having to restore the filters manually
     std::unique_ptr< QgsOWSServerFilterRestorer > filterRestorer( new QgsOWSServerFilterRestorer( accessControl ) );
 
     // features counters
     long sentFeatures = 0;
-    long iteratedFeatures = 0;
+    // features still to skip before the first one is sent
+    long skipFeatures = aRequest.startIndex;
     // sent features
     QgsFeature feature;
     qIt = aRequest.queries.begin();
@@ -184,6 +200,10 @@ namespace QgsWfs
         throw QgsSecurityAccessException( QStringLiteral( "Feature access permission denied" ) );
       }
 
+      if ( QgsMapLayer *requestLayer = requestLayers.mapLayer( layer->id() ) )
+        layer = requestLayer;
+      else
+        layer = requestLayers.addMapLayer( QgsServerProjectUtils::cloneLayer( *layer, *project ) );
       QgsVectorLayer *vlayer = qobject_cast<QgsVectorLayer *>( layer );
       if ( !vlayer )
       {
@@ -292,8 +312,10 @@ namespace QgsWfs
 
       if ( aRequest.maxFeatures > 0 )
       {
-        featureRequest.setLimit( aRequest.maxFeatures + aRequest.startIndex - sentFeatures );
+        featureRequest.setLimit( aRequest.maxFeatures - sentFeatures );
       }
+      // let the provider skip the features before the start index
+      featureRequest.setOffset( skipFeatures );
       // specific layer precision
       int layerPrecision = QgsServerProjectUtils::wfsLayerPrecision( *project, vlayer->id() );
       // specific layer crs
@@ -308,19 +330,35 @@ namespace QgsWfs
       }
 
       // Iterate through features
+      long layerSentFeatures = 0;
       QgsFeatureIterator fit = vlayer->getFeatures( featureRequest );
-      while ( fit.nextFeature( feature ) && ( aRequest.maxFeatures == -1 || sentFeatures < aRequest.maxFeatures ) )
+      while ( ( aRequest.maxFeatures == -1 || sentFeatures < aRequest.maxFeatures ) && fit.nextFeature( feature ) )
       {
-        if ( iteratedFeatures == aRequest.startIndex )
+        if ( sentFeatures == 0 )
           startGetFeature( request, response, project, aRequest.outputFormat, requestPrecision, requestCrs, &requestRect, typeNameList );
 
-        if ( iteratedFeatures >= aRequest.startIndex )
+        setGetFeature( response, aRequest.outputFormat, &feature, sentFeatures, layerPrecision, layerCrs, attrIndexes, layerExcludedAttributes,
+                       typeName, withGeom, geometryName );
+        ++sentFeatures;
+        ++layerSentFeatures;
+      }
+
+      if ( skipFeatures > 0 )
+      {
+        if ( layerSentFeatures > 0 )
         {
-          setGetFeature( response, aRequest.outputFormat, &feature, sentFeatures, layerPrecision, layerCrs, attrIndexes, layerExcludedAttributes,
-                         typeName, withGeom, geometryName );
-          ++sentFeatures;
+          skipFeatures = 0;
+        }
+        else
+        {
+          // the whole layer is before the start index, so the following layers need to skip less features
+          QgsFeatureRequest countRequest = featureRequest;
+          countRequest.setOffset( 0 );
+          countRequest.setLimit( skipFeatures );
+          QgsFeatureIterator countIt = vlayer->getFeatures( countRequest );
+          while ( countIt.nextFeature( feature ) )
+            --skipFeatures;
         }
-        ++iteratedFeatures;
       }
     }
 
@@ -330,7 +368,7 @@ namespace QgsWfs
 #endif
 
     // End of GetFeature
-    if ( iteratedFeatures <= aRequest.startIndex )
+    if ( sentFeatures == 0 )
       startGetFeature( request, response, project, aRequest.outputFormat, requestPrecision, requestCrs, &requestRect, typeNameList );
     endGetFeature( response, aRequest.outputFormat );
 
@@ -954,23 +992,21 @@ namespace QgsWfs
       }
       else
       {
-        QDomDocument gmlDoc;
-        QDomElement featureElement;
+        QString gml;
         if ( format == QLatin1String( "GML3" ) )
         {
-          featureElement = createFeatureGML3( feat, gmlDoc, prec, crs, attrIndexes, excludedAttributes, typeName, withGeom, geometryName );
-          gmlDoc.appendChild( featureElement );
+          gml = createFeatureGML3( feat, prec, crs, attrIndexes, excludedAttributes, typeName, withGeom, geometryName );
         }
         else
         {
-          featureElement = createFeatureGML2( feat, gmlDoc, prec, crs, attrIndexes, excludedAttributes, typeName, withGeom, geometryName );
-          gmlDoc.appendChild( featureElement );
+          gml = createFeatureGML2( feat, prec, crs, attrIndexes, excludedAttributes, typeName, withGeom, geometryName );
         }
-        response.write( gmlDoc.toByteArray() );
+        response.write( gml.toUtf8() );
       }
 
-      // Stream partial content
-      response.flush();
+      // Stream partial content, once enough has been collected
+      if ( response.io() && response.io()->size() >= STREAM_CHUNK_SIZE )
+        response.flush();
     }
 
     void endGetFeature( QgsServerResponse &response, const QString &format )
@@ -1044,22 +1080,24 @@ namespace QgsWfs
     }
 
 
-    QDomElement createFeatureGML2( QgsFeature *feat, QDomDocument &doc, int prec, QgsCoordinateReferenceSystem &crs, const QgsAttributeList &attrIndexes, const QSet<QString> &excludedAttributes, const QString &typeName, bool withGeom, const QString &geometryName )
+    QString createFeatureGML2( QgsFeature *feat, int prec, QgsCoordinateReferenceSystem &crs, const QgsAttributeList &attrIndexes, const QSet<QString> &excludedAttributes, const QString &typeName, bool withGeom, const QString &geometryName )
     {
+      // the feature is written as text, formatted the same way as a serialized QDomDocument.
+      // Only the geometry is still created as DOM element, which keeps memory bounded to a single geometry.
+
       //gml:FeatureMember
-      QDomElement featureElement = doc.createElement( QStringLiteral( "gml:featureMember" )/*wfs:FeatureMember*/ );
+      QString gml = QStringLiteral( "<gml:featureMember>\n" );
 
       //qgs:%TYPENAME%
-      QDomElement typeNameElement = doc.createElement( "qgs:" + typeName /*qgs:%TYPENAME%*/ );
-      typeNameElement.setAttribute( QStringLiteral( "fid" ), typeName + "." + QString::number( feat->id() ) );
-      featureElement.appendChild( typeNameElement );
+      gml += QStringLiteral( " <qgs:%1 fid=\"%2\"" ).arg( typeName, encodeXmlText( typeName + "." + QString::number( feat->id() ), true ) );
 
+      bool hasContent = false;
       if ( withGeom && geometryName != QLatin1String( "NONE" ) )
       {
         //add geometry column (as gml)
         QgsGeometry geom = feat->geometry();
 
-        QDomElement geomElem = doc.createElement( QStringLiteral( "qgs:geometry" ) );
+        QDomDocument doc;
         QDomElement gmlElem;
         if ( geometryName == QLatin1String( "EXTENT" ) )
         {
@@ -1083,7 +1121,6 @@ namespace QgsWfs
         if ( !gmlElem.isNull() )
         {
           QgsRectangle box = geom.boundingBox();
-          QDomElement bbElem = doc.createElement( QStringLiteral( "gml:boundedBy" ) );
           QDomElement boxElem = QgsOgcUtils::rectangleToGMLBox( &box, doc, prec );
 
           if ( crs.isValid() )
@@ -1092,56 +1129,34 @@ namespace QgsWfs
             gmlElem.setAttribute( QStringLiteral( "srsName" ), crs.authid() );
           }
 
-          bbElem.appendChild( boxElem );
-          typeNameElement.appendChild( bbElem );
-
-          geomElem.appendChild( gmlElem );
-          typeNameElement.appendChild( geomElem );
+          gml += QLatin1String( ">\n  <gml:boundedBy>\n" );
+          writeGMLFragment( gml, boxElem, 3 );
+          gml += QLatin1String( "  </gml:boundedBy>\n  <qgs:geometry>\n" );
+          writeGMLFragment( gml, gmlElem, 3 );
+          gml += QLatin1String( "  </qgs:geometry>\n" );
+          hasContent = true;
         }
       }
 
-      //read all attribute values from the feature
-      QgsAttributes featureAttributes = feat->attributes();
-      QgsFields fields = feat->fields();
-      for ( int i = 0; i < attrIndexes.count(); ++i )
-      {
-        int idx = attrIndexes[i];
-        if ( idx >= fields.count() )
-        {
-          continue;
-        }
-        QString attributeName = fields.at( idx ).name();
-        //skip attribute if it is excluded from WFS publication
-        if ( excludedAttributes.contains( attributeName ) )
-        {
-          continue;
-        }
-
-        QDomElement fieldElem = doc.createElement( "qgs:" + attributeName.replace( QStringLiteral( " " ), QStringLiteral( "_" ) ) );
-        QDomText fieldText = doc.createTextNode( featureAttributes[idx].toString() );
-        fieldElem.appendChild( fieldText );
-        typeNameElement.appendChild( fieldElem );
-      }
-
-      return featureElement;
+      writeGMLFeatureEnd( gml, feat, attrIndexes, excludedAttributes, typeName, hasContent );
+      return gml;
     }
 
-    QDomElement createFeatureGML3( QgsFeature *feat, QDomDocument &doc, int prec, QgsCoordinateReferenceSystem &crs, const QgsAttributeList &attrIndexes, const QSet<QString> &excludedAttributes, const QString &typeName, bool withGeom, const QString geometryName )
+    QString createFeatureGML3( QgsFeature *feat, int prec, QgsCoordinateReferenceSystem &crs, const QgsAttributeList &attrIndexes, const QSet<QString> &excludedAttributes, const QString &typeName, bool withGeom, const QString &geometryName )
     {
       //gml:FeatureMember
-      QDomElement featureElement = doc.createElement( QStringLiteral( "gml:featureMember" )/*wfs:FeatureMember*/ );
+      QString gml = QStringLiteral( "<gml:featureMember>\n" );
 
       //qgs:%TYPENAME%
-      QDomElement typeNameElement = doc.createElement( "qgs:" + typeName /*qgs:%TYPENAME%*/ );
-      typeNameElement.setAttribute( QStringLiteral( "gml:id" ), typeName + "." + QString::number( feat->id() ) );
-      featureElement.appendChild( typeNameElement );
+      gml += QStringLiteral( " <qgs:%1 gml:id=\"%2\"" ).arg( typeName, encodeXmlText( typeName + "." + QString::number( feat->id() ), true ) );
 
+      bool hasContent = false;
       if ( withGeom && geometryName != QLatin1String( "NONE" ) )
       {
         //add geometry column (as gml)
         QgsGeometry geom = feat->geometry();
 
-        QDomElement geomElem = doc.createElement( QStringLiteral( "qgs:geometry" ) );
+        QDomDocument doc;
         QDomElement gmlElem;
         if ( geometryName == QLatin1String( "EXTENT" ) )
         {
@@ -1165,7 +1180,6 @@ namespace QgsWfs
         if ( !gmlElem.isNull() )
         {
           QgsRectangle box = geom.boundingBox();
-          QDomElement bbElem = doc.createElement( QStringLiteral( "gml:boundedBy" ) );
           QDomElement boxElem = QgsOgcUtils::rectangleToGMLEnvelope( &box, doc, prec );
 
           if ( crs.isValid() )
@@ -1174,14 +1188,22 @@ namespace QgsWfs
             gmlElem.setAttribute( QStringLiteral( "srsName" ), crs.authid() );
           }
 
-          bbElem.appendChild( boxElem );
-          typeNameElement.appendChild( bbElem );
-
-          geomElem.appendChild( gmlElem );
-          typeNameElement.appendChild( geomElem );
+          gml += QLatin1String( ">\n  <gml:boundedBy>\n" );
+          writeGMLFragment( gml, boxElem, 3 );
+          gml += QLatin1String( "  </gml:boundedBy>\n  <qgs:geometry>\n" );
+          writeGMLFragment( gml, gmlElem, 3 );
+          gml += QLatin1String( "  </qgs:geometry>\n" );
+          hasContent = true;
         }
       }
 
+      writeGMLFeatureEnd( gml, feat, attrIndexes, excludedAttributes, typeName, hasContent );
+      return gml;
+    }
+
+    void writeGMLFeatureEnd( QString &gml, const QgsFeature *feat, const QgsAttributeList &attrIndexes, const QSet<QString> &excludedAttributes,
+                             const QString &typeName, bool hasContent )
+    {
       //read all attribute values from the feature
       QgsAttributes featureAttributes = feat->attributes();
       QgsFields fields = feat->fields();
@@ -1199,17 +1221,65 @@ namespace QgsWfs
           continue;
         }
 
-        QDomElement fieldElem = doc.createElement( "qgs:" + attributeName.replace( QStringLiteral( " " ), QStringLiteral( "_" ) ) );
-        QDomText fieldText = doc.createTextNode( featureAttributes[idx].toString() );
-        fieldElem.appendChild( fieldText );
-        typeNameElement.appendChild( fieldElem );
+        if ( !hasContent )
+        {
+          gml += QLatin1String( ">\n" );
+          hasContent = true;
+        }
+        const QString elementName = "qgs:" + attributeName.replace( QStringLiteral( " " ), QStringLiteral( "_" ) );
+        gml += QStringLiteral( "  <%1>%2</%1>\n" ).arg( elementName, encodeXmlText( featureAttributes[idx].toString(), false ) );
       }
 
-      return featureElement;
+      if ( hasContent )
+        gml += QStringLiteral( " </qgs:%1>\n" ).arg( typeName );
+      else
+        gml += QLatin1String( "/>\n" );
+      gml += QLatin1String( "</gml:featureMember>\n" );
     }
 
+    void writeGMLFragment( QString &gml, const QDomElement &element, int depth )
+    {
+      QString fragment;
+      QTextStream stream( &fragment );
+      element.save( stream, 1 );
+      stream.flush();
+
+      // indent the fragment to the depth it is written at
+      const QString indent( depth, ' ' );
+      const QStringList lines = fragment.split( '\n', QString::SkipEmptyParts );
+      for ( const QString &line : lines )
+      {
+        gml += indent + line + '\n';
+      }
+    }
 
-
+    QString encodeXmlText( const QString &text, bool attributeValue )
+    {
+      // same escaping rules as QDomDocument uses when serializing text and attribute nodes
+      QString encoded;
+      encoded.reserve( text.size() );
+      for ( int i = 0; i < text.size(); ++i )
+      {
+        const QChar c = text.at( i );
+        if ( c == '<' )
+          encoded += QLatin1String( "&lt;" );
+        else if ( c == '&' )
+          encoded += QLatin1String( "&amp;" );
+        else if ( c == '"' && attributeValue )
+          encoded += QLatin1String( "&quot;" );
+        else if ( c == '>' && i >= 2 && text.at( i - 1 ) == ']' && text.at( i - 2 ) == ']' )
+          encoded += QLatin1String( "&gt;" );
+        else if ( attributeValue && c == '\n' )
+          encoded += QLatin1String( "&#xa;" );
+        else if ( attributeValue && c == '\t' )
+          encoded += QLatin1String( "&#x9;" );
+        else if ( c == '\r' )
+          encoded += QLatin1String( "&#xd;" );
+        else
+          encoded += c;
+      }
+      return encoded;
+    }
 
   } // namespace
 
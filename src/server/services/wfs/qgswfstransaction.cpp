@@ -25,6 +25,7 @@
 #include "qgsexpression.h"
 #include "qgsgeometry.h"
 #include "qgsmaplayer.h"
+#include "qgsmaplayerstore.h"
 #include "qgsfeatureiterator.h"
 #include "qgsvectordataprovider.h"
 #include "qgsvectorlayer.h"
@@ -222,6 +223,9 @@ namespace QgsWfs
     // get access controls
     QgsAccessControl *accessControl = serverIface->accessControls();
 
+    // the project is shared by all requests, so the layers are edited through copies of them
+    QgsMapLayerStore requestLayers;
+
     //scoped pointer to restore all original layer filters (subsetStrings) when pointer goes out of scope
     //there's LOTS of potential exit paths here, so we avoid having to restore the filters manually
     std::unique_ptr< QgsOWSServerFilterRestorer > filterRestorer( new QgsOWSServerFilterRestorer( accessControl ) );
@@ -251,7 +255,7 @@ namespace QgsWfs
       }
 
       // get vector layer
-      QgsVectorLayer *vlayer = qobject_cast<QgsVectorLayer *>( layer );
+      QgsVectorLayer *vlayer = qobject_cast<QgsVectorLayer *>( requestLayers.addMapLayer( QgsServerProjectUtils::cloneLayer( *layer, *project ) ) );
       if ( !vlayer )
       {
         throw QgsRequestNotWellFormedException( QStringLiteral( "Layer error on '%1'" ).arg( name ) );
@@ -26,6 +26,8 @@
 #include "qgsvectorlayer.h"
 #include "qgsmaplayerstylemanager.h"
 
+#include <memory>
+
 namespace QgsWms
 {
 
@@ -168,17 +170,24 @@ namespace QgsWms
 
         if ( layer->type() == QgsMapLayer::VectorLayer )
         {
-          QgsVectorLayer *vlayer = qobject_cast<QgsVectorLayer *>( layer );
-          if ( vlayer->isSpatial() )
+          QgsVectorLayer *projectLayer = qobject_cast<QgsVectorLayer *>( layer );
+          if ( projectLayer->isSpatial() )
           {
-            QString currentStyle = vlayer->styleManager()->currentStyle();
+            // the project is shared by all requests, so the styles are switched on a copy of the layer
+            std::unique_ptr< QgsMapLayer > clone( QgsServerProjectUtils::cloneLayer( *projectLayer, *project ) );
+            QgsVectorLayer *vlayer = qobject_cast<QgsVectorLayer *>( clone.get() );
+            if ( !vlayer )
+            {
+              throw QgsServiceException( QStringLiteral( "LayerNotLoaded" ),
+                                         QStringLiteral( "Layer \"%1\" could not be loaded" ).arg( name ), 500 );
+            }
+
             Q_FOREACH ( QString styleName, vlayer->styleManager()->styles() )
             {
               vlayer->styleManager()->setCurrentStyle( styleName );
               QDomElement styleElem = vlayer->renderer()->writeSld( myDocument, styleName );
               namedLayerNode.appendChild( styleElem );
             }
-            vlayer->styleManager()->setCurrentStyle( currentStyle );
           }
         }
       }
@@ -64,7 +64,6 @@
 #include "qgsvectorlayerlabeling.h"
 #include "qgsvectorlayerfeaturecounter.h"
 #include "qgspallabeling.h"
-#include "qgslayerrestorer.h"
 #include "qgsdxfexport.h"
 #include "qgssymbollayerutils.h"
 
@@ -151,9 +150,6 @@ namespace QgsWms
     QgsLegendSettings legendSettings = mWmsParameters.legendSettings();
 
     // get layers
-    std::unique_ptr<QgsLayerRestorer> restorer;
-    restorer.reset( new QgsLayerRestorer( mNicknameLayers.values() ) );
-
     QList<QgsMapLayer *> layers;
     QList<QgsWmsParametersLayer> params = mWmsParameters.layersParameters();
 
@@ -229,7 +225,7 @@ namespace QgsWms
 
     Q_FOREACH ( const QString &id, mapSettings.layerIds() )
     {
-      QgsVectorLayer *vl = qobject_cast<QgsVectorLayer *>( mProject->mapLayer( id ) );
+      QgsVectorLayer *vl = qobject_cast<QgsVectorLayer *>( mRequestLayers.mapLayer( id ) );
       if ( !vl || !vl->renderer() )
         continue;
 
@@ -293,10 +289,6 @@ namespace QgsWms
     QgsMapSettings mapSettings;
     configureMapSettings( image.get(), mapSettings );
 
-    // init layer restorer before doing anything
-    std::unique_ptr<QgsLayerRestorer> restorer;
-    restorer.reset( new QgsLayerRestorer( mNicknameLayers.values() ) );
-
     // init stylized layers according to LAYERS/STYLES or SLD
     QString sld = mWmsParameters.sld();
     if ( !sld.isEmpty() )
@@ -493,15 +485,16 @@ namespace QgsWms
               QString style = layer.mStyle;
               if ( mNicknameLayers.contains( nickname ) && !mRestrictedLayers.contains( nickname ) )
               {
+                QgsMapLayer *requestLayer = this->requestLayer( nickname );
                 if ( !style.isEmpty() )
                 {
-                  bool rc = mNicknameLayers[nickname]->styleManager()->setCurrentStyle( style );
+                  bool rc = requestLayer->styleManager()->setCurrentStyle( style );
                   if ( ! rc )
                   {
                     throw QgsMapServiceException( QStringLiteral( "StyleNotDefined" ), QStringLiteral( "Style \"%1\" does not exist for layer \"%2\"" ).arg( style, nickname ) );
                   }
                 }
-                layerSet << mNicknameLayers[nickname];
+                layerSet << requestLayer;
               }
               else
               {
@@ -696,10 +689,6 @@ namespace QgsWms
     QList<QgsMapLayer *> layers;
     QList<QgsWmsParametersLayer> params = mWmsParameters.layersParameters();
 
-    // init layer restorer before doing anything
-    std::unique_ptr<QgsLayerRestorer> restorer;
-    restorer.reset( new QgsLayerRestorer( mNicknameLayers.values() ) );
-
     // init stylized layers according to LAYERS/STYLES or SLD
     QString sld = mWmsParameters.sld();
     if ( !sld.isEmpty() )
@@ -784,10 +773,6 @@ namespace QgsWms
     QList<QgsMapLayer *> layers;
     QList<QgsWmsParametersLayer> params = mWmsParameters.layersParameters();
 
-    // init layer restorer before doing anything
-    std::unique_ptr<QgsLayerRestorer> restorer;
-    restorer.reset( new QgsLayerRestorer( mNicknameLayers.values() ) );
-
     // init stylized layers according to LAYERS/STYLES or SLD
     QString sld = mWmsParameters.sld();
     if ( !sld.isEmpty() )
@@ -940,10 +925,6 @@ namespace QgsWms
     QList<QgsMapLayer *> layers;
     QList<QgsWmsParametersLayer> params = mWmsParameters.layersParameters();
 
-    // init layer restorer before doing anything
-    std::unique_ptr<QgsLayerRestorer> restorer;
-    restorer.reset( new QgsLayerRestorer( mNicknameLayers.values() ) );
-
     // init stylized layers according to LAYERS/STYLES or SLD
     QString sld = mWmsParameters.sld();
     if ( !sld.isEmpty() )
@@ -2379,6 +2360,27 @@ namespace QgsWms
     }
   }
 
+  QgsMapLayer *QgsRenderer::requestLayer( const QString &nickname ) const
+  {
+    QgsMapLayer *projectLayer = mNicknameLayers.value( nickname );
+    if ( !projectLayer )
+      return nullptr;
+
+    // the project is shared by all requests, so the request changes a copy of its own
+    QgsMapLayer *layer = mRequestLayers.mapLayer( projectLayer->id() );
+    if ( !layer )
+    {
+      layer = QgsServerProjectUtils::cloneLayer( *projectLayer, *mProject );
+      if ( !layer )
+      {
+        throw QgsServiceException( QStringLiteral( "LayerNotLoaded" ),
+                                   QStringLiteral( "Layer \"%1\" could not be loaded" ).arg( nickname ), 500 );
+      }
+      mRequestLayers.addMapLayer( layer );
+    }
+    return layer;
+  }
+
   QString QgsRenderer::layerNickname( const QgsMapLayer &layer ) const
   {
     QString name = layer.shortName();
@@ -2585,9 +2587,10 @@ namespace QgsWms
             QString err;
             if ( mNicknameLayers.contains( lname ) && !mRestrictedLayers.contains( lname ) )
             {
-              mNicknameLayers[lname]->readSld( namedElem, err );
-              mNicknameLayers[lname]->setCustomProperty( "readSLD", true );
-              layers.append( mNicknameLayers[lname] );
+              QgsMapLayer *layer = requestLayer( lname );
+              layer->readSld( namedElem, err );
+              layer->setCustomProperty( "readSLD", true );
+              layers.append( layer );
             }
             else
             {
@@ -2612,16 +2615,17 @@ namespace QgsWms
       QString style = param.mStyle;
       if ( mNicknameLayers.contains( nickname ) && !mRestrictedLayers.contains( nickname ) )
       {
+        QgsMapLayer *layer = requestLayer( nickname );
         if ( !style.isEmpty() )
         {
-          bool rc = mNicknameLayers[nickname]->styleManager()->setCurrentStyle( style );
+          bool rc = layer->styleManager()->setCurrentStyle( style );
           if ( ! rc )
           {
             throw QgsMapServiceException( QStringLiteral( "StyleNotDefined" ), QStringLiteral( "Style \"%1\" does not exist for layer \"%2\"" ).arg( style, nickname ) );
           }
         }
 
-        layers.append( mNicknameLayers[nickname] );
+        layers.append( layer );
       }
       else
       {
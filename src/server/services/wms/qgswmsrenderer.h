@@ -20,6 +20,7 @@
 #ifndef QGSWMSRENDERER_H
 #define QGSWMSRENDERER_H
 
+#include "qgsmaplayerstore.h"
 #include "qgsserversettings.h"
 #include "qgswmsparameters.h"
 #include <QDomDocument>
@@ -125,6 +126,10 @@ namespace QgsWms
       // Init a map with nickname for layers' project
       void initNicknameLayers();
 
+      // Return the copy of the layer with the nickname, which the request may change
+      // (style, filter, ...). The project's layers are shared with other requests.
+      QgsMapLayer *requestLayer( const QString &nickname ) const;
+
       // Return the nickname of the layer (short name, id or name according to
       // the project configuration)
       QString layerNickname( const QgsMapLayer &layer ) const;
@@ -274,6 +279,9 @@ namespace QgsWms
       QStringList mRestrictedLayers;
       QMap<QString, QgsMapLayer *> mNicknameLayers;
 
+      // Copies of the project's layers used by the request, see requestLayer()
+      mutable QgsMapLayerStore mRequestLayers;
+
     public:
 
       //! Return the image quality to use for getMap request
@@ -82,6 +82,8 @@ void usage( std::string const &appName )
             << "\t[--prefix path]\tpath to a different build of qgis, may be used to test old versions\n"
             << "\t[--quality]\trenderer hint(s), comma separated, possible values: Antialiasing,TextAntialiasing,SmoothPixmapTransform,NonCosmeticDefaultPen\n"
             << "\t[--parallel]\trender layers in parallel instead of sequentially\n"
+            << "\t[--tiles count]\tsplit each vector layer into given number of strips rendered in parallel (requires --parallel), default 1\n"
+            << "\t[--threads count]\tmaximum number of rendering threads (requires --parallel), default is number of cores\n"
             << "\t[--print type]\twhat kind of time to print, possible values: wall,total,user,sys. Default is total.\n"
             << "\t[--help]\t\tthis text\n\n"
             << "  FILES:\n"
@@ -138,6 +140,8 @@ int main( int argc, char *argv[] )
   int mySnapshotHeight = 600;
   QString myQuality;
   bool myParallel = false;
+  int myTiles = 1;
+  int myThreads = 0;
   QString myPrintTime = QStringLiteral( "total" );
 
   // This behavior will set initial extent of map canvas, but only if
@@ -178,6 +182,8 @@ int main( int argc, char *argv[] )
       {"prefix", required_argument, 0, 'r'},
       {"quality", required_argument, 0, 'q'},
       {"parallel", no_argument, 0, 'P'},
+      {"tiles", required_argument, 0, 't'},
+      {"threads", required_argument, 0, 'T'},
       {"print", required_argument, 0, 'R'},
       {0, 0, 0, 0}
     };
@@ -252,6 +258,14 @@ int main( int argc, char *argv[] )
         myParallel = true;
         break;
 
+      case 't':
+        myTiles = QString( optarg ).toInt();
+        break;
+
+      case 'T':
+        myThreads = QString( optarg ).toInt();
+        break;
+
       case 'R':
         myPrintTime = optarg;
         break;
@@ -339,6 +353,14 @@ int main( int argc, char *argv[] )
     {
       myParallel = true;
     }
+    else if ( i + 1 < argc && arg == "--tiles" )
+    {
+      myTiles = QString( argv[++i] ).toInt();
+    }
+    else if ( i + 1 < argc && arg == "--threads" )
+    {
+      myThreads = QString( argv[++i] ).toInt();
+    }
     else if ( i + 1 < argc && ( arg == "--print" || arg == "-R" ) )
     {
       myPrintTime = argv[++i];
@@ -516,6 +538,8 @@ int main( int argc, char *argv[] )
   }
 
   qbench->setParallel( myParallel );
+  qbench->setLayerTileCount( myTiles );
+  qbench->setThreads( myThreads );
 
   /////////////////////////////////////////////////////////////////////
   // autoload any file names that were passed in on the command line
@@ -32,6 +32,7 @@
 #include <QSettings>
 #include <QString>
 #include <QTextStream>
+#include <QThreadPool>
 #include <QTime>
 
 #ifndef QGSVERSION
@@ -191,6 +192,16 @@ void QgsBench::render()
   // TODO: do we need the other QPainter flags?
   mMapSettings.setFlag( QgsMapSettings::Antialiasing, mRendererHints.testFlag( QPainter::Antialiasing ) );
 
+  if ( mParallel )
+  {
+    if ( mThreads > 0 )
+      QThreadPool::globalInstance()->setMaxThreadCount( mThreads );
+
+    mMapSettings.setLayerRenderTileCount( mLayerTileCount );
+    // split every vector layer, the benchmark is meant to measure scaling of the split rendering
+    mMapSettings.setLayerRenderTileFeatureThreshold( 0 );
+  }
+
   for ( int i = 0; i < mIterations; i++ )
   {
     QgsMapRendererQImageJob *job = nullptr;
@@ -210,6 +221,8 @@ void QgsBench::render()
 
 
   mLogMap.insert( QStringLiteral( "iterations" ), mTimes.size() );
+  mLogMap.insert( QStringLiteral( "threads" ), mParallel ? QThreadPool::globalInstance()->maxThreadCount() : 1 );
+  mLogMap.insert( QStringLiteral( "layer_tiles" ), mParallel ? mLayerTileCount : 1 );
   mLogMap.insert( QStringLiteral( "revision" ), QGSVERSION );
 
   // Calc stats: user, sys, total
@@ -59,6 +59,12 @@ class QgsBench :  public QObject
 
     void setParallel( bool enabled ) { mParallel = enabled; }
 
+    // split large vector layers into given number of strips (parallel rendering only)
+    void setLayerTileCount( int count ) { mLayerTileCount = count; }
+
+    // maximum number of threads used for parallel rendering, 0 = default
+    void setThreads( int threads ) { mThreads = threads; }
+
   public slots:
     void readProject( const QDomDocument &doc );
 
@@ -93,6 +99,10 @@ class QgsBench :  public QObject
     QgsMapSettings mMapSettings;
 
     bool mParallel;
+
+    int mLayerTileCount = 1;
+
+    int mThreads = 0;
 };
 
 #endif // QGSBENCH_H
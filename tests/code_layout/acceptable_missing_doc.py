@@ -406,7 +406,7 @@ ACCEPTABLE_MISSING_DOCS = {
     "QgsVertexMarker": ["QgsVertexMarker(QgsMapCanvas *mapCanvas)", "setColor(const QColor &color)", "setIconSize(int iconSize)", "setCenter(const QgsPointXY &point)", "setPenWidth(int width)", "setIconType(int iconType)"],
     "QgsAttributeFormLegacyInterface": ["QgsAttributeFormLegacyInterface(const QString &function, const QString &pyFormName, QgsAttributeForm *form)"],
     "QgsLongLongValidator": ["QgsLongLongValidator(qint64 bottom, qint64 top, QObject *parent)", "setTop(qint64 top)", "setRange(qint64 bottom, qint64 top)", "bottom() const ", "setBottom(qint64 bottom)", "QgsLongLongValidator(QObject *parent)", "top() const "],
-    "QgsPalLayerSettings": ["DataDefinedProperties", "ShapeType", "DirectionSymbols", "UpsideDownLabels", "QuadrantPosition", "MultiLineAlign", "writeToLayer(QgsVectorLayer *layer)", "RotationType", "ShadowType", "calculateLabelSize(const QFontMetricsF *fm, QString text, double &labelX, double &labelY, QgsFeature *f=nullptr, QgsRenderContext *context=nullptr)", "QgsPalLayerSettings(const QgsPalLayerSettings &s)", "SizeType", "readFromLayer(QgsVectorLayer *layer)"],
+    "QgsPalLayerSettings": ["DataDefinedProperties", "ShapeType", "DirectionSymbols", "UpsideDownLabels", "QuadrantPosition", "MultiLineAlign", "writeToLayer(QgsVectorLayer *layer)", "RotationType", "ShadowType", "QgsPalLayerSettings(const QgsPalLayerSettings &s)", "SizeType", "readFromLayer(QgsVectorLayer *layer)"],
     "QgsRasterLayerRenderer": ["QgsRasterLayerRenderer(QgsRasterLayer *layer, QgsRenderContext &rendererContext)"],
     "QgsCptCityColorRamp": ["descFileName() const ", "copyingInfo() const ", "fileName() const ", "copyingFileName() const ", "setVariantName(const QString &variantName)", "schemeName() const ", "variantList() const ", "setSchemeName(const QString &schemeName)", "loadPalette()", "QgsCptCityColorRamp(const QString &schemeName=DEFAULT_CPTCITY_SCHEMENAME, const QString &variantName=DEFAULT_CPTCITY_VARIANTNAME, bool doLoadFile=true)", "copy(const QgsCptCityColorRamp *other)", "setName(const QString &schemeName, const QString &variantName=QString(), const QStringList &variantList=QStringList())", "cloneGradientRamp() const ", "setVariantList(const QStringList &variantList)", "loadFile()", "variantName() const ", "fileLoaded() const ", "hasMultiStops() const ", "create(const QgsStringMap &properties=QgsStringMap())", "QgsCptCityColorRamp(const QString &schemeName, const QStringList &variantList, const QString &variantName=QString(), bool doLoadFile=true)"],
     "QgsRenderChecker": ["matchTarget()", "setRenderedImage(const QString &imageFileName)", "matchPercent()", "setElapsedTimeTarget(int target)", "mismatchCount()", "elapsedTime()", "report()", "controlImagePath() const ", "setControlPathSuffix(const QString &name)"],
@@ -0,0 +1,315 @@
+/***************************************************************************
+  testqgsinterpolator.cpp
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+
+#include "qgsapplication.h"
+#include "qgsgeometry.h"
+#include "qgsgridfilewriter.h"
+#include "qgsidwinterpolator.h"
+#include "qgspoint.h"
+#include "qgstininterpolator.h"
+#include "qgsvectordataprovider.h"
+#include "qgsvectorlayer.h"
+#include "DualEdgeTriangulation.h"
+#include "LinTriangleInterpolator.h"
+#include "Line3D.h"
+
+#include <QDir>
+#include <QFile>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+/** \ingroup UnitTests
+ * This is a unit test for the interpolation classes
+ */
+class TestQgsInterpolator : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void idwAllPoints();
+    void idwNearestNeighbors();
+    void idwSearchRadius();
+    void gridFileWriterParallel();
+    void tinSortedInsertion();
+
+  private:
+    QgsVectorLayer *mLayer = nullptr;
+    QList< QgsPointXY > mPoints;
+    QList< double > mValues;
+
+    QList<QgsInterpolator::LayerData> layerData() const;
+
+    //! Brute force IDW using only the maxCount nearest points within radius
+    bool referenceIdw( double x, double y, int maxCount, double radius, double &result ) const;
+
+    QByteArray writeGrid( QgsInterpolator *interpolator, const QString &fileName ) const;
+};
+
+void TestQgsInterpolator::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+
+  mLayer = new QgsVectorLayer( QStringLiteral( "Point?field=value:double" ), QStringLiteral( "points" ), QStringLiteral( "memory" ) );
+  QVERIFY( mLayer->isValid() );
+
+  QgsFeatureList features;
+  for ( int i = 0; i < 500; ++i )
+  {
+    // deterministic, irregularly spaced points
+    const QgsPointXY point( std::fmod( i * 37.17, 100.0 ), std::fmod( i * 61.31, 100.0 ) );
+    const double value = std::sin( i * 0.1 ) * 50;
+    mPoints << point;
+    mValues << value;
+
+    QgsFeature f( mLayer->fields() );
+    f.setGeometry( QgsGeometry::fromPoint( point ) );
+    f.setAttribute( 0, value );
+    features << f;
+  }
+  QVERIFY( mLayer->dataProvider()->addFeatures( features ) );
+}
+
+void TestQgsInterpolator::cleanupTestCase()
+{
+  delete mLayer;
+  QgsApplication::exitQgis();
+}
+
+QList<QgsInterpolator::LayerData> TestQgsInterpolator::layerData() const
+{
+  QgsInterpolator::LayerData data;
+  data.vectorLayer = mLayer;
+  data.zCoordInterpolation = false;
+  data.interpolationAttribute = 0;
+  data.mInputType = QgsInterpolator::POINTS;
+  return QList<QgsInterpolator::LayerData>() << data;
+}
+
+bool TestQgsInterpolator::referenceIdw( double x, double y, int maxCount, double radius, double &result ) const
+{
+  QList< QPair< double, double > > candidates;
+  for ( int i = 0; i < mPoints.size(); ++i )
+  {
+    const double distance = std::sqrt( mPoints.at( i ).sqrDist( x, y ) );
+    if ( radius > 0 && distance > radius )
+      continue;
+    candidates << qMakePair( distance, mValues.at( i ) );
+  }
+  std::sort( candidates.begin(), candidates.end() );
+  if ( maxCount > 0 )
+    candidates = candidates.mid( 0, maxCount );
+
+  double sumCounter = 0;
+  double sumDenominator = 0;
+  for ( const QPair< double, double > &c : qgsAsConst( candidates ) )
+  {
+    const double weight = 1 / ( c.first * c.first );
+    sumCounter += weight * c.second;
+    sumDenominator += weight;
+  }
+  if ( sumDenominator == 0 )
+    return false;
+
+  result = sumCounter / sumDenominator;
+  return true;
+}
+
+void TestQgsInterpolator::idwAllPoints()
+{
+  QgsIDWInterpolator interpolator( layerData() );
+  QCOMPARE( interpolator.maximumNeighbors(), 0 );
+  QCOMPARE( interpolator.searchRadius(), 0.0 );
+
+  double result = 0;
+  double expected = 0;
+  QCOMPARE( interpolator.interpolatePoint( 45.5, 12.25, result ), 0 );
+  QVERIFY( referenceIdw( 45.5, 12.25, 0, 0, expected ) );
+  QGSCOMPARENEAR( result, expected, 1e-9 );
+
+  // exactly on a sample point
+  QCOMPARE( interpolator.interpolatePoint( mPoints.at( 7 ).x(), mPoints.at( 7 ).y(), result ), 0 );
+  QCOMPARE( result, mValues.at( 7 ) );
+}
+
+void TestQgsInterpolator::idwNearestNeighbors()
+{
+  QgsIDWInterpolator interpolator( layerData() );
+  interpolator.setMaximumNeighbors( 12 );
+  QCOMPARE( interpolator.maximumNeighbors(), 12 );
+
+  for ( int i = 0; i < 50; ++i )
+  {
+    const double x = std::fmod( i * 13.7, 100.0 );
+    const double y = std::fmod( i * 29.3, 100.0 );
+    double result = 0;
+    double expected = 0;
+    QCOMPARE( interpolator.interpolatePoint( x, y, result ), 0 );
+    QVERIFY( referenceIdw( x, y, 12, 0, expected ) );
+    QGSCOMPARENEAR( result, expected, 1e-9 );
+  }
+
+  // exactly on a sample point
+  double result = 0;
+  QCOMPARE( interpolator.interpolatePoint( mPoints.at( 42 ).x(), mPoints.at( 42 ).y(), result ), 0 );
+  QCOMPARE( result, mValues.at( 42 ) );
+}
+
+void TestQgsInterpolator::idwSearchRadius()
+{
+  QgsIDWInterpolator interpolator( layerData() );
+  interpolator.setSearchRadius( 8 );
+  QCOMPARE( interpolator.searchRadius(), 8.0 );
+
+  for ( int i = 0; i < 50; ++i )
+  {
+    const double x = std::fmod( i * 13.7, 100.0 );
+    const double y = std::fmod( i * 29.3, 100.0 );
+    double result = 0;
+    double expected = 0;
+    QCOMPARE( interpolator.interpolatePoint( x, y, result ), 0 );
+    QVERIFY( referenceIdw( x, y, 0, 8, expected ) );
+    QGSCOMPARENEAR( result, expected, 1e-9 );
+  }
+
+  // combined with a neighbor limit
+  interpolator.setMaximumNeighbors( 3 );
+  double result = 0;
+  double expected = 0;
+  QCOMPARE( interpolator.interpolatePoint( 50, 50, result ), 0 );
+  QVERIFY( referenceIdw( 50, 50, 3, 8, expected ) );
+  QGSCOMPARENEAR( result, expected, 1e-9 );
+
+  // no sample points within radius
+  double outside = 0;
+  QCOMPARE( interpolator.interpolatePoint( 1000, 1000, outside ), 1 );
+}
+
+QByteArray TestQgsInterpolator::writeGrid( QgsInterpolator *interpolator, const QString &fileName ) const
+{
+  const QString path = QDir::tempPath() + '/' + fileName;
+  QgsGridFileWriter writer( interpolator, path, QgsRectangle( 0, 0, 100, 100 ), 57, 43, 100.0 / 57, 100.0 / 43 );
+  if ( writer.writeFile() != 0 )
+    return QByteArray();
+
+  QFile file( path );
+  file.open( QIODevice::ReadOnly );
+  return file.readAll();
+}
+
+void TestQgsInterpolator::gridFileWriterParallel()
+{
+  QgsIDWInterpolator interpolator( layerData() );
+  interpolator.setMaximumNeighbors( 10 );
+  interpolator.setSearchRadius( 15 );
+  QVERIFY( interpolator.supportsConcurrentInterpolation() );
+
+  const int maxThreads = QThreadPool::globalInstance()->maxThreadCount();
+
+  QThreadPool::globalInstance()->setMaxThreadCount( 1 );
+  const QByteArray serial = writeGrid( &interpolator, QStringLiteral( "idw_serial.asc" ) );
+  QThreadPool::globalInstance()->setMaxThreadCount( 4 );
+  const QByteArray parallel = writeGrid( &interpolator, QStringLiteral( "idw_parallel.asc" ) );
+  QThreadPool::globalInstance()->setMaxThreadCount( maxThreads );
+
+  QVERIFY( !serial.isEmpty() );
+  QVERIFY( serial.startsWith( "NCOLS 57" ) );
+  // rows must be written in order, with identical values
+  QCOMPARE( parallel, serial );
+}
+
+void TestQgsInterpolator::tinSortedInsertion()
+{
+  // enough points for the interpolator to insert them in spatially sorted rounds
+  QgsVectorLayer pointLayer( QStringLiteral( "Point?field=value:double" ), QStringLiteral( "tin_points" ), QStringLiteral( "memory" ) );
+  QVERIFY( pointLayer.isValid() );
+  std::mt19937 generator( 42 );
+  std::uniform_real_distribution< double > coordinate( 0, 100 );
+  QVector< QgsPoint > points;
+  QgsFeatureList features;
+  for ( int i = 0; i < 3000; ++i )
+  {
+    const double x = coordinate( generator );
+    const double y = coordinate( generator );
+    const double value = std::sin( x * 0.1 ) * std::cos( y * 0.05 ) * 50;
+    points << QgsPoint( x, y, value );
+
+    QgsFeature f( pointLayer.fields() );
+    f.setGeometry( QgsGeometry::fromPoint( QgsPointXY( x, y ) ) );
+    f.setAttribute( 0, value );
+    features << f;
+  }
+  QVERIFY( pointLayer.dataProvider()->addFeatures( features ) );
+
+  // structure line crossing the points
+  QgsVectorLayer lineLayer( QStringLiteral( "LineString?field=value:double" ), QStringLiteral( "tin_lines" ), QStringLiteral( "memory" ) );
+  QVERIFY( lineLayer.isValid() );
+  const QgsPolyline polyline = QgsPolyline() << QgsPointXY( 5.5, 7.25 ) << QgsPointXY( 52.3, 61.7 ) << QgsPointXY( 94.1, 38.6 );
+  QgsFeature lineFeature( lineLayer.fields() );
+  lineFeature.setGeometry( QgsGeometry::fromPolyline( polyline ) );
+  lineFeature.setAttribute( 0, 80.0 );
+  QVERIFY( lineLayer.dataProvider()->addFeatures( QgsFeatureList() << lineFeature ) );
+
+  QgsInterpolator::LayerData pointData;
+  pointData.vectorLayer = &pointLayer;
+  pointData.zCoordInterpolation = false;
+  pointData.interpolationAttribute = 0;
+  pointData.mInputType = QgsInterpolator::POINTS;
+  QgsInterpolator::LayerData lineData = pointData;
+  lineData.vectorLayer = &lineLayer;
+  lineData.mInputType = QgsInterpolator::STRUCTURE_LINES;
+  QgsTINInterpolator interpolator( QList<QgsInterpolator::LayerData>() << pointData << lineData );
+
+  // reference triangulation, with the points inserted in their original order
+  DualEdgeTriangulation reference( 100000, nullptr );
+  for ( const QgsPoint &point : qgsAsConst( points ) )
+  {
+    reference.addPoint( new QgsPoint( point ) );
+  }
+  // the line and its nodes are deleted by the triangulation, together with the points
+  Line3D *line = new Line3D();
+  for ( const QgsPointXY &point : polyline )
+  {
+    line->insertPoint( new QgsPoint( point.x(), point.y(), 80.0 ) );
+  }
+  reference.addLine( line, false );
+  LinTriangleInterpolator referenceInterpolator( &reference );
+
+  for ( int i = 0; i < 200; ++i )
+  {
+    const double x = 2 + std::fmod( i * 13.7, 96.0 );
+    const double y = 2 + std::fmod( i * 29.3, 96.0 );
+    double result = 0;
+    QgsPoint expected( 0, 0, 0 );
+    QVERIFY( referenceInterpolator.calcPoint( x, y, &expected ) );
+    QCOMPARE( interpolator.interpolatePoint( x, y, result ), 0 );
+    QGSCOMPARENEAR( result, expected.z(), 1e-9 );
+  }
+
+  // on the structure line
+  double result = 0;
+  QCOMPARE( interpolator.interpolatePoint( 52.3, 61.7, result ), 0 );
+  QGSCOMPARENEAR( result, 80.0, 1e-9 );
+}
+
+QGSTEST_MAIN( TestQgsInterpolator )
+#include "testqgsinterpolator.moc"
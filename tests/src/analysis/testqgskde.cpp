@@ -0,0 +1,160 @@
+/***************************************************************************
+  testqgskde.cpp
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+
+#include "qgsapplication.h"
+#include "qgsgeometry.h"
+#include "qgskde.h"
+#include "qgsrasterdataprovider.h"
+#include "qgsrasterlayer.h"
+#include "qgsvectordataprovider.h"
+#include "qgsvectorlayer.h"
+
+#include <QDir>
+#include <QThreadPool>
+
+#include <cmath>
+#include <memory>
+
+/** \ingroup UnitTests
+ * This is a unit test for the kernel density estimation
+ */
+class TestQgsKernelDensityEstimation : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void runMatchesAddFeature();
+    void surfaceWrittenInParts();
+
+  private:
+    QgsVectorLayer *mLayer = nullptr;
+
+    QgsKernelDensityEstimation::Parameters parameters() const;
+
+    /**
+     * Calculates the estimation to \a fileName, with at most \a maximumMemory bytes for the surface,
+     * and returns the values of the output raster. Returns an empty array on failure.
+     */
+    QByteArray calculate( const QString &fileName, bool useRun, qint64 maximumMemory ) const;
+};
+
+void TestQgsKernelDensityEstimation::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+
+  mLayer = new QgsVectorLayer( QStringLiteral( "Point?crs=EPSG:3857&field=weight:double" ), QStringLiteral( "points" ), QStringLiteral( "memory" ) );
+  QVERIFY( mLayer->isValid() );
+
+  QgsFeatureList features;
+  for ( int i = 0; i < 300; ++i )
+  {
+    QgsFeature f( mLayer->fields() );
+    f.setGeometry( QgsGeometry::fromPoint( QgsPointXY( std::fmod( i * 37.17, 400.0 ), std::fmod( i * 61.31, 300.0 ) ) ) );
+    f.setAttribute( 0, 1.0 + i % 5 );
+    features << f;
+  }
+  QVERIFY( mLayer->dataProvider()->addFeatures( features ) );
+}
+
+void TestQgsKernelDensityEstimation::cleanupTestCase()
+{
+  delete mLayer;
+  QgsApplication::exitQgis();
+}
+
+QgsKernelDensityEstimation::Parameters TestQgsKernelDensityEstimation::parameters() const
+{
+  QgsKernelDensityEstimation::Parameters parameters;
+  parameters.source = mLayer;
+  parameters.radius = 20;
+  parameters.weightField = QStringLiteral( "weight" );
+  parameters.pixelSize = 0.5;
+  parameters.shape = QgsKernelDensityEstimation::KernelQuartic;
+  parameters.decayRatio = 0;
+  parameters.outputValues = QgsKernelDensityEstimation::OutputRaw;
+  return parameters;
+}
+
+QByteArray TestQgsKernelDensityEstimation::calculate( const QString &fileName, bool useRun, qint64 maximumMemory ) const
+{
+  const QString path = QDir::tempPath() + '/' + fileName;
+  QgsKernelDensityEstimation kde( parameters(), path, QStringLiteral( "GTiff" ) );
+  kde.mMaximumSurfaceMemory = maximumMemory;
+
+  if ( useRun )
+  {
+    if ( kde.run() != QgsKernelDensityEstimation::Success )
+      return QByteArray();
+  }
+  else
+  {
+    if ( kde.prepare() != QgsKernelDensityEstimation::Success )
+      return QByteArray();
+
+    QgsFeature f;
+    QgsFeatureIterator fit = mLayer->getFeatures();
+    while ( fit.nextFeature( f ) )
+    {
+      kde.addFeature( f );
+    }
+    if ( kde.finalise() != QgsKernelDensityEstimation::Success )
+      return QByteArray();
+  }
+
+  QgsRasterLayer layer( path, QStringLiteral( "kde" ) );
+  if ( !layer.isValid() )
+    return QByteArray();
+
+  std::unique_ptr< QgsRasterBlock > block( layer.dataProvider()->block( 1, layer.extent(), layer.width(), layer.height() ) );
+  return block ? block->data() : QByteArray();
+}
+
+void TestQgsKernelDensityEstimation::runMatchesAddFeature()
+{
+  const QByteArray added = calculate( QStringLiteral( "kde_add_feature.tif" ), false, 512 * 1024 * 1024LL );
+  QVERIFY( !added.isEmpty() );
+
+  // run() calculates bands of the surface in multiple threads, which must not change the output
+  const int maxThreadCount = QThreadPool::globalInstance()->maxThreadCount();
+  QThreadPool::globalInstance()->setMaxThreadCount( 4 );
+  const QByteArray run = calculate( QStringLiteral( "kde_run.tif" ), true, 512 * 1024 * 1024LL );
+  QThreadPool::globalInstance()->setMaxThreadCount( 1 );
+  const QByteArray runSerial = calculate( QStringLiteral( "kde_run_serial.tif" ), true, 512 * 1024 * 1024LL );
+  QThreadPool::globalInstance()->setMaxThreadCount( maxThreadCount );
+  QCOMPARE( run, added );
+  QCOMPARE( runSerial, added );
+
+  // the surface spans several tiles in each direction
+  QgsRasterLayer layer( QDir::tempPath() + "/kde_run.tif", QStringLiteral( "kde" ) );
+  QVERIFY( layer.width() > 512 );
+  QVERIFY( layer.height() > 512 );
+}
+
+void TestQgsKernelDensityEstimation::surfaceWrittenInParts()
+{
+  const QByteArray inMemory = calculate( QStringLiteral( "kde_in_memory.tif" ), false, 512 * 1024 * 1024LL );
+  // only a single tile is kept in memory, all others are written to the output file and read again
+  const QByteArray inParts = calculate( QStringLiteral( "kde_in_parts.tif" ), false, 1 );
+  QVERIFY( !inMemory.isEmpty() );
+  QCOMPARE( inParts, inMemory );
+}
+
+QGSTEST_MAIN( TestQgsKernelDensityEstimation )
+#include "testqgskde.moc"
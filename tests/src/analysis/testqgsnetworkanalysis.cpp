@@ -0,0 +1,243 @@
+/***************************************************************************
+  testqgsnetworkanalysis.cpp
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+
+#include "qgscompactgraph.h"
+#include "qgsgraph.h"
+#include "qgsgraphanalyzer.h"
+#include "qgsgraphcontractionhierarchy.h"
+#include "qgspointxy.h"
+
+#include <cmath>
+#include <limits>
+#include <memory>
+
+/**
+ * Creates a grid graph with \a size x \a size vertices, connecting all horizontal and
+ * vertical neighbors in both directions with varying costs.
+ */
+static QgsGraph *_gridGraph( int size )
+{
+  QgsGraph *graph = new QgsGraph();
+  for ( int y = 0; y < size; ++y )
+  {
+    for ( int x = 0; x < size; ++x )
+      graph->addVertex( QgsPointXY( x, y ) );
+  }
+
+  auto addEdges = [graph]( int a, int b, double cost )
+  {
+    graph->addEdge( a, b, QVector< QVariant >() << cost );
+    // make the graph asymmetric, so that forward and backward searches differ
+    graph->addEdge( b, a, QVector< QVariant >() << cost * 1.5 );
+  };
+
+  for ( int y = 0; y < size; ++y )
+  {
+    for ( int x = 0; x < size; ++x )
+    {
+      const int idx = y * size + x;
+      if ( x + 1 < size )
+        addEdges( idx, idx + 1, 1 + ( x * 7 + y * 13 ) % 5 );
+      if ( y + 1 < size )
+        addEdges( idx, idx + size, 1 + ( x * 11 + y * 3 ) % 7 );
+    }
+  }
+  return graph;
+}
+
+class TestQgsNetworkAnalysis : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void compactDijkstra();
+    void bidirectionalSearch();
+    void unreachable();
+    void contractionHierarchy();
+    void costMatrix();
+
+    void benchmarkDijkstra();
+    void benchmarkCompactDijkstra();
+    void benchmarkContractionHierarchy();
+};
+
+void TestQgsNetworkAnalysis::compactDijkstra()
+{
+  std::unique_ptr< QgsGraph > graph( _gridGraph( 20 ) );
+  QgsCompactGraph compact( *graph, 0 );
+  QCOMPARE( compact.vertexCount(), graph->vertexCount() );
+  QCOMPARE( compact.edgeCount(), graph->edgeCount() );
+
+  for ( int start : { 0, 57, 399 } )
+  {
+    QVector< int > tree;
+    QVector< double > cost;
+    QgsGraphAnalyzer::dijkstra( graph.get(), start, 0, &tree, &cost );
+
+    QVector< int > compactTree;
+    QVector< double > compactCost;
+    compact.dijkstra( start, &compactTree, &compactCost );
+
+    QCOMPARE( compactCost, cost );
+    QCOMPARE( compactTree.at( start ), -1 );
+    for ( int v = 0; v < graph->vertexCount(); ++v )
+    {
+      if ( v == start )
+        continue;
+      // tree edges may differ for equal cost paths, but must be consistent with the costs
+      const QgsGraphEdge &edge = graph->edge( compactTree.at( v ) );
+      QCOMPARE( edge.inVertex(), v );
+      QCOMPARE( compactCost.at( edge.outVertex() ) + edge.cost( 0 ).toDouble(), compactCost.at( v ) );
+    }
+  }
+}
+
+void TestQgsNetworkAnalysis::bidirectionalSearch()
+{
+  std::unique_ptr< QgsGraph > graph( _gridGraph( 20 ) );
+  QgsCompactGraph compact( *graph, 0 );
+
+  QVector< double > cost;
+  compact.dijkstra( 13, nullptr, &cost );
+
+  for ( int end : { 13, 14, 200, 250, 399 } )
+  {
+    QVector< int > route;
+    QCOMPARE( compact.shortestPath( 13, end, &route ), cost.at( end ) );
+
+    // route must be a connected chain of edges from start to end, with the expected cost
+    int v = 13;
+    double routeCost = 0;
+    for ( int edgeId : qgsAsConst( route ) )
+    {
+      const QgsGraphEdge &edge = graph->edge( edgeId );
+      QCOMPARE( edge.outVertex(), v );
+      v = edge.inVertex();
+      routeCost += edge.cost( 0 ).toDouble();
+    }
+    QCOMPARE( v, end );
+    QCOMPARE( routeCost, cost.at( end ) );
+  }
+}
+
+void TestQgsNetworkAnalysis::unreachable()
+{
+  QgsGraph graph;
+  graph.addVertex( QgsPointXY( 0, 0 ) );
+  graph.addVertex( QgsPointXY( 1, 0 ) );
+  graph.addVertex( QgsPointXY( 2, 0 ) );
+  // one way edge, vertex 2 is isolated
+  graph.addEdge( 0, 1, QVector< QVariant >() << 3.0 );
+
+  QgsCompactGraph compact( graph, 0 );
+  const double inf = std::numeric_limits<double>::infinity();
+
+  QVector< int > tree;
+  QVector< double > cost;
+  compact.dijkstra( 0, &tree, &cost );
+  QCOMPARE( cost, QVector< double >() << 0.0 << 3.0 << inf );
+  QCOMPARE( tree, QVector< int >() << -1 << 0 << -1 );
+
+  QCOMPARE( compact.shortestPath( 0, 1 ), 3.0 );
+  QVERIFY( std::isinf( compact.shortestPath( 1, 0 ) ) );
+  QVERIFY( std::isinf( compact.shortestPath( 0, 2 ) ) );
+
+  QgsGraphContractionHierarchy ch( compact );
+  QCOMPARE( ch.cost( 0, 1 ), 3.0 );
+  QVERIFY( std::isinf( ch.cost( 1, 0 ) ) );
+  QVERIFY( std::isinf( ch.cost( 2, 0 ) ) );
+  QCOMPARE( ch.cost( 2, 2 ), 0.0 );
+}
+
+void TestQgsNetworkAnalysis::contractionHierarchy()
+{
+  std::unique_ptr< QgsGraph > graph( _gridGraph( 20 ) );
+  QgsCompactGraph compact( *graph, 0 );
+  QgsGraphContractionHierarchy ch( compact );
+  QCOMPARE( ch.vertexCount(), graph->vertexCount() );
+
+  for ( int start : { 0, 111, 399 } )
+  {
+    QVector< double > cost;
+    compact.dijkstra( start, nullptr, &cost );
+    for ( int end = 0; end < graph->vertexCount(); ++end )
+      QCOMPARE( ch.cost( start, end ), cost.at( end ) );
+  }
+}
+
+void TestQgsNetworkAnalysis::costMatrix()
+{
+  std::unique_ptr< QgsGraph > graph( _gridGraph( 15 ) );
+  QgsCompactGraph compact( *graph, 0 );
+  QgsGraphContractionHierarchy ch( compact );
+
+  const QVector< int > sources = QVector< int >() << 0 << 17 << 100 << 224;
+  const QVector< int > targets = QVector< int >() << 3 << 17 << 150 << 200 << 224;
+  const QVector< double > matrix = ch.costMatrix( sources, targets );
+  QCOMPARE( matrix.size(), sources.size() * targets.size() );
+
+  for ( int i = 0; i < sources.size(); ++i )
+  {
+    QVector< double > cost;
+    compact.dijkstra( sources.at( i ), nullptr, &cost );
+    for ( int j = 0; j < targets.size(); ++j )
+      QCOMPARE( matrix.at( i * targets.size() + j ), cost.at( targets.at( j ) ) );
+  }
+}
+
+void TestQgsNetworkAnalysis::benchmarkDijkstra()
+{
+  std::unique_ptr< QgsGraph > graph( _gridGraph( 100 ) );
+  QVector< double > cost;
+  QBENCHMARK
+  {
+    QgsGraphAnalyzer::dijkstra( graph.get(), 0, 0, nullptr, &cost );
+  }
+}
+
+void TestQgsNetworkAnalysis::benchmarkCompactDijkstra()
+{
+  std::unique_ptr< QgsGraph > graph( _gridGraph( 100 ) );
+  QgsCompactGraph compact( *graph, 0 );
+  QVector< double > cost;
+  QBENCHMARK
+  {
+    compact.dijkstra( 0, nullptr, &cost );
+  }
+}
+
+void TestQgsNetworkAnalysis::benchmarkContractionHierarchy()
+{
+  std::unique_ptr< QgsGraph > graph( _gridGraph( 100 ) );
+  QgsCompactGraph compact( *graph, 0 );
+  QgsGraphContractionHierarchy ch( compact );
+
+  // 20 x 20 origin-destination matrix
+  QVector< int > sources;
+  QVector< int > targets;
+  for ( int i = 0; i < 20; ++i )
+  {
+    sources << i * 499;
+    targets << 9999 - i * 443;
+  }
+  QBENCHMARK
+  {
+    ch.costMatrix( sources, targets );
+  }
+}
+
+QGSTEST_MAIN( TestQgsNetworkAnalysis )
+#include "testqgsnetworkanalysis.moc"
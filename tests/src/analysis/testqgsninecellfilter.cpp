@@ -0,0 +1,189 @@
+/***************************************************************************
+  testqgsninecellfilter.cpp
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+
+#include "qgsapplication.h"
+#include "qgsaspectfilter.h"
+#include "qgshillshadefilter.h"
+#include "qgsruggednessfilter.h"
+#include "qgsslopefilter.h"
+#include "qgstotalcurvaturefilter.h"
+
+#include <QDir>
+#include <QThreadPool>
+#include <QVector>
+
+#include <gdal.h>
+#include <memory>
+
+/**
+ * Slope filter subclass, which is processed serially with the virtual
+ * processNineCellWindow() calls of the default row processing.
+ */
+class SerialSlopeFilter : public QgsSlopeFilter
+{
+  public:
+    SerialSlopeFilter( const QString &inputFile, const QString &outputFile )
+      : QgsSlopeFilter( inputFile, outputFile, QStringLiteral( "GTiff" ) )
+    {}
+};
+
+/** \ingroup UnitTests
+ * This is a unit test for the nine cell terrain filters
+ */
+class TestQgsNineCellFilter : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void slopeMatchesWindow();
+    void filtersParallel_data();
+    void filtersParallel();
+
+  private:
+    QString mInputFile;
+
+    QString outputFile( const QString &name ) const { return QDir::tempPath() + "/ninecell_" + name + ".tif"; }
+
+    //! Reads the values of the first band of \a fileName
+    QVector< float > readRaster( const QString &fileName, int &width, int &height ) const;
+
+    QgsNineCellFilter *createFilter( const QString &name, const QString &outputFile ) const;
+};
+
+void TestQgsNineCellFilter::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+
+  // first band of the landsat image, which is large enough for several strips of rows
+  mInputFile = QStringLiteral( TEST_DATA_DIR ) + "/landsat.tif";
+  QVERIFY( QFile::exists( mInputFile ) );
+}
+
+void TestQgsNineCellFilter::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+QVector< float > TestQgsNineCellFilter::readRaster( const QString &fileName, int &width, int &height ) const
+{
+  QVector< float > values;
+  GDALDatasetH dataset = GDALOpen( fileName.toUtf8().constData(), GA_ReadOnly );
+  if ( !dataset )
+    return values;
+
+  width = GDALGetRasterXSize( dataset );
+  height = GDALGetRasterYSize( dataset );
+  values.resize( width * height );
+  if ( GDALRasterIO( GDALGetRasterBand( dataset, 1 ), GF_Read, 0, 0, width, height, values.data(), width, height, GDT_Float32, 0, 0 ) != CE_None )
+    values.clear();
+  GDALClose( dataset );
+  return values;
+}
+
+QgsNineCellFilter *TestQgsNineCellFilter::createFilter( const QString &name, const QString &outputFile ) const
+{
+  const QString format = QStringLiteral( "GTiff" );
+  if ( name == QLatin1String( "slope" ) )
+    return new QgsSlopeFilter( mInputFile, outputFile, format );
+  else if ( name == QLatin1String( "aspect" ) )
+    return new QgsAspectFilter( mInputFile, outputFile, format );
+  else if ( name == QLatin1String( "hillshade" ) )
+    return new QgsHillshadeFilter( mInputFile, outputFile, format, 300, 40 );
+  else if ( name == QLatin1String( "ruggedness" ) )
+    return new QgsRuggednessFilter( mInputFile, outputFile, format );
+  else
+    return new QgsTotalCurvatureFilter( mInputFile, outputFile, format );
+}
+
+void TestQgsNineCellFilter::slopeMatchesWindow()
+{
+  // the serial filter goes through processNineCellWindow() for every cell, with the
+  // border cells padded with nodata
+  SerialSlopeFilter serial( mInputFile, outputFile( QStringLiteral( "slope_serial" ) ) );
+  QVERIFY( !serial.supportsConcurrentProcessing() );
+  QCOMPARE( serial.processRaster(), 0 );
+
+  std::unique_ptr< QgsNineCellFilter > filter( createFilter( QStringLiteral( "slope" ), outputFile( QStringLiteral( "slope" ) ) ) );
+  QVERIFY( filter->supportsConcurrentProcessing() );
+  QCOMPARE( filter->processRaster(), 0 );
+
+  int width = 0;
+  int height = 0;
+  const QVector< float > input = readRaster( mInputFile, width, height );
+  QVERIFY( !input.isEmpty() );
+  const QVector< float > expected = readRaster( outputFile( QStringLiteral( "slope_serial" ) ), width, height );
+  const QVector< float > result = readRaster( outputFile( QStringLiteral( "slope" ) ), width, height );
+  QCOMPARE( result, expected );
+
+  // spot check a few cells against the nine cell window, including the raster corners
+  float noData = serial.inputNodataValue();
+  auto cell = [&]( int x, int y ) -> float *
+  {
+    if ( x < 0 || y < 0 || x >= width || y >= height )
+      return &noData;
+    return const_cast< float * >( &input.at( y * width + x ) );
+  };
+  for ( const QPoint &p : { QPoint( 0, 0 ), QPoint( width - 1, height - 1 ), QPoint( width / 2, height / 3 ), QPoint( 1, height - 1 ) } )
+  {
+    const int x = p.x();
+    const int y = p.y();
+    const float value = serial.processNineCellWindow( cell( x - 1, y - 1 ), cell( x, y - 1 ), cell( x + 1, y - 1 ),
+                        cell( x - 1, y ), cell( x, y ), cell( x + 1, y ),
+                        cell( x - 1, y + 1 ), cell( x, y + 1 ), cell( x + 1, y + 1 ) );
+    QCOMPARE( result.at( y * width + x ), value );
+  }
+}
+
+void TestQgsNineCellFilter::filtersParallel_data()
+{
+  QTest::addColumn<QString>( "name" );
+
+  QTest::newRow( "slope" ) << "slope";
+  QTest::newRow( "aspect" ) << "aspect";
+  QTest::newRow( "hillshade" ) << "hillshade";
+  QTest::newRow( "ruggedness" ) << "ruggedness";
+  QTest::newRow( "total curvature" ) << "curvature";
+}
+
+void TestQgsNineCellFilter::filtersParallel()
+{
+  QFETCH( QString, name );
+
+  const int maxThreads = QThreadPool::globalInstance()->maxThreadCount();
+
+  QThreadPool::globalInstance()->setMaxThreadCount( 1 );
+  std::unique_ptr< QgsNineCellFilter > serial( createFilter( name, outputFile( name + "_1" ) ) );
+  QCOMPARE( serial->processRaster(), 0 );
+
+  QThreadPool::globalInstance()->setMaxThreadCount( 4 );
+  std::unique_ptr< QgsNineCellFilter > parallel( createFilter( name, outputFile( name + "_4" ) ) );
+  QCOMPARE( parallel->processRaster(), 0 );
+  QThreadPool::globalInstance()->setMaxThreadCount( maxThreads );
+
+  int width = 0;
+  int height = 0;
+  const QVector< float > serialValues = readRaster( outputFile( name + "_1" ), width, height );
+  QVERIFY( !serialValues.isEmpty() );
+  // rows must be written in order, with identical values
+  QCOMPARE( readRaster( outputFile( name + "_4" ), width, height ), serialValues );
+}
+
+QGSTEST_MAIN( TestQgsNineCellFilter )
+#include "testqgsninecellfilter.moc"
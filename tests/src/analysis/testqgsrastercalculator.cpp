@@ -22,6 +22,10 @@ Email                : nyall dot dawson at gmail dot com
 #include "qgsapplication.h"
 #include "qgsproject.h"
 
+#include <QThreadPool>
+
+#include <memory>
+
 Q_DECLARE_METATYPE( QgsRasterCalcNode::Operator )
 
 class TestQgsRasterCalculator : public QObject
@@ -53,6 +57,8 @@ class TestQgsRasterCalculator : public QObject
 
     void calcWithLayers();
     void calcWithReprojectedLayers();
+    void calcWithCreateOptions();
+    void calcInStrips();
 
   private:
 
@@ -528,5 +534,110 @@ void TestQgsRasterCalculator::calcWithReprojectedLayers()
   delete block;
 }
 
+void TestQgsRasterCalculator::calcWithCreateOptions()
+{
+  QgsRasterCalculatorEntry entry1;
+  entry1.bandNumber = 1;
+  entry1.raster = mpLandsatRasterLayer;
+  entry1.ref = QStringLiteral( "landsat@1" );
+
+  QVector<QgsRasterCalculatorEntry> entries;
+  entries << entry1;
+
+  QgsCoordinateReferenceSystem crs;
+  crs.createFromId( 32633, QgsCoordinateReferenceSystem::EpsgCrsId );
+  QgsRectangle extent( 783235, 3348110, 783350, 3347960 );
+
+  QTemporaryFile tmpFile;
+  tmpFile.open(); // fileName is no avialable until open
+  QString tmpName = tmpFile.fileName();
+  tmpFile.close();
+
+  QgsRasterCalculator rc( QStringLiteral( "\"landsat@1\" + 2" ),
+                          tmpName,
+                          QStringLiteral( "GTiff" ),
+                          extent, crs, 2, 3, entries );
+  rc.setCreateOptions( QStringList() << QStringLiteral( "TILED=YES" ) << QStringLiteral( "COMPRESS=DEFLATE" ) );
+  QCOMPARE( rc.createOptions(), QStringList() << QStringLiteral( "TILED=YES" ) << QStringLiteral( "COMPRESS=DEFLATE" ) );
+  QCOMPARE( rc.processCalculation(), 0 );
+
+  //open output file and check results
+  QgsRasterLayer *result = new QgsRasterLayer( tmpName, QStringLiteral( "result" ) );
+  QCOMPARE( result->width(), 2 );
+  QCOMPARE( result->height(), 3 );
+  QVERIFY( result->dataProvider()->metadata().contains( QStringLiteral( "DEFLATE" ) ) );
+  QgsRasterBlock *block = result->dataProvider()->block( 1, extent, 2, 3 );
+  QCOMPARE( block->value( 0, 0 ), 127.0 );
+  QCOMPARE( block->value( 0, 1 ), 127.0 );
+  QCOMPARE( block->value( 1, 0 ), 126.0 );
+  QCOMPARE( block->value( 1, 1 ), 127.0 );
+  QCOMPARE( block->value( 2, 0 ), 127.0 );
+  QCOMPARE( block->value( 2, 1 ), 126.0 );
+  delete result;
+  delete block;
+}
+
+void TestQgsRasterCalculator::calcInStrips()
+{
+  QgsRasterCalculatorEntry entry1;
+  entry1.bandNumber = 1;
+  entry1.raster = mpLandsatRasterLayer;
+  entry1.ref = QStringLiteral( "landsat@1" );
+  QgsRasterCalculatorEntry entry2;
+  entry2.bandNumber = 2;
+  entry2.raster = mpLandsatRasterLayer;
+  entry2.ref = QStringLiteral( "landsat@2" );
+
+  QVector<QgsRasterCalculatorEntry> entries;
+  entries << entry1 << entry2;
+
+  QgsCoordinateReferenceSystem crs;
+  crs.createFromId( 32633, QgsCoordinateReferenceSystem::EpsgCrsId );
+  // the extent and cells of the landsat raster
+  QgsRectangle extent( 781662.375, 3339523.125, 793062.375, 3350923.125 );
+
+  const int maxThreads = QThreadPool::globalInstance()->maxThreadCount();
+  QByteArray results[2];
+  for ( int i = 0; i < 2; ++i )
+  {
+    QTemporaryFile tmpFile;
+    tmpFile.open(); // fileName is no avialable until open
+    QString tmpName = tmpFile.fileName();
+    tmpFile.close();
+
+    QgsRasterCalculator rc( QStringLiteral( "\"landsat@1\" * 2 + \"landsat@2\"" ),
+                            tmpName,
+                            QStringLiteral( "GTiff" ),
+                            extent, crs, 200, 200, entries );
+    if ( i == 1 )
+    {
+      // strips of a few rows each, calculated in parallel
+      rc.mStripCells = 200 * 10;
+      QThreadPool::globalInstance()->setMaxThreadCount( 4 );
+    }
+    const int result = rc.processCalculation();
+    QThreadPool::globalInstance()->setMaxThreadCount( maxThreads );
+    QCOMPARE( result, 0 );
+
+    QgsRasterLayer layer( tmpName, QStringLiteral( "result" ) );
+    QCOMPARE( layer.width(), 200 );
+    QCOMPARE( layer.height(), 200 );
+    std::unique_ptr< QgsRasterBlock > block( layer.dataProvider()->block( 1, extent, 200, 200 ) );
+    QVERIFY( block );
+    results[i] = block->data();
+  }
+
+  QVERIFY( !results[0].isEmpty() );
+  QCOMPARE( results[1], results[0] );
+
+  // spot check the values of the last strip
+  std::unique_ptr< QgsRasterBlock > input1( mpLandsatRasterLayer->dataProvider()->block( 1, extent, 200, 200 ) );
+  std::unique_ptr< QgsRasterBlock > input2( mpLandsatRasterLayer->dataProvider()->block( 2, extent, 200, 200 ) );
+  QgsRasterBlock output( Qgis::Float32, 200, 200 );
+  output.setData( results[1] );
+  QCOMPARE( output.value( 199, 0 ), input1->value( 199, 0 ) * 2 + input2->value( 199, 0 ) );
+  QCOMPARE( output.value( 195, 123 ), input1->value( 195, 123 ) * 2 + input2->value( 195, 123 ) );
+}
+
 QGSTEST_MAIN( TestQgsRasterCalculator )
 #include "testqgsrastercalculator.moc"
@@ -37,6 +37,8 @@ class TestQgsZonalStatistics : public QObject
     void cleanup() {}
 
     void testStatistics();
+    void testPercentiles();
+    void testVarietyOnly();
 
   private:
     QgsVectorLayer *mVectorLayer = nullptr;
@@ -181,5 +183,39 @@ void TestQgsZonalStatistics::testStatistics()
   QCOMPARE( f.attribute( "myqgis2__4" ).toDouble(), 0.13888888888889 );
 }
 
+void TestQgsZonalStatistics::testPercentiles()
+{
+  QgsZonalStatistics zs( mVectorLayer, mRasterLayer, QStringLiteral( "pc_" ), 1, QgsZonalStatistics::Percentiles );
+  zs.setPercentiles( QList< double >() << 0 << 50 << 100 );
+  QCOMPARE( zs.calculateStatistics( nullptr ), 0 );
+
+  QgsFeature f;
+  QgsFeatureRequest request;
+  request.setFilterFid( 0 );
+  QVERIFY( mVectorLayer->getFeatures( request ).nextFeature( f ) );
+  QCOMPARE( f.attribute( "pc_p0" ).toDouble(), 0.0 );
+  QCOMPARE( f.attribute( "pc_p50" ).toDouble(), 1.0 );
+  QCOMPARE( f.attribute( "pc_p100" ).toDouble(), 1.0 );
+
+  request.setFilterFid( 1 );
+  QVERIFY( mVectorLayer->getFeatures( request ).nextFeature( f ) );
+  QCOMPARE( f.attribute( "pc_p0" ).toDouble(), 0.0 );
+  QCOMPARE( f.attribute( "pc_p50" ).toDouble(), 1.0 );
+  QCOMPARE( f.attribute( "pc_p100" ).toDouble(), 1.0 );
+}
+
+void TestQgsZonalStatistics::testVarietyOnly()
+{
+  // the distinct values have to be collected, even if neither minority nor majority are requested
+  QgsZonalStatistics zs( mVectorLayer, mRasterLayer, QStringLiteral( "v_" ), 1, QgsZonalStatistics::Variety );
+  QCOMPARE( zs.calculateStatistics( nullptr ), 0 );
+
+  QgsFeature f;
+  QgsFeatureRequest request;
+  request.setFilterFid( 0 );
+  QVERIFY( mVectorLayer->getFeatures( request ).nextFeature( f ) );
+  QCOMPARE( f.attribute( "v_variety" ).toInt(), 2 );
+}
+
 QGSTEST_MAIN( TestQgsZonalStatistics )
 #include "testqgszonalstatistics.moc"
@@ -17,7 +17,9 @@
 #include "qgscoordinatetransform.h"
 #include "qgsapplication.h"
 #include "qgsrectangle.h"
+#include "qgsapproximatecoordinatetransform.h"
 #include <QObject>
+#include <cmath>
 #include "qgstest.h"
 
 class TestQgsCoordinateTransform: public QObject
@@ -32,6 +34,11 @@ class TestQgsCoordinateTransform: public QObject
     void assignment();
     void isValid();
     void isShortCircuited();
+    void builtInTransforms_data();
+    void builtInTransforms();
+    void builtInTransformsOutsideDomain();
+    void approximateTransform();
+    void approximateTransformInvalid();
 
   private:
 
@@ -206,5 +213,157 @@ void TestQgsCoordinateTransform::transformBoundingBox()
   QGSCOMPARENEAR( resultRect.yMaximum(), expectedRect.yMaximum(), 0.001 );
 }
 
+void TestQgsCoordinateTransform::builtInTransforms_data()
+{
+  QTest::addColumn<QString>( "authid" );
+  // equivalent definition without an authority id, so that proj is used
+  QTest::addColumn<QString>( "proj" );
+
+  QTest::newRow( "web mercator" ) << "EPSG:3857" << "+proj=merc +a=6378137 +b=6378137 +units=m +nadgrids=@null +no_defs";
+  QTest::newRow( "utm 32N" ) << "EPSG:32632" << "+proj=utm +zone=32 +ellps=WGS84 +units=m +no_defs";
+  QTest::newRow( "utm 1N" ) << "EPSG:32601" << "+proj=utm +zone=1 +ellps=WGS84 +units=m +no_defs";
+  QTest::newRow( "utm 33S" ) << "EPSG:32733" << "+proj=utm +zone=33 +south +ellps=WGS84 +units=m +no_defs";
+}
+
+void TestQgsCoordinateTransform::builtInTransforms()
+{
+  QFETCH( QString, authid );
+  QFETCH( QString, proj );
+
+  const QgsCoordinateReferenceSystem wgs84( QStringLiteral( "EPSG:4326" ) );
+  const QgsCoordinateReferenceSystem projected( authid );
+  const QgsCoordinateReferenceSystem reference = QgsCoordinateReferenceSystem::fromProj4( proj );
+  QVERIFY( projected.isValid() );
+  QVERIFY( reference.isValid() );
+  QVERIFY( reference.authid().isEmpty() );
+
+  const QgsCoordinateTransform fast( wgs84, projected );
+  const QgsCoordinateTransform fastReverse( projected, wgs84 );
+  const QgsCoordinateTransform slow( wgs84, reference );
+
+  const double centralMeridian = authid == QLatin1String( "EPSG:3857" ) ? 0 : ( authid.rightRef( 2 ).toInt() * 6 - 183 );
+  for ( double lat = -84; lat <= 84; lat += 7.5 )
+  {
+    // covers the whole band of the built-in UTM transforms
+    for ( double dLon = -12; dLon <= 12; dLon += 1.5 )
+    {
+      const QgsPointXY geographic( centralMeridian + dLon, lat );
+      const QgsPointXY expected = slow.transform( geographic );
+      const QgsPointXY result = fast.transform( geographic );
+      QGSCOMPARENEAR( result.x(), expected.x(), 0.0001 );
+      QGSCOMPARENEAR( result.y(), expected.y(), 0.0001 );
+
+      // both directions of the built-in transforms
+      const QgsPointXY back = fastReverse.transform( result );
+      QGSCOMPARENEAR( back.x(), geographic.x(), 1e-9 );
+      QGSCOMPARENEAR( back.y(), geographic.y(), 1e-9 );
+      const QgsPointXY inverse = fast.transform( result, QgsCoordinateTransform::ReverseTransform );
+      QGSCOMPARENEAR( inverse.x(), geographic.x(), 1e-9 );
+      QGSCOMPARENEAR( inverse.y(), geographic.y(), 1e-9 );
+    }
+  }
+}
+
+void TestQgsCoordinateTransform::builtInTransformsOutsideDomain()
+{
+  const QgsCoordinateReferenceSystem wgs84( QStringLiteral( "EPSG:4326" ) );
+
+  // known values
+  const QgsCoordinateTransform webMercator( wgs84, QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:3857" ) ) );
+  QgsPointXY p = webMercator.transform( QgsPointXY( 10, 50 ) );
+  QGSCOMPARENEAR( p.x(), 1113194.9079327357, 0.000001 );
+  QGSCOMPARENEAR( p.y(), 6446275.841017158, 0.000001 );
+
+  const QgsCoordinateTransform utm( wgs84, QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:32632" ) ) );
+  p = utm.transform( QgsPointXY( 9, 0 ) );
+  QGSCOMPARENEAR( p.x(), 500000, 0.000001 );
+  QGSCOMPARENEAR( p.y(), 0, 0.000001 );
+
+  // points outside of the built-in transform domain must give the same results as proj
+  const QgsCoordinateTransform utmProj( wgs84, QgsCoordinateReferenceSystem::fromProj4( QStringLiteral( "+proj=utm +zone=32 +ellps=WGS84 +units=m +no_defs" ) ) );
+  double x[] = { 9, 35, 9 };
+  double y[] = { 45, 10, 88 };
+  double z[] = { 0, 0, 0 };
+  double expectedX[] = { 9, 35, 9 };
+  double expectedY[] = { 45, 10, 88 };
+  double expectedZ[] = { 0, 0, 0 };
+  utm.transformCoords( 3, x, y, z );
+  utmProj.transformCoords( 3, expectedX, expectedY, expectedZ );
+  for ( int i = 0; i < 3; ++i )
+  {
+    QGSCOMPARENEAR( x[i], expectedX[i], 0.0001 );
+    QGSCOMPARENEAR( y[i], expectedY[i], 0.0001 );
+  }
+}
+
+void TestQgsCoordinateTransform::approximateTransform()
+{
+  const QgsCoordinateTransform ct( QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:4326" ) ), QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:3111" ) ) );
+  const QgsRectangle extent( 140, -39, 150, -34 );
+  const double tolerance = 1.0;
+  QgsApproximateCoordinateTransform approximation( ct, extent, tolerance );
+  QVERIFY( approximation.isValid() );
+  QCOMPARE( approximation.extent(), extent );
+  QVERIFY( approximation.controlPointCount() > 9 );
+  QVERIFY( approximation.controlPointCount() < 10000 );
+
+  QPolygonF polygon;
+  for ( int i = 0; i < 1000; ++i )
+    polygon << QPointF( 140 + std::fmod( i * 0.7371, 10.0 ), -39 + std::fmod( i * 0.3119, 5.0 ) );
+  // outside of the extent
+  polygon << QPointF( 151, -30 ) << QPointF( 135, -40 );
+
+  QPolygonF expected = polygon;
+  ct.transformPolygon( expected );
+  QPolygonF result = polygon;
+  approximation.transformPolygon( result );
+  QCOMPARE( result.size(), expected.size() );
+  for ( int i = 0; i < result.size(); ++i )
+  {
+    QGSCOMPARENEAR( result.at( i ).x(), expected.at( i ).x(), tolerance );
+    QGSCOMPARENEAR( result.at( i ).y(), expected.at( i ).y(), tolerance );
+  }
+  // exact outside of the extent
+  QCOMPARE( result.last(), expected.last() );
+
+  // control points are exact
+  double x = 145;
+  double y = -36.5;
+  approximation.transformInPlace( x, y );
+  const QgsPointXY exact = ct.transform( 145, -36.5 );
+  QGSCOMPARENEAR( x, exact.x(), 0.000001 );
+  QGSCOMPARENEAR( y, exact.y(), 0.000001 );
+
+  // tighter tolerance needs more control points
+  QgsApproximateCoordinateTransform fine( ct, extent, tolerance / 100 );
+  QVERIFY( fine.isValid() );
+  QVERIFY( fine.controlPointCount() > approximation.controlPointCount() );
+}
+
+void TestQgsCoordinateTransform::approximateTransformInvalid()
+{
+  const QgsCoordinateReferenceSystem wgs84( QStringLiteral( "EPSG:4326" ) );
+  const QgsCoordinateTransform ct( wgs84, QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:3111" ) ) );
+
+  // no transform needed
+  QVERIFY( !QgsApproximateCoordinateTransform( QgsCoordinateTransform( wgs84, wgs84 ), QgsRectangle( 0, 0, 1, 1 ), 1 ).isValid() );
+  QVERIFY( !QgsApproximateCoordinateTransform( ct, QgsRectangle(), 1 ).isValid() );
+  QVERIFY( !QgsApproximateCoordinateTransform( ct, QgsRectangle( 140, -39, 150, -34 ), 0 ).isValid() );
+
+  // the poles can't be transformed to web mercator
+  const QgsCoordinateTransform mercator( wgs84, QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:3857" ) ) );
+  QgsApproximateCoordinateTransform invalid( mercator, QgsRectangle( -180, -90, 180, 90 ), 1 );
+  QVERIFY( !invalid.isValid() );
+  QCOMPARE( invalid.controlPointCount(), 0 );
+
+  // invalid approximations transform exactly
+  QPolygonF polygon;
+  polygon << QPointF( 10, 50 ) << QPointF( -20, 30 );
+  QPolygonF expected = polygon;
+  mercator.transformPolygon( expected );
+  invalid.transformPolygon( polygon );
+  QCOMPARE( polygon, expected );
+}
+
 QGSTEST_MAIN( TestQgsCoordinateTransform )
 #include "testqgscoordinatetransform.moc"
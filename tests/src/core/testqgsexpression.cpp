@@ -1685,6 +1685,36 @@ class TestQgsExpression: public QObject
       QCOMPARE( res, result );
     }
 
+    void relationAggregateGrouped()
+    {
+      // evaluating for several parents with the same context calculates the aggregates of all parents at once
+      QgsExpressionContext context;
+      context.appendScope( QgsExpressionContextUtils::layerScope( mAggregatesLayer ) );
+
+      const QStringList expressions = QStringList() << QStringLiteral( "relation_aggregate('my_rel','sum',\"col3\")" )
+                                      << QStringLiteral( "relation_aggregate('my_rel','count',\"col3\")" )
+                                      << QStringLiteral( "relation_aggregate('my_rel','concatenate',to_string(\"col3\"),concatenator:=',')" );
+      const QList< QVariant > parentKeys = QList< QVariant >() << 4 << 3 << 6 << QVariant( QVariant::Int ) << 4;
+      for ( const QString &string : expressions )
+      {
+        QgsExpression exp( string );
+        for ( const QVariant &parentKey : parentKeys )
+        {
+          QgsFeature af1( mAggregatesLayer->dataProvider()->fields(), 1 );
+          af1.setAttribute( QStringLiteral( "col1" ), parentKey );
+          context.setFeature( af1 );
+          QVariant res = exp.evaluate( &context );
+          QVERIFY( !exp.hasEvalError() );
+
+          // compare with the result of a single evaluation
+          QgsExpressionContext singleContext;
+          singleContext.appendScope( QgsExpressionContextUtils::layerScope( mAggregatesLayer ) );
+          singleContext.setFeature( af1 );
+          QCOMPARE( res, exp.evaluate( &singleContext ) );
+        }
+      }
+    }
+
     void get_feature_geometry()
     {
       //test that get_feature fetches feature's geometry
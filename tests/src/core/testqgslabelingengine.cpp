@@ -27,6 +27,10 @@
 #include <qgsvectorlayerlabelprovider.h>
 #include "qgsrenderchecker.h"
 #include "qgsfontutils.h"
+#include "qgsfontmetricscache.h"
+
+#include <QElapsedTimer>
+#include <QtConcurrentMap>
 
 class TestQgsLabelingEngine : public QObject
 {
@@ -48,6 +52,8 @@ class TestQgsLabelingEngine : public QObject
     void testCapitalization();
     void testParticipatingLayers();
     void testRegisterFeatureUnprojectible();
+    void testFontMetricsCache();
+    void benchmarkLabeling();
 
   private:
     QgsVectorLayer *vl = nullptr;
@@ -623,5 +629,97 @@ void TestQgsLabelingEngine::testRegisterFeatureUnprojectible()
   QCOMPARE( provider->mLabels.size(), 0 );
 }
 
+void TestQgsLabelingEngine::testFontMetricsCache()
+{
+  QgsFontMetricsCache::clear();
+
+  QFont font = QgsFontUtils::getStandardTestFont( QStringLiteral( "Bold" ), 14 );
+  QFontMetricsF fm( font );
+  const QString text = QStringLiteral( "Label text" );
+
+  QCOMPARE( QgsFontMetricsCache::fontMetrics( font ).height(), fm.height() );
+  QCOMPARE( QgsFontMetricsCache::width( font, text ), fm.width( text ) );
+  // cached value
+  QCOMPARE( QgsFontMetricsCache::width( font, text ), fm.width( text ) );
+  QCOMPARE( QgsFontMetricsCache::width( font, QStringLiteral( "L" ) ), fm.width( QStringLiteral( "L" ) ) );
+
+  QPainterPath expectedPath;
+  expectedPath.setFillRule( Qt::WindingFill );
+  expectedPath.addText( 0, 0, font, text );
+  QPainterPath path = QgsFontMetricsCache::textPath( font, text );
+  QCOMPARE( path.fillRule(), Qt::WindingFill );
+  QCOMPARE( path.elementCount(), expectedPath.elementCount() );
+  QCOMPARE( path.boundingRect(), expectedPath.boundingRect() );
+
+  // settings which change the text layout must give different keys
+  QFont spaced = font;
+  spaced.setLetterSpacing( QFont::AbsoluteSpacing, 5 );
+  QVERIFY( QgsFontMetricsCache::fontKey( spaced ) != QgsFontMetricsCache::fontKey( font ) );
+  QCOMPARE( QgsFontMetricsCache::width( spaced, text ), QFontMetricsF( spaced ).width( text ) );
+  QVERIFY( QgsFontMetricsCache::width( spaced, text ) > QgsFontMetricsCache::width( font, text ) );
+
+  QFont larger = font;
+  larger.setPointSizeF( 28 );
+  QVERIFY( QgsFontMetricsCache::fontKey( larger ) != QgsFontMetricsCache::fontKey( font ) );
+
+  // used from several threads at once
+  QStringList strings;
+  for ( int i = 0; i < 200; ++i )
+    strings << QStringLiteral( "label %1" ).arg( i % 50 );
+  const QList< double > widths = QtConcurrent::blockingMapped< QList< double > >( strings, [font]( const QString & string ) -> double
+  {
+    return QgsFontMetricsCache::width( font, string );
+  } );
+  for ( int i = 0; i < strings.count(); ++i )
+    QCOMPARE( widths.at( i ), fm.width( strings.at( i ) ) );
+}
+
+void TestQgsLabelingEngine::benchmarkLabeling()
+{
+  std::unique_ptr< QgsVectorLayer > layer( new QgsVectorLayer( QStringLiteral( "Point?crs=epsg:3857&field=name:string" ), QStringLiteral( "labels" ), QStringLiteral( "memory" ) ) );
+  QgsFeatureList features;
+  for ( int i = 0; i < 5000; ++i )
+  {
+    QgsFeature f( layer->fields() );
+    f.setAttribute( 0, QStringLiteral( "Label %1" ).arg( i % 100 ) );
+    f.setGeometry( QgsGeometry::fromPoint( QgsPointXY( ( i % 100 ) * 10.0, ( i / 100 ) * 10.0 ) ) );
+    features << f;
+  }
+  QVERIFY( layer->dataProvider()->addFeatures( features ) );
+
+  QgsPalLayerSettings settings;
+  settings.fieldName = QStringLiteral( "name" );
+  setDefaultLabelParams( settings );
+
+  QgsMapSettings mapSettings;
+  mapSettings.setOutputSize( QSize( 1024, 768 ) );
+  mapSettings.setExtent( layer->extent() );
+  mapSettings.setLayers( QList<QgsMapLayer *>() << layer.get() );
+  mapSettings.setOutputDpi( 96 );
+
+  QImage img( mapSettings.outputSize(), QImage::Format_ARGB32_Premultiplied );
+  QElapsedTimer timer;
+  int runs = 0;
+  qint64 elapsed = 0;
+  QBENCHMARK
+  {
+    img.fill( Qt::white );
+    QPainter p( &img );
+    QgsRenderContext context = QgsRenderContext::fromMapSettings( mapSettings );
+    context.setPainter( &p );
+
+    timer.start();
+    QgsLabelingEngine engine;
+    engine.setMapSettings( mapSettings );
+    engine.addProvider( new QgsVectorLayerLabelProvider( layer.get(), QString(), true, &settings ) );
+    engine.run( context );
+    elapsed += timer.elapsed();
+    runs++;
+    p.end();
+  }
+  if ( elapsed > 0 )
+    qDebug() << "labels/second:" << runs * features.count() * 1000.0 / elapsed;
+}
+
 QGSTEST_MAIN( TestQgsLabelingEngine )
 #include "testqgslabelingengine.moc"
@@ -20,6 +20,7 @@
 #include <QTime>
 #include <QApplication>
 #include <QDesktopServices>
+#include <memory>
 
 //qgis includes...
 #include <qgsvectorlayer.h> //defines QgsFieldMap
@@ -32,6 +33,8 @@
 #include <qgsfield.h>
 #include <qgis.h> //defines GEOWkt
 #include "qgsmaprenderersequentialjob.h"
+#include "qgsmaprendererparalleljob.h"
+#include "qgsmaprenderercache.h"
 #include <qgsmaplayer.h>
 #include <qgsreadwritecontext.h>
 #include <qgsvectorlayer.h>
@@ -41,6 +44,14 @@
 
 //qgs unit test utility class
 #include "qgsrenderchecker.h"
+#include "qgsfillsymbollayer.h"
+#include "qgsmarkersymbollayer.h"
+#include "qgssinglesymbolrenderer.h"
+#include "qgssymbol.h"
+#include "qgsvectorlayerrenderer.h"
+#include "qgsvectorlayerlabeling.h"
+#include "qgsvectordataprovider.h"
+#include "qgspallabeling.h"
 
 /** \ingroup UnitTests
  * This is a unit test for the QgsMapRendererJob class.
@@ -68,6 +79,20 @@ class TestQgsMapRendererJob : public QObject
     //! This method tests render performance
     void performanceTest();
 
+    //! Test that splitting a layer into strips gives the same result as unsplit rendering
+    void testLayerSplitIntoStrips();
+
+    //! Test that the labels of a layer split into strips are placed as for unsplit rendering
+    void testLabeledLayerSplitIntoStrips();
+
+    //! Test that reusing cached images after panning gives the same result as a full render
+    void testPannedCache_data();
+    void testPannedCache();
+
+    //! Test that drawing symbol levels into separate images gives the same result as buffering the features
+    void testSymbolLevelsDrawnToImages_data();
+    void testSymbolLevelsDrawnToImages();
+
     /** This unit test checks if rendering of adjacent tiles (e.g. to render images for tile caches)
      * does not result in border effects
      */
@@ -82,6 +107,11 @@ class TestQgsMapRendererJob : public QObject
     QgsMapSettings *mMapSettings = nullptr;
     QgsMapLayer *mpPolysLayer = nullptr;
     QString mReport;
+
+    //! Returns the number of pixels which differ by more than a small tolerance
+    int mismatchCount( const QImage &expected, const QImage &rendered ) const;
+
+    QImage renderImage( const QgsMapSettings &settings, bool parallel, QgsMapRendererCache *cache = nullptr ) const;
 };
 
 
@@ -213,6 +243,243 @@ void TestQgsMapRendererJob::performanceTest()
   QVERIFY( myResultFlag );
 }
 
+void TestQgsMapRendererJob::testLayerSplitIntoStrips()
+{
+  QgsMapSettings mapSettings( *mMapSettings );
+  mapSettings.setExtent( mpPolysLayer->extent() );
+  mapSettings.setOutputSize( QSize( 512, 512 ) );
+  mapSettings.setFlag( QgsMapSettings::Antialiasing );
+  mapSettings.setLayerRenderTileCount( 4 );
+  mapSettings.setLayerRenderTileFeatureThreshold( 0 );
+
+  QgsMapRendererParallelJob job( mapSettings );
+  job.start();
+  job.waitForFinished();
+  QImage splitImage = job.renderedImage();
+
+  mapSettings.setLayerRenderTileCount( 1 );
+  QgsMapRendererParallelJob job2( mapSettings );
+  job2.start();
+  job2.waitForFinished();
+  QImage wholeImage = job2.renderedImage();
+
+  QCOMPARE( splitImage.size(), wholeImage.size() );
+  QCOMPARE( mismatchCount( wholeImage, splitImage ), 0 );
+}
+
+void TestQgsMapRendererJob::testLabeledLayerSplitIntoStrips()
+{
+  // the polygons span several strips, and their labels overlap the other polygons
+  QgsVectorLayer layer( QStringLiteral( "Polygon?crs=EPSG:4326&field=name:string" ), QStringLiteral( "labeled" ), QStringLiteral( "memory" ) );
+  QVERIFY( layer.isValid() );
+  QgsFeatureList features;
+  for ( int i = 0; i < 6; ++i )
+  {
+    QgsFeature f( layer.fields() );
+    f.setGeometry( QgsGeometry::fromRect( QgsRectangle( i * 10, i * 5, i * 10 + 8, i * 5 + 40 ) ) );
+    f.setAttribute( 0, QStringLiteral( "polygon number %1" ).arg( i ) );
+    features << f;
+  }
+  QVERIFY( layer.dataProvider()->addFeatures( features ) );
+
+  QgsPalLayerSettings settings;
+  settings.fieldName = QStringLiteral( "name" );
+  settings.placement = QgsPalLayerSettings::OverPoint;
+  layer.setLabeling( new QgsVectorLayerSimpleLabeling( settings ) );
+
+  QgsMapSettings mapSettings;
+  mapSettings.setLayers( QList<QgsMapLayer *>() << &layer );
+  mapSettings.setDestinationCrs( layer.crs() );
+  mapSettings.setExtent( QgsRectangle( -5, -5, 65, 70 ) );
+  mapSettings.setOutputSize( QSize( 400, 400 ) );
+  mapSettings.setLayerRenderTileCount( 4 );
+  mapSettings.setLayerRenderTileFeatureThreshold( 0 );
+  QgsMapRendererParallelJob job( mapSettings );
+  job.start();
+  job.waitForFinished();
+  QImage splitImage = job.renderedImage();
+
+  mapSettings.setLayerRenderTileCount( 1 );
+  QgsMapRendererParallelJob job2( mapSettings );
+  job2.start();
+  job2.waitForFinished();
+  QImage wholeImage = job2.renderedImage();
+  QCOMPARE( mismatchCount( wholeImage, splitImage ), 0 );
+
+  layer.setLabeling( nullptr );
+  QgsMapRendererParallelJob job3( mapSettings );
+  job3.start();
+  job3.waitForFinished();
+  QImage unlabeledImage = job3.renderedImage();
+  QVERIFY( mismatchCount( wholeImage, unlabeledImage ) > 0 );
+}
+
+int TestQgsMapRendererJob::mismatchCount( const QImage &expected, const QImage &rendered ) const
+{
+  int count = 0;
+  for ( int y = 0; y < expected.height(); ++y )
+  {
+    for ( int x = 0; x < expected.width(); ++x )
+    {
+      QRgb e = expected.pixel( x, y );
+      QRgb r = rendered.pixel( x, y );
+      if ( std::abs( qRed( e ) - qRed( r ) ) > 5 || std::abs( qGreen( e ) - qGreen( r ) ) > 5
+           || std::abs( qBlue( e ) - qBlue( r ) ) > 5 || std::abs( qAlpha( e ) - qAlpha( r ) ) > 5 )
+        count++;
+    }
+  }
+  return count;
+}
+
+QImage TestQgsMapRendererJob::renderImage( const QgsMapSettings &settings, bool parallel, QgsMapRendererCache *cache ) const
+{
+  std::unique_ptr< QgsMapRendererQImageJob > job;
+  if ( parallel )
+    job.reset( new QgsMapRendererParallelJob( settings ) );
+  else
+    job.reset( new QgsMapRendererSequentialJob( settings ) );
+  job->setCache( cache );
+  job->start();
+  job->waitForFinished();
+  return job->renderedImage();
+}
+
+void TestQgsMapRendererJob::testPannedCache_data()
+{
+  QTest::addColumn<bool>( "parallel" );
+  QTest::addColumn<int>( "dx" );
+  QTest::addColumn<int>( "dy" );
+  QTest::addColumn<bool>( "markers" );
+
+  QTest::newRow( "parallel horizontal" ) << true << 37 << 0 << false;
+  QTest::newRow( "parallel vertical" ) << true << 0 << -55 << false;
+  QTest::newRow( "parallel diagonal" ) << true << -41 << 23 << false;
+  QTest::newRow( "sequential horizontal" ) << false << -37 << 0 << false;
+  QTest::newRow( "sequential diagonal" ) << false << 41 << 77 << false;
+  QTest::newRow( "markers parallel horizontal" ) << true << 37 << 0 << true;
+  QTest::newRow( "markers parallel diagonal" ) << true << -41 << 23 << true;
+  QTest::newRow( "markers sequential diagonal" ) << false << 41 << -77 << true;
+}
+
+void TestQgsMapRendererJob::testPannedCache()
+{
+  QFETCH( bool, parallel );
+  QFETCH( int, dx );
+  QFETCH( int, dy );
+  QFETCH( bool, markers );
+
+  QgsMapSettings mapSettings( *mMapSettings );
+  mapSettings.setOutputSize( QSize( 400, 300 ) );
+  mapSettings.setExtent( QgsRectangle( -10.1, -5.3, 9.9, 9.7 ) );
+  mapSettings.setFlag( QgsMapSettings::Antialiasing );
+
+  QgsMapLayer *layer = mpPolysLayer;
+  std::unique_ptr< QgsVectorLayer > markerLayer;
+  if ( markers )
+  {
+    // a grid of large semi-transparent markers, so that some markers straddle the borders of the
+    // newly exposed parts and of the parts rendered again, and markers drawn twice would show
+    markerLayer.reset( new QgsVectorLayer( QStringLiteral( "Point?crs=epsg:4326" ), QStringLiteral( "markers" ), QStringLiteral( "memory" ) ) );
+    QgsFeatureList features;
+    for ( double x = -14.0; x <= 14.0; x += 1.1 )
+    {
+      for ( double y = -9.0; y <= 14.0; y += 1.1 )
+      {
+        QgsFeature f;
+        f.setGeometry( QgsGeometry::fromPoint( QgsPointXY( x, y ) ) );
+        features << f;
+      }
+    }
+    QVERIFY( markerLayer->dataProvider()->addFeatures( features ) );
+    QgsSimpleMarkerSymbolLayer *markerSymbolLayer = new QgsSimpleMarkerSymbolLayer( QgsSimpleMarkerSymbolLayerBase::Circle, 8.0 );
+    markerSymbolLayer->setColor( QColor( 255, 0, 0, 150 ) );
+    markerSymbolLayer->setStrokeColor( QColor( 0, 0, 255, 150 ) );
+    markerLayer->setRenderer( new QgsSingleSymbolRenderer( new QgsMarkerSymbol( QgsSymbolLayerList() << markerSymbolLayer ) ) );
+    layer = markerLayer.get();
+    mapSettings.setLayers( QList<QgsMapLayer *>() << layer );
+  }
+
+  QgsMapRendererCache cache;
+  renderImage( mapSettings, parallel, &cache );
+  QVERIFY( cache.hasCacheImage( layer->id() ) );
+  const QgsRectangle previousExtent = mapSettings.visibleExtent();
+
+  // pan the map by whole pixels
+  const double mupp = mapSettings.mapUnitsPerPixel();
+  QgsRectangle extent = mapSettings.visibleExtent();
+  extent = QgsRectangle( extent.xMinimum() - dx * mupp, extent.yMinimum() + dy * mupp,
+                         extent.xMaximum() - dx * mupp, extent.yMaximum() + dy * mupp );
+  mapSettings.setExtent( extent );
+  QVERIFY( !cache.init( mapSettings.visibleExtent(), mapSettings.scale() ) );
+  QVERIFY( !cache.hasCacheImage( layer->id() ) );
+  QgsRectangle cachedExtent;
+  QVERIFY( !cache.pannedCacheImage( layer->id(), cachedExtent ).isNull() );
+  QCOMPARE( cachedExtent, previousExtent );
+
+  const QImage panned = renderImage( mapSettings, parallel, &cache );
+  const QImage expected = renderImage( mapSettings, parallel );
+  QCOMPARE( panned.size(), expected.size() );
+  QCOMPARE( mismatchCount( expected, panned ), 0 );
+
+  // the stitched image is cached for the new extent
+  QVERIFY( cache.hasCacheImage( layer->id() ) );
+}
+
+void TestQgsMapRendererJob::testSymbolLevelsDrawnToImages_data()
+{
+  QTest::addColumn<int>( "limit" );
+
+  QTest::newRow( "from the start" ) << 0;
+  QTest::newRow( "after some features" ) << 10;
+}
+
+void TestQgsMapRendererJob::testSymbolLevelsDrawnToImages()
+{
+  QFETCH( int, limit );
+
+  // thick strokes drawn below the fills of all features
+  QgsSimpleFillSymbolLayer *strokeLayer = new QgsSimpleFillSymbolLayer( Qt::transparent, Qt::NoBrush, QColor( 255, 0, 0 ), Qt::SolidLine, 2.0 );
+  strokeLayer->setRenderingPass( 0 );
+  QgsSimpleFillSymbolLayer *fillLayer = new QgsSimpleFillSymbolLayer( QColor( 0, 0, 255, 150 ), Qt::SolidPattern, Qt::transparent, Qt::NoPen );
+  fillLayer->setRenderingPass( 1 );
+  QgsFillSymbol *symbol = new QgsFillSymbol( QgsSymbolLayerList() << fillLayer << strokeLayer );
+  QgsSingleSymbolRenderer *symbolRenderer = new QgsSingleSymbolRenderer( symbol );
+  symbolRenderer->setUsingSymbolLevels( true );
+
+  std::unique_ptr< QgsVectorLayer > layer( mpPolysLayer->clone() );
+  layer->setRenderer( symbolRenderer );
+
+  QgsMapSettings mapSettings( *mMapSettings );
+  mapSettings.setOutputSize( QSize( 300, 200 ) );
+  mapSettings.setExtent( QgsRectangle( -10, -5, 20, 15 ) );
+  mapSettings.setLayers( QList<QgsMapLayer *>() << layer.get() );
+
+  auto render = [&]( int bufferLimit )
+  {
+    QImage image( mapSettings.outputSize(), QImage::Format_ARGB32_Premultiplied );
+    image.fill( 0 );
+    QPainter painter( &image );
+    painter.setRenderHint( QPainter::Antialiasing, true );
+
+    QgsRenderContext context = QgsRenderContext::fromMapSettings( mapSettings );
+    context.setPainter( &painter );
+    context.setCoordinateTransform( mapSettings.layerTransform( layer.get() ) );
+    std::unique_ptr< QgsMapLayerRenderer > renderer( layer->createMapRenderer( context ) );
+    QgsVectorLayerRenderer *vectorRenderer = dynamic_cast< QgsVectorLayerRenderer * >( renderer.get() );
+    vectorRenderer->setSymbolLevelsBufferLimit( bufferLimit );
+    renderer->render();
+    painter.end();
+    return image;
+  };
+
+  const QImage buffered = render( -1 );
+  const QImage streamed = render( limit );
+
+  // sanity check, both levels are drawn
+  QCOMPARE( QColor( buffered.pixel( 150, 100 ) ).alpha(), 255 );
+  QCOMPARE( mismatchCount( buffered, streamed ), 0 );
+}
+
 void TestQgsMapRendererJob::testFourAdjacentTiles_data()
 {
   QTest::addColumn<QStringList>( "bboxList" );
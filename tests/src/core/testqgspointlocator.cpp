@@ -16,6 +16,7 @@
 #include "qgstest.h"
 #include <QObject>
 #include <QString>
+#include <QtTest/QSignalSpy>
 
 #include "qgsapplication.h"
 #include "qgsvectorlayer.h"
@@ -302,6 +303,128 @@ class TestQgsPointLocator : public QObject
 
       delete vlEmptyGeom;
     }
+
+    void testMultiPartVertexIndex()
+    {
+      // vertex indices must match the vertex numbering of QgsGeometry, also for holes and multiple parts
+      QgsVectorLayer vl( QStringLiteral( "MultiPolygon" ), QStringLiteral( "x" ), QStringLiteral( "memory" ) );
+      QgsFeature f;
+      QgsGeometry geom = QgsGeometry::fromWkt( QStringLiteral( "MultiPolygon(((0 0, 10 0, 10 10, 0 10, 0 0),(2 2, 4 2, 4 4, 2 2)),((20 0, 30 0, 30 10, 20 0)))" ) );
+      f.setGeometry( geom );
+      QVERIFY( vl.dataProvider()->addFeatures( QgsFeatureList() << f ) );
+
+      QgsPointLocator loc( &vl );
+      const QList< QgsPointXY > points = QList< QgsPointXY >() << QgsPointXY( 4.2, 2.1 ) << QgsPointXY( 29, 1 ) << QgsPointXY( 9, 9.5 ) << QgsPointXY( 2.5, 3 );
+      for ( const QgsPointXY &pt : points )
+      {
+        int vertexIndex, beforeVertex, afterVertex;
+        double sqrDist;
+        QgsPointXY vertex = geom.closestVertex( pt, vertexIndex, beforeVertex, afterVertex, sqrDist );
+        QgsPointLocator::Match mV = loc.nearestVertex( pt, 999 );
+        QVERIFY( mV.isValid() );
+        QCOMPARE( mV.point(), vertex );
+        QCOMPARE( mV.vertexIndex(), vertexIndex );
+
+        QgsPointXY segmentPt;
+        double segmentDist = geom.closestSegmentWithContext( pt, segmentPt, afterVertex, nullptr, 1e-12 );
+        QgsPointLocator::Match mE = loc.nearestEdge( pt, 999 );
+        QVERIFY( mE.isValid() );
+        QCOMPARE( mE.point(), segmentPt );
+        QGSCOMPARENEAR( mE.distance(), std::sqrt( segmentDist ), 1e-12 );
+        QCOMPARE( mE.vertexIndex(), afterVertex - 1 );
+        QgsPointXY pt1, pt2;
+        mE.edgePoints( pt1, pt2 );
+        QCOMPARE( pt1, geom.vertexAt( afterVertex - 1 ) );
+        QCOMPARE( pt2, geom.vertexAt( afterVertex ) );
+      }
+
+      // inside the hole
+      QCOMPARE( loc.pointInPolygon( QgsPointXY( 3.5, 2.5 ) ).count(), 0 );
+      QCOMPARE( loc.pointInPolygon( QgsPointXY( 5, 5 ) ).count(), 1 );
+      QCOMPARE( loc.pointInPolygon( QgsPointXY( 28, 1 ) ).count(), 1 );
+    }
+
+    void testRepeatedChanges()
+    {
+      QgsVectorLayer vl( QStringLiteral( "LineString" ), QStringLiteral( "x" ), QStringLiteral( "memory" ) );
+      QgsFeatureList features;
+      for ( int i = 0; i < 10; ++i )
+      {
+        QgsFeature f;
+        f.setGeometry( QgsGeometry::fromWkt( QStringLiteral( "LineString(%1 0, %1 1, %1 2)" ).arg( i * 10 ) ) );
+        features << f;
+      }
+      QVERIFY( vl.dataProvider()->addFeatures( features ) );
+
+      QgsPointLocator loc( &vl );
+      QVERIFY( loc.init() );
+      QCOMPARE( loc.cachedGeometryCount(), 10 );
+
+      // enough edits to make the locator reuse its vertex buffer
+      vl.startEditing();
+      const QgsFeatureId fid = features.at( 3 ).id();
+      for ( int i = 0; i < 1000; ++i )
+      {
+        QgsGeometry geom = QgsGeometry::fromWkt( QStringLiteral( "LineString(30 0, 30 1, 30 2, %1 3)" ).arg( 30 + i % 7 ) );
+        QVERIFY( vl.changeGeometry( fid, geom ) );
+      }
+      QCOMPARE( loc.cachedGeometryCount(), 10 );
+
+      QgsPointLocator::Match m = loc.nearestVertex( QgsPointXY( 36, 3.1 ), 2 );
+      QVERIFY( m.isValid() );
+      QCOMPARE( m.featureId(), fid );
+      QCOMPARE( m.point(), QgsPointXY( 35, 3 ) );
+      QCOMPARE( m.vertexIndex(), 3 );
+
+      m = loc.nearestVertex( QgsPointXY( 90.1, 2 ), 1 );
+      QVERIFY( m.isValid() );
+      QCOMPARE( m.featureId(), features.at( 9 ).id() );
+      QCOMPARE( m.point(), QgsPointXY( 90, 2 ) );
+      vl.rollBack();
+    }
+
+    void testBackgroundIndexing()
+    {
+      QgsPointLocator loc( mVL );
+      QSignalSpy spy( &loc, &QgsPointLocator::initFinished );
+
+      QVERIFY( loc.init( -1, true ) );
+      QVERIFY( loc.isIndexing() );
+      // not ready yet - no results, no blocking
+      QVERIFY( !loc.hasIndex() );
+      QVERIFY( !loc.nearestVertex( QgsPointXY( 2, 2 ), 999 ).isValid() );
+
+      // changes made while indexing are applied once the index is built
+      mVL->startEditing();
+      QgsFeature ff( 0 );
+      ff.setGeometry( QgsGeometry::fromWkt( QStringLiteral( "Polygon((10 11, 11 10, 11 11, 10 11))" ) ) );
+      QVERIFY( mVL->addFeature( ff ) );
+
+      loc.waitForIndexingFinished();
+      QVERIFY( !loc.isIndexing() );
+      QVERIFY( loc.hasIndex() );
+      QCOMPARE( spy.count(), 1 );
+      QVERIFY( spy.at( 0 ).at( 0 ).toBool() );
+
+      QgsPointLocator::Match m = loc.nearestVertex( QgsPointXY( 12, 12 ), 999 );
+      QVERIFY( m.isValid() );
+      QCOMPARE( m.point(), QgsPointXY( 11, 11 ) );
+      QCOMPARE( loc.cachedGeometryCount(), 2 );
+
+      // the signal is not emitted again
+      QCoreApplication::processEvents();
+      QCOMPARE( spy.count(), 1 );
+      mVL->rollBack();
+
+      // limit of features exceeded
+      QgsPointLocator loc2( mVL );
+      QSignalSpy spy2( &loc2, &QgsPointLocator::initFinished );
+      QVERIFY( loc2.init( 0, true ) );
+      loc2.waitForIndexingFinished();
+      QCOMPARE( spy2.count(), 1 );
+      QVERIFY( !spy2.at( 0 ).at( 0 ).toBool() );
+      QVERIFY( !loc2.hasIndex() );
+    }
 };
 
 QGSTEST_MAIN( TestQgsPointLocator )
@@ -0,0 +1,287 @@
+/***************************************************************************
+     testqgspreparedgeometrycache.cpp
+     --------------------------------------
+    Date                 : October 2017
+    Copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+#include <QObject>
+
+#include "qgsapplication.h"
+#include "qgsfeatureiterator.h"
+#include "qgsgeometry.h"
+#include "qgspreparedgeometrycache.h"
+#include "qgsprocessingalgorithm.h"
+#include "qgsprocessingcontext.h"
+#include "qgsprocessingfeedback.h"
+#include "qgsprocessingregistry.h"
+#include "qgsprocessingutils.h"
+#include "qgsvectordataprovider.h"
+#include "qgsvectorlayer.h"
+
+class TestQgsPreparedGeometryCache : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void engine();
+    void nullGeometry();
+    void eviction();
+    void selectByLocation_data();
+    void selectByLocation();
+    void benchmarkExtractByLocation();
+
+  private:
+
+    //! Creates a layer with a grid of \a columns x \a rows points, spaced 1 map unit apart
+    QgsVectorLayer *createPointLayer( int columns, int rows ) const;
+
+    //! Creates a layer with square polygons of \a size map units at \a origins
+    QgsVectorLayer *createPolygonLayer( const QList< QgsPointXY > &origins, double size ) const;
+
+    QgsFeatureIds selectByLocation( QgsVectorLayer *target, QgsVectorLayer *intersect, int predicate ) const;
+};
+
+void TestQgsPreparedGeometryCache::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+}
+
+void TestQgsPreparedGeometryCache::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+void TestQgsPreparedGeometryCache::engine()
+{
+  QgsPreparedGeometryCache cache;
+  QCOMPARE( cache.count(), 0 );
+
+  QgsGeometry square = QgsGeometry::fromWkt( QStringLiteral( "Polygon((0 0, 10 0, 10 10, 0 10, 0 0))" ) );
+  QgsGeometryEngine *engine = cache.engine( 1, square );
+  QVERIFY( engine );
+  QVERIFY( cache.contains( 1 ) );
+  QCOMPARE( cache.count(), 1 );
+
+  QgsGeometry inside = QgsGeometry::fromPoint( QgsPointXY( 5, 5 ) );
+  QgsGeometry outside = QgsGeometry::fromPoint( QgsPointXY( 15, 5 ) );
+  QVERIFY( engine->intersects( inside.geometry() ) );
+  QVERIFY( engine->contains( inside.geometry() ) );
+  QVERIFY( !engine->intersects( outside.geometry() ) );
+
+  // cached engine is reused, even if the geometry is not passed again
+  QCOMPARE( cache.engine( 1, QgsGeometry() ), engine );
+  QCOMPARE( cache.count(), 1 );
+
+  QVERIFY( cache.engine( 2, QgsGeometry::fromWkt( QStringLiteral( "Polygon((20 0, 30 0, 30 10, 20 10, 20 0))" ) ) ) );
+  QCOMPARE( cache.count(), 2 );
+
+  cache.clear();
+  QCOMPARE( cache.count(), 0 );
+  QVERIFY( !cache.contains( 1 ) );
+}
+
+void TestQgsPreparedGeometryCache::nullGeometry()
+{
+  QgsPreparedGeometryCache cache;
+  QVERIFY( !cache.engine( 1, QgsGeometry() ) );
+  QVERIFY( !cache.contains( 1 ) );
+  QCOMPARE( cache.count(), 0 );
+}
+
+void TestQgsPreparedGeometryCache::eviction()
+{
+  // room for two squares (5 vertices each)
+  QgsPreparedGeometryCache cache( 10 );
+  QgsGeometry square = QgsGeometry::fromWkt( QStringLiteral( "Polygon((0 0, 10 0, 10 10, 0 10, 0 0))" ) );
+  QVERIFY( cache.engine( 1, square ) );
+  QVERIFY( cache.engine( 2, square ) );
+  QCOMPARE( cache.count(), 2 );
+
+  // least recently used engine goes
+  QVERIFY( cache.engine( 1, square ) );
+  QVERIFY( cache.engine( 3, square ) );
+  QCOMPARE( cache.count(), 2 );
+  QVERIFY( cache.contains( 1 ) );
+  QVERIFY( !cache.contains( 2 ) );
+  QVERIFY( cache.contains( 3 ) );
+
+  // geometries exceeding the budget are prepared, but not cached
+  QgsGeometry large = QgsGeometry::fromWkt( QStringLiteral( "Polygon((0 0, 5 0, 10 0, 10 5, 10 10, 5 10, 0 10, 0 5, 2 2, 1 1, 0 0))" ) );
+  QgsGeometryEngine *engine = cache.engine( 4, large );
+  QVERIFY( engine );
+  QVERIFY( engine->intersects( QgsGeometry::fromPoint( QgsPointXY( 5, 5 ) ).geometry() ) );
+  QVERIFY( !cache.contains( 4 ) );
+  QVERIFY( cache.contains( 1 ) );
+  QVERIFY( cache.contains( 3 ) );
+}
+
+void TestQgsPreparedGeometryCache::selectByLocation_data()
+{
+  QTest::addColumn<int>( "predicate" );
+
+  QTest::newRow( "intersect" ) << 0;
+  QTest::newRow( "contain" ) << 1;
+  QTest::newRow( "disjoint" ) << 2;
+  QTest::newRow( "touch" ) << 4;
+  QTest::newRow( "are within" ) << 6;
+}
+
+void TestQgsPreparedGeometryCache::selectByLocation()
+{
+  QFETCH( int, predicate );
+
+  // many more points than polygons, so that the points are tested against indexed polygons
+  std::unique_ptr< QgsVectorLayer > points( createPointLayer( 50, 40 ) );
+  std::unique_ptr< QgsVectorLayer > polygons( createPolygonLayer( QList< QgsPointXY >() << QgsPointXY( 2, 2 ) << QgsPointXY( 10, 5 ) << QgsPointXY( 12, 7 ) << QgsPointXY( 30.5, 20.5 ), 5 ) );
+  // a point without geometry, which is disjoint from everything
+  QgsFeature noGeometry( points->fields() );
+  QVERIFY( points->dataProvider()->addFeatures( QgsFeatureList() << noGeometry ) );
+
+  // build the expected results with plain geometry predicates
+  QgsFeatureIds expected;
+  QgsFeature point;
+  QgsFeatureIterator pointIt = points->getFeatures();
+  while ( pointIt.nextFeature( point ) )
+  {
+    bool intersectsAny = false;
+    bool isMatch = false;
+    QgsFeature polygon;
+    QgsFeatureIterator polygonIt = polygons->getFeatures();
+    while ( polygonIt.nextFeature( polygon ) )
+    {
+      if ( !point.hasGeometry() )
+        continue;
+
+      intersectsAny = intersectsAny || point.geometry().intersects( polygon.geometry() );
+      switch ( predicate )
+      {
+        case 0:
+          isMatch = isMatch || point.geometry().intersects( polygon.geometry() );
+          break;
+        case 1:
+          isMatch = isMatch || point.geometry().contains( polygon.geometry() );
+          break;
+        case 4:
+          isMatch = isMatch || point.geometry().touches( polygon.geometry() );
+          break;
+        case 6:
+          isMatch = isMatch || point.geometry().within( polygon.geometry() );
+          break;
+      }
+    }
+    if ( isMatch || ( predicate == 2 && !intersectsAny ) )
+      expected.insert( point.id() );
+  }
+  QVERIFY( predicate == 1 || !expected.isEmpty() );
+
+  // points against polygons
+  QCOMPARE( selectByLocation( points.get(), polygons.get(), predicate ), expected );
+}
+
+void TestQgsPreparedGeometryCache::benchmarkExtractByLocation()
+{
+  // 1M points against 10k polygons takes a while, so only run when explicitly asked for
+  if ( qgetenv( "QGIS_RUN_LARGE_BENCHMARKS" ).isEmpty() )
+    QSKIP( "Set QGIS_RUN_LARGE_BENCHMARKS to run the extract by location benchmark" );
+
+  std::unique_ptr< QgsVectorLayer > points( createPointLayer( 1000, 1000 ) );
+  QList< QgsPointXY > origins;
+  for ( int i = 0; i < 100; ++i )
+  {
+    for ( int j = 0; j < 100; ++j )
+      origins << QgsPointXY( i * 10 + 0.5, j * 10 + 0.5 );
+  }
+  std::unique_ptr< QgsVectorLayer > polygons( createPolygonLayer( origins, 5 ) );
+
+  QgsProcessingContext context;
+  QgsProcessingFeedback feedback;
+  const QgsProcessingAlgorithm *alg = QgsApplication::processingRegistry()->algorithmById( QStringLiteral( "native:extractbylocation" ) );
+  QVERIFY( alg );
+
+  QVariantMap parameters;
+  parameters.insert( QStringLiteral( "INPUT" ), QVariant::fromValue( points.get() ) );
+  parameters.insert( QStringLiteral( "INTERSECT" ), QVariant::fromValue( polygons.get() ) );
+  parameters.insert( QStringLiteral( "PREDICATE" ), QVariantList() << 0 );
+  parameters.insert( QStringLiteral( "OUTPUT" ), QStringLiteral( "memory:" ) );
+
+  QVariantMap results;
+  QBENCHMARK_ONCE
+  {
+    bool ok = false;
+    results = alg->run( parameters, context, &feedback, &ok );
+    QVERIFY( ok );
+  }
+
+  QgsVectorLayer *result = qobject_cast< QgsVectorLayer * >( QgsProcessingUtils::mapLayerFromString( results.value( QStringLiteral( "OUTPUT" ) ).toString(), context ) );
+  QVERIFY( result );
+  // each polygon covers 5 x 5 points
+  QCOMPARE( result->featureCount(), 250000L );
+}
+
+QgsVectorLayer *TestQgsPreparedGeometryCache::createPointLayer( int columns, int rows ) const
+{
+  QgsVectorLayer *layer = new QgsVectorLayer( QStringLiteral( "Point?crs=epsg:3857" ), QStringLiteral( "points" ), QStringLiteral( "memory" ) );
+  QgsFeatureList features;
+  features.reserve( columns * rows );
+  for ( int i = 0; i < columns; ++i )
+  {
+    for ( int j = 0; j < rows; ++j )
+    {
+      QgsFeature f;
+      f.setGeometry( QgsGeometry::fromPoint( QgsPointXY( i, j ) ) );
+      features << f;
+    }
+  }
+  layer->dataProvider()->addFeatures( features );
+  return layer;
+}
+
+QgsVectorLayer *TestQgsPreparedGeometryCache::createPolygonLayer( const QList< QgsPointXY > &origins, double size ) const
+{
+  QgsVectorLayer *layer = new QgsVectorLayer( QStringLiteral( "Polygon?crs=epsg:3857" ), QStringLiteral( "polygons" ), QStringLiteral( "memory" ) );
+  QgsFeatureList features;
+  features.reserve( origins.size() );
+  for ( const QgsPointXY &origin : origins )
+  {
+    QgsFeature f;
+    f.setGeometry( QgsGeometry::fromRect( QgsRectangle( origin.x(), origin.y(), origin.x() + size, origin.y() + size ) ) );
+    features << f;
+  }
+  layer->dataProvider()->addFeatures( features );
+  return layer;
+}
+
+QgsFeatureIds TestQgsPreparedGeometryCache::selectByLocation( QgsVectorLayer *target, QgsVectorLayer *intersect, int predicate ) const
+{
+  QgsProcessingContext context;
+  QgsProcessingFeedback feedback;
+  const QgsProcessingAlgorithm *alg = QgsApplication::processingRegistry()->algorithmById( QStringLiteral( "native:selectbylocation" ) );
+  if ( !alg )
+    return QgsFeatureIds();
+
+  QVariantMap parameters;
+  parameters.insert( QStringLiteral( "INPUT" ), QVariant::fromValue( target ) );
+  parameters.insert( QStringLiteral( "INTERSECT" ), QVariant::fromValue( intersect ) );
+  parameters.insert( QStringLiteral( "PREDICATE" ), QVariantList() << predicate );
+  parameters.insert( QStringLiteral( "METHOD" ), 0 );
+
+  target->removeSelection();
+  bool ok = false;
+  alg->run( parameters, context, &feedback, &ok );
+  return ok ? target->selectedFeatureIds() : QgsFeatureIds();
+}
+
+QGSTEST_MAIN( TestQgsPreparedGeometryCache )
+#include "testqgspreparedgeometrycache.moc"
@@ -33,6 +33,7 @@
 #include "qgsexpressioncontext.h"
 #include "qgsxmlutils.h"
 #include "qgsreferencedgeometry.h"
+#include "qgsexception.h"
 
 class DummyAlgorithm : public QgsProcessingAlgorithm
 {
@@ -287,6 +288,57 @@ class DummyProviderNoLoad : public DummyProvider
 
 };
 
+//dummy feature based algorithm, doubling the first attribute and skipping every third feature
+class DummyFeatureBasedAlgorithm : public QgsProcessingFeatureBasedAlgorithm
+{
+  public:
+
+    DummyFeatureBasedAlgorithm( bool parallel, QgsFeatureId failingFeature = -1 )
+      : mParallel( parallel )
+      , mFailingFeature( failingFeature )
+    {}
+
+    QString name() const override { return QStringLiteral( "featurebased" ); }
+    QString displayName() const override { return name(); }
+    DummyFeatureBasedAlgorithm *createInstance() const override { return new DummyFeatureBasedAlgorithm( mParallel, mFailingFeature ); }
+
+  protected:
+
+    QString outputName() const override { return QStringLiteral( "output" ); }
+    bool supportsParallelProcessing() const override { return mParallel; }
+
+    QgsFeature processFeature( const QgsFeature &feature, QgsProcessingFeedback *feedback ) override
+    {
+      if ( feature.id() == mFailingFeature )
+        throw QgsProcessingException( QStringLiteral( "failed at %1" ).arg( feature.id() ) );
+
+      const int value = feature.attribute( 0 ).toInt();
+      if ( value % 3 == 0 )
+        return QgsFeature();
+
+      QgsFeature f = feature;
+      f.setAttribute( 0, value * 2 );
+      feedback->pushInfo( QString::number( value ) );
+      return f;
+    }
+
+  private:
+
+    bool mParallel = false;
+    QgsFeatureId mFailingFeature = -1;
+};
+
+//feedback keeping all messages
+class MessageCollectingFeedback : public QgsProcessingFeedback
+{
+  public:
+
+    void reportError( const QString &error ) override { messages << QStringLiteral( "error: %1" ).arg( error ); }
+    void pushInfo( const QString &info ) override { messages << info; }
+
+    QStringList messages;
+};
+
 class TestQgsProcessing: public QObject
 {
     Q_OBJECT
@@ -354,6 +406,7 @@ class TestQgsProcessing: public QObject
     void create();
     void combineFields();
     void stringToPythonLiteral();
+    void parallelFeatureBasedAlgorithm();
 
   private:
 
@@ -5609,5 +5662,72 @@ void TestQgsProcessing::stringToPythonLiteral()
   QCOMPARE( QgsProcessingUtils::stringToPythonLiteral( QStringLiteral( "a \"string\"" ) ), QStringLiteral( "'a \\\"string\\\"'" ) );
 }
 
+void TestQgsProcessing::parallelFeatureBasedAlgorithm()
+{
+  // more features than fit in a single batch
+  std::unique_ptr< QgsVectorLayer > layer( new QgsVectorLayer( QStringLiteral( "Point?field=value:integer" ), QStringLiteral( "v" ), QStringLiteral( "memory" ) ) );
+  QVERIFY( layer->isValid() );
+  QgsFeatureList features;
+  for ( int i = 0; i < 5000; ++i )
+  {
+    QgsFeature f( layer->fields() );
+    f.setAttributes( QgsAttributes() << i );
+    f.setGeometry( QgsGeometry::fromPoint( QgsPointXY( i, i ) ) );
+    features << f;
+  }
+  QVERIFY( layer->dataProvider()->addFeatures( features ) );
+
+  auto runAlgorithm = [&layer]( const QgsProcessingAlgorithm & algorithm, QStringList & messages, bool & ok )
+  {
+    QgsProcessingContext context;
+    MessageCollectingFeedback feedback;
+
+    QVariantMap params;
+    params.insert( QStringLiteral( "INPUT" ), QVariant::fromValue( layer.get() ) );
+    params.insert( QStringLiteral( "OUTPUT" ), QStringLiteral( "memory:" ) );
+    QVariantMap results = algorithm.run( params, context, &feedback, &ok );
+    messages = feedback.messages;
+
+    QList< int > values;
+    QgsVectorLayer *output = qobject_cast< QgsVectorLayer * >( QgsProcessingUtils::mapLayerFromString( results.value( QStringLiteral( "OUTPUT" ) ).toString(), context ) );
+    if ( !output )
+      return values;
+
+    QgsFeature f;
+    QgsFeatureIterator it = output->getFeatures();
+    while ( it.nextFeature( f ) )
+      values << f.attribute( 0 ).toInt();
+    return values;
+  };
+
+  QStringList serialMessages;
+  bool ok = false;
+  DummyFeatureBasedAlgorithm serial( false );
+  const QList< int > serialValues = runAlgorithm( serial, serialMessages, ok );
+  QVERIFY( ok );
+  QCOMPARE( serialValues.count(), 3333 );
+  QCOMPARE( serialValues.at( 0 ), 2 );
+  QCOMPARE( serialValues.at( 1 ), 4 );
+  QCOMPARE( serialValues.at( 2 ), 8 );
+  QCOMPARE( serialMessages.count(), 3333 );
+
+  // results and messages must be identical, and in the same order
+  QStringList parallelMessages;
+  DummyFeatureBasedAlgorithm parallel( true );
+  QCOMPARE( runAlgorithm( parallel, parallelMessages, ok ), serialValues );
+  QVERIFY( ok );
+  QCOMPARE( parallelMessages, serialMessages );
+
+  // exceptions thrown from worker threads must stop the algorithm
+  QgsFeature failingFeature;
+  QVERIFY( layer->getFeatures( QgsFeatureRequest().setFilterExpression( QStringLiteral( "value = 2500" ) ) ).nextFeature( failingFeature ) );
+  DummyFeatureBasedAlgorithm failing( true, failingFeature.id() );
+  runAlgorithm( failing, parallelMessages, ok );
+  QVERIFY( !ok );
+  QCOMPARE( parallelMessages.last(), QStringLiteral( "error: failed at %1" ).arg( failingFeature.id() ) );
+  // messages for the features before the failing one are still reported
+  QCOMPARE( parallelMessages.count(), 1666 + 1 );
+}
+
 QGSTEST_MAIN( TestQgsProcessing )
 #include "testqgsprocessing.moc"
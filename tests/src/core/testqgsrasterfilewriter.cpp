@@ -47,10 +47,11 @@ class TestQgsRasterFileWriter: public QObject
     void cleanup() {} // will be called after every testfunction.
 
     void writeTest();
+    void writeTestInParts();
     void testCreateOneBandRaster();
     void testCreateMultiBandRaster();
   private:
-    bool writeTest( const QString &rasterName );
+    bool writeTest( const QString &rasterName, int maxTileSize = 0 );
     void log( const QString &msg );
     void logError( const QString &msg );
     QString mTestDataDir;
@@ -104,7 +105,25 @@ void TestQgsRasterFileWriter::writeTest()
   QVERIFY( allOK );
 }
 
-bool TestQgsRasterFileWriter::writeTest( const QString &rasterName )
+void TestQgsRasterFileWriter::writeTestInParts()
+{
+  // small parts, so that many parts are read in parallel and have to be written in order
+  QDir dir( mTestDataDir + "/raster" );
+
+  QStringList filters;
+  filters << QStringLiteral( "*.tif" );
+  QStringList rasterNames = dir.entryList( filters, QDir::Files );
+  bool allOK = true;
+  Q_FOREACH ( const QString &rasterName, rasterNames )
+  {
+    bool ok = writeTest( "raster/" + rasterName, 7 );
+    if ( !ok ) allOK = false;
+  }
+
+  QVERIFY( allOK );
+}
+
+bool TestQgsRasterFileWriter::writeTest( const QString &rasterName, int maxTileSize )
 {
   mReport += "<h2>" + rasterName + "</h2>\n";
 
@@ -132,6 +151,11 @@ bool TestQgsRasterFileWriter::writeTest( const QString &rasterName )
   mReport += "temporary output file: " + tmpName + "<br>";
 
   QgsRasterFileWriter fileWriter( tmpName );
+  if ( maxTileSize > 0 )
+  {
+    fileWriter.setMaxTileWidth( maxTileSize );
+    fileWriter.setMaxTileHeight( maxTileSize );
+  }
   QgsRasterPipe *pipe = new QgsRasterPipe();
   if ( !pipe->set( provider->clone() ) )
   {
@@ -183,6 +183,36 @@ class TestQgsSnappingUtils : public QObject
       QVERIFY( !m2.isValid() );
     }
 
+    void testSnapBackgroundIndexingExtent()
+    {
+      QgsMapSettings mapSettings;
+      mapSettings.setOutputSize( QSize( 100, 100 ) );
+      mapSettings.setExtent( QgsRectangle( 0, 0, 1, 1 ) );
+      mapSettings.setLayers( QList<QgsMapLayer *>() << mVL );
+      QVERIFY( mapSettings.hasValidSettings() );
+
+      QgsSnappingUtils u;
+      u.setMapSettings( mapSettings );
+      u.setIndexingStrategy( QgsSnappingUtils::IndexExtent );
+      u.setBackgroundIndexingEnabled( true );
+      QgsSnappingConfig snappingConfig = u.config();
+      snappingConfig.setEnabled( true );
+      snappingConfig.setMode( QgsSnappingConfig::AllLayers );
+      snappingConfig.setType( QgsSnappingConfig::Vertex );
+      snappingConfig.setTolerance( 10 );
+      snappingConfig.setUnits( QgsTolerance::Pixels );
+      u.setConfig( snappingConfig );
+
+      // a temporary locator is used while the extent is indexed in background
+      QgsPointLocator::Match m = u.snapToMap( QPoint( 100, 100 ) );
+      QVERIFY( m.isValid() );
+      QCOMPARE( m.point(), QgsPointXY( 1, 0 ) );
+
+      QTRY_VERIFY( u.snapToMap( QPoint( 100, 100 ) ).isValid() );
+      QgsPointLocator::Match m2 = u.snapToMap( QPoint( 100, 100 ) );
+      QCOMPARE( m2.point(), QgsPointXY( 1, 0 ) );
+    }
+
     void testSnapOnIntersection()
     {
       // testing with a layer with two crossing linestrings
@@ -14,6 +14,8 @@
  ***************************************************************************/
 
 #include "qgstest.h"
+#include <QDir>
+#include <QFile>
 #include <QObject>
 #include <QString>
 
@@ -136,6 +138,56 @@ class TestQgsSpatialIndex : public QObject
       QVERIFY( fids[0] == 1 );
     }
 
+    void testPersistence()
+    {
+      QString filePath = QDir::tempPath() + QStringLiteral( "/qgis_test_spatialindex.idx" );
+      QFile::remove( filePath );
+
+      QgsSpatialIndex index;
+      // no file yet
+      QVERIFY( !index.readFromFile( filePath, QStringLiteral( "stamp1" ) ) );
+
+      for ( int i = 0; i < 100; ++i )
+      {
+        for ( int j = 0; j < 100; ++j )
+        {
+          index.insertFeature( _pointFeature( i * 1000 + j, i, j ) );
+        }
+      }
+      QVERIFY( index.writeToFile( filePath, QStringLiteral( "stamp1" ) ) );
+
+      // outdated stamp
+      QgsSpatialIndex index2;
+      QVERIFY( !index2.readFromFile( filePath, QStringLiteral( "stamp2" ) ) );
+      QVERIFY( index2.intersects( QgsRectangle( -1000, -1000, 1000, 1000 ) ).isEmpty() );
+
+      QVERIFY( index2.readFromFile( filePath, QStringLiteral( "stamp1" ) ) );
+      QList<QgsFeatureId> fids = index2.intersects( QgsRectangle( 49.5, 49.5, 51.5, 51.5 ) );
+      std::sort( fids.begin(), fids.end() );
+      QCOMPARE( fids, QList<QgsFeatureId>() << 50050 << 50051 << 51050 << 51051 );
+      QCOMPARE( index2.intersects( QgsRectangle( -1000, -1000, 1000, 1000 ) ).count(), 10000 );
+      QCOMPARE( index2.nearestNeighbor( QgsPointXY( 20.1, 30.1 ), 1 ), QList<QgsFeatureId>() << 20030 );
+
+      // modifications stay in memory
+      QVERIFY( index2.insertFeature( _pointFeature( 1000000, 500, 500 ) ) );
+      QVERIFY( index2.deleteFeature( _pointFeature( 50050, 50, 50 ) ) );
+      QCOMPARE( index2.intersects( QgsRectangle( 499, 499, 501, 501 ) ), QList<QgsFeatureId>() << 1000000 );
+      QCOMPARE( index2.intersects( QgsRectangle( 49.5, 49.5, 50.5, 50.5 ) ).count(), 0 );
+
+      QgsSpatialIndex index3;
+      QVERIFY( index3.readFromFile( filePath, QStringLiteral( "stamp1" ) ) );
+      QCOMPARE( index3.intersects( QgsRectangle( 499, 499, 501, 501 ) ).count(), 0 );
+      QCOMPARE( index3.intersects( QgsRectangle( 49.5, 49.5, 50.5, 50.5 ) ).count(), 1 );
+
+      // empty index
+      QString emptyFilePath = QDir::tempPath() + QStringLiteral( "/qgis_test_spatialindex_empty.idx" );
+      QgsSpatialIndex emptyIndex;
+      QVERIFY( emptyIndex.writeToFile( emptyFilePath ) );
+      QgsSpatialIndex index4;
+      QVERIFY( index4.readFromFile( emptyFilePath ) );
+      QVERIFY( index4.intersects( QgsRectangle( -1000, -1000, 1000, 1000 ) ).isEmpty() );
+    }
+
     void benchmarkIntersect()
     {
       // add 50K features to the index
@@ -64,6 +64,7 @@ class TestVectorLayerJoinBuffer : public QObject
     void testCacheUpdate();
     void testRemoveJoinOnLayerDelete();
     void testResolveReferences();
+    void testBatchedJoin();
 
   private:
     QgsProject mProject;
@@ -664,6 +665,95 @@ void TestVectorLayerJoinBuffer::testResolveReferences()
   delete vlA;
 }
 
+void TestVectorLayerJoinBuffer::testBatchedJoin()
+{
+  // more features than fit in a single batch, joined without memory cache
+  QgsVectorLayer *vlA = new QgsVectorLayer( QStringLiteral( "Point?field=id_a:integer&field=name_a:string" ), QStringLiteral( "batchA" ), QStringLiteral( "memory" ) );
+  QVERIFY( vlA->isValid() );
+  QgsVectorLayer *vlB = new QgsVectorLayer( QStringLiteral( "Point?field=name_b:string&field=value_b:integer&field=other_b:integer" ), QStringLiteral( "batchB" ), QStringLiteral( "memory" ) );
+  QVERIFY( vlB->isValid() );
+
+  QgsFeatureList featuresA;
+  for ( int i = 0; i < 2500; ++i )
+  {
+    QgsFeature f( vlA->fields() );
+    f.setAttribute( 0, i );
+    // every 7th feature has no join value, every 5th one has no matching join feature,
+    // and a few values need quoting
+    if ( i % 7 == 0 )
+      f.setAttribute( 1, QVariant( QVariant::String ) );
+    else
+      f.setAttribute( 1, QStringLiteral( "n'%1" ).arg( i % 1200 ) );
+    featuresA << f;
+  }
+  QVERIFY( vlA->dataProvider()->addFeatures( featuresA ) );
+
+  QgsFeatureList featuresB;
+  for ( int i = 0; i < 1200; ++i )
+  {
+    if ( i % 5 == 0 )
+      continue;
+
+    QgsFeature f( vlB->fields() );
+    f.setAttribute( 0, QStringLiteral( "n'%1" ).arg( i ) );
+    f.setAttribute( 1, i * 10 );
+    f.setAttribute( 2, i * 100 );
+    featuresB << f;
+  }
+  QVERIFY( vlB->dataProvider()->addFeatures( featuresB ) );
+
+  QgsVectorLayerJoinInfo joinInfo;
+  joinInfo.setTargetFieldName( QStringLiteral( "name_a" ) );
+  joinInfo.setJoinLayer( vlB );
+  joinInfo.setJoinFieldName( QStringLiteral( "name_b" ) );
+  joinInfo.setUsingMemoryCache( false );
+  joinInfo.setPrefix( QStringLiteral( "B_" ) );
+  joinInfo.setJoinFieldNamesSubset( new QStringList( QStringList() << QStringLiteral( "value_b" ) ) );
+  QVERIFY( vlA->addJoin( joinInfo ) );
+  QCOMPARE( vlA->fields().count(), 3 ); // id_a, name_a, B_value_b
+
+  int count = 0;
+  QgsFeature f;
+  QgsFeatureIterator fi = vlA->getFeatures();
+  while ( fi.nextFeature( f ) )
+  {
+    const int i = f.attribute( QStringLiteral( "id_a" ) ).toInt();
+    if ( i % 7 == 0 || ( i % 1200 ) % 5 == 0 )
+      QVERIFY( f.attribute( QStringLiteral( "B_value_b" ) ).isNull() );
+    else
+      QCOMPARE( f.attribute( QStringLiteral( "B_value_b" ) ).toInt(), ( i % 1200 ) * 10 );
+    count++;
+  }
+  QCOMPARE( count, 2500 );
+
+  // limit smaller than the batch size
+  fi = vlA->getFeatures( QgsFeatureRequest().setLimit( 3 ) );
+  count = 0;
+  while ( fi.nextFeature( f ) )
+  {
+    if ( f.attribute( QStringLiteral( "id_a" ) ).toInt() == 1 )
+      QCOMPARE( f.attribute( QStringLiteral( "B_value_b" ) ).toInt(), 10 );
+    count++;
+  }
+  QCOMPARE( count, 3 );
+
+  // edited join values must be used for the batched lookup
+  QVERIFY( vlA->startEditing() );
+  QgsFeature first;
+  QVERIFY( vlA->getFeatures( QgsFeatureRequest().setFilterExpression( QStringLiteral( "id_a = 1" ) ) ).nextFeature( first ) );
+  QVERIFY( vlA->changeAttributeValue( first.id(), 1, QStringLiteral( "n'2" ) ) );
+  fi = vlA->getFeatures();
+  while ( fi.nextFeature( f ) )
+  {
+    if ( f.id() == first.id() )
+      QCOMPARE( f.attribute( QStringLiteral( "B_value_b" ) ).toInt(), 20 );
+  }
+  vlA->rollBack();
+
+  delete vlA;
+  delete vlB;
+}
+
 
 QGSTEST_MAIN( TestVectorLayerJoinBuffer )
 #include "testqgsvectorlayerjoinbuffer.moc"
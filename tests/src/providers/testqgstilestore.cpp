@@ -0,0 +1,153 @@
+/***************************************************************************
+    testqgstilestore.cpp
+    ---------------------
+    begin                : October 2017
+    copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include <QBuffer>
+#include <QImage>
+#include <QObject>
+#include <QTemporaryDir>
+#include <QUrl>
+#include "qgstest.h"
+#include <qgstilecache.h>
+#include <qgstilestore.h>
+#include <qgsapplication.h>
+
+/** \ingroup UnitTests
+ * This is a unit test for the persistent tile store of the WMS provider.
+ */
+class TestQgsTileStore: public QObject
+{
+    Q_OBJECT
+  private slots:
+
+    void initTestCase()
+    {
+      QgsApplication::init();
+      QgsApplication::initQgis();
+    }
+
+    void cleanupTestCase()
+    {
+      QgsTileCache::setTileStore( nullptr );
+      QgsApplication::exitQgis();
+    }
+
+    void storeAndRead()
+    {
+      QTemporaryDir dir;
+      const QString path = dir.path() + "/tiles.sqlite";
+      const QUrl url( QStringLiteral( "http://localhost/tiles/1/0/0.png" ) );
+      {
+        QgsTileStore store( path, 1000 );
+        QVERIFY( store.isValid() );
+        QCOMPARE( store.tileCount(), 0 );
+        QVERIFY( store.tileData( url ).isEmpty() );
+
+        store.insertTileData( url, QByteArray( 100, 'a' ) );
+        QCOMPARE( store.tileCount(), 1 );
+        QCOMPARE( store.size(), 100LL );
+        QCOMPARE( store.tileData( url ), QByteArray( 100, 'a' ) );
+
+        // replace the tile
+        store.insertTileData( url, QByteArray( 50, 'b' ) );
+        QCOMPARE( store.tileCount(), 1 );
+        QCOMPARE( store.size(), 50LL );
+        QCOMPARE( store.tileData( url ), QByteArray( 50, 'b' ) );
+
+        // tiles larger than the store are not stored
+        store.insertTileData( QUrl( QStringLiteral( "http://localhost/tiles/1/0/1.png" ) ), QByteArray( 1001, 'c' ) );
+        QCOMPARE( store.tileCount(), 1 );
+      }
+
+      // tiles persist
+      QgsTileStore store( path, 1000 );
+      QCOMPARE( store.tileCount(), 1 );
+      QCOMPARE( store.size(), 50LL );
+      QCOMPARE( store.tileData( url ), QByteArray( 50, 'b' ) );
+
+      store.clear();
+      QCOMPARE( store.tileCount(), 0 );
+      QCOMPARE( store.size(), 0LL );
+      QVERIFY( store.tileData( url ).isEmpty() );
+    }
+
+    void eviction()
+    {
+      QTemporaryDir dir;
+      QgsTileStore store( dir.path() + "/tiles.sqlite", 1000 );
+      QVERIFY( store.isValid() );
+
+      auto tileUrl = []( int i ) { return QUrl( QStringLiteral( "http://localhost/tiles/2/%1/0.png" ).arg( i ) ); };
+      for ( int i = 0; i < 10; ++i )
+        store.insertTileData( tileUrl( i ), QByteArray( 100, 'a' ) );
+      QCOMPARE( store.tileCount(), 10 );
+      QCOMPARE( store.size(), 1000LL );
+
+      // use the first tile, so that it is the most recently used one
+      QVERIFY( !store.tileData( tileUrl( 0 ) ).isEmpty() );
+
+      // exceeding the maximum size evicts the least recently used tiles
+      store.insertTileData( tileUrl( 10 ), QByteArray( 100, 'a' ) );
+      QVERIFY( store.size() <= 900 );
+      QCOMPARE( store.size(), store.tileCount() * 100LL );
+      QVERIFY( !store.tileData( tileUrl( 0 ) ).isEmpty() );
+      QVERIFY( !store.tileData( tileUrl( 10 ) ).isEmpty() );
+      QVERIFY( store.tileData( tileUrl( 1 ) ).isEmpty() );
+      QVERIFY( store.tileData( tileUrl( 2 ) ).isEmpty() );
+    }
+
+    void cacheUsesStore()
+    {
+      QTemporaryDir dir;
+      QgsTileCache::setTileStore( new QgsTileStore( dir.path() + "/tiles.sqlite", 1024 * 1024 ) );
+      QgsTileStore *store = QgsTileCache::tileStore();
+      QVERIFY( store );
+
+      QList<QUrl> urls;
+      for ( int i = 0; i < 4; ++i )
+      {
+        QImage image( 16, 16, QImage::Format_ARGB32 );
+        image.fill( QColor( 50 * i, 0, 0 ) );
+        QByteArray data;
+        QBuffer buffer( &data );
+        buffer.open( QIODevice::WriteOnly );
+        image.save( &buffer, "PNG" );
+
+        const QUrl url( QStringLiteral( "http://localhost/tilestoretest/%1.png" ).arg( i ) );
+        store->insertTileData( url, data );
+        urls << url;
+      }
+      urls << QUrl( QStringLiteral( "http://localhost/tilestoretest/missing.png" ) );
+
+      QVERIFY( !QgsTileCache::hasTile( urls.at( 0 ) ) );
+      const QList<QImage> images = QgsTileCache::tiles( urls );
+      QCOMPARE( images.count(), 5 );
+      for ( int i = 0; i < 4; ++i )
+      {
+        QCOMPARE( images.at( i ).size(), QSize( 16, 16 ) );
+        QCOMPARE( QColor( images.at( i ).pixel( 8, 8 ) ).red(), 50 * i );
+        // decoded tiles are kept in memory
+        QVERIFY( QgsTileCache::hasTile( urls.at( i ) ) );
+      }
+      QVERIFY( images.at( 4 ).isNull() );
+
+      // tiles inserted with their data are written to the store
+      const QUrl newUrl( QStringLiteral( "http://localhost/tilestoretest/new.png" ) );
+      QgsTileCache::insertTile( newUrl, images.at( 1 ), store->tileData( urls.at( 1 ) ) );
+      QVERIFY( !store->tileData( newUrl ).isEmpty() );
+
+      QgsTileCache::setTileStore( nullptr );
+    }
+};
+
+QGSTEST_MAIN( TestQgsTileStore )
+#include "testqgstilestore.moc"
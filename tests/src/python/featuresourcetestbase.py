@@ -578,6 +578,46 @@ class FeatureSourceTestCase(object):
         features = [f['pk'] for f in it]
         assert 1 in features or 5 in features, 'Expected either 1 or 5 for expression and feature limit, Got {} instead'.format(features)
 
+    def testGetFeaturesOffset(self):
+        # pages of unordered features must not overlap
+        all_pks = [f['pk'] for f in self.source.getFeatures()]
+        it = self.source.getFeatures(QgsFeatureRequest().setOffset(2))
+        features = [f['pk'] for f in it]
+        self.assertEqual(len(features), 3)
+        first_page = [f['pk'] for f in self.source.getFeatures(QgsFeatureRequest().setLimit(2))]
+        self.assertEqual(set(first_page + features), set(all_pks))
+        it.rewind()
+        features = [f['pk'] for f in it]
+        self.assertEqual(len(features), 3, 'Expected three features after rewind, got {} instead'.format(len(features)))
+
+        # offset past the last feature
+        features = [f['pk'] for f in self.source.getFeatures(QgsFeatureRequest().setOffset(5))]
+        self.assertEqual(features, [])
+
+        # combined with limit and ordering
+        request = QgsFeatureRequest().addOrderBy('pk').setOffset(1).setLimit(2)
+        features = [f['pk'] for f in self.source.getFeatures(request)]
+        self.assertEqual(features, [2, 3])
+        request = QgsFeatureRequest().addOrderBy('cnt', False).setOffset(3)
+        features = [f['pk'] for f in self.source.getFeatures(request)]
+        self.assertEqual(features, [1, 5])
+
+        # the offset applies to the filtered features, both with and without compilation
+        for compile in (False, True):
+            try:
+                if compile:
+                    self.enableCompiler()
+                else:
+                    self.disableCompiler()
+            except AttributeError:
+                pass
+            request = QgsFeatureRequest().setFilterExpression('cnt >= 100').addOrderBy('pk').setOffset(1).setLimit(2)
+            features = [f['pk'] for f in self.source.getFeatures(request)]
+            self.assertEqual(features, [2, 3])
+            request = QgsFeatureRequest().setFilterExpression('cnt >= 100').setOffset(3)
+            features = [f['pk'] for f in self.source.getFeatures(request)]
+            self.assertEqual(len(features), 1)
+
     def testClosedIterators(self):
         """ Test behavior of closed iterators """
 
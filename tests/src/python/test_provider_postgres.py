@@ -279,6 +279,65 @@ class TestPyQgsPostgresProvider(unittest.TestCase, ProviderTestCase):
         # max negative signed 32bit integer
         test(self.dbconn, '(SELECT (-9223372036854775808)::int8 i, NULL::geometry(Point) g)', 'i', -9223372036854775808, 1)
 
+    def testBinaryAttributes(self):
+        """
+        Test decoding of attribute values transferred in binary form
+        """
+        query = ('(SELECT 1 id, -7::int2 i2, -70000::int4 i4, 5000000000::int8 i8, '
+                 '1.5::float4 f4, 0.1::float4 f4b, 0.1234567890123456789::float8 f8, '
+                 '\'1987-06-05\'::date d, \'infinity\'::date dinf, '
+                 '\'13:41:52.25\'::time t, \'1999-12-31 23:59:59.5\'::timestamp ts, '
+                 '\'2017-07-15 12:30:00\'::timestamp tssummer, '
+                 'NULL::float8 fnull, NULL::timestamp tsnull, NULL::geometry(Point) g)')
+        uri = '%s table="%s" (g) key=\'id\'' % (self.dbconn, query)
+        vl = QgsVectorLayer(uri, "t", "postgres")
+        self.assertTrue(vl.isValid())
+
+        f = next(vl.getFeatures())
+        self.assertEqual(f['i2'], -7)
+        self.assertEqual(f['i4'], -70000)
+        self.assertEqual(f['i8'], 5000000000)
+        self.assertEqual(f['f4'], 1.5)
+        self.assertEqual(f['f4b'], 0.1)
+        self.assertEqual(f['f8'], 0.1234567890123456789)
+        self.assertEqual(f['d'], QDate(1987, 6, 5))
+        self.assertFalse(f['dinf'])
+        self.assertEqual(f['t'], QTime(13, 41, 52, 250))
+        self.assertEqual(f['ts'], QDateTime(QDate(1999, 12, 31), QTime(23, 59, 59, 500)))
+        self.assertEqual(f['tssummer'], QDateTime(QDate(2017, 7, 15), QTime(12, 30)))
+        self.assertFalse(f['fnull'])
+        self.assertFalse(f['tsnull'])
+
+        # subset of attributes
+        request = QgsFeatureRequest().setSubsetOfAttributes(['f8', 'ts'], vl.fields())
+        f = next(vl.getFeatures(request))
+        self.assertEqual(f['f8'], 0.1234567890123456789)
+        self.assertEqual(f['ts'], QDateTime(QDate(1999, 12, 31), QTime(23, 59, 59, 500)))
+
+    def testFetchBatches(self):
+        """
+        Test reading features over multiple cursor fetches, with and without requesting them ahead of time
+        """
+        query = '(SELECT i id, i * 2 v, NULL::geometry(Point) g FROM generate_series(1, 20000) i)'
+        for prefetch in ['0', '1']:
+            uri = '%s table="%s" (g) key=\'id\' prefetch=\'%s\'' % (self.dbconn, query, prefetch)
+            vl = QgsVectorLayer(uri, "t", "postgres")
+            self.assertTrue(vl.isValid())
+
+            request = QgsFeatureRequest().addOrderBy('id')
+            values = [f['v'] for f in vl.getFeatures(request)]
+            self.assertEqual(values, list(range(2, 40001, 2)))
+
+            # closing an iterator while a fetch is pending must leave the connection usable
+            it = vl.getFeatures(request)
+            for i in range(5000):
+                self.assertTrue(next(it))
+            it.rewind()
+            self.assertEqual(next(it)['v'], 2)
+            it.close()
+            self.assertEqual(vl.featureCount(), 20000)
+            self.assertEqual(len([f for f in vl.getFeatures(QgsFeatureRequest().setLimit(10))]), 10)
+
     def testPktIntInsert(self):
         vl = QgsVectorLayer('{} table="qgis_test"."{}" key="pk" sql='.format(self.dbconn, 'bikes_view'), "bikes_view", "postgres")
         self.assertTrue(vl.isValid())
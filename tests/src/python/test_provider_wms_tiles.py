@@ -0,0 +1,170 @@
+# -*- coding: utf-8 -*-
+"""QGIS Unit tests for the tile cache, tile store and tile prefetching of the WMS provider.
+
+.. note:: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+"""
+__author__ = 'QGIS contributors'
+__date__ = '16/10/2017'
+__copyright__ = 'Copyright 2017, The QGIS Project'
+# This will get replaced with a git SHA1 when you do a git archive
+__revision__ = '$Format:%H$'
+
+import qgis  # NOQA
+
+import http.server
+import os
+import shutil
+import socketserver
+import sqlite3
+import tempfile
+import threading
+import time
+
+from qgis.core import (QgsCoordinateReferenceSystem,
+                       QgsMapRendererSequentialJob,
+                       QgsMapSettings,
+                       QgsRasterLayer,
+                       QgsRectangle,
+                       QgsSettings)
+from qgis.PyQt.QtCore import QBuffer, QByteArray, QCoreApplication, QIODevice, QSize
+from qgis.PyQt.QtGui import QColor, QImage
+from qgis.testing import start_app, unittest
+
+# half the width of the web mercator world
+ORIGIN_SHIFT = 20037508.342789244
+
+
+class TileRequestHandler(http.server.BaseHTTPRequestHandler):
+    """Serves the same PNG tile for every request and records the requested paths"""
+
+    tile = None
+    requests = []
+
+    def do_GET(self):
+        TileRequestHandler.requests.append(self.path)
+        self.send_response(200)
+        self.send_header('Content-Type', 'image/png')
+        # don't let the network disk cache keep the tiles
+        self.send_header('Cache-Control', 'no-store')
+        self.send_header('Content-Length', str(len(TileRequestHandler.tile)))
+        self.end_headers()
+        self.wfile.write(TileRequestHandler.tile)
+
+    def log_message(self, format, *args):
+        pass
+
+
+class TestPyQgsWmsProviderTiles(unittest.TestCase):
+
+    @classmethod
+    def setUpClass(cls):
+        """Run before all tests"""
+        QCoreApplication.setOrganizationName("QGIS_Test")
+        QCoreApplication.setOrganizationDomain("TestPyQgsWmsProviderTiles.com")
+        QCoreApplication.setApplicationName("TestPyQgsWmsProviderTiles")
+        QgsSettings().clear()
+        start_app()
+
+        cls.basetestpath = tempfile.mkdtemp()
+        cls.store_path = os.path.join(cls.basetestpath, 'tiles.sqlite')
+
+        # the tile store and prefetching are set up on first use
+        settings = QgsSettings()
+        settings.setValue('cache/tileStorePath', cls.store_path)
+        settings.setValue('cache/tileStoreSize', 10 * 1024 * 1024)
+        settings.setValue('qgis/tilePrefetch', True)
+
+        image = QImage(256, 256, QImage.Format_ARGB32)
+        image.fill(QColor(255, 0, 0))
+        data = QByteArray()
+        buffer = QBuffer(data)
+        buffer.open(QIODevice.WriteOnly)
+        image.save(buffer, 'PNG')
+        TileRequestHandler.tile = bytes(data)
+
+        cls.httpd = socketserver.TCPServer(('localhost', 0), TileRequestHandler)
+        cls.port = cls.httpd.server_address[1]
+        cls.httpd_thread = threading.Thread(target=cls.httpd.serve_forever)
+        cls.httpd_thread.setDaemon(True)
+        cls.httpd_thread.start()
+
+    @classmethod
+    def tearDownClass(cls):
+        """Run after all tests"""
+        cls.httpd.shutdown()
+        shutil.rmtree(cls.basetestpath, True)
+        QgsSettings().clear()
+
+    def tileExtent(self, zoom, x0, y0, x1, y1):
+        """Returns the extent of XYZ tiles x0 to x1 and y0 to y1, inset by a bit
+        so that the neighbouring tiles are not in view"""
+        size = 2 * ORIGIN_SHIFT / 2 ** zoom
+        return QgsRectangle(-ORIGIN_SHIFT + x0 * size + 1, ORIGIN_SHIFT - (y1 + 1) * size + 1,
+                            -ORIGIN_SHIFT + (x1 + 1) * size - 1, ORIGIN_SHIFT - y0 * size - 1)
+
+    def render(self, layer, extent, width, height):
+        settings = QgsMapSettings()
+        settings.setLayers([layer])
+        settings.setDestinationCrs(QgsCoordinateReferenceSystem('EPSG:3857'))
+        settings.setOutputSize(QSize(width, height))
+        settings.setExtent(extent)
+        job = QgsMapRendererSequentialJob(settings)
+        job.start()
+        job.waitForFinished()
+        return job.renderedImage()
+
+    def waitForRequests(self, paths, timeout=10):
+        start = time.time()
+        while time.time() - start < timeout:
+            if all(p in TileRequestHandler.requests for p in paths):
+                return True
+            QCoreApplication.processEvents()
+            time.sleep(0.01)
+        return False
+
+    def storedUrls(self):
+        con = sqlite3.connect(self.store_path)
+        urls = set(r[0] for r in con.execute('SELECT url FROM tiles'))
+        con.close()
+        return urls
+
+    def tileUrl(self, zoom, x, y):
+        return 'http://localhost:{}/{}/{}/{}.png'.format(self.port, zoom, x, y)
+
+    def testStoreAndPrefetch(self):
+        layer = QgsRasterLayer('type=xyz&url=http://localhost:{}/{{z}}/{{x}}/{{y}}.png&zmax=19&zmin=0'.format(self.port), 'tiles', 'wms')
+        self.assertTrue(layer.isValid())
+
+        # a view of 2x2 tiles at zoom level 3
+        image = self.render(layer, self.tileExtent(3, 2, 2, 3, 3), 512, 512)
+        self.assertEqual(QColor(image.pixel(256, 256)), QColor(255, 0, 0))
+        view_tiles = ['/3/2/2.png', '/3/3/2.png', '/3/2/3.png', '/3/3/3.png']
+        for p in view_tiles:
+            self.assertEqual(TileRequestHandler.requests.count(p), 1)
+
+        # the parent tile and the ring of tiles around the view are prefetched in the background
+        prefetched = ['/2/1/1.png', '/3/1/1.png', '/3/4/1.png', '/3/1/4.png', '/3/4/4.png', '/3/4/2.png', '/3/4/3.png']
+        self.assertTrue(self.waitForRequests(prefetched), TileRequestHandler.requests)
+        # tiles in view are not requested again
+        for p in view_tiles:
+            self.assertEqual(TileRequestHandler.requests.count(p), 1)
+
+        # downloaded tiles are kept in the tile store, even though the server does not allow caching
+        start = time.time()
+        expected = set(self.tileUrl(3, x, y) for x in range(1, 5) for y in range(1, 5)) | {self.tileUrl(2, 1, 1)}
+        while not expected.issubset(self.storedUrls()) and time.time() - start < 10:
+            time.sleep(0.01)
+        self.assertTrue(expected.issubset(self.storedUrls()))
+
+        # panning to the prefetched tiles does not need any requests
+        image = self.render(layer, self.tileExtent(3, 3, 2, 4, 3), 512, 512)
+        self.assertEqual(QColor(image.pixel(384, 256)), QColor(255, 0, 0))
+        for p in ['/3/4/2.png', '/3/4/3.png']:
+            self.assertEqual(TileRequestHandler.requests.count(p), 1)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -313,6 +313,45 @@ class TestQgsAggregateCalculator(unittest.TestCase):
         self.assertTrue(ok)
         self.assertEqual(val, 24)
 
+    def testGrouped(self):
+        """ test calculating aggregate for groups of features """
+
+        layer = QgsVectorLayer("Point?field=fldint:integer&field=fldgroup:string", "layer", "memory")
+        pr = layer.dataProvider()
+
+        values = [[4, 'a'], [2, 'b'], [3, 'a'], [2, None], [5, 'b'], [None, 'a'], [8, '']]
+
+        features = []
+        for v in values:
+            f = QgsFeature()
+            f.setFields(layer.fields())
+            f.setAttributes(v)
+            features.append(f)
+        assert pr.addFeatures(features)
+
+        agg = QgsAggregateCalculator(layer)
+        val, ok = agg.calculateGrouped(QgsAggregateCalculator.Sum, 'fldint', ['fldgroup'])
+        self.assertTrue(ok)
+        self.assertEqual(val[QgsAggregateCalculator.groupKey(['a'])], 7)
+        self.assertEqual(val[QgsAggregateCalculator.groupKey(['b'])], 7)
+        self.assertEqual(val[QgsAggregateCalculator.groupKey([None])], 2)
+        self.assertEqual(val[QgsAggregateCalculator.groupKey([''])], 8)
+        self.assertNotIn(QgsAggregateCalculator.groupKey(['c']), val)
+        # value for groups without features
+        self.assertEqual(val[''], 0)
+
+        # with expression and filter
+        agg.setFilter('fldint > 2')
+        val, ok = agg.calculateGrouped(QgsAggregateCalculator.Count, 'fldint * 2', ['fldgroup'])
+        self.assertTrue(ok)
+        self.assertEqual(val[QgsAggregateCalculator.groupKey(['a'])], 2)
+        self.assertEqual(val[QgsAggregateCalculator.groupKey(['b'])], 1)
+        self.assertNotIn(QgsAggregateCalculator.groupKey([None]), val)
+
+        # bad group field
+        val, ok = agg.calculateGrouped(QgsAggregateCalculator.Count, 'fldint', ['xxx'])
+        self.assertFalse(ok)
+
     def testExpression(self):
         """ test aggregate calculation using an expression """
 
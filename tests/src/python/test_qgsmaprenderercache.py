@@ -97,6 +97,32 @@ class TestQgsMapRendererCache(unittest.TestCase):
         self.assertTrue(cache.cacheImage('layer').isNull())
         self.assertFalse(cache.hasCacheImage('layer'))
 
+    def testPanned(self):
+        cache = QgsMapRendererCache()
+        extent = QgsRectangle(1, 2, 3, 4)
+        self.assertFalse(cache.init(extent, 1000))
+        im = QImage(200, 200, QImage.Format_RGB32)
+        cache.setCacheImage('layer', im)
+
+        # no panned image for the current extent
+        image, image_extent = cache.pannedCacheImage('layer')
+        self.assertTrue(image.isNull())
+
+        # pan the map, without changing scale or size of the extent
+        self.assertFalse(cache.init(QgsRectangle(1.5, 1.5, 3.5, 3.5), 1000))
+        # image is not valid for the new extent...
+        self.assertTrue(cache.cacheImage('layer').isNull())
+        self.assertFalse(cache.hasCacheImage('layer'))
+        # ...but can be reused for the part of the map which is still visible
+        image, image_extent = cache.pannedCacheImage('layer')
+        self.assertFalse(image.isNull())
+        self.assertEqual(image_extent, extent)
+        self.assertTrue(cache.pannedCacheImage('another layer')[0].isNull())
+
+        # changing the size of the extent clears the cache
+        self.assertFalse(cache.init(QgsRectangle(1.5, 1.5, 4.5, 3.5), 1000))
+        self.assertTrue(cache.pannedCacheImage('layer')[0].isNull())
+
     def testRequestRepaintSimple(self):
         """ test requesting repaint with a single dependent layer """
         layer = QgsVectorLayer("Point?field=fldtxt:string",
@@ -235,6 +235,75 @@ class TestQgsRasterLayer(unittest.TestCase):
         assert self.rendererChanged
         assert layer.renderer() == r
 
+    def testPseudoColorBlock(self):
+        """ test that shading whole blocks gives the same colors as shading single values """
+        for file_name in ['band1_byte_noct_epsg4326.tif',
+                          'band1_int16_noct_epsg4326.tif',
+                          'band1_float32_noct_epsg4326.tif']:
+            path = os.path.join(unitTestDataPath('raster'), file_name)
+            layer = QgsRasterLayer(path, 'test')
+            self.assertTrue(layer.isValid(), 'Raster not loaded: {}'.format(path))
+            provider = layer.dataProvider()
+            extent = layer.extent()
+            values = provider.block(1, extent, 30, 20)
+
+            for ramp_type in [QgsColorRampShader.Interpolated, QgsColorRampShader.Discrete, QgsColorRampShader.Exact]:
+                shader_function = QgsColorRampShader()
+                shader_function.setColorRampType(ramp_type)
+                shader_function.setClip(True)
+                shader_function.setColorRampItemList([QgsColorRampShader.ColorRampItem(50, QColor(255, 255, 0), 'a'),
+                                                      QgsColorRampShader.ColorRampItem(100, QColor(255, 0, 255), 'b'),
+                                                      QgsColorRampShader.ColorRampItem(150, QColor(0, 255, 0, 128), 'c'),
+                                                      QgsColorRampShader.ColorRampItem(200, QColor(0, 0, 255), 'd')])
+                shader = QgsRasterShader()
+                shader.setRasterShaderFunction(shader_function)
+                renderer = QgsSingleBandPseudoColorRenderer(provider, 1, shader)
+
+                block = renderer.block(1, extent, 30, 20)
+                for i in range(30 * 20):
+                    expected = QColor(0, 0, 0, 0)
+                    if not values.isNoData(i):
+                        ok, red, green, blue, alpha = shader.shade(values.value(i))
+                        if ok:
+                            expected = QColor(int(red * (alpha / 255.0)), int(green * (alpha / 255.0)), int(blue * (alpha / 255.0)), alpha)
+                    self.assertEqual(QColor.fromRgba(block.color(i)), expected,
+                                     '{} type {} pixel {} value {}'.format(file_name, ramp_type, i, values.value(i)))
+
+    def testPseudoColorFloatBlockTable(self):
+        """ test that large float blocks shaded through the color table are close to the exact colors """
+        path = os.path.join(unitTestDataPath('raster'), 'band1_float32_noct_epsg4326.tif')
+        layer = QgsRasterLayer(path, 'test')
+        self.assertTrue(layer.isValid(), 'Raster not loaded: {}'.format(path))
+        provider = layer.dataProvider()
+        extent = layer.extent()
+        values = provider.block(1, extent, 256, 256)
+
+        for ramp_type in [QgsColorRampShader.Interpolated, QgsColorRampShader.Discrete, QgsColorRampShader.Exact]:
+            shader_function = QgsColorRampShader(50, 200)
+            shader_function.setColorRampType(ramp_type)
+            shader_function.setClip(True)
+            shader_function.setColorRampItemList([QgsColorRampShader.ColorRampItem(50, QColor(255, 255, 0), 'a'),
+                                                  QgsColorRampShader.ColorRampItem(100, QColor(255, 0, 255), 'b'),
+                                                  QgsColorRampShader.ColorRampItem(150, QColor(0, 255, 0, 128), 'c'),
+                                                  QgsColorRampShader.ColorRampItem(200, QColor(0, 0, 255), 'd')])
+            shader = QgsRasterShader()
+            shader.setRasterShaderFunction(shader_function)
+            renderer = QgsSingleBandPseudoColorRenderer(provider, 1, shader)
+
+            # interpolated colors are quantized, the other types must be exact
+            tolerance = 1 if ramp_type == QgsColorRampShader.Interpolated else 0
+            block = renderer.block(1, extent, 256, 256)
+            for i in range(256 * 256):
+                expected = QColor(0, 0, 0, 0)
+                if not values.isNoData(i):
+                    ok, red, green, blue, alpha = shader.shade(values.value(i))
+                    if ok:
+                        expected = QColor(int(red * (alpha / 255.0)), int(green * (alpha / 255.0)), int(blue * (alpha / 255.0)), alpha)
+                color = QColor.fromRgba(block.color(i))
+                for channel in ['red', 'green', 'blue', 'alpha']:
+                    self.assertLessEqual(abs(getattr(color, channel)() - getattr(expected, channel)()), tolerance,
+                                         'type {} pixel {} value {}'.format(ramp_type, i, values.value(i)))
+
     def testQgsRasterMinMaxOrigin(self):
 
         mmo = QgsRasterMinMaxOrigin()
@@ -80,6 +80,22 @@ class TestQgsServerProjectUtils(unittest.TestCase):
 
         self.assertEqual(expected, result)
 
+    def test_clonelayer(self):
+        layer = self.prj.mapLayer('points20170309173738552')
+        self.assertIsNotNone(layer)
+
+        clone = QgsServerProjectUtils.cloneLayer(layer, self.prj)
+        self.assertIsNotNone(clone)
+        self.assertTrue(clone.isValid())
+        self.assertEqual(clone.id(), layer.id())
+        self.assertEqual(clone.name(), layer.name())
+        self.assertEqual(clone.subsetString(), layer.subsetString())
+
+        # changing the copy leaves the layer of the project untouched
+        clone.setSubsetString('1 = 0')
+        self.assertNotEqual(clone.subsetString(), layer.subsetString())
+        self.assertEqual(self.prj.mapLayer('points20170309173738552'), layer)
+
 
 if __name__ == '__main__':
     unittest.main()
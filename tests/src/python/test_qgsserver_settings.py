@@ -115,6 +115,16 @@ class TestQgsServerSettings(unittest.TestCase):
         self.assertEqual(self.settings.maxThreads(), 5)
         os.environ.pop(env)
 
+    def test_env_fcgi_workers(self):
+        env = "QGIS_SERVER_FCGI_WORKERS"
+
+        self.assertEqual(self.settings.fcgiWorkers(), 1)
+
+        os.environ[env] = "4"
+        self.settings.load()
+        self.assertEqual(self.settings.fcgiWorkers(), 4)
+        os.environ.pop(env)
+
     def test_env_cache_size(self):
         env = "QGIS_SERVER_CACHE_SIZE"
 